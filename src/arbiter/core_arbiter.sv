@@ -2,19 +2,28 @@
 
 module core_arbiter
   import offnariscv_pkg::*;
-(
+#(
+    parameter BLOCK_SIZE = 256
+) (
     input logic clk,
     input logic rst,
 
     ace_if.s ifu_ace_if,  // From IFU
     ace_if.s lsu_ace_if,  // From LSU
+    ace_if.s ptw_ace_if,  // From page-table walker
 
-    ace_if.m core_ace_if
+    ace_if.m core_ace_if,
+
+    output logic demand_busy  // The IFU or PTW has a read pending; the LSU holds its prefetches
 );
 
   // Define local parameters
   localparam ACE_XDATA_WIDTH = core_ace_if.ACE_XDATA_WIDTH;
   localparam ACE_AXADDR_WIDTH = core_ace_if.ACE_AXADDR_WIDTH;
+  localparam BUS_OFFSET_WIDTH = $clog2(ACE_XDATA_WIDTH / 8);
+  localparam BLOCK_OFFSET_WIDTH = $clog2(BLOCK_SIZE / 8);
+  localparam BEATS = BLOCK_SIZE / ACE_XDATA_WIDTH;
+  localparam BEAT_SEL_WIDTH = (BEATS > 1) ? $clog2(BEATS) : 1;
 
   // Assert conditions
   initial begin
@@ -26,19 +35,40 @@ module core_arbiter
     else $fatal("ACE_XDATA_WIDTH must match between core_ace_if and ifu_ace_if");
     assert (ACE_AXADDR_WIDTH == ifu_ace_if.ACE_AXADDR_WIDTH)
     else $fatal("ACE_AXADDR_WIDTH must match between core_ace_if and ifu_ace_if");
+    assert (ACE_XDATA_WIDTH == ptw_ace_if.ACE_XDATA_WIDTH)
+    else $fatal("ACE_XDATA_WIDTH must match between core_ace_if and ptw_ace_if");
+    assert (ACE_AXADDR_WIDTH == ptw_ace_if.ACE_AXADDR_WIDTH)
+    else $fatal("ACE_AXADDR_WIDTH must match between core_ace_if and ptw_ace_if");
   end
 
   // Define types
-  typedef enum logic {
+  typedef enum logic [1:0] {
     IFU,
-    LSU
+    LSU,
+    PTW
   } initiator_e;
 
-  typedef enum logic {
+  typedef enum logic [1:0] {
     R_IDLE,
-    R_LOAD
+    R_SNOOP,  // The page-table walker and the IFU read through the L1D, which may hold a newer copy
+    R_LOCAL,  // ... and get the beats from the L1D
+    R_LOAD  // The R channel passes through until the last beat
   } r_state_e;
 
+  typedef enum logic [1:0] {
+    W_IDLE,
+    W_LSU,
+    W_SNOOP,  // The page-table walker takes the line out of the L1D before writing it
+    W_PTW
+  } w_state_e;
+
+  typedef enum logic [1:0] {
+    LS_IDLE,
+    LS_AC,
+    LS_CR,
+    LS_CD
+  } local_snoop_state_e;
+
   // Declare registers and their next states
   initiator_e r_initiator_q, r_initiator_d;
 
@@ -60,15 +90,44 @@ module core_arbiter
   logic [ACE_DOMAIN_WIDTH-1:0] ardomain_q, ardomain_d;
   logic [ACE_BAR_WIDTH-1:0] arbar_q, arbar_d;
 
+  // A read served from the L1D is a copy of the line, returned from the
+  // beat of the address in wrapping order, as the bus would
   logic [ACE_XID_WIDTH-1:0] rid_q, rid_d;
-  logic [ACE_XDATA_WIDTH-1:0] rdata_q, rdata_d;
+  logic [BLOCK_SIZE-1:0] rline_q, rline_d;
   logic [ACE_RRESP_WIDTH-1:0] rresp_q, rresp_d;
-  logic rlast_q, rlast_d;
   logic [ACE_XUSER_WIDTH-1:0] ruser_q, ruser_d;
-  logic rready_q, rready_d;
+  logic local_rvalid_q, local_rvalid_d;
+  logic [BEAT_SEL_WIDTH-1:0] rbeat_q, rbeat_d;
+  logic [ACE_AXLEN_WIDTH-1:0] rleft_q, rleft_d;  // Beats left after the current one
+
+  // A write of the page-table walker is a single beat, or the whole line
+  // with the PTE merged in when the L1D had it dirty
+  w_state_e w_state_q, w_state_d;
+  logic [ACE_AXADDR_WIDTH-1:0] awaddr_q, awaddr_d;
+  logic [BLOCK_SIZE-1:0] wdata_q, wdata_d;
+  logic [ACE_XDATA_WIDTH/8-1:0] wstrb_q, wstrb_d;
+  logic awvalid_q, awvalid_d;
+  logic wvalid_q, wvalid_d;
+  logic wline_q, wline_d;
+  logic [BEAT_SEL_WIDTH-1:0] wbeat_q, wbeat_d;
 
-  logic ifu_rvalid_q, ifu_rvalid_d;
-  logic lsu_rvalid_q, lsu_rvalid_d;
+  // Snoops of the local L1D on behalf of the page-table walker. They are
+  // issued only while the LSU has no snoop from the interconnect in progress,
+  // and hold off the interconnect until they complete.
+  local_snoop_state_e ls_state_q, ls_state_d;
+  logic [ACE_AXADDR_WIDTH-1:0] ls_addr_q, ls_addr_d;
+  ace_snoop_e ls_snoop_q, ls_snoop_d;
+  logic [BLOCK_SIZE-1:0] ls_rdata_q, ls_rdata_d;  // The line, collected from the CD beats
+  logic [BEAT_SEL_WIDTH-1:0] ls_beat_q, ls_beat_d;
+
+  // Declare wires
+  logic ls_start;
+  logic ls_done;  // The local snoop completes in this cycle
+  logic ls_hit;  // ... and returned data
+  logic [BEAT_SEL_WIDTH-1:0] ls_sel;  // Beat of the address of the local snoop
+
+  assign demand_busy = ifu_ace_if.arvalid || ptw_ace_if.arvalid ||
+      ((r_state_q != R_IDLE) && (r_initiator_q != LSU));
 
   always_comb begin
     // AR/R channel
@@ -92,11 +151,52 @@ module core_arbiter
     arbar_d = arbar_q;
 
     rid_d = rid_q;
-    rdata_d = rdata_q;
+    rline_d = rline_q;
     rresp_d = rresp_q;
-    rlast_d = rlast_q;
     ruser_d = ruser_q;
-    rready_d = rready_q;
+    local_rvalid_d = local_rvalid_q;
+    rbeat_d = rbeat_q;
+    rleft_d = rleft_q;
+
+    // Local snoop
+    ls_state_d = ls_state_q;
+    ls_addr_d = ls_addr_q;
+    ls_snoop_d = ls_snoop_q;
+    ls_rdata_d = ls_rdata_q;
+    ls_beat_d = ls_beat_q;
+    ls_start = 1'b0;
+    ls_done = 1'b0;
+    ls_hit = 1'b0;
+    ls_sel = BEAT_SEL_WIDTH'(ls_addr_q[BLOCK_OFFSET_WIDTH-1:0] >> BUS_OFFSET_WIDTH);
+    unique case (ls_state_q)
+      LS_AC: begin
+        ls_beat_d = '0;
+        if (lsu_ace_if.acready) ls_state_d = LS_CR;
+      end
+      LS_CR: begin
+        if (lsu_ace_if.crvalid) begin
+          if (lsu_ace_if.crresp[0]) begin  // DataTransfer
+            ls_state_d = LS_CD;
+          end else begin
+            ls_done = 1'b1;
+            ls_state_d = LS_IDLE;
+          end
+        end
+      end
+      LS_CD: begin
+        if (lsu_ace_if.cdvalid) begin
+          ls_rdata_d[ACE_XDATA_WIDTH*ls_beat_q+:ACE_XDATA_WIDTH] = lsu_ace_if.cddata;
+          ls_beat_d = ls_beat_q + BEAT_SEL_WIDTH'(1);
+          if (lsu_ace_if.cdlast) begin
+            ls_done = 1'b1;
+            ls_hit = 1'b1;
+            ls_state_d = LS_IDLE;
+          end
+        end
+      end
+      default: begin
+      end
+    endcase
 
     core_ace_if.arid = arid_q;
     core_ace_if.araddr = araddr_q;
@@ -113,27 +213,35 @@ module core_arbiter
     core_ace_if.arsnoop = arsnoop_q;
     core_ace_if.ardomain = ardomain_q;
     core_ace_if.arbar = arbar_q;
-    core_ace_if.rready = rready_q;
+    core_ace_if.rready = '0;
 
     ifu_ace_if.arready = '0;
-    ifu_ace_if.rid = rid_q;
-    ifu_ace_if.rdata = rdata_q;
-    ifu_ace_if.rresp = rresp_q;
-    ifu_ace_if.rlast = rlast_q;
-    ifu_ace_if.ruser = ruser_q;
-    ifu_ace_if.rvalid = ifu_rvalid_q;
+    ifu_ace_if.rid = core_ace_if.rid;
+    ifu_ace_if.rdata = core_ace_if.rdata;
+    ifu_ace_if.rresp = core_ace_if.rresp;
+    ifu_ace_if.rlast = core_ace_if.rlast;
+    ifu_ace_if.ruser = core_ace_if.ruser;
+    ifu_ace_if.rvalid = '0;
 
     lsu_ace_if.arready = '0;
-    lsu_ace_if.rid = rid_q;
-    lsu_ace_if.rdata = rdata_q;
-    lsu_ace_if.rresp = rresp_q;
-    lsu_ace_if.rlast = rlast_q;
-    lsu_ace_if.ruser = ruser_q;
-    lsu_ace_if.rvalid = lsu_rvalid_q;
+    lsu_ace_if.rid = core_ace_if.rid;
+    lsu_ace_if.rdata = core_ace_if.rdata;
+    lsu_ace_if.rresp = core_ace_if.rresp;
+    lsu_ace_if.rlast = core_ace_if.rlast;
+    lsu_ace_if.ruser = core_ace_if.ruser;
+    lsu_ace_if.rvalid = '0;
+
+    ptw_ace_if.arready = '0;
+    ptw_ace_if.rid = core_ace_if.rid;
+    ptw_ace_if.rdata = core_ace_if.rdata;
+    ptw_ace_if.rresp = core_ace_if.rresp;
+    ptw_ace_if.rlast = core_ace_if.rlast;
+    ptw_ace_if.ruser = core_ace_if.ruser;
+    ptw_ace_if.rvalid = '0;
 
     unique case (r_state_q)
       R_IDLE: begin
-        // Priority: LSU > PW > IFU
+        // Priority: LSU > PTW > IFU
         if (lsu_ace_if.arvalid) begin
           arid_d = lsu_ace_if.arid;
           araddr_d = lsu_ace_if.araddr;
@@ -151,10 +259,28 @@ module core_arbiter
           arbar_d = lsu_ace_if.arbar;
 
           arvalid_d = 1'b1;
-          rready_d = 1'b1;
           lsu_ace_if.arready = 1'b1;
           r_initiator_d = LSU;
           r_state_d = R_LOAD;
+        end else if (ptw_ace_if.arvalid) begin
+          arid_d = ptw_ace_if.arid;
+          araddr_d = ptw_ace_if.araddr;
+          arlen_d = ptw_ace_if.arlen;
+          arsize_d = ptw_ace_if.arsize;
+          arburst_d = ptw_ace_if.arburst;
+          arlock_d = ptw_ace_if.arlock;
+          arcache_d = ptw_ace_if.arcache;
+          arprot_d = ptw_ace_if.arprot;
+          arqos_d = ptw_ace_if.arqos;
+          arregion_d = ptw_ace_if.arregion;
+          aruser_d = ptw_ace_if.aruser;
+          arsnoop_d = ptw_ace_if.arsnoop;
+          ardomain_d = ptw_ace_if.ardomain;
+          arbar_d = ptw_ace_if.arbar;
+
+          ptw_ace_if.arready = 1'b1;
+          r_initiator_d = PTW;
+          r_state_d = R_SNOOP;
         end else if (ifu_ace_if.arvalid) begin
           arid_d = ifu_ace_if.arid;
           araddr_d = ifu_ace_if.araddr;
@@ -172,50 +298,97 @@ module core_arbiter
           arbar_d = ifu_ace_if.arbar;
 
           arvalid_d = 1'b1;
-          rready_d = 1'b1;
           ifu_ace_if.arready = 1'b1;
           r_initiator_d = IFU;
-          r_state_d = R_LOAD;
+          r_state_d = R_SNOOP;
+        end
+      end
+      R_SNOOP: begin
+        if (ls_state_q == LS_IDLE) begin
+          ls_start = 1'b1;
+          ls_snoop_d = ACE_READ_ONCE;
+          ls_addr_d = araddr_q;
+        end
+        if (ls_done && (ls_snoop_q == ACE_READ_ONCE)) begin
+          if (ls_hit) begin  // The L1D has the line; it is at least as new as the memory
+            rid_d = '0;
+            rline_d = ls_rdata_d;
+            rresp_d = '0;
+            ruser_d = '0;
+            local_rvalid_d = 1'b1;
+            rbeat_d = ls_sel;
+            rleft_d = arlen_q;
+            r_state_d = R_LOCAL;
+          end else begin
+            arvalid_d = 1'b1;
+            r_state_d = R_LOAD;
+          end
+        end
+      end
+      R_LOCAL: begin
+        ptw_ace_if.rid = rid_q;
+        ptw_ace_if.rdata = rline_q[ACE_XDATA_WIDTH*rbeat_q+:ACE_XDATA_WIDTH];
+        ptw_ace_if.rresp = rresp_q;
+        ptw_ace_if.rlast = (rleft_q == '0);
+        ptw_ace_if.ruser = ruser_q;
+        ifu_ace_if.rid = ptw_ace_if.rid;
+        ifu_ace_if.rdata = ptw_ace_if.rdata;
+        ifu_ace_if.rresp = ptw_ace_if.rresp;
+        ifu_ace_if.rlast = ptw_ace_if.rlast;
+        ifu_ace_if.ruser = ptw_ace_if.ruser;
+        if (r_initiator_q == IFU) begin
+          ifu_ace_if.rvalid = local_rvalid_q;
+        end else begin
+          ptw_ace_if.rvalid = local_rvalid_q;
+        end
+        if ((r_initiator_q == IFU) ? ifu_ace_if.rready : ptw_ace_if.rready) begin
+          rbeat_d = rbeat_q + BEAT_SEL_WIDTH'(1);
+          rleft_d = rleft_q - ACE_AXLEN_WIDTH'(1);
+          if (rleft_q == '0) begin
+            local_rvalid_d = '0;
+            r_state_d = R_IDLE;
+          end
         end
       end
       R_LOAD: begin
         if (core_ace_if.arready) begin
           arvalid_d = '0;
         end
-        if (core_ace_if.rvalid) begin
-          rready_d = '0;
-          rid_d = core_ace_if.rid;
-          rdata_d = core_ace_if.rdata;
-          rresp_d = core_ace_if.rresp;
-          rlast_d = core_ace_if.rlast;
-          ruser_d = core_ace_if.ruser;
-          unique case (r_initiator_q)
-            IFU: begin
-              ifu_rvalid_d = 1'b1;
-            end
-            LSU: begin
-              lsu_rvalid_d = 1'b1;
-            end
-            default: begin
-            end
-          endcase
-        end
-        if (!rready_d) begin
-          if (ifu_rvalid_q && ifu_ace_if.rready) begin
-            ifu_rvalid_d = '0;
-            r_state_d = R_IDLE;
+        unique case (r_initiator_q)
+          IFU: begin
+            ifu_ace_if.rvalid  = core_ace_if.rvalid;
+            core_ace_if.rready = ifu_ace_if.rready;
           end
-          if (lsu_rvalid_q && lsu_ace_if.rready) begin
-            lsu_rvalid_d = '0;
-            r_state_d = R_IDLE;
+          LSU: begin
+            lsu_ace_if.rvalid  = core_ace_if.rvalid;
+            core_ace_if.rready = lsu_ace_if.rready;
+          end
+          PTW: begin
+            ptw_ace_if.rvalid  = core_ace_if.rvalid;
+            core_ace_if.rready = ptw_ace_if.rready;
           end
+          default: begin
+          end
+        endcase
+        if (core_ace_if.rvalid && core_ace_if.rready && core_ace_if.rlast) begin
+          r_state_d = R_IDLE;
         end
       end
       default: begin
       end
     endcase
 
-    // AW/W/B channel
+    // AW/W/B channel: the LSU passes through; a write of the page-table
+    // walker is buffered here and merged with the line from the L1D, if any
+    w_state_d = w_state_q;
+    awaddr_d = awaddr_q;
+    wdata_d = wdata_q;
+    wstrb_d = wstrb_q;
+    awvalid_d = awvalid_q;
+    wvalid_d = wvalid_q;
+    wline_d = wline_q;
+    wbeat_d = wbeat_q;
+
     core_ace_if.awid = lsu_ace_if.awid;
     core_ace_if.awaddr = lsu_ace_if.awaddr;
     core_ace_if.awlen = lsu_ace_if.awlen;
@@ -227,8 +400,8 @@ module core_arbiter
     core_ace_if.awqos = lsu_ace_if.awqos;
     core_ace_if.awregion = lsu_ace_if.awregion;
     core_ace_if.awuser = lsu_ace_if.awuser;
-    core_ace_if.awvalid = lsu_ace_if.awvalid;
-    lsu_ace_if.awready = core_ace_if.awready;
+    core_ace_if.awvalid = '0;
+    lsu_ace_if.awready = '0;
     core_ace_if.awsnoop = lsu_ace_if.awsnoop;
     core_ace_if.awdomain = lsu_ace_if.awdomain;
     core_ace_if.awbar = lsu_ace_if.awbar;
@@ -236,16 +409,154 @@ module core_arbiter
     core_ace_if.wstrb = lsu_ace_if.wstrb;
     core_ace_if.wlast = lsu_ace_if.wlast;
     core_ace_if.wuser = lsu_ace_if.wuser;
-    core_ace_if.wvalid = lsu_ace_if.wvalid;
-    lsu_ace_if.wready = core_ace_if.wready;
+    core_ace_if.wvalid = '0;
+    lsu_ace_if.wready = '0;
     lsu_ace_if.bid = core_ace_if.bid;
     lsu_ace_if.bresp = core_ace_if.bresp;
     lsu_ace_if.buser = core_ace_if.buser;
-    lsu_ace_if.bvalid = core_ace_if.bvalid;
-    core_ace_if.bready = lsu_ace_if.bready;
+    lsu_ace_if.bvalid = '0;
+    ptw_ace_if.awready = '0;
+    ptw_ace_if.wready = '0;
+    ptw_ace_if.bid = core_ace_if.bid;
+    ptw_ace_if.bresp = core_ace_if.bresp;
+    ptw_ace_if.buser = core_ace_if.buser;
+    ptw_ace_if.bvalid = '0;
+    core_ace_if.bready = '0;
+
+    unique case (w_state_q)
+      W_IDLE, W_LSU: begin
+        core_ace_if.awvalid = lsu_ace_if.awvalid;
+        lsu_ace_if.awready = core_ace_if.awready;
+        core_ace_if.wvalid = lsu_ace_if.wvalid;
+        lsu_ace_if.wready = core_ace_if.wready;
+        lsu_ace_if.bvalid = core_ace_if.bvalid;
+        core_ace_if.bready = lsu_ace_if.bready;
+        if (lsu_ace_if.awvalid) begin
+          w_state_d = W_LSU;
+        end else if ((w_state_q == W_IDLE) && ptw_ace_if.awvalid && ptw_ace_if.wvalid) begin
+          ptw_ace_if.awready = 1'b1;
+          ptw_ace_if.wready = 1'b1;
+          awaddr_d = ptw_ace_if.awaddr;
+          wdata_d = {BEATS{ptw_ace_if.wdata}};
+          wstrb_d = ptw_ace_if.wstrb;
+          w_state_d = W_SNOOP;
+        end
+        if (core_ace_if.bvalid && lsu_ace_if.bready) begin
+          w_state_d = W_IDLE;
+        end
+      end
+      W_SNOOP: begin
+        if ((ls_state_q == LS_IDLE) && (r_state_q != R_SNOOP)) begin
+          ls_start = 1'b1;
+          ls_snoop_d = ACE_CLEAN_INVALID;
+          ls_addr_d = awaddr_q;
+        end
+        if (ls_done && (ls_snoop_q == ACE_CLEAN_INVALID)) begin
+          wline_d = ls_hit;
+          wbeat_d = ls_sel;
+          if (ls_hit) begin  // Dirty line: write it back whole, with the PTE merged in
+            for (int i = 0; i < BLOCK_SIZE / 8; ++i) begin
+              if (!((i / (ACE_XDATA_WIDTH / 8) == ls_sel) && wstrb_q[i%(ACE_XDATA_WIDTH/8)])) begin
+                wdata_d[8*i+:8] = ls_rdata_d[8*i+:8];
+              end
+            end
+            wbeat_d = '0;
+          end
+          awvalid_d = 1'b1;
+          wvalid_d = 1'b1;
+          w_state_d = W_PTW;
+        end
+      end
+      W_PTW: begin
+        core_ace_if.awid = '0;
+        core_ace_if.awaddr = wline_q ?
+            {awaddr_q[ACE_AXADDR_WIDTH-1:BLOCK_OFFSET_WIDTH], BLOCK_OFFSET_WIDTH'(0)} : awaddr_q;
+        core_ace_if.awlen = wline_q ? ACE_AXLEN_WIDTH'(BEATS - 1) : '0;
+        core_ace_if.awsize = wline_q ? ACE_AXSIZE_WIDTH'(BUS_OFFSET_WIDTH) : ACE_AXSIZE_WIDTH'(2);
+        core_ace_if.awburst = ACE_BURST_INCR;
+        core_ace_if.awlock = '0;
+        core_ace_if.awcache = '0;
+        core_ace_if.awprot = '0;
+        core_ace_if.awqos = '0;
+        core_ace_if.awregion = '0;
+        core_ace_if.awuser = '0;
+        core_ace_if.awvalid = awvalid_q;
+        core_ace_if.awsnoop = ACE_WRITE_UNIQUE;
+        core_ace_if.awdomain = ACE_DOMAIN_INNER_SHAREABLE;
+        core_ace_if.awbar = '0;
+        core_ace_if.wdata = wdata_q[ACE_XDATA_WIDTH*wbeat_q+:ACE_XDATA_WIDTH];
+        core_ace_if.wstrb = wline_q ? '1 : wstrb_q;
+        core_ace_if.wlast = !wline_q || (wbeat_q == BEAT_SEL_WIDTH'(BEATS - 1));
+        core_ace_if.wuser = '0;
+        core_ace_if.wvalid = wvalid_q;
+        if (core_ace_if.awready) awvalid_d = 1'b0;
+        if (core_ace_if.wready && wvalid_q) begin
+          wbeat_d = wbeat_q + BEAT_SEL_WIDTH'(1);
+          wvalid_d = !core_ace_if.wlast;
+        end
+        ptw_ace_if.bvalid = core_ace_if.bvalid;
+        core_ace_if.bready = ptw_ace_if.bready;
+        if (core_ace_if.bvalid && ptw_ace_if.bready) begin
+          w_state_d = W_IDLE;
+        end
+      end
+      default: begin
+      end
+    endcase
+
+    if (ls_start) begin
+      ls_state_d = LS_AC;
+    end
+
+    // AC/CR/CD channel: only the L1D holds lines that can be snooped
+    lsu_ace_if.acvalid = core_ace_if.acvalid;
+    lsu_ace_if.acaddr = core_ace_if.acaddr;
+    lsu_ace_if.acsnoop = core_ace_if.acsnoop;
+    lsu_ace_if.acprot = core_ace_if.acprot;
+    core_ace_if.acready = lsu_ace_if.acready;
+    core_ace_if.crvalid = lsu_ace_if.crvalid;
+    lsu_ace_if.crready = core_ace_if.crready;
+    core_ace_if.crresp = lsu_ace_if.crresp;
+    core_ace_if.cdvalid = lsu_ace_if.cdvalid;
+    lsu_ace_if.cdready = core_ace_if.cdready;
+    core_ace_if.cddata = lsu_ace_if.cddata;
+    core_ace_if.cdlast = lsu_ace_if.cdlast;
+    if (ls_state_q != LS_IDLE) begin  // A local snoop owns the channels of the LSU
+      lsu_ace_if.acvalid = (ls_state_q == LS_AC);
+      lsu_ace_if.acaddr = ls_addr_q;
+      lsu_ace_if.acsnoop = ls_snoop_q;
+      lsu_ace_if.acprot = '0;
+      core_ace_if.acready = 1'b0;
+      core_ace_if.crvalid = 1'b0;
+      lsu_ace_if.crready = 1'b1;
+      core_ace_if.cdvalid = 1'b0;
+      lsu_ace_if.cdready = 1'b1;
+    end
+    // A local snoop starts only when the LSU has no snoop in progress, and no
+    // snoop from the interconnect is handed to it in the same cycle
+    if (ls_start && !(lsu_ace_if.acready && !core_ace_if.acvalid)) begin
+      ls_start = 1'b0;
+      ls_state_d = ls_state_q;
+      ls_snoop_d = ls_snoop_q;
+      ls_addr_d = ls_addr_q;
+    end
+
+    ptw_ace_if.acvalid = '0;
+    ptw_ace_if.acaddr = '0;
+    ptw_ace_if.acsnoop = '0;
+    ptw_ace_if.acprot = '0;
+    ptw_ace_if.crready = '0;
+    ptw_ace_if.cdready = '0;
+
+    ifu_ace_if.acvalid = '0;
+    ifu_ace_if.acaddr = '0;
+    ifu_ace_if.acsnoop = '0;
+    ifu_ace_if.acprot = '0;
+    ifu_ace_if.crready = '0;
+    ifu_ace_if.cdready = '0;
 
-    core_ace_if.rack = ifu_ace_if.rack || lsu_ace_if.rack;  // TODO
-    core_ace_if.wack = lsu_ace_if.wack;
+    core_ace_if.rack = ifu_ace_if.rack || lsu_ace_if.rack || ptw_ace_if.rack;  // TODO
+    core_ace_if.wack = lsu_ace_if.wack || ptw_ace_if.wack;
   end
 
   always_ff @(posedge clk) begin
@@ -268,13 +579,25 @@ module core_arbiter
       ardomain_q <= '0;
       arbar_q <= '0;
       rid_q <= '0;
-      rdata_q <= '0;
+      rline_q <= '0;
       rresp_q <= '0;
-      rlast_q <= '0;
       ruser_q <= '0;
-      rready_q <= '0;
-      ifu_rvalid_q <= '0;
-      lsu_rvalid_q <= '0;
+      local_rvalid_q <= '0;
+      rbeat_q <= '0;
+      rleft_q <= '0;
+      w_state_q <= W_IDLE;
+      awaddr_q <= '0;
+      wdata_q <= '0;
+      wstrb_q <= '0;
+      awvalid_q <= '0;
+      wvalid_q <= '0;
+      wline_q <= '0;
+      wbeat_q <= '0;
+      ls_state_q <= LS_IDLE;
+      ls_addr_q <= '0;
+      ls_snoop_q <= ACE_READ_ONCE;
+      ls_rdata_q <= '0;
+      ls_beat_q <= '0;
     end else begin
       r_initiator_q <= r_initiator_d;
       r_state_q <= r_state_d;
@@ -294,13 +617,25 @@ module core_arbiter
       ardomain_q <= ardomain_d;
       arbar_q <= arbar_d;
       rid_q <= rid_d;
-      rdata_q <= rdata_d;
+      rline_q <= rline_d;
       rresp_q <= rresp_d;
-      rlast_q <= rlast_d;
       ruser_q <= ruser_d;
-      rready_q <= rready_d;
-      ifu_rvalid_q <= ifu_rvalid_d;
-      lsu_rvalid_q <= lsu_rvalid_d;
+      local_rvalid_q <= local_rvalid_d;
+      rbeat_q <= rbeat_d;
+      rleft_q <= rleft_d;
+      w_state_q <= w_state_d;
+      awaddr_q <= awaddr_d;
+      wdata_q <= wdata_d;
+      wstrb_q <= wstrb_d;
+      awvalid_q <= awvalid_d;
+      wvalid_q <= wvalid_d;
+      wline_q <= wline_d;
+      wbeat_q <= wbeat_d;
+      ls_state_q <= ls_state_d;
+      ls_addr_q <= ls_addr_d;
+      ls_snoop_q <= ls_snoop_d;
+      ls_rdata_q <= ls_rdata_d;
+      ls_beat_q <= ls_beat_d;
     end
   end
 
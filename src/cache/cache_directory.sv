@@ -1,9 +1,19 @@
 // SPDX-License-Identifier: MIT
 
 // Dual-port cache directory
+//
+// With SYNC_READ, the tags are read through ram_sync so that they map to
+// block RAM, and the line states, which are reset and flushed at once, stay
+// in registers but are read a cycle ahead as well: current_tag and
+// current_state in a cycle are those at the next_index of the previous
+// cycle, which the requester keeps equal to index. A write to the line being
+// read is forwarded. Port 1 only changes line states in that variant, as the
+// snoop responder and the L1I invalidation do; the tags are written by port 0.
 module cache_directory
   import cache_pkg::*;
-(
+#(
+    parameter SYNC_READ = 0  // 0: combinational read of index, 1: registered read of next_index
+) (
     input logic clk,
     input logic rst,
 
@@ -16,6 +26,7 @@ module cache_directory
   // Define local parameters
   localparam INDEX_WIDTH = cache_dir_rsp_if_0.INDEX_WIDTH;
   localparam TAG_WIDTH = cache_dir_rsp_if_0.TAG_WIDTH;
+  localparam TAG_RAM_WIDTH = (TAG_WIDTH > 0) ? (TAG_WIDTH + 7) / 8 * 8 : 8;  // Whole bytes for ram_sync
 
   // Assert conditions
   initial begin
@@ -27,20 +38,8 @@ module cache_directory
     else $fatal("INDEX_WIDTH must be greater than 0 for now");  // TODO: Support 1 entry cache
     assert (TAG_WIDTH >= 0)
     else $fatal("TAG_WIDTH must be greater than or equal to 0");  // NOTE: 0 means no tag...
-  end
-
-  // Define types
-  typedef struct packed {
-    line_state_t state;
-    logic [TAG_WIDTH-1:0] tag;
-  } directory_t;
-
-  // Declare memory array
-  directory_t directory[2**INDEX_WIDTH];
-  initial begin
-    for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
-      directory[i] = '0;
-    end
+    assert (SYNC_READ == 0 || SYNC_READ == 1)
+    else $fatal("SYNC_READ must be 0 or 1");
   end
 
   // Declare wires
@@ -54,50 +53,198 @@ module cache_directory
     if0_index = cache_dir_rsp_if_0.index;
     if0_tag = cache_dir_rsp_if_0.next_tag;
 
-    cache_dir_rsp_if_0.current_tag = directory[if0_index].tag;
-    cache_dir_rsp_if_0.current_state = directory[if0_index].state;
-
     // if1
     if1_index = cache_dir_rsp_if_1.index;
     if1_tag = cache_dir_rsp_if_1.next_tag;
+  end
+
+  generate
+    if (SYNC_READ == 0) begin : gen_async
+      // Define types
+      typedef struct packed {
+        line_state_t state;
+        logic [TAG_WIDTH-1:0] tag;
+      } directory_t;
+
+      // Declare memory array
+      directory_t directory[2**INDEX_WIDTH];
+      initial begin
+        for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+          directory[i] = '0;
+        end
+      end
 
-    cache_dir_rsp_if_1.current_tag = directory[if1_index].tag;
-    cache_dir_rsp_if_1.current_state = directory[if1_index].state;
+      always_comb begin
+        cache_dir_rsp_if_0.current_tag = directory[if0_index].tag;
+        cache_dir_rsp_if_0.current_state = directory[if0_index].state;
 
-  end
+        cache_dir_rsp_if_1.current_tag = directory[if1_index].tag;
+        cache_dir_rsp_if_1.current_state = directory[if1_index].state;
+      end
 
-  always_ff @(posedge clk) begin
-    // For valid bit, reset is needed
-    if (rst) begin
-      for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
-        directory[i].state.v <= '0;
+      always_ff @(posedge clk) begin
+        // For valid bit, reset is needed
+        if (rst) begin
+          for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+            directory[i].state.v <= '0;
+          end
+        end else begin
+          if (flush) begin
+            for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+              directory[i].state.v <= '0;
+            end
+          end else begin
+            if (cache_dir_rsp_if_0.write)
+              directory[if0_index].state.v <= cache_dir_rsp_if_0.next_state.v;
+            if (cache_dir_rsp_if_1.write)
+              directory[if1_index].state.v <= cache_dir_rsp_if_1.next_state.v;
+          end
+        end
+      end
+
+      always_ff @(posedge clk) begin
+        // For other bits (expecting to be synthesized to dedicated RAM elements), don't reset
+        if (cache_dir_rsp_if_0.write) begin
+          directory[if0_index].state.d <= cache_dir_rsp_if_0.next_state.d;
+          directory[if0_index].state.u <= cache_dir_rsp_if_0.next_state.u;
+          directory[if0_index].tag <= if0_tag;
+        end
+        if (cache_dir_rsp_if_1.write) begin
+          directory[if1_index].state.d <= cache_dir_rsp_if_1.next_state.d;
+          directory[if1_index].state.u <= cache_dir_rsp_if_1.next_state.u;
+          directory[if1_index].tag <= if1_tag;
+        end
       end
-    end else begin
-      if (flush) begin
+    end else begin : gen_sync
+      // Declare memory array
+      line_state_t state_mem[2**INDEX_WIDTH];
+      initial begin
         for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
-          directory[i].state.v <= '0;
+          state_mem[i] = '0;
         end
-      end else begin
-        if (cache_dir_rsp_if_0.write)
-          directory[if0_index].state.v <= cache_dir_rsp_if_0.next_state.v;
-        if (cache_dir_rsp_if_1.write)
-          directory[if1_index].state.v <= cache_dir_rsp_if_1.next_state.v;
       end
-    end
-  end
 
-  always_ff @(posedge clk) begin
-    // For other bits (expecting to be synthesized to dedicated RAM elements), don't reset
-    if (cache_dir_rsp_if_0.write) begin
-      directory[if0_index].state.d <= cache_dir_rsp_if_0.next_state.d;
-      directory[if0_index].state.u <= cache_dir_rsp_if_0.next_state.u;
-      directory[if0_index].tag <= if0_tag;
-    end
-    if (cache_dir_rsp_if_1.write) begin
-      directory[if1_index].state.d <= cache_dir_rsp_if_1.next_state.d;
-      directory[if1_index].state.u <= cache_dir_rsp_if_1.next_state.u;
-      directory[if1_index].tag <= if1_tag;
+      // Declare registers and their next states
+      line_state_t if0_state_q, if0_state_d;  // State at the index read by if0
+      line_state_t if1_state_q, if1_state_d;
+      logic if0_fwd_q, if0_fwd_d;  // The tag read by if0 was written in the same cycle
+      logic if1_fwd_q, if1_fwd_d;
+      logic [TAG_WIDTH-1:0] fwd_tag_q;  // ... and this was written
+
+      // Declare wires
+      logic [TAG_RAM_WIDTH-1:0] if0_ram_rdata;
+      logic [TAG_RAM_WIDTH-1:0] if1_ram_rdata;
+
+      always_comb begin
+        cache_dir_rsp_if_0.current_tag = if0_fwd_q ? fwd_tag_q : TAG_WIDTH'(if0_ram_rdata);
+        cache_dir_rsp_if_0.current_state = if0_state_q;
+
+        cache_dir_rsp_if_1.current_tag = if1_fwd_q ? fwd_tag_q : TAG_WIDTH'(if1_ram_rdata);
+        cache_dir_rsp_if_1.current_state = if1_state_q;
+
+        // The states at next_index once this cycle's writes are done; port 1 wins as above
+        if0_state_d = state_mem[cache_dir_rsp_if_0.next_index];
+        if (cache_dir_rsp_if_0.write && (if0_index == cache_dir_rsp_if_0.next_index))
+          if0_state_d = cache_dir_rsp_if_0.next_state;
+        if (cache_dir_rsp_if_1.write && (if1_index == cache_dir_rsp_if_0.next_index))
+          if0_state_d = cache_dir_rsp_if_1.next_state;
+        if (flush) if0_state_d.v = 1'b0;
+
+        if1_state_d = state_mem[cache_dir_rsp_if_1.next_index];
+        if (cache_dir_rsp_if_0.write && (if0_index == cache_dir_rsp_if_1.next_index))
+          if1_state_d = cache_dir_rsp_if_0.next_state;
+        if (cache_dir_rsp_if_1.write && (if1_index == cache_dir_rsp_if_1.next_index))
+          if1_state_d = cache_dir_rsp_if_1.next_state;
+        if (flush) if1_state_d.v = 1'b0;
+
+        if0_fwd_d = cache_dir_rsp_if_0.write && (if0_index == cache_dir_rsp_if_0.next_index);
+        if1_fwd_d = cache_dir_rsp_if_0.write && (if0_index == cache_dir_rsp_if_1.next_index);
+      end
+
+      always_ff @(posedge clk) begin
+        if (rst) begin
+          if0_state_q <= '0;
+          if1_state_q <= '0;
+        end else begin
+          if0_state_q <= if0_state_d;
+          if1_state_q <= if1_state_d;
+        end
+        if0_fwd_q <= if0_fwd_d;
+        if1_fwd_q <= if1_fwd_d;
+        fwd_tag_q <= if0_tag;
+      end
+
+      always_ff @(posedge clk) begin
+        // For valid bit, reset is needed
+        if (rst) begin
+          for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+            state_mem[i].v <= '0;
+          end
+        end else begin
+          if (flush) begin
+            for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+              state_mem[i].v <= '0;
+            end
+          end else begin
+            if (cache_dir_rsp_if_0.write) state_mem[if0_index].v <= cache_dir_rsp_if_0.next_state.v;
+            if (cache_dir_rsp_if_1.write) state_mem[if1_index].v <= cache_dir_rsp_if_1.next_state.v;
+          end
+        end
+      end
+
+      always_ff @(posedge clk) begin
+        if (cache_dir_rsp_if_0.write) begin
+          state_mem[if0_index].d <= cache_dir_rsp_if_0.next_state.d;
+          state_mem[if0_index].u <= cache_dir_rsp_if_0.next_state.u;
+        end
+        if (cache_dir_rsp_if_1.write) begin
+          state_mem[if1_index].d <= cache_dir_rsp_if_1.next_state.d;
+          state_mem[if1_index].u <= cache_dir_rsp_if_1.next_state.u;
+        end
+      end
+
+`ifndef SYNTHESIS
+      always_ff @(posedge clk) begin
+        if (!rst && cache_dir_rsp_if_1.write && (if1_tag != cache_dir_rsp_if_1.current_tag))
+          $fatal("cache_directory: port 1 cannot change a tag with SYNC_READ");
+      end
+`endif
+
+      // One copy of the tags per read port, both written by port 0
+      ram_sync #(
+          .DATA_WIDTH(TAG_RAM_WIDTH),
+          .ADDR_WIDTH(INDEX_WIDTH),
+          .OUTPUT_REG(0)
+      ) if0_tag_ram (
+          .clk(clk),
+          .rst(rst),
+          .wdata(TAG_RAM_WIDTH'(if0_tag)),
+          .waddr(if0_index),
+          .wvalid(cache_dir_rsp_if_0.write),
+          .wstrb('1),
+          .rdata(if0_ram_rdata),
+          .raddr(cache_dir_rsp_if_0.next_index),
+          .rvalid(1'b1),
+          .oreg_cen(1'b0)
+      );
+
+      ram_sync #(
+          .DATA_WIDTH(TAG_RAM_WIDTH),
+          .ADDR_WIDTH(INDEX_WIDTH),
+          .OUTPUT_REG(0)
+      ) if1_tag_ram (
+          .clk(clk),
+          .rst(rst),
+          .wdata(TAG_RAM_WIDTH'(if0_tag)),
+          .waddr(if0_index),
+          .wvalid(cache_dir_rsp_if_0.write),
+          .wstrb('1),
+          .rdata(if1_ram_rdata),
+          .raddr(cache_dir_rsp_if_1.next_index),
+          .rvalid(1'b1),
+          .oreg_cen(1'b0)
+      );
     end
-  end
+  endgenerate
 
 endmodule
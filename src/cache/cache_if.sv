@@ -8,6 +8,7 @@ interface cache_dir_if
     parameter TAG_WIDTH   = 20
 );
   logic [INDEX_WIDTH-1:0] index;
+  logic [INDEX_WIDTH-1:0] next_index;  // index in the next cycle, for a directory with a synchronous read
   logic [TAG_WIDTH-1:0] next_tag;
   line_state_t next_state;
   logic write;
@@ -15,10 +16,10 @@ interface cache_dir_if
   line_state_t current_state;
 
   // Request modport (controller side)
-  modport req(output index, next_tag, next_state, write, input current_tag, current_state);
+  modport req(output index, next_index, next_tag, next_state, write, input current_tag, current_state);
 
   // Response modport (directory side)
-  modport rsp(input index, next_tag, next_state, write, output current_tag, current_state);
+  modport rsp(input index, next_index, next_tag, next_state, write, output current_tag, current_state);
 
 endinterface
 
@@ -29,14 +30,15 @@ interface cache_mem_if #(
     localparam STRB_WIDTH  = BLOCK_SIZE / 8
 );
   logic [INDEX_WIDTH-1:0] index;
+  logic [INDEX_WIDTH-1:0] next_index;  // index in the next cycle, for a memory with a synchronous read
   logic [ BLOCK_SIZE-1:0] wdata;
   logic [ STRB_WIDTH-1:0] wstrb;
   logic [ BLOCK_SIZE-1:0] rdata;
 
   // Request modport (controller side)
-  modport req(output index, wdata, wstrb, input rdata);
+  modport req(output index, next_index, wdata, wstrb, input rdata);
 
   // Response modport (memory side)
-  modport rsp(input index, wdata, wstrb, output rdata);
+  modport rsp(input index, next_index, wdata, wstrb, output rdata);
 
 endinterface
@@ -1,9 +1,17 @@
 // SPDX-License-Identifier: MIT
 
 // Dual-port cache memory
+//
+// With SYNC_READ, the array is read through ram_sync so that it maps to block
+// RAM: rdata in a cycle is the block at the next_index of the previous cycle,
+// which the requester keeps equal to index. A write to the block being read
+// is forwarded, so a line reads back its last write in the next cycle. Only
+// port 0 writes in that variant; no requester writes through port 1.
 module cache_memory
   import cache_pkg::*;
-(
+#(
+    parameter SYNC_READ = 0  // 0: combinational read of index, 1: registered read of next_index
+) (
     input logic clk,
     input logic rst,
 
@@ -28,14 +36,8 @@ module cache_memory
     else $fatal("INDEX_WIDTH must be greater than 0 for now");  // TODO: Support 1 entry cache
     assert (STRB_WIDTH == BLOCK_SIZE / 8)
     else $fatal("STRB_WIDTH must be equal to BLOCK_SIZE / 8");
-  end
-
-  // Declare memory array
-  logic [BLOCK_SIZE-1:0] memory[2**INDEX_WIDTH];
-  initial begin
-    for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
-      memory[i] = '0;
-    end
+    assert (SYNC_READ == 0 || SYNC_READ == 1)
+    else $fatal("SYNC_READ must be 0 or 1");
   end
 
   // Declare wires
@@ -52,21 +54,99 @@ module cache_memory
     if0_wdata = cache_mem_rsp_if_0.wdata;
     if0_wstrb = cache_mem_rsp_if_0.wstrb;
 
-    cache_mem_rsp_if_0.rdata = memory[if0_index];
-
     // if1
     if1_index = cache_mem_rsp_if_1.index;
     if1_wdata = cache_mem_rsp_if_1.wdata;
     if1_wstrb = cache_mem_rsp_if_1.wstrb;
-
-    cache_mem_rsp_if_1.rdata = memory[if1_index];
   end
 
-  always_ff @(posedge clk) begin
-    for (int i = 0; i < STRB_WIDTH; ++i) begin
-      if (if0_wstrb[i]) memory[if0_index][i*8+:8] <= if0_wdata[i*8+:8];
-      if (if1_wstrb[i]) memory[if1_index][i*8+:8] <= if1_wdata[i*8+:8];
+  generate
+    if (SYNC_READ == 0) begin : gen_async
+      // Declare memory array
+      logic [BLOCK_SIZE-1:0] memory[2**INDEX_WIDTH];
+      initial begin
+        for (int i = 0; i < 2 ** INDEX_WIDTH; ++i) begin
+          memory[i] = '0;
+        end
+      end
+
+      always_comb begin
+        cache_mem_rsp_if_0.rdata = memory[if0_index];
+        cache_mem_rsp_if_1.rdata = memory[if1_index];
+      end
+
+      always_ff @(posedge clk) begin
+        for (int i = 0; i < STRB_WIDTH; ++i) begin
+          if (if0_wstrb[i]) memory[if0_index][i*8+:8] <= if0_wdata[i*8+:8];
+          if (if1_wstrb[i]) memory[if1_index][i*8+:8] <= if1_wdata[i*8+:8];
+        end
+      end
+    end else begin : gen_sync
+      // Declare registers
+      logic [STRB_WIDTH-1:0] if0_fwd_strb_q;  // Bytes of the block read by if0 written in the same cycle
+      logic [STRB_WIDTH-1:0] if1_fwd_strb_q;
+      logic [BLOCK_SIZE-1:0] fwd_wdata_q;  // ... and what was written
+
+      // Declare wires
+      logic [BLOCK_SIZE-1:0] if0_ram_rdata;
+      logic [BLOCK_SIZE-1:0] if1_ram_rdata;
+
+      always_comb begin
+        for (int i = 0; i < STRB_WIDTH; ++i) begin
+          cache_mem_rsp_if_0.rdata[i*8+:8] =
+              if0_fwd_strb_q[i] ? fwd_wdata_q[i*8+:8] : if0_ram_rdata[i*8+:8];
+          cache_mem_rsp_if_1.rdata[i*8+:8] =
+              if1_fwd_strb_q[i] ? fwd_wdata_q[i*8+:8] : if1_ram_rdata[i*8+:8];
+        end
+      end
+
+      always_ff @(posedge clk) begin
+        if0_fwd_strb_q <= (cache_mem_rsp_if_0.next_index == if0_index) ? if0_wstrb : '0;
+        if1_fwd_strb_q <= (cache_mem_rsp_if_1.next_index == if0_index) ? if0_wstrb : '0;
+        fwd_wdata_q <= if0_wdata;
+      end
+
+`ifndef SYNTHESIS
+      always_ff @(posedge clk) begin
+        if (!rst && (if1_wstrb != '0)) $fatal("cache_memory: port 1 cannot write with SYNC_READ");
+      end
+`endif
+
+      // One copy of the array per read port, both written by port 0
+      ram_sync #(
+          .DATA_WIDTH(BLOCK_SIZE),
+          .ADDR_WIDTH(INDEX_WIDTH),
+          .OUTPUT_REG(0)
+      ) if0_ram (
+          .clk(clk),
+          .rst(rst),
+          .wdata(if0_wdata),
+          .waddr(if0_index),
+          .wvalid(if0_wstrb != '0),
+          .wstrb(if0_wstrb),
+          .rdata(if0_ram_rdata),
+          .raddr(cache_mem_rsp_if_0.next_index),
+          .rvalid(1'b1),
+          .oreg_cen(1'b0)
+      );
+
+      ram_sync #(
+          .DATA_WIDTH(BLOCK_SIZE),
+          .ADDR_WIDTH(INDEX_WIDTH),
+          .OUTPUT_REG(0)
+      ) if1_ram (
+          .clk(clk),
+          .rst(rst),
+          .wdata(if0_wdata),
+          .waddr(if0_index),
+          .wvalid(if0_wstrb != '0),
+          .wstrb(if0_wstrb),
+          .rdata(if1_ram_rdata),
+          .raddr(cache_mem_rsp_if_1.next_index),
+          .rvalid(1'b1),
+          .oreg_cen(1'b0)
+      );
     end
-  end
+  endgenerate
 
 endmodule
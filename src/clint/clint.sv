@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MIT
+
+// Core-Local Interruptor, with the SiFive register layout: msip at 0x0000,
+// mtimecmp at 0x4000 and mtime at 0xbff8. mtime counts clock cycles.
+module clint
+  import riscv_pkg::*, offnariscv_pkg::*;
+#(
+    parameter NUM_HARTS = 1
+) (
+    input logic clk,
+    input logic rst,
+
+    clint_if.rsp clint_rsp_if[NUM_HARTS],
+
+    // Cycles to add to mtime on top of this one. The simulation harness uses
+    // it to fast-forward harts that sleep in WFI; hardware ties it to zero.
+    input logic [63:0] skip
+);
+
+  // Define local parameters
+  localparam logic [CLINT_ADDR_WIDTH-1:0] MSIP = CLINT_ADDR_WIDTH'('h0000);
+  localparam logic [CLINT_ADDR_WIDTH-1:0] MTIMECMP = CLINT_ADDR_WIDTH'('h4000);
+  localparam logic [CLINT_ADDR_WIDTH-1:0] MTIME = CLINT_ADDR_WIDTH'('hbff8);
+
+  // Assert conditions
+  initial begin
+    assert (NUM_HARTS >= 1 && NUM_HARTS <= 4095)
+    else $fatal("NUM_HARTS must be between 1 and 4095");
+    assert (XLEN == 32)
+    else $fatal("The 64-bit registers are accessed as two words, so XLEN must be 32");
+  end
+
+  // Define functions
+  function automatic logic [XLEN-1:0] merge(logic [XLEN-1:0] old, logic [XLEN-1:0] wdata,
+                                            logic [XLEN/8-1:0] wstrb);
+    merge = old;
+    for (int i = 0; i < XLEN / 8; i++) begin
+      if (wstrb[i]) merge[8*i+:8] = wdata[8*i+:8];
+    end
+  endfunction
+
+  // Declare registers and their next states
+  logic [63:0] mtime_q, mtime_d;
+  logic [63:0] mtimecmp_q[NUM_HARTS], mtimecmp_d[NUM_HARTS];
+  logic [NUM_HARTS-1:0] msip_q, msip_d;
+
+  // Declare wires
+  logic [NUM_HARTS-1:0] wen;
+  logic [CLINT_ADDR_WIDTH-1:0] addr[NUM_HARTS];
+  logic [XLEN-1:0] wdata[NUM_HARTS];
+  logic [XLEN/8-1:0] wstrb[NUM_HARTS];
+  logic [XLEN-1:0] rdata[NUM_HARTS];
+
+  // Interface arrays can only be indexed by constants
+  for (genvar i = 0; i < NUM_HARTS; i++) begin : gen_port
+    assign wen[i] = clint_rsp_if[i].valid && clint_rsp_if[i].write;
+    assign addr[i] = {clint_rsp_if[i].addr[CLINT_ADDR_WIDTH-1:2], 2'b00};
+    assign wdata[i] = clint_rsp_if[i].wdata;
+    assign wstrb[i] = clint_rsp_if[i].wstrb;
+    assign clint_rsp_if[i].rdata = rdata[i];
+    assign clint_rsp_if[i].mtip = (mtime_q >= mtimecmp_q[i]);
+    assign clint_rsp_if[i].msip = msip_q[i];
+  end
+
+  always_comb begin
+    mtime_d = mtime_q + 64'(1) + skip;
+    mtimecmp_d = mtimecmp_q;
+    msip_d = msip_q;
+
+    // Read
+    for (int i = 0; i < NUM_HARTS; i++) begin
+      rdata[i] = '0;
+      for (int h = 0; h < NUM_HARTS; h++) begin
+        if (addr[i] == MSIP + CLINT_ADDR_WIDTH'(4 * h)) rdata[i] = XLEN'(msip_q[h]);
+        if (addr[i] == MTIMECMP + CLINT_ADDR_WIDTH'(8 * h)) rdata[i] = mtimecmp_q[h][31:0];
+        if (addr[i] == MTIMECMP + CLINT_ADDR_WIDTH'(8 * h + 4)) rdata[i] = mtimecmp_q[h][63:32];
+      end
+      if (addr[i] == MTIME) rdata[i] = mtime_q[31:0];
+      if (addr[i] == MTIME + CLINT_ADDR_WIDTH'(4)) rdata[i] = mtime_q[63:32];
+    end
+
+    // Write; when harts write the same register in one cycle, the highest one wins
+    for (int i = 0; i < NUM_HARTS; i++) begin
+      if (wen[i]) begin
+        for (int h = 0; h < NUM_HARTS; h++) begin
+          if (addr[i] == MSIP + CLINT_ADDR_WIDTH'(4 * h)) begin
+            if (wstrb[i][0]) msip_d[h] = wdata[i][0];
+          end
+          if (addr[i] == MTIMECMP + CLINT_ADDR_WIDTH'(8 * h)) begin
+            mtimecmp_d[h][31:0] = merge(mtimecmp_q[h][31:0], wdata[i], wstrb[i]);
+          end
+          if (addr[i] == MTIMECMP + CLINT_ADDR_WIDTH'(8 * h + 4)) begin
+            mtimecmp_d[h][63:32] = merge(mtimecmp_q[h][63:32], wdata[i], wstrb[i]);
+          end
+        end
+        if (addr[i] == MTIME) mtime_d[31:0] = merge(mtime_q[31:0], wdata[i], wstrb[i]);
+        if (addr[i] == MTIME + CLINT_ADDR_WIDTH'(4)) begin
+          mtime_d[63:32] = merge(mtime_q[63:32], wdata[i], wstrb[i]);
+        end
+      end
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      mtime_q <= '0;
+      mtimecmp_q <= '{default: '1};  // No timer interrupt until software sets one up
+      msip_q <= '0;
+    end else begin
+      mtime_q <= mtime_d;
+      mtimecmp_q <= mtimecmp_d;
+      msip_q <= msip_d;
+`ifndef OFFNARISCV_QUIET
+      for (int h = 0; h < NUM_HARTS; h++) begin
+        if (mtimecmp_d[h] != mtimecmp_q[h])
+          $write("CLINT: mtimecmp[%0d] updated to %0h\n", h, mtimecmp_d[h]);
+      end
+`endif
+    end
+  end
+
+endmodule
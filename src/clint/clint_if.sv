@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MIT
+
+// CLINT interface, one per hart. Registers are read and written a word at a
+// time; a read has no side effects, so `rdata` follows `addr` combinationally.
+interface clint_if;
+  import offnariscv_pkg::*;
+
+  logic valid;
+  logic write;
+  logic [CLINT_ADDR_WIDTH-1:0] addr;  // Offset from CLINT_BASE
+  logic [XLEN-1:0] wdata;
+  logic [XLEN/8-1:0] wstrb;
+  logic [XLEN-1:0] rdata;
+  logic mtip;  // Machine timer interrupt pending, for mip
+  logic msip;  // Machine software interrupt pending, for mip
+
+  // Request modport (hart side)
+  modport req(output valid, write, addr, wdata, wstrb, input rdata, mtip, msip);
+
+  // Response modport (CLINT side)
+  modport rsp(input valid, write, addr, wdata, wstrb, output rdata, mtip, msip);
+
+endinterface
@@ -7,30 +7,53 @@ module committer
     input logic clk,
     input logic rst,
 
-    axis_if.s exwb_axis_if,   // From EX FIFO (Dispatcher)
-    axis_if.s aluwb_axis_if,  // From ALU
+    axis_if.s exwb_axis_if,    // From EX FIFO (Dispatcher)
+    axis_if.s exwb1_axis_if,   // From EX FIFO (Dispatcher, second issue slot)
+    axis_if.s aluwb_axis_if,   // From ALU
+    axis_if.s aluwb1_axis_if,  // From ALU (second issue slot)
     axis_if.s bruwb_axis_if,  // From BRU
     axis_if.s syswb_axis_if,  // From System Unit
     axis_if.s lsuwb_axis_if,  // From LSU
     axis_if.m wbrf_axis_if,   // To Register File
+    axis_if.m wbrf1_axis_if,  // To Register File (second issue slot)
     axis_if.m wbpcg_axis_if,  // To Program Counter Generator
 
-    csr_wif.req wbcsr_wif  // For CSR write interface
+    csr_wif.req wbcsr_wif,  // For CSR write interface
+
+    output logic sfence  // SFENCE.VMA retires; flush the TLBs
 );
 
-  exwb_tdata_t exwb_tdata;
-  aluwb_tdata_t aluwb_tdata;
+  exwb_tdata_t exwb_tdata, exwb1_tdata;
+  aluwb_tdata_t aluwb_tdata, aluwb1_tdata;
   bruwb_tdata_t bruwb_tdata;
   syswb_tdata_t syswb_tdata;
   lsuwb_tdata_t lsuwb_tdata;
-  wbrf_tdata_t wbrf_tdata;
+  wbrf_tdata_t wbrf_tdata, wbrf1_tdata;
 
   trap_cause_t trap_cause;
   logic trap;
+  logic sys_trap;
+  logic lsu_trap;
+  logic commit;
+  logic bru_redirect;  // The outcome differs from what the decoder predicted
+  logic [XLEN-1:0] next_pc;
+  logic [XLEN-1:0] fused_pc;  // Address of the second instruction of a fused op
+  logic squash1;  // The first slot redirects or traps, so the younger second slot must not retire
+  logic redirect;  // The first slot changes the control flow by itself
+  logic irq;  // Take the pending interrupt right after the first slot retires
+  logic wfi_stall;  // A WFI waits at the head until an interrupt is pending
+
+`ifndef SYNTHESIS
+  // Retired instructions, counting both halves of a fused op, and fused ops
+  logic [63:0] retired_count_q, retired_count_d;
+  logic [63:0] fused_count_q, fused_count_d;
+`endif
 
   always_comb begin
     exwb_tdata = exwb_axis_if.tdata;
+    exwb1_tdata = exwb1_axis_if.tdata;
     aluwb_tdata = aluwb_axis_if.tdata;
+    aluwb1_tdata = aluwb1_axis_if.tdata;
     bruwb_tdata = bruwb_axis_if.tdata;
     syswb_tdata = syswb_axis_if.tdata;
     lsuwb_tdata = lsuwb_axis_if.tdata;
@@ -38,21 +61,34 @@ module committer
     // NOTE: Handling traps and interrupts in the system unit may not be enough,
     //       because an execution unit, such as LSU, can generate an exception.
     //       Therefore, handle them in this module.
-    trap_cause = syswb_tdata.trap_cause;  // TODO: Check the result of LSU
-    trap = syswb_tdata.trap;  // TODO
+    commit = exwb_axis_if.tvalid && exwb_axis_if.tready;
+    sys_trap = exwb_tdata.sys_cmd_vld && syswb_tdata.trap;
+    lsu_trap = exwb_tdata.lsu_cmd_vld && lsuwb_tdata.trap;
+    trap_cause = lsu_trap ? lsuwb_tdata.trap_cause : syswb_tdata.trap_cause;
+    trap = sys_trap || lsu_trap;
+    bru_redirect = bruwb_tdata.taken != exwb_tdata.pred_taken;
+    next_pc = seq_next_pc(exwb_tdata.pc, exwb_tdata.compressed, exwb_tdata.fused,
+                          exwb_tdata.fused_compressed);
+    // A fused op that traps has only its second instruction trap; the first
+    // one, which made the constant, retires
+    fused_pc = exwb_tdata.pc + (exwb_tdata.compressed ? XLEN'(2) : XLEN'(4));
+    // A faulting fetch also reaches here as a WFI, but it must trap right away
+    wfi_stall = exwb_axis_if.tvalid && exwb_tdata.sys_cmd_vld &&
+        (exwb_tdata.sys_cmd == WFI) &&
+        (exwb_tdata.trap_cause == '0) && !wbcsr_wif.wakeup;
 
     // wbrf_tdata.wdata = aluwb_tdata.result;
     unique case (1'b1)
-      exwb_tdata.rf_data.id_data.alu_cmd_vld: begin
+      exwb_tdata.alu_cmd_vld: begin
         wbrf_tdata.wdata = aluwb_tdata.result;
       end
-      exwb_tdata.rf_data.id_data.bru_cmd_vld: begin
+      exwb_tdata.bru_cmd_vld: begin
         wbrf_tdata.wdata = bruwb_tdata.result;
       end
-      exwb_tdata.rf_data.id_data.sys_cmd_vld: begin
-        wbrf_tdata.wdata = exwb_tdata.rf_data.csr_rdata;
+      exwb_tdata.sys_cmd_vld: begin
+        wbrf_tdata.wdata = exwb_tdata.csr_rdata;
       end
-      exwb_tdata.rf_data.id_data.lsu_cmd_vld: begin
+      exwb_tdata.lsu_cmd_vld: begin
         wbrf_tdata.wdata = lsuwb_tdata.result;
       end
       default: begin
@@ -60,42 +96,99 @@ module committer
     endcase
     wbrf_tdata.ex_data = exwb_tdata;
 
-    exwb_axis_if.tready = wbrf_axis_if.tready && ((!exwb_tdata.rf_data.id_data.alu_cmd_vld || aluwb_axis_if.tvalid) && 
-                                                  (!exwb_tdata.rf_data.id_data.bru_cmd_vld || (bruwb_axis_if.tvalid && (!bruwb_tdata.taken || wbpcg_axis_if.tready))) && 
-                                                  (!exwb_tdata.rf_data.id_data.sys_cmd_vld || (syswb_axis_if.tvalid && (!syswb_tdata.use_new_pc || wbpcg_axis_if.tready))) &&
-                                                  (!exwb_tdata.rf_data.id_data.lsu_cmd_vld || (lsuwb_axis_if.tvalid && (!lsuwb_tdata.trap || wbpcg_axis_if.tready))) && 
-                                                  (!exwb_tdata.rf_data.id_data.fence_i || (wbpcg_axis_if.tready))); // TODO
+    exwb_axis_if.tready = wbrf_axis_if.tready && ((!exwb_tdata.alu_cmd_vld || aluwb_axis_if.tvalid) && 
+                                                  (!exwb_tdata.bru_cmd_vld || (bruwb_axis_if.tvalid && (!bru_redirect || wbpcg_axis_if.tready))) && 
+                                                  (!exwb_tdata.sys_cmd_vld || (syswb_axis_if.tvalid && (!syswb_tdata.use_new_pc || wbpcg_axis_if.tready))) &&
+                                                  (!exwb_tdata.lsu_cmd_vld || (lsuwb_axis_if.tvalid && (!lsuwb_tdata.trap || wbpcg_axis_if.tready))) && 
+                                                  (!exwb_tdata.fence_i || (wbpcg_axis_if.tready)) &&
+                                                  !wfi_stall &&
+                                                  (!exwb1_axis_if.tvalid || (aluwb1_axis_if.tvalid && wbrf1_axis_if.tready))); // TODO
     aluwb_axis_if.tready = wbrf_axis_if.tready;
-    bruwb_axis_if.tready = wbrf_axis_if.tready && (!bruwb_tdata.taken || wbpcg_axis_if.tready);
+    bruwb_axis_if.tready = wbrf_axis_if.tready && (!bru_redirect || wbpcg_axis_if.tready);
     syswb_axis_if.tready = wbrf_axis_if.tready && (!syswb_tdata.use_new_pc || wbpcg_axis_if.tready);
     lsuwb_axis_if.tready = wbrf_axis_if.tready && (!lsuwb_tdata.trap || wbpcg_axis_if.tready);
 
-    if (exwb_tdata.rf_data.id_data.sys_cmd_vld && trap)
-      wbrf_tdata.ex_data.rf_data.id_data.rd = '0; // If a trap occurs, the destination register is not written
+    if (trap && exwb_tdata.fused) begin
+      wbrf_tdata.wdata = exwb_tdata.fused_rd_data;
+    end else if (trap) begin
+      wbrf_tdata.ex_data.rd = '0; // If a trap occurs, the destination register is not written
+    end
     wbrf_axis_if.tdata = wbrf_tdata;
     wbrf_axis_if.tvalid = exwb_axis_if.tvalid && exwb_axis_if.tready;
 
+    // Interrupts are taken between instructions: the one at the head retires,
+    // and the trap is entered with its successor in mepc. Instructions that
+    // redirect by themselves are left alone, so the interrupt waits for the
+    // next one; in particular, a CSR write that enables it takes effect first.
+    redirect = (exwb_tdata.bru_cmd_vld && bru_redirect) ||
+        (exwb_tdata.sys_cmd_vld && syswb_tdata.use_new_pc) || lsu_trap ||
+        exwb_tdata.fence_i;
+    irq = wbcsr_wif.interrupt && !redirect && wbpcg_axis_if.tready;
+
     // CSR
-    wbcsr_wif.addr = exwb_tdata.rf_data.id_data.csr_addr;
+    wbcsr_wif.addr = exwb_tdata.csr_addr;
     wbcsr_wif.data = syswb_tdata.csr_wdata;
-    wbcsr_wif.pc = exwb_tdata.rf_data.id_data.if_data.pcg_data.pc;
-    wbcsr_wif.cause = XLEN'(transform_cause(trap_cause));  // TODO: Support interrupts
-    wbcsr_wif.trap = trap;
-    wbcsr_wif.valid = syswb_axis_if.tvalid && (syswb_tdata.csr_update || trap);  // TODO
+    wbcsr_wif.pc = irq ? next_pc : exwb_tdata.fused ? fused_pc : exwb_tdata.pc;
+    wbcsr_wif.cause = irq ? wbcsr_wif.interrupt_cause : XLEN'(transform_cause(trap_cause));
+    wbcsr_wif.tval = irq ? '0 : lsu_trap ? lsuwb_tdata.tval :
+        (trap_cause[EXC_IPF] || trap_cause[EXC_IAF]) ? wbcsr_wif.pc : '0;
+    wbcsr_wif.trap = trap || irq;
+    wbcsr_wif.mret = exwb_tdata.sys_cmd_vld && (exwb_tdata.sys_cmd == MRET);
+    wbcsr_wif.sret = exwb_tdata.sys_cmd_vld && (exwb_tdata.sys_cmd == SRET);
+    wbcsr_wif.valid = commit && (trap || irq || (exwb_tdata.sys_cmd_vld &&
+                                                 (syswb_tdata.csr_update || wbcsr_wif.mret || wbcsr_wif.sret)));
+    sfence = commit && !trap && exwb_tdata.sys_cmd_vld &&
+        (exwb_tdata.sys_cmd == SFENCE_VMA);
 
     // Program Counter Generator
     wbpcg_axis_if.tdata = '0;
     case (1'b1)
-      exwb_tdata.rf_data.id_data.fence_i:
-      wbpcg_axis_if.tdata = exwb_tdata.rf_data.id_data.if_data.pcg_data.pc + 'd4;
+      trap, irq: wbpcg_axis_if.tdata = wbcsr_wif.tvec;
+      exwb_tdata.fence_i:
+      wbpcg_axis_if.tdata = next_pc;
       syswb_axis_if.tvalid && syswb_tdata.use_new_pc: wbpcg_axis_if.tdata = syswb_tdata.new_pc;
-      bruwb_tdata.taken: wbpcg_axis_if.tdata = bruwb_tdata.new_pc;
+      bru_redirect:
+      wbpcg_axis_if.tdata = bruwb_tdata.taken ? bruwb_tdata.new_pc : next_pc;
       default: begin
       end
     endcase
-    wbpcg_axis_if.tvalid = (exwb_axis_if.tvalid && exwb_axis_if.tready) && ((exwb_tdata.rf_data.id_data.bru_cmd_vld && bruwb_tdata.taken) || 
-                                                                            (exwb_tdata.rf_data.id_data.sys_cmd_vld && syswb_tdata.use_new_pc) ||
-                                                                            (exwb_tdata.rf_data.id_data.fence_i)); // TODO
+    wbpcg_axis_if.tvalid = (exwb_axis_if.tvalid && exwb_axis_if.tready) && (redirect || irq);
+
+    // Second issue slot: an ALU instruction that retires together with the
+    // first slot, in program order behind it. Traps stay precise because it
+    // is dropped, along with the rest of the pipeline, whenever the first
+    // slot changes the control flow.
+    squash1 = wbpcg_axis_if.tvalid ||
+        (exwb_tdata.lsu_cmd_vld && lsuwb_tdata.trap);
+    exwb1_axis_if.tready = exwb_axis_if.tready;
+    aluwb1_axis_if.tready = exwb_axis_if.tready;
+    wbrf1_tdata.wdata = aluwb1_tdata.result;
+    wbrf1_tdata.ex_data = exwb1_tdata;
+    wbrf1_axis_if.tdata = wbrf1_tdata;
+    wbrf1_axis_if.tvalid = exwb_axis_if.tvalid && exwb_axis_if.tready && exwb1_axis_if.tvalid && !squash1;
+
+`ifndef SYNTHESIS
+    // The first half of a fused op retires even when the second one traps
+    retired_count_d = retired_count_q;
+    fused_count_d = fused_count_q;
+    if (commit) begin
+      retired_count_d = retired_count_d + 64'(!trap) + 64'(exwb_tdata.fused);
+      fused_count_d = fused_count_q + 64'(exwb_tdata.fused && !trap);
+    end
+    if (wbrf1_axis_if.tvalid) retired_count_d = retired_count_d + 64'(1);
+`endif
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      retired_count_q <= '0;
+      fused_count_q <= '0;
+    end else begin
+      retired_count_q <= retired_count_d;
+      fused_count_q <= fused_count_d;
+    end
   end
+`endif
 
 endmodule
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+
+// Synchronous FIFO for AXI Stream interface that exposes its two oldest
+// entries. axis_mif_0 is the head and axis_mif_1 the entry behind it; a
+// handshake on axis_mif_1 only counts together with one on axis_mif_0, so the
+// consumer can take either the head alone or both at once, in order.
+module axis_pair_fifo #(
+    parameter DEPTH = 8  // 2**n
+) (
+    input logic clk,
+    input logic rst,
+
+    axis_if.m axis_mif_0,  // Manager (head)
+    axis_if.m axis_mif_1,  // Manager (next to the head)
+    axis_if.s axis_sif,    // Subordinate
+
+    input logic invalidate
+);
+
+  // Define local parameters
+  localparam TDATA_WIDTH = axis_sif.TDATA_WIDTH;
+  localparam ADDR_WIDTH = $clog2(DEPTH);
+
+  // Assert conditions
+  initial begin
+    assert (DEPTH >= 2 && DEPTH == 2 ** ADDR_WIDTH)
+    else $fatal("DEPTH must be a power of 2 greater than or equal to 2");
+    assert (TDATA_WIDTH == axis_mif_0.TDATA_WIDTH && TDATA_WIDTH == axis_mif_1.TDATA_WIDTH)
+    else $fatal("TDATA_WIDTH must match between manager and subordinate interfaces");
+  end
+
+  // Declare memory array
+  logic [TDATA_WIDTH-1:0] mem[DEPTH];
+
+  // Declare registers and their next states
+  logic [ADDR_WIDTH-1:0] wptr_q, wptr_d;
+  logic [ADDR_WIDTH-1:0] rptr_q, rptr_d;
+  logic [ADDR_WIDTH:0] count_q, count_d;
+
+  // Declare wires
+  logic push;
+  logic [1:0] pop;
+
+  // Wire assignments
+  assign axis_sif.tready = (count_q != (ADDR_WIDTH + 1)'(DEPTH));
+  assign axis_mif_0.tvalid = (count_q != '0);
+  assign axis_mif_0.tdata = mem[rptr_q];
+  assign axis_mif_1.tvalid = (count_q > (ADDR_WIDTH + 1)'(1));
+  assign axis_mif_1.tdata = mem[rptr_q+ADDR_WIDTH'(1)];
+
+  always_comb begin
+    push = axis_sif.tvalid && axis_sif.tready;
+    pop = '0;
+    if (axis_mif_0.tvalid && axis_mif_0.tready) begin
+      pop = (axis_mif_1.tvalid && axis_mif_1.tready) ? 2'd2 : 2'd1;
+    end
+
+    wptr_d = wptr_q + ADDR_WIDTH'(push);
+    rptr_d = rptr_q + ADDR_WIDTH'(pop);
+    count_d = count_q + (ADDR_WIDTH + 1)'(push) - (ADDR_WIDTH + 1)'(pop);
+  end
+
+  // Update registers
+  always_ff @(posedge clk) begin
+    if (rst || invalidate) begin
+      wptr_q  <= '0;
+      rptr_q  <= '0;
+      count_q <= '0;
+    end else begin
+      wptr_q  <= wptr_d;
+      rptr_q  <= rptr_d;
+      count_q <= count_d;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (push) mem[wptr_q] <= axis_sif.tdata;
+  end
+
+endmodule
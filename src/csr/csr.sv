@@ -2,7 +2,7 @@
 
 // Control and Status Register
 module csr
-  import offnariscv_pkg::*;
+  import riscv_pkg::*, offnariscv_pkg::*;
 #(
     parameter MHARTID = 0
 ) (
@@ -10,99 +10,272 @@ module csr
     input logic rst,
 
     csr_rif.rsp csr_rif_rsp,
-    csr_wif.rsp csr_wif_rsp
+    csr_wif.rsp csr_wif_rsp,
+    csr_pif.rsp csr_pif_rsp,
+
+    // From the CLINT
+    input logic mtip,
+    input logic msip
 );
 
+  // Define local parameters
+  localparam logic [XLEN-1:0] MEDELEG_MASK = XLEN'(16'hb3ff);  // ECALL from M-mode can't be delegated
+  localparam logic [XLEN-1:0] MIDELEG_MASK = XLEN'(12'h222);  // Supervisor interrupts
+  localparam logic [XLEN-1:0] MIE_MASK = XLEN'(12'h088);  // Only the CLINT raises interrupts
+
   // Declare registers and their next states
+  priv_e priv_q, priv_d;
   logic [XLEN-1:0] mvendorid_q, mvendorid_d;
   logic [XLEN-1:0] marchid_q, marchid_d;
   // logic [XLEN-1:0] mimpid_q; // TODO
   logic [XLEN-1:0] mhartid_q, mhartid_d;
-  // mstatus_t mstatus_q, mstatus_d; // TODO
+  mstatus_t mstatus_q, mstatus_d;
   logic [XLEN-1:0] misa_q, misa_d;
-  // logic [XLEN-1:0] medeleg_q, medeleg_d; // TODO
-  // logic [XLEN-1:0] mideleg_q, mideleg_d; // TODO
-  // logic [XLEN-1:0] mie_q, mie_d; // TODO
+  logic [XLEN-1:0] medeleg_q, medeleg_d;
+  logic [XLEN-1:0] mideleg_q, mideleg_d;
+  logic [XLEN-1:0] mie_q, mie_d;
   logic [XLEN-1:0] mtvec_q, mtvec_d;
   // mstatush_t mstatush_q, mstatush_d; // TODO
   // logic [XLEN-1:0] medelegh_q, medelegh_d; // TODO
+  logic [XLEN-1:0] mscratch_q, mscratch_d;
   logic [XLEN-1:0] mepc_q, mepc_d;
   logic [XLEN-1:0] mcause_q, mcause_d;
+  logic [XLEN-1:0] mtval_q, mtval_d;
+  logic menvcfg_adue_q, menvcfg_adue_d;  // menvcfg[61]
+  logic [XLEN-1:0] stvec_q, stvec_d;
+  logic [XLEN-1:0] sscratch_q, sscratch_d;
+  logic [XLEN-1:0] sepc_q, sepc_d;
+  logic [XLEN-1:0] scause_q, scause_d;
+  logic [XLEN-1:0] stval_q, stval_d;
+  satp_t satp_q, satp_d;
+
+  // Declare wires
+  mstatus_t sstatus;  // Restricted view of mstatus
+  logic delegate;  // The trap being taken goes to S-mode
+  logic [XLEN-1:0] mip;
+  logic [XLEN-1:0] pending;  // Pending and enabled in mie
 
   always_comb begin
+    priv_d = priv_q;
     misa_d = misa_q;
     mvendorid_d = mvendorid_q;
     marchid_d = marchid_q;
     mhartid_d = mhartid_q;
+    mstatus_d = mstatus_q;
+    medeleg_d = medeleg_q;
+    mideleg_d = mideleg_q;
+    mie_d = mie_q;
     mtvec_d = mtvec_q;
+    mscratch_d = mscratch_q;
     mepc_d = mepc_q;
     mcause_d = mcause_q;
+    mtval_d = mtval_q;
+    menvcfg_adue_d = menvcfg_adue_q;
+    stvec_d = stvec_q;
+    sscratch_d = sscratch_q;
+    sepc_d = sepc_q;
+    scause_d = scause_q;
+    stval_d = stval_q;
+    satp_d = satp_q;
+
+    sstatus = '0;
+    sstatus.sie = mstatus_q.sie;
+    sstatus.spie = mstatus_q.spie;
+    sstatus.spp = mstatus_q.spp;
+    sstatus.sum = mstatus_q.sum;
+    sstatus.mxr = mstatus_q.mxr;
+
+    mip = '0;
+    mip[INT_MSI] = msip;
+    mip[INT_MTI] = mtip;
 
     // Read CSR
     csr_rif_rsp.rdata = '0;
-    csr_rif_rsp.mtvec = mtvec_q;
-    csr_rif_rsp.mepc = mepc_q;
+    csr_rif_rsp.mepc = {mepc_q[XLEN-1:1], 1'b0};  // MRET target
+    csr_rif_rsp.sepc = {sepc_q[XLEN-1:1], 1'b0};  // SRET target
+    csr_rif_rsp.priv = priv_q;
     csr_rif_rsp.ro = (csr_rif_rsp.addr[11:10] == 2'b11);
-    csr_rif_rsp.exception = '0; // TODO: This would be used for illegal CSR access, such as privilege level violations
+    csr_rif_rsp.exception = (csr_rif_rsp.addr[9:8] > priv_q);  // Privilege level violation
     unique case (csr_rif_rsp.addr)
+      12'h100: csr_rif_rsp.rdata = sstatus;
+      12'h105: csr_rif_rsp.rdata = stvec_q;
+      12'h140: csr_rif_rsp.rdata = sscratch_q;
+      12'h141: csr_rif_rsp.rdata = {sepc_q[XLEN-1:1], 1'b0};
+      12'h142: csr_rif_rsp.rdata = scause_q;
+      12'h143: csr_rif_rsp.rdata = stval_q;
+      12'h180: csr_rif_rsp.rdata = satp_q;
       12'hf11: csr_rif_rsp.rdata = mvendorid_q;
       12'hf12: csr_rif_rsp.rdata = marchid_q;
       // 12'hf13: csr_rif_rsp.rdata = mimpid_q; // TODO
       12'hf14: csr_rif_rsp.rdata = mhartid_q;
-      // 12'h300: csr_rif_rsp.rdata = mstatus_q; // TODO
+      12'h300: csr_rif_rsp.rdata = mstatus_q;
       12'h301: csr_rif_rsp.rdata = misa_q;
-      // 12'h302: csr_rif_rsp.rdata = medeleg_q; // TODO
-      // 12'h303: csr_rif_rsp.rdata = mideleg_q; // TODO
-      // 12'h304: csr_rif_rsp.rdata = mie_q; // TODO
+      12'h302: csr_rif_rsp.rdata = medeleg_q;
+      12'h303: csr_rif_rsp.rdata = mideleg_q;
+      12'h304: csr_rif_rsp.rdata = mie_q;
       12'h305: csr_rif_rsp.rdata = mtvec_q;
+      // menvcfg (lower half): CBZE, CBCFE and CBIE are read-only, so the
+      // CBOs are always enabled, and cbo.inval flushes (CBIE = 01)
+      12'h30a: csr_rif_rsp.rdata = 32'h0000_00d0;
       // 12'h310: csr_rif_rsp.rdata = mstatush_q; // TODO
       // 12'h312: csr_rif_rsp.rdata = medelegh_q; // TODO
-      12'h341: csr_rif_rsp.rdata = {mepc_q[XLEN-1:2], 2'b00};  // IALIGN = 32
+      12'h31a: csr_rif_rsp.rdata = {2'b0, menvcfg_adue_q, 29'b0};  // menvcfgh
+      12'h340: csr_rif_rsp.rdata = mscratch_q;
+      12'h341: csr_rif_rsp.rdata = {mepc_q[XLEN-1:1], 1'b0};  // IALIGN = 16
       12'h342: csr_rif_rsp.rdata = mcause_q;
+      12'h343: csr_rif_rsp.rdata = mtval_q;
+      12'h344: csr_rif_rsp.rdata = mip;
       default: begin
       end
     endcase
 
+    // Interrupts. Machine interrupts are taken in M-mode only if mstatus.MIE
+    // is set, and always below it; MSI has priority over MTI.
+    pending = mip & mie_q;
+    csr_wif_rsp.wakeup = |pending;
+    csr_wif_rsp.interrupt = |pending && ((priv_q != PRIV_M) || mstatus_q.mie);
+    csr_wif_rsp.interrupt_cause = {1'b1, (XLEN - 1)'(pending[INT_MSI] ? INT_MSI : INT_MTI)};
+
+    // Trap vector; traps raised below M-mode go to S-mode if delegated
+    delegate = (priv_q != PRIV_M) &&
+        (csr_wif_rsp.cause[XLEN-1] ? mideleg_q[csr_wif_rsp.cause[INT_CODES_WIDTH-1:0]] :
+                                     medeleg_q[csr_wif_rsp.cause[EXC_CODES_WIDTH-1:0]]);
+    csr_wif_rsp.tvec = delegate ? {stvec_q[XLEN-1:2], 2'b0} : {mtvec_q[XLEN-1:2], 2'b0};
+
     // Write CSR
     if (csr_wif_rsp.valid) begin
       if (csr_wif_rsp.trap) begin
-        mepc_d   = csr_wif_rsp.pc;
-        mcause_d = csr_wif_rsp.cause;
+        if (delegate) begin
+          sepc_d = csr_wif_rsp.pc;
+          scause_d = csr_wif_rsp.cause;
+          stval_d = csr_wif_rsp.tval;
+          mstatus_d.spp = priv_q[0];
+          mstatus_d.spie = mstatus_q.sie;
+          mstatus_d.sie = 1'b0;
+          priv_d = PRIV_S;
+        end else begin
+          mepc_d = csr_wif_rsp.pc;
+          mcause_d = csr_wif_rsp.cause;
+          mtval_d = csr_wif_rsp.tval;
+          mstatus_d.mpp = priv_q;
+          mstatus_d.mpie = mstatus_q.mie;
+          mstatus_d.mie = 1'b0;
+          priv_d = PRIV_M;
+        end
+      end else if (csr_wif_rsp.mret) begin
+        priv_d = priv_e'(mstatus_q.mpp);
+        mstatus_d.mie = mstatus_q.mpie;
+        mstatus_d.mpie = 1'b1;
+        mstatus_d.mpp = PRIV_U;
+        if (priv_e'(mstatus_q.mpp) != PRIV_M) mstatus_d.mprv = 1'b0;
+      end else if (csr_wif_rsp.sret) begin
+        priv_d = mstatus_q.spp ? PRIV_S : PRIV_U;
+        mstatus_d.sie = mstatus_q.spie;
+        mstatus_d.spie = 1'b1;
+        mstatus_d.spp = 1'b0;
+        mstatus_d.mprv = 1'b0;
       end else begin
         unique case (csr_wif_rsp.addr)
+          12'h100: begin
+            mstatus_d.sie = csr_wif_rsp.data[1];
+            mstatus_d.spie = csr_wif_rsp.data[5];
+            mstatus_d.spp = csr_wif_rsp.data[8];
+            mstatus_d.sum = csr_wif_rsp.data[18];
+            mstatus_d.mxr = csr_wif_rsp.data[19];
+          end
+          12'h105: stvec_d[XLEN-1:2] = csr_wif_rsp.data[XLEN-1:2];  // Direct mode
+          12'h140: sscratch_d = csr_wif_rsp.data;
+          12'h141: sepc_d = csr_wif_rsp.data;
+          12'h142: scause_d = csr_wif_rsp.data;
+          12'h143: stval_d = csr_wif_rsp.data;
+          12'h180: satp_d = csr_wif_rsp.data;
+          12'h300: begin
+            mstatus_d.sie = csr_wif_rsp.data[1];
+            mstatus_d.mie = csr_wif_rsp.data[3];
+            mstatus_d.spie = csr_wif_rsp.data[5];
+            mstatus_d.mpie = csr_wif_rsp.data[7];
+            mstatus_d.spp = csr_wif_rsp.data[8];
+            if (csr_wif_rsp.data[12:11] != 2'b10) mstatus_d.mpp = csr_wif_rsp.data[12:11];  // WARL
+            mstatus_d.mprv = csr_wif_rsp.data[17];
+            mstatus_d.sum = csr_wif_rsp.data[18];
+            mstatus_d.mxr = csr_wif_rsp.data[19];
+          end
+          12'h302: medeleg_d = csr_wif_rsp.data & MEDELEG_MASK;
+          12'h303: mideleg_d = csr_wif_rsp.data & MIDELEG_MASK;
+          12'h304: mie_d = csr_wif_rsp.data & MIE_MASK;
           12'h305: mtvec_d[XLEN-1:2] = csr_wif_rsp.data[XLEN-1:2];  // Direct mode
+          12'h31a: menvcfg_adue_d = csr_wif_rsp.data[29];
+          12'h340: mscratch_d = csr_wif_rsp.data;
           12'h341: mepc_d = csr_wif_rsp.data;
           12'h342: mcause_d = csr_wif_rsp.data;
+          12'h343: mtval_d = csr_wif_rsp.data;
           default: begin
             // TODO: Handle other CSRs
           end
         endcase
       end
     end
+
+    // Address translation
+    csr_pif_rsp.priv = priv_q;
+    csr_pif_rsp.ls_priv = mstatus_q.mprv ? priv_e'(mstatus_q.mpp) : priv_q;
+    csr_pif_rsp.satp = satp_q;
+    csr_pif_rsp.sum = mstatus_q.sum;
+    csr_pif_rsp.mxr = mstatus_q.mxr;
+    csr_pif_rsp.adue = menvcfg_adue_q;
   end
 
   always_ff @(posedge clk) begin
     if (rst) begin
-      misa_q <= {2'd2, (XLEN - 28)'(0), 26'(2 ** 8)};  // RV32I
+      priv_q <= PRIV_M;
+      misa_q <= {2'd2, (XLEN - 28)'(0), 26'(2 ** 20 | 2 ** 18 | 2 ** 8 | 2 ** 2)};  // RV32ICSU
       mvendorid_q <= '0;  // Non-commercial implementation
       marchid_q <= '0;  // Not assigned yet
       mhartid_q <= MHARTID;
-      // mstatus_q <= '0; // TODO
+      mstatus_q <= '0;
       // mstatush_q <= '0; // TODO
+      medeleg_q <= '0;
+      mideleg_q <= '0;
+      mie_q <= '0;
       mtvec_q <= '0;  // Direct mode
+      mscratch_q <= '0;
       mepc_q <= '0;
       mcause_q <= '0;
+      mtval_q <= '0;
+      menvcfg_adue_q <= '0;
+      stvec_q <= '0;
+      sscratch_q <= '0;
+      sepc_q <= '0;
+      scause_q <= '0;
+      stval_q <= '0;
+      satp_q <= '0;  // Bare
     end else begin
+      priv_q <= priv_d;
       misa_q <= misa_d;
       mvendorid_q <= mvendorid_d;
       marchid_q <= marchid_d;
       mhartid_q <= mhartid_d;
-      // mstatus_q <= mstatus_d;
+      mstatus_q <= mstatus_d;
       // mstatush_q <= mstatush_d;
+      medeleg_q <= medeleg_d;
+      mideleg_q <= mideleg_d;
+      mie_q <= mie_d;
       mtvec_q <= mtvec_d;
+      mscratch_q <= mscratch_d;
       mepc_q <= mepc_d;
       mcause_q <= mcause_d;
+      mtval_q <= mtval_d;
+      menvcfg_adue_q <= menvcfg_adue_d;
+      stvec_q <= stvec_d;
+      sscratch_q <= sscratch_d;
+      sepc_q <= sepc_d;
+      scause_q <= scause_d;
+      stval_q <= stval_d;
+      satp_q <= satp_d;
+`ifndef OFFNARISCV_QUIET
       if (mepc_d != mepc_q) $write("CSR: mepc updated to %0h from %0h\n", mepc_d, mepc_q);
+      if (priv_d != priv_q) $write("CSR: privilege level changed to %0d from %0d\n", priv_d, priv_q);
+`endif
     end
   end
 
@@ -2,20 +2,21 @@
 
 // CSR Read Interface
 interface csr_rif;
-  import offnariscv_pkg::*;
+  import riscv_pkg::*, offnariscv_pkg::*;
 
   logic [11:0] addr;
   logic [XLEN-1:0] rdata;
-  logic [XLEN-1:0] mtvec;
   logic [XLEN-1:0] mepc;
+  logic [XLEN-1:0] sepc;
+  priv_e priv;
   logic ro;  // Read-only flag
   logic exception;
 
   // Request modport
-  modport req(output addr, input rdata, mtvec, mepc, ro, exception);
+  modport req(output addr, input rdata, mepc, sepc, priv, ro, exception);
 
   // Response modport
-  modport rsp(input addr, output rdata, mtvec, mepc, ro, exception);
+  modport rsp(input addr, output rdata, mepc, sepc, priv, ro, exception);
 
 endinterface
 
@@ -27,15 +28,41 @@ interface csr_wif;
   logic [XLEN-1:0] data;
   logic [XLEN-1:0] pc;
   logic [XLEN-1:0] cause;
+  logic [XLEN-1:0] tval;
   logic trap;
+  logic mret;
+  logic sret;
   logic valid;
+  logic [XLEN-1:0] tvec;  // Trap vector for `cause` at the current privilege level
+  logic interrupt;  // An interrupt is pending, enabled and not masked by the privilege level
+  logic [XLEN-1:0] interrupt_cause;
+  logic wakeup;  // An interrupt is pending and enabled in mie, which ends WFI
 
   // Request modport
-  modport req(output addr, data, pc, cause, trap, valid);
+  modport req(output addr, data, pc, cause, tval, trap, mret, sret, valid,
+              input tvec, interrupt, interrupt_cause, wakeup);
 
   // Response modport
-  modport rsp(input addr, data, pc, cause, trap, valid);
+  modport rsp(input addr, data, pc, cause, tval, trap, mret, sret, valid,
+              output tvec, interrupt, interrupt_cause, wakeup);
 
 endinterface
 
-// TODO: Add interface for IFU that reads privilege-related CSRs
+// CSR Privilege Interface, for address translation in the IFU, LSU and page-table walker
+interface csr_pif;
+  import riscv_pkg::*;
+
+  priv_e priv;  // For instruction fetch
+  priv_e ls_priv;  // For loads and stores, with MPRV applied
+  satp_t satp;
+  logic sum;
+  logic mxr;
+  logic adue;  // Svadu: hardware updates A/D bits instead of raising page faults (Svade)
+
+  // Request modport
+  modport req(input priv, ls_priv, satp, sum, mxr, adue);
+
+  // Response modport
+  modport rsp(output priv, ls_priv, satp, sum, mxr, adue);
+
+endinterface
@@ -1,20 +1,31 @@
 // SPDX-License-Identifier: MIT
 
-// Instruction decoder module for RV32I
+// Instruction decoder module for RV32I, with RV32C expanded ahead of it
 module decoder
   import riscv_pkg::*, offnariscv_pkg::*;
 #(
-    parameter FIFO_DEPTH = 9 // Greater than the block size should be better, because IFU can continue fetching instructions
+    parameter FIFO_DEPTH = 9, // Greater than the block size should be better, because IFU can continue fetching instructions
+    parameter ISSUE_WIDTH = 1,
+    parameter FUSION = 1  // Fuse adjacent instruction pairs at the FIFO output
 ) (
     input logic clk,
     input logic rst,
 
-    axis_if.s ifid_axis_if,  // From IFU
-    axis_if.m idrf_axis_if,  // To Register File
+    axis_if.s ifid_axis_if,   // From IFU
+    axis_if.m idrf_axis_if,   // To Register File
+    axis_if.m idrf1_axis_if,  // To Register File (second issue slot)
+    axis_if.m idpcg_axis_if,  // To Program Counter Generator (front-end redirect)
 
+    input logic loop_taken,  // From the loop buffer: the branch at ifid_axis_if closes a loop
     input logic invalidate
 );
 
+  // Assert conditions
+  initial begin
+    assert (ISSUE_WIDTH == 1 || ISSUE_WIDTH == 2)
+    else $fatal("ISSUE_WIDTH must be 1 or 2");
+  end
+
   // Define types
   typedef struct packed {
     logic [6:0] funct7;
@@ -79,20 +90,39 @@ module decoder
 
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(idrf_tdata_t))) idrf_fifo_if ();
-  axis_if #(.TDATA_WIDTH(5)) prev_rd_sif ();
-  axis_if #(.TDATA_WIDTH(5)) prev_rd_mif ();
+  axis_if #(.TDATA_WIDTH($bits(idrf_tdata_t))) head_if ();  // Oldest FIFO entry
+  axis_if #(.TDATA_WIDTH($bits(idrf_tdata_t))) next_if ();  // The entry behind it
+
+  // Declare registers and their next states
+  // Value of the register written by the previously decoded instruction, if
+  // it is known at decode time (LUI, AUIPC and the link register of JAL)
+  logic known_vld_q, known_vld_d;
+  logic [4:0] known_rd_q, known_rd_d;
+  logic [XLEN-1:0] known_val_q, known_val_d;
+
+`ifndef SYNTHESIS
+  // What the payloads past this stage leave behind, looked up by their tag
+  logic [INST_TAG_WIDTH-1:0] tag_q, tag_d;
+  inst_info_t inst_info_mem[2**INST_TAG_WIDTH];
+`endif
 
   // Declare wires
   ifid_tdata_t ifid_tdata;
   idrf_tdata_t idrf_tdata;
+  logic [31:0] expanded;
   inst_u inst;
   opcode_e opcode;
   logic rtype, itype, stype, btype, utype, jtype;
+  logic ifid_ack;
+  logic redirect;
+  logic [XLEN-1:0] redirect_pc;
+  logic [XLEN-1:0] seq_pc;  // Actual fall-through address
+  logic [XLEN-1:0] next_pc;  // Where the front end must have gone after this instruction
 
   always_comb begin
     ifid_tdata = ifid_axis_if.tdata;
 
-    inst = ifid_tdata.inst;
+    inst = ifid_tdata.compressed ? expanded : ifid_tdata.inst;
     opcode = opcode_e'(inst[6:2]);  // TODO: Check if inst[1:0]==2'b11
     rtype = opcode inside {AMO, OP};
     itype = opcode inside {LOAD, OP_IMM, JALR};
@@ -148,7 +178,8 @@ module decoder
     idrf_tdata.alu_cmd_vld = opcode inside {OP_IMM, AUIPC, OP, LUI};
     idrf_tdata.bru_cmd_vld = opcode inside {BRANCH, JAL, JALR};
     idrf_tdata.sys_cmd_vld = opcode inside {SYSTEM};
-    idrf_tdata.lsu_cmd_vld = opcode inside {LOAD, STORE};  // TODO: AMO
+    idrf_tdata.lsu_cmd_vld = (opcode inside {LOAD, STORE, AMO}) ||
+        ((opcode == MISC_MEM) && (inst.i.funct3 == 3'b010));  // CBO
     idrf_tdata.alu_cmd = ADD;  // TODO
     idrf_tdata.bru_cmd = BRU_JAL;  // TODO
     idrf_tdata.sys_cmd = CSRRW;  // TODO
@@ -157,6 +188,70 @@ module decoder
       idrf_tdata.alu_cmd_vld: begin
         if (opcode inside {AUIPC, LUI}) begin
           idrf_tdata.alu_cmd = ADD;
+        end else if ((opcode == OP) && (inst.r.funct7 == 7'b0010000)) begin
+          // Zba
+          unique case (inst.r.funct3)
+            3'b010: idrf_tdata.alu_cmd = SH1ADD;
+            3'b100: idrf_tdata.alu_cmd = SH2ADD;
+            3'b110: idrf_tdata.alu_cmd = SH3ADD;
+            default: begin
+              // Invalid instruction, raise an exception
+            end
+          endcase
+        end else if ((opcode == OP) && (inst.r.funct7 == 7'b0000101)) begin
+          unique case (inst.r.funct3)
+            3'b100: idrf_tdata.alu_cmd = MIN;
+            3'b101: idrf_tdata.alu_cmd = MINU;
+            3'b110: idrf_tdata.alu_cmd = MAX;
+            3'b111: idrf_tdata.alu_cmd = MAXU;
+            default: begin
+              // Invalid instruction, raise an exception
+            end
+          endcase
+        end else if ((opcode == OP) && (inst.r.funct7 == 7'b0000100)) begin
+          // zext.h is the pack encoding with rs2 = x0; the rest of the space is not implemented
+          if ((inst.r.funct3 == 3'b100) && (inst.r.rs2 == '0)) begin
+            idrf_tdata.alu_cmd = ZEXTH;
+          end else begin
+            // Invalid instruction, raise an exception
+          end
+        end else if ((opcode == OP) && (inst.r.funct7 == 7'b0100000) && inst.r.funct3[2]) begin
+          unique case (inst.r.funct3)
+            3'b100: idrf_tdata.alu_cmd = XNOR;
+            3'b101: idrf_tdata.alu_cmd = SRA;
+            3'b110: idrf_tdata.alu_cmd = ORN;
+            3'b111: idrf_tdata.alu_cmd = ANDN;
+            default: begin
+            end
+          endcase
+        end else if ((inst.r.funct7 == 7'b0110000) && (inst.r.funct3 inside {3'b001, 3'b101})) begin
+          // Rotates and unary operations; the unary ones are OP-IMM with rs2
+          // selecting the operation
+          unique case (inst.r.funct3)
+            3'b001: begin
+              if (opcode == OP) begin
+                idrf_tdata.alu_cmd = ROL;
+              end else begin
+                unique case (inst.r.rs2)
+                  5'b00000: idrf_tdata.alu_cmd = CLZ;
+                  5'b00001: idrf_tdata.alu_cmd = CTZ;
+                  5'b00010: idrf_tdata.alu_cmd = CPOP;
+                  5'b00100: idrf_tdata.alu_cmd = SEXTB;
+                  5'b00101: idrf_tdata.alu_cmd = SEXTH;
+                  default: begin
+                    // Invalid instruction, raise an exception
+                  end
+                endcase
+              end
+            end
+            3'b101: idrf_tdata.alu_cmd = ROR;  // ror, rori
+            default: begin
+              // Invalid instruction, raise an exception
+            end
+          endcase
+        end else if ((opcode == OP_IMM) && (inst.r.funct3 == 3'b101) &&
+                     (inst.i.imm_11_0 inside {12'h287, 12'h698})) begin
+          idrf_tdata.alu_cmd = (inst.i.imm_11_0 == 12'h287) ? ORCB : REV8;
         end else begin
           unique case (inst.r.funct3)
             3'b000: idrf_tdata.alu_cmd = (inst[30] && (opcode == OP)) ? SUB : ADD;
@@ -274,6 +369,41 @@ module decoder
             idrf_tdata.rs1 = inst.s.rs1;
             idrf_tdata.rs2 = inst.s.rs2;
           end
+          AMO: begin
+            // aq/rl need nothing more: the LSU performs one access at a time, in program order
+            unique case (inst.r.funct7[6:2])
+              5'b00010: begin
+                idrf_tdata.lsu_cmd = LSU_LR;
+                idrf_tdata.rs2 = '0;
+              end
+              5'b00011: idrf_tdata.lsu_cmd = LSU_SC;
+              5'b00001: idrf_tdata.lsu_cmd = LSU_AMOSWAP;
+              5'b00000: idrf_tdata.lsu_cmd = LSU_AMOADD;
+              5'b00100: idrf_tdata.lsu_cmd = LSU_AMOXOR;
+              5'b01100: idrf_tdata.lsu_cmd = LSU_AMOAND;
+              5'b01000: idrf_tdata.lsu_cmd = LSU_AMOOR;
+              5'b10000: idrf_tdata.lsu_cmd = LSU_AMOMIN;
+              5'b10100: idrf_tdata.lsu_cmd = LSU_AMOMAX;
+              5'b11000: idrf_tdata.lsu_cmd = LSU_AMOMINU;
+              5'b11100: idrf_tdata.lsu_cmd = LSU_AMOMAXU;
+              default: begin
+                // Invalid instruction, raise an exception
+              end
+            endcase
+          end
+          MISC_MEM: begin
+            // The address is rs1 itself; the immediate selects the operation
+            unique case (inst.i.imm_11_0)
+              12'h000: idrf_tdata.lsu_cmd = LSU_CBO_INVAL;
+              12'h001: idrf_tdata.lsu_cmd = LSU_CBO_CLEAN;
+              12'h002: idrf_tdata.lsu_cmd = LSU_CBO_FLUSH;
+              12'h004: idrf_tdata.lsu_cmd = LSU_CBO_ZERO;
+              default: begin
+                // Invalid instruction, raise an exception
+              end
+            endcase
+            idrf_tdata.rs1 = inst.i.rs1;
+          end
           default: begin
             // Invalid instruction, raise an exception
           end
@@ -284,44 +414,238 @@ module decoder
     endcase
     idrf_tdata.csr_addr = inst[31:20];
 
-    // Forwarding information
+    // Forwarding information; `rf` marks the operand as read here, and the
+    // register file resolves both flags against its scoreboard
     idrf_tdata.fwd_rs1.rf = (idrf_tdata.rs1 != '0);
-    idrf_tdata.fwd_rs1.ex = (idrf_tdata.rs1 != '0) && (prev_rd_mif.tvalid && (idrf_tdata.rs1 == prev_rd_mif.tdata));
+    idrf_tdata.fwd_rs1.ex = 1'b0;
     idrf_tdata.fwd_rs2.rf = (idrf_tdata.rs2 != '0);
-    idrf_tdata.fwd_rs2.ex = (idrf_tdata.rs2 != '0) && (prev_rd_mif.tvalid && (idrf_tdata.rs2 == prev_rd_mif.tdata));
+    idrf_tdata.fwd_rs2.ex = 1'b0;
 
     // MISC-MEM
     idrf_tdata.fence_i = (opcode == MISC_MEM) && (inst.i.funct3 == 3'b001) && (inst.i.rs1 == '0) && (inst.i.rd == '0) && (inst.i.imm_11_0 == '0);
 
-    idrf_tdata.if_data = ifid_tdata;
+    // A faulting fetch carries no instruction; send it to the system unit as
+    // a no-op so that the trap is taken in order
+    if (ifid_tdata.trap_cause != '0) begin
+      idrf_tdata.alu_cmd_vld = 1'b0;
+      idrf_tdata.bru_cmd_vld = 1'b0;
+      idrf_tdata.lsu_cmd_vld = 1'b0;
+      idrf_tdata.sys_cmd_vld = 1'b1;
+      idrf_tdata.sys_cmd = WFI;
+      idrf_tdata.rs1 = '0;
+      idrf_tdata.rs2 = '0;
+      idrf_tdata.rd = '0;
+      idrf_tdata.fwd_rs1.rf = 1'b0;
+      idrf_tdata.fwd_rs2.rf = 1'b0;
+      idrf_tdata.fence_i = 1'b0;
+    end
+
+    idrf_tdata.pc = ifid_tdata.pcg_data.pc;
+    idrf_tdata.compressed = ifid_tdata.compressed;
+    idrf_tdata.trap_cause = ifid_tdata.trap_cause;
+    idrf_tdata.fused = 1'b0;
+    idrf_tdata.fused_compressed = 1'b0;
+    idrf_tdata.fused_rd_data = '0;
+    idrf_tdata.fused_shamt = '0;
+
+    // Front-end redirect for jumps whose target is already known, for
+    // branches the loop buffer predicts taken, and for fall-throughs that the
+    // PC generator predicted with the wrong length. Nothing is redirected if
+    // the PC generator already went there, as it does inside a replayed loop.
+    ifid_ack = ifid_axis_if.tvalid && ifid_axis_if.tready;
+    seq_pc = ifid_tdata.pcg_data.pc + (ifid_tdata.compressed ? XLEN'(2) : XLEN'(4));
+    redirect = 1'b0;
+    redirect_pc = ifid_tdata.pcg_data.pc + idrf_tdata.immediate;
+    if (ifid_tdata.trap_cause == '0) begin
+      unique case (opcode)
+        JAL: redirect = 1'b1;
+        JALR: begin
+          if (inst.i.rs1 == '0) begin
+            redirect = 1'b1;
+            redirect_pc = idrf_tdata.immediate & ~XLEN'(1);
+          end else if (known_vld_q && (inst.i.rs1 == known_rd_q)) begin
+            redirect = 1'b1;
+            redirect_pc = (known_val_q + idrf_tdata.immediate) & ~XLEN'(1);
+          end
+        end
+        BRANCH: redirect = loop_taken;
+        default: begin
+        end
+      endcase
+    end
+    idrf_tdata.pred_taken = redirect;
+
+    next_pc = redirect ? redirect_pc : seq_pc;
+    idpcg_axis_if.tdata = next_pc;
+    idpcg_axis_if.tvalid = ifid_ack && (ifid_tdata.trap_cause == '0) &&
+        (ifid_tdata.pcg_data.untaken_pc != next_pc);
+
+    known_vld_d = known_vld_q;
+    known_rd_d = known_rd_q;
+    known_val_d = known_val_q;
+    if (invalidate) begin
+      known_vld_d = 1'b0;
+    end else if (ifid_ack) begin
+      known_vld_d = (opcode inside {LUI, AUIPC, JAL}) && (idrf_tdata.rd != '0) &&
+          (ifid_tdata.trap_cause == '0);
+      known_rd_d = idrf_tdata.rd;
+      unique case (opcode)
+        LUI: known_val_d = idrf_tdata.immediate;
+        AUIPC: known_val_d = ifid_tdata.pcg_data.pc + idrf_tdata.immediate;
+        default: known_val_d = seq_pc;  // JAL
+      endcase
+    end
+
+`ifndef SYNTHESIS
+    idrf_tdata.tag = tag_q;
+    tag_d = tag_q + INST_TAG_WIDTH'(ifid_ack);
+`endif
 
     // FIFO connection
     idrf_fifo_if.tdata = idrf_tdata;
     idrf_fifo_if.tvalid = ifid_axis_if.tvalid;
     ifid_axis_if.tready = idrf_fifo_if.tready;
+  end
 
-    prev_rd_sif.tdata = idrf_tdata.rd;
-    prev_rd_sif.tvalid = idrf_fifo_if.tvalid && idrf_fifo_if.tready && (idrf_tdata.rd != '0);
-    prev_rd_mif.tready = ifid_axis_if.tvalid && ifid_axis_if.tready;
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      tag_q <= '0;
+    end else begin
+      tag_q <= tag_d;
+    end
   end
 
-  // Instantiate FIFO
-  axis_sync_fifo #(
-      .DEPTH(FIFO_DEPTH)
-  ) idrf_fifo (
-      .clk(clk),
-      .rst(rst),
-      .axis_mif(idrf_axis_if),
-      .axis_sif(idrf_fifo_if),
-      .invalidate(invalidate)
-  );
+  always_ff @(posedge clk) begin
+    if (ifid_ack) begin
+      inst_info_mem[tag_q].pc <= ifid_tdata.pcg_data.pc;
+      inst_info_mem[tag_q].inst <= ifid_tdata.inst;
+      inst_info_mem[tag_q].id <= ifid_tdata.pcg_data.id;
+    end
+  end
+`endif
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      known_vld_q <= '0;
+      known_rd_q <= '0;
+      known_val_q <= '0;
+    end else begin
+      known_vld_q <= known_vld_d;
+      known_rd_q <= known_rd_d;
+      known_val_q <= known_val_d;
+    end
+  end
 
-  axis_slice prev_rd_slice (
-      .clk(clk),
-      .rst(rst),
-      .axis_mif(prev_rd_mif),
-      .axis_sif(prev_rd_sif),
-      .invalidate(invalidate)
+  expander expander_inst (
+      .cinst(ifid_tdata.inst[15:0]),
+      .inst (expanded)
   );
 
+  // Instantiate FIFO
+  // Decoding stays one instruction per cycle; with ISSUE_WIDTH == 2 the
+  // register file may take the two oldest entries at once, so the backlog
+  // built up behind a stall drains at twice the fetch rate. This does not
+  // make the core dual issue: over a run, no more than one instruction per
+  // cycle gets past this stage. Fusion also
+  // looks at the two oldest entries, so it needs the pair FIFO as well.
+  generate
+    if (ISSUE_WIDTH == 2 || FUSION) begin : gen_pair
+      // Declare wires
+      idrf_tdata_t head, next, fused;
+      logic [XLEN-1:0] head_const;  // rd written by a head that only uses constants
+      logic adjacent;
+      logic fuse_const, fuse_shift;
+      logic fuse;
+
+      // Pairs fused into one op; the second instruction reads and rewrites
+      // the rd of the first, so the intermediate value is dead afterwards
+      // except for the commit stream, which gets it from fused_rd_data or
+      // fused_shamt:
+      // - LUI/AUIPC/LI + ADDI:  ADDI of the whole constant
+      // - LUI/AUIPC/LI + load:  the load with the constant as its base
+      // - LUI/AUIPC/LI + JALR:  the jump with the constant as its base
+      // - SLLI + SRLI by the same amount:  ANDI with the low-bit mask
+      always_comb begin
+        head = head_if.tdata;
+        next = next_if.tdata;
+
+        head_const = head.auipc + head.immediate;
+        adjacent = FUSION && head_if.tvalid && next_if.tvalid &&
+            (head.trap_cause == '0) && (next.trap_cause == '0) &&
+            (next.pc == seq_next_pc(head.pc, head.compressed, 1'b0, 1'b0)) && (head.rd != '0) &&
+            next.fwd_rs1.rf && (next.rs1 == head.rd) && (next.rd == head.rd) &&
+            !next.fwd_rs2.rf;
+        fuse_const = head.alu_cmd_vld && (head.alu_cmd == ADD) && !head.fwd_rs1.rf &&
+            !head.fwd_rs2.rf &&
+            ((next.alu_cmd_vld && (next.alu_cmd == ADD)) ||
+             (next.lsu_cmd_vld && (next.lsu_cmd inside {LSU_LW, LSU_LH, LSU_LB, LSU_LHU, LSU_LBU})) ||
+             (next.bru_cmd_vld && (next.bru_cmd == BRU_JALR)));
+        fuse_shift = head.alu_cmd_vld && (head.alu_cmd == SLL) && !head.fwd_rs2.rf &&
+            next.alu_cmd_vld && (next.alu_cmd == SRL) &&
+            (next.immediate[4:0] == head.immediate[4:0]);
+        fuse = adjacent && (fuse_const || fuse_shift);
+
+        fused = next;
+        fused.pc = head.pc;
+        fused.compressed = head.compressed;
+`ifndef SYNTHESIS
+        fused.tag = head.tag;
+`endif
+        fused.fused = 1'b1;
+        fused.fused_compressed = next.compressed;
+        fused.fused_rd_data = head_const;
+        fused.fused_shamt = '0;
+        if (fuse_shift) begin
+          fused.rs1 = head.rs1;
+          fused.fwd_rs1 = head.fwd_rs1;
+          fused.alu_cmd = AND;
+          fused.immediate = '1 >> head.immediate[4:0];
+          fused.fused_rd_data = '0;
+          fused.fused_shamt = head.immediate[4:0];
+        end else begin
+          fused.rs1 = '0;
+          fused.fwd_rs1.rf = 1'b0;
+          if (next.alu_cmd_vld) begin
+            fused.immediate = head_const + next.immediate;
+          end else begin
+            fused.auipc = head_const;  // Base of the load or the jump
+          end
+        end
+
+        // A fused op takes the first issue slot alone
+        idrf_axis_if.tdata = fuse ? fused : head;
+        idrf_axis_if.tvalid = head_if.tvalid;
+        head_if.tready = idrf_axis_if.tready;
+        idrf1_axis_if.tdata = next;
+        idrf1_axis_if.tvalid = (ISSUE_WIDTH == 2) && next_if.tvalid && !fuse;
+        next_if.tready = fuse ? idrf_axis_if.tready : ((ISSUE_WIDTH == 2) && idrf1_axis_if.tready);
+      end
+
+      axis_pair_fifo #(
+          .DEPTH(2 ** $clog2(FIFO_DEPTH - 1))
+      ) idrf_fifo (
+          .clk(clk),
+          .rst(rst),
+          .axis_mif_0(head_if),
+          .axis_mif_1(next_if),
+          .axis_sif(idrf_fifo_if),
+          .invalidate(invalidate)
+      );
+    end else begin : gen_single
+      axis_sync_fifo #(
+          .DEPTH(FIFO_DEPTH)
+      ) idrf_fifo (
+          .clk(clk),
+          .rst(rst),
+          .axis_mif(idrf_axis_if),
+          .axis_sif(idrf_fifo_if),
+          .invalidate(invalidate)
+      );
+
+      assign idrf1_axis_if.tvalid = 1'b0;
+      assign idrf1_axis_if.tdata = '0;
+    end
+  endgenerate
+
 endmodule
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+
+// RV32C expander: translates a 16-bit compressed instruction into its 32-bit
+// equivalent, so that the decoder only has to deal with RV32I encodings.
+// Reserved and unsupported (F/D, RV64) encodings expand to 0, which is an
+// illegal instruction in both formats.
+module expander (
+    input  logic [15:0] cinst,
+    output logic [31:0] inst
+);
+
+  // Define local parameters
+  localparam logic [6:0] OPC_LOAD = 7'b00_000_11;
+  localparam logic [6:0] OPC_OP_IMM = 7'b00_100_11;
+  localparam logic [6:0] OPC_STORE = 7'b01_000_11;
+  localparam logic [6:0] OPC_OP = 7'b01_100_11;
+  localparam logic [6:0] OPC_LUI = 7'b01_101_11;
+  localparam logic [6:0] OPC_BRANCH = 7'b11_000_11;
+  localparam logic [6:0] OPC_JALR = 7'b11_001_11;
+  localparam logic [6:0] OPC_JAL = 7'b11_011_11;
+  localparam logic [6:0] OPC_SYSTEM = 7'b11_100_11;
+
+  // Encoders of the base formats; immediates are the architectural values
+  function automatic logic [31:0] enc_r(logic [6:0] funct7, logic [4:0] rs2, logic [4:0] rs1,
+                                        logic [2:0] funct3, logic [4:0] rd, logic [6:0] opcode);
+    return {funct7, rs2, rs1, funct3, rd, opcode};
+  endfunction
+
+  function automatic logic [31:0] enc_i(logic [11:0] imm, logic [4:0] rs1, logic [2:0] funct3,
+                                        logic [4:0] rd, logic [6:0] opcode);
+    return {imm, rs1, funct3, rd, opcode};
+  endfunction
+
+  function automatic logic [31:0] enc_s(logic [11:0] imm, logic [4:0] rs2, logic [4:0] rs1,
+                                        logic [2:0] funct3, logic [6:0] opcode);
+    return {imm[11:5], rs2, rs1, funct3, imm[4:0], opcode};
+  endfunction
+
+  function automatic logic [31:0] enc_b(logic [12:0] imm, logic [4:0] rs2, logic [4:0] rs1,
+                                        logic [2:0] funct3);
+    return {imm[12], imm[10:5], rs2, rs1, funct3, imm[4:1], imm[11], OPC_BRANCH};
+  endfunction
+
+  function automatic logic [31:0] enc_j(logic [20:0] imm, logic [4:0] rd);
+    return {imm[20], imm[10:1], imm[11], imm[19:12], rd, OPC_JAL};
+  endfunction
+
+  // Declare wires
+  logic [4:0] rd, rs2;  // Full register specifiers
+  logic [4:0] rd_p, rs1_p, rs2_p;  // Popular registers x8..x15
+  logic [11:0] imm6;  // Sign-extended imm[5:0] of CI/CB formats
+  logic [11:0] lw_off, sw_off, lwsp_off, swsp_off, addi4spn_imm, addi16sp_imm;
+  logic [12:0] b_off;
+  logic [20:0] j_off;
+
+  always_comb begin
+    rd = cinst[11:7];
+    rs2 = cinst[6:2];
+    rd_p = {2'b01, cinst[4:2]};
+    rs1_p = {2'b01, cinst[9:7]};
+    rs2_p = {2'b01, cinst[4:2]};
+
+    imm6 = {{7{cinst[12]}}, cinst[6:2]};
+    lw_off = {5'b0, cinst[5], cinst[12:10], cinst[6], 2'b0};
+    sw_off = lw_off;
+    lwsp_off = {4'b0, cinst[3:2], cinst[12], cinst[6:4], 2'b0};
+    swsp_off = {4'b0, cinst[8:7], cinst[12:9], 2'b0};
+    addi4spn_imm = {2'b0, cinst[10:7], cinst[12:11], cinst[5], cinst[6], 2'b0};
+    addi16sp_imm = {{3{cinst[12]}}, cinst[4:3], cinst[5], cinst[2], cinst[6], 4'b0};
+    b_off = {{5{cinst[12]}}, cinst[6:5], cinst[2], cinst[11:10], cinst[4:3], 1'b0};
+    j_off = {
+      {10{cinst[12]}}, cinst[8], cinst[10:9], cinst[6], cinst[7], cinst[2], cinst[11], cinst[5:3], 1'b0
+    };
+
+    inst = '0;
+    unique case (cinst[1:0])
+      2'b00: begin
+        unique case (cinst[15:13])
+          3'b000:  // C.ADDI4SPN
+          if (addi4spn_imm != '0) inst = enc_i(addi4spn_imm, 5'd2, 3'b000, rd_p, OPC_OP_IMM);
+          3'b010:  // C.LW
+          inst = enc_i(lw_off, rs1_p, 3'b010, rd_p, OPC_LOAD);
+          3'b110:  // C.SW
+          inst = enc_s(sw_off, rs2_p, rs1_p, 3'b010, OPC_STORE);
+          default: begin  // C.FLD, C.FLW, C.FSD, C.FSW and reserved
+          end
+        endcase
+      end
+      2'b01: begin
+        unique case (cinst[15:13])
+          3'b000:  // C.ADDI, C.NOP
+          inst = enc_i(imm6, rd, 3'b000, rd, OPC_OP_IMM);
+          3'b001:  // C.JAL
+          inst = enc_j(j_off, 5'd1);
+          3'b010:  // C.LI
+          inst = enc_i(imm6, 5'd0, 3'b000, rd, OPC_OP_IMM);
+          3'b011: begin
+            if (rd == 5'd2) begin  // C.ADDI16SP
+              if (addi16sp_imm != '0) inst = enc_i(addi16sp_imm, 5'd2, 3'b000, 5'd2, OPC_OP_IMM);
+            end else begin  // C.LUI
+              if (imm6 != '0) inst = {{15{cinst[12]}}, cinst[6:2], rd, OPC_LUI};
+            end
+          end
+          3'b100: begin
+            unique case (cinst[11:10])
+              2'b00:  // C.SRLI
+              if (!cinst[12]) inst = enc_i({7'b0000000, cinst[6:2]}, rs1_p, 3'b101, rs1_p, OPC_OP_IMM);
+              2'b01:  // C.SRAI
+              if (!cinst[12]) inst = enc_i({7'b0100000, cinst[6:2]}, rs1_p, 3'b101, rs1_p, OPC_OP_IMM);
+              2'b10:  // C.ANDI
+              inst = enc_i(imm6, rs1_p, 3'b111, rs1_p, OPC_OP_IMM);
+              default: begin
+                if (!cinst[12]) begin  // C.SUBW and C.ADDW are RV64 only
+                  unique case (cinst[6:5])
+                    2'b00: inst = enc_r(7'b0100000, rs2_p, rs1_p, 3'b000, rs1_p, OPC_OP);  // C.SUB
+                    2'b01: inst = enc_r(7'b0000000, rs2_p, rs1_p, 3'b100, rs1_p, OPC_OP);  // C.XOR
+                    2'b10: inst = enc_r(7'b0000000, rs2_p, rs1_p, 3'b110, rs1_p, OPC_OP);  // C.OR
+                    default: inst = enc_r(7'b0000000, rs2_p, rs1_p, 3'b111, rs1_p, OPC_OP);  // C.AND
+                  endcase
+                end
+              end
+            endcase
+          end
+          3'b101:  // C.J
+          inst = enc_j(j_off, 5'd0);
+          3'b110:  // C.BEQZ
+          inst = enc_b(b_off, 5'd0, rs1_p, 3'b000);
+          default:  // C.BNEZ
+          inst = enc_b(b_off, 5'd0, rs1_p, 3'b001);
+        endcase
+      end
+      2'b10: begin
+        unique case (cinst[15:13])
+          3'b000:  // C.SLLI
+          if (!cinst[12]) inst = enc_i({7'b0000000, cinst[6:2]}, rd, 3'b001, rd, OPC_OP_IMM);
+          3'b010:  // C.LWSP
+          if (rd != '0) inst = enc_i(lwsp_off, 5'd2, 3'b010, rd, OPC_LOAD);
+          3'b100: begin
+            if (!cinst[12]) begin
+              if (rs2 == '0) begin  // C.JR
+                if (rd != '0) inst = enc_i('0, rd, 3'b000, 5'd0, OPC_JALR);
+              end else begin  // C.MV
+                inst = enc_r(7'b0000000, rs2, 5'd0, 3'b000, rd, OPC_OP);
+              end
+            end else begin
+              if (rs2 == '0) begin
+                if (rd == '0) inst = enc_i(12'h001, 5'd0, 3'b000, 5'd0, OPC_SYSTEM);  // C.EBREAK
+                else inst = enc_i('0, rd, 3'b000, 5'd1, OPC_JALR);  // C.JALR
+              end else begin  // C.ADD
+                inst = enc_r(7'b0000000, rs2, rd, 3'b000, rd, OPC_OP);
+              end
+            end
+          end
+          3'b110:  // C.SWSP
+          inst = enc_s(swsp_off, rs2, 5'd2, 3'b010, OPC_STORE);
+          default: begin  // C.FLDSP, C.FLWSP, C.FSDSP, C.FSWSP
+          end
+        endcase
+      end
+      default: begin  // Not a compressed instruction
+        inst = '0;
+      end
+    endcase
+  end
+
+endmodule
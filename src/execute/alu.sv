@@ -13,15 +13,46 @@ module alu
     input logic invalidate
 );
 
+  // Define local parameters
+  localparam SHAMT_WIDTH = $clog2(XLEN);
+
+  // Count of leading zeros; XLEN for zero
+  function automatic logic [XLEN-1:0] count_leading_zeros(logic [XLEN-1:0] value);
+    count_leading_zeros = XLEN;
+    for (int i = 0; i < XLEN; i++) begin
+      if (value[i]) count_leading_zeros = XLEN'(XLEN - 1 - i);
+    end
+  endfunction
+
+  // Count of trailing zeros; XLEN for zero
+  function automatic logic [XLEN-1:0] count_trailing_zeros(logic [XLEN-1:0] value);
+    count_trailing_zeros = XLEN;
+    for (int i = XLEN - 1; i >= 0; i--) begin
+      if (value[i]) count_trailing_zeros = XLEN'(i);
+    end
+  endfunction
+
+  function automatic logic [XLEN-1:0] count_ones(logic [XLEN-1:0] value);
+    count_ones = '0;
+    for (int i = 0; i < XLEN; i++) begin
+      count_ones += XLEN'(value[i]);
+    end
+  endfunction
+
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(aluwb_tdata_t))) aluwb_slice_if ();
 
   // Declare wires
   rfalu_tdata_t rfalu_tdata;
   aluwb_tdata_t aluwb_tdata;
+  logic [XLEN-1:0] op1, op2;
+  logic [SHAMT_WIDTH-1:0] shamt;
 
   always_comb begin
     rfalu_tdata = rfalu_axis_if.tdata;
+    op1 = rfalu_tdata.operands.op1;
+    op2 = rfalu_tdata.operands.op2;
+    shamt = op2[SHAMT_WIDTH-1:0];
 
     aluwb_tdata.result = '0;
     unique case (rfalu_tdata.cmd)
@@ -39,6 +70,34 @@ module alu
           $signed($signed(rfalu_tdata.operands.op1) >>> rfalu_tdata.operands.op2[4:0]);
       OR: aluwb_tdata.result = rfalu_tdata.operands.op1 | rfalu_tdata.operands.op2;
       AND: aluwb_tdata.result = rfalu_tdata.operands.op1 & rfalu_tdata.operands.op2;
+      SH1ADD: aluwb_tdata.result = (op1 << 1) + op2;
+      SH2ADD: aluwb_tdata.result = (op1 << 2) + op2;
+      SH3ADD: aluwb_tdata.result = (op1 << 3) + op2;
+      ANDN: aluwb_tdata.result = op1 & ~op2;
+      ORN: aluwb_tdata.result = op1 | ~op2;
+      XNOR: aluwb_tdata.result = ~(op1 ^ op2);
+      CLZ: aluwb_tdata.result = count_leading_zeros(op1);
+      CTZ: aluwb_tdata.result = count_trailing_zeros(op1);
+      CPOP: aluwb_tdata.result = count_ones(op1);
+      MAX: aluwb_tdata.result = ($signed(op1) < $signed(op2)) ? op2 : op1;
+      MAXU: aluwb_tdata.result = (op1 < op2) ? op2 : op1;
+      MIN: aluwb_tdata.result = ($signed(op1) < $signed(op2)) ? op1 : op2;
+      MINU: aluwb_tdata.result = (op1 < op2) ? op1 : op2;
+      SEXTB: aluwb_tdata.result = {{(XLEN - 8) {op1[7]}}, op1[7:0]};
+      SEXTH: aluwb_tdata.result = {{(XLEN - 16) {op1[15]}}, op1[15:0]};
+      ZEXTH: aluwb_tdata.result = {(XLEN - 16)'(0), op1[15:0]};
+      ROL: aluwb_tdata.result = (op1 << shamt) | (op1 >> (XLEN - shamt));
+      ROR: aluwb_tdata.result = (op1 >> shamt) | (op1 << (XLEN - shamt));
+      ORCB: begin
+        for (int i = 0; i < XLEN / 8; i++) begin
+          aluwb_tdata.result[8*i+:8] = {8{|op1[8*i+:8]}};
+        end
+      end
+      REV8: begin
+        for (int i = 0; i < XLEN / 8; i++) begin
+          aluwb_tdata.result[8*i+:8] = op1[XLEN-8-8*i+:8];
+        end
+      end
       default: begin
       end
     endcase
@@ -23,7 +23,7 @@ module bru
   always_comb begin
     rfbru_tdata = rfbru_axis_if.tdata;
 
-    bruwb_tdata.result = rfbru_tdata.this_pc + XLEN'(4);
+    bruwb_tdata.result = rfbru_tdata.next_pc;
     bruwb_tdata.new_pc = rfbru_tdata.this_pc + rfbru_tdata.offset;
     bruwb_tdata.taken = 1'b0;
 
@@ -32,7 +32,7 @@ module bru
         bruwb_tdata.taken = 1'b1;
       end
       BRU_JALR: begin
-        bruwb_tdata.new_pc = rfbru_tdata.operands.op1 + rfbru_tdata.offset;
+        bruwb_tdata.new_pc = (rfbru_tdata.operands.op1 + rfbru_tdata.offset) & ~XLEN'(1);
         bruwb_tdata.taken  = 1'b1;
       end
       BRU_BEQ: begin
@@ -73,9 +73,11 @@ module bru
     rfbru_axis_if.tready  = bruwb_slice_if.tready;
   end
 
+`ifndef OFFNARISCV_QUIET
   always_ff @(posedge clk)
     if (rfbru_axis_if.tvalid && bruwb_tdata.taken)
       $write("BRU: New PC = %08h, cmd=%s\n", bruwb_tdata.new_pc, rfbru_tdata.cmd.name());
+`endif
 
   // Instantiate slice
   axis_slice bruwb_slice (
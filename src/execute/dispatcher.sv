@@ -9,78 +9,166 @@ module dispatcher
     input logic clk,
     input logic rst,
 
-    axis_if.s rfex_axis_if,   // From Register File
-    axis_if.m rfalu_axis_if,  // To ALU
+    axis_if.s rfex_axis_if,    // From Register File
+    axis_if.s rfex1_axis_if,   // From Register File (second issue slot)
+    axis_if.m rfalu_axis_if,   // To ALU
+    axis_if.m rfalu1_axis_if,  // To ALU (second issue slot)
     axis_if.m rfbru_axis_if,  // To Branch Resolution Unit
     axis_if.m rfsys_axis_if,  // To System Unit
     axis_if.m rflsu_axis_if,  // To Load/Store Unit
     axis_if.m exwb_axis_if,   // To Write Back
+    axis_if.m exwb1_axis_if,  // To Write Back (second issue slot)
 
-    axis_if.s wbrf_axis_if,  // For forwarding
+    axis_if.s wbrf_axis_if,   // For forwarding
+    axis_if.s wbrf1_axis_if,  // For forwarding
 
     input logic invalidate
 );
 
+  // Assert conditions
+  initial begin
+    // The scoreboard of the register file counts at most one writer in the
+    // EXWB FIFO, and bypasses from it as if it were the preceding instruction
+    assert (FIFO_DEPTH == 1)
+    else $fatal("FIFO_DEPTH must be 1; the register file bypass assumes it");
+  end
+
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(exwb_tdata_t))) exwb_slice_if ();
+  axis_if #(.TDATA_WIDTH($bits(exwb_tdata_t))) exwb1_slice_if ();  // Moves in lockstep with exwb_slice_if
 
   // Declare wires
-  rfex_tdata_t rfex_tdata;
-  rfalu_tdata_t rfalu_tdata;
+  rfex_tdata_t rfex_tdata, rfex1_tdata;
+  rfalu_tdata_t rfalu_tdata, rfalu1_tdata;
   rfbru_tdata_t rfbru_tdata;
   rfsys_tdata_t rfsys_tdata;
   rflsu_tdata_t rflsu_tdata;
-  exwb_tdata_t exwb_tdata;
-  wbrf_tdata_t wbrf_tdata;
-
-  logic [XLEN-1:0] fwd_data;
+  exwb_tdata_t exwb_tdata, exwb1_tdata;
+  wbrf_tdata_t wbrf_tdata, wbrf1_tdata;
+
+  logic [XLEN-1:0] fwd_rs1_data, fwd_rs2_data, fwd_rs1_1_data, fwd_rs2_1_data;
+  logic fwd_rs1, fwd_rs2, fwd_rs1_1, fwd_rs2_1;  // The producer is committing in this cycle
+  logic interlock;  // A producer has not committed yet
+  logic [XLEN-1:0] next_pc;
+
+  // Look for the producer of a `fwd.ex` operand among the committing lanes
+  function automatic void forward(input logic [4:0] rs, input logic ex,
+                                  input wbrf_tdata_t wb, input logic wb_vld,
+                                  input wbrf_tdata_t wb1, input logic wb1_vld, output logic hit,
+                                  output logic [XLEN-1:0] data);
+    logic hit1;
+    hit1 = ex && wb1_vld && (wb1.ex_data.rd == rs);
+    hit = hit1 || (ex && wb_vld && (wb.ex_data.rd == rs));
+    data = hit1 ? wb1.wdata : wb.wdata;
+  endfunction
+
+  // Only what the committer consumes goes on to the EXWB FIFO
+  function automatic exwb_tdata_t to_exwb(rfex_tdata_t rf);
+    exwb_tdata_t ex;
+    ex.rd = rf.id_data.rd;
+    ex.csr_addr = rf.id_data.csr_addr;
+    ex.csr_rdata = rf.csr_rdata;
+    ex.alu_cmd_vld = rf.id_data.alu_cmd_vld;
+    ex.bru_cmd_vld = rf.id_data.bru_cmd_vld;
+    ex.sys_cmd = rf.id_data.sys_cmd;
+    ex.sys_cmd_vld = rf.id_data.sys_cmd_vld;
+    ex.lsu_cmd_vld = rf.id_data.lsu_cmd_vld;
+    ex.pc = rf.id_data.pc;
+    ex.compressed = rf.id_data.compressed;
+    ex.trap_cause = rf.id_data.trap_cause;
+    ex.fence_i = rf.id_data.fence_i;
+    ex.pred_taken = rf.id_data.pred_taken;
+    ex.fused = rf.id_data.fused;
+    ex.fused_compressed = rf.id_data.fused_compressed;
+    ex.fused_rd_data = rf.id_data.fused_rd_data;
+`ifndef SYNTHESIS
+    ex.alu_cmd = rf.id_data.alu_cmd;
+    ex.fused_shamt = rf.id_data.fused_shamt;
+    ex.tag = rf.id_data.tag;
+`endif
+    return ex;
+  endfunction
 
   always_comb begin
     rfex_tdata = rfex_axis_if.tdata;
-    rfex_axis_if.tready = exwb_slice_if.tready;
-    exwb_slice_if.tvalid = rfex_axis_if.tvalid;
+    rfex1_tdata = rfex1_axis_if.tdata;
 
     wbrf_tdata = wbrf_axis_if.tdata;
-    fwd_data = wbrf_tdata.wdata;
+    wbrf1_tdata = wbrf1_axis_if.tdata;
+    forward(rfex_tdata.id_data.rs1, rfex_tdata.id_data.fwd_rs1.ex, wbrf_tdata,
+            wbrf_axis_if.tvalid, wbrf1_tdata, wbrf1_axis_if.tvalid, fwd_rs1, fwd_rs1_data);
+    forward(rfex_tdata.id_data.rs2, rfex_tdata.id_data.fwd_rs2.ex, wbrf_tdata,
+            wbrf_axis_if.tvalid, wbrf1_tdata, wbrf1_axis_if.tvalid, fwd_rs2, fwd_rs2_data);
+    forward(rfex1_tdata.id_data.rs1, rfex1_tdata.id_data.fwd_rs1.ex, wbrf_tdata,
+            wbrf_axis_if.tvalid, wbrf1_tdata, wbrf1_axis_if.tvalid, fwd_rs1_1, fwd_rs1_1_data);
+    forward(rfex1_tdata.id_data.rs2, rfex1_tdata.id_data.fwd_rs2.ex, wbrf_tdata,
+            wbrf_axis_if.tvalid, wbrf1_tdata, wbrf1_axis_if.tvalid, fwd_rs2_1, fwd_rs2_1_data);
+    // A pair is dispatched as a whole, so either slot can hold both back
+    interlock = (rfex_tdata.id_data.fwd_rs1.ex && !fwd_rs1) ||
+        (rfex_tdata.id_data.fwd_rs2.ex && !fwd_rs2) ||
+        (rfex1_axis_if.tvalid && ((rfex1_tdata.id_data.fwd_rs1.ex && !fwd_rs1_1) ||
+                                  (rfex1_tdata.id_data.fwd_rs2.ex && !fwd_rs2_1)));
+
+    rfex_axis_if.tready = exwb_slice_if.tready && exwb1_slice_if.tready && !interlock;
+    exwb_slice_if.tvalid = rfex_axis_if.tvalid && !interlock;
+    rfex1_axis_if.tready = rfex_axis_if.tready;
+    exwb1_slice_if.tvalid = rfex1_axis_if.tvalid && rfex_axis_if.tvalid && rfex_axis_if.tready;
+
+    next_pc = seq_next_pc(rfex_tdata.id_data.pc, rfex_tdata.id_data.compressed,
+                          rfex_tdata.id_data.fused, rfex_tdata.id_data.fused_compressed);
 
     // ALU
-    rfalu_tdata.operands.op1 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs1.ex) ? fwd_data : rfex_tdata.operands.op1;
-    rfalu_tdata.operands.op2 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs2.ex) ? fwd_data : rfex_tdata.operands.op2;
+    rfalu_tdata.operands.op1 = fwd_rs1 ? fwd_rs1_data : rfex_tdata.operands.op1;
+    rfalu_tdata.operands.op2 = fwd_rs2 ? fwd_rs2_data : rfex_tdata.operands.op2;
     rfalu_tdata.cmd = rfex_tdata.id_data.alu_cmd;
     rfalu_axis_if.tdata = rfalu_tdata;
     rfalu_axis_if.tvalid = exwb_slice_if.tvalid && rfex_tdata.id_data.alu_cmd_vld && rfex_axis_if.tready;
 
     // BRU
-    rfbru_tdata.operands.op1 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs1.ex) ? fwd_data : rfex_tdata.operands.op1;
-    rfbru_tdata.operands.op2 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs2.ex) ? fwd_data : rfex_tdata.rs2_data;
+    rfbru_tdata.operands.op1 = fwd_rs1 ? fwd_rs1_data : rfex_tdata.operands.op1;
+    rfbru_tdata.operands.op2 = fwd_rs2 ? fwd_rs2_data : rfex_tdata.rs2_data;
     rfbru_tdata.offset = rfex_tdata.id_data.immediate;
-    rfbru_tdata.this_pc = rfex_tdata.id_data.if_data.pcg_data.pc;
+    rfbru_tdata.this_pc = rfex_tdata.id_data.pc;
+    rfbru_tdata.next_pc = next_pc;
     rfbru_tdata.cmd = rfex_tdata.id_data.bru_cmd;
     rfbru_axis_if.tdata = rfbru_tdata;
     rfbru_axis_if.tvalid = exwb_slice_if.tvalid && rfex_tdata.id_data.bru_cmd_vld && rfex_axis_if.tready;
 
     // System
-    rfsys_tdata.operands.op1 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs1.ex) ? fwd_data : rfex_tdata.operands.op1;
-    rfsys_tdata.operands.op2 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs2.ex) ? fwd_data : rfex_tdata.operands.op2;
+    rfsys_tdata.operands.op1 = fwd_rs1 ? fwd_rs1_data : rfex_tdata.operands.op1;
+    rfsys_tdata.operands.op2 = fwd_rs2 ? fwd_rs2_data : rfex_tdata.operands.op2;
     rfsys_tdata.csr_rdata = rfex_tdata.csr_rdata;
+    rfsys_tdata.csr_illegal = rfex_tdata.csr_illegal;
     rfsys_tdata.cmd = rfex_tdata.id_data.sys_cmd;
-    rfsys_tdata.trap_cause = rfex_tdata.id_data.if_data.trap_cause;
-    rfsys_tdata.this_pc = rfex_tdata.id_data.if_data.pcg_data.pc;
-    rfsys_tdata.mtvec = rfex_tdata.mtvec;
+    rfsys_tdata.trap_cause = rfex_tdata.id_data.trap_cause;
+    rfsys_tdata.this_pc = rfex_tdata.id_data.pc;
+    rfsys_tdata.next_pc = next_pc;
     rfsys_tdata.mepc = rfex_tdata.mepc;
+    rfsys_tdata.sepc = rfex_tdata.sepc;
+    rfsys_tdata.priv = rfex_tdata.priv;
     rfsys_axis_if.tdata = rfsys_tdata;
     rfsys_axis_if.tvalid = exwb_slice_if.tvalid && rfex_tdata.id_data.sys_cmd_vld && rfex_axis_if.tready;
 
     // LSU
-    rflsu_tdata.operands.op1 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs1.ex) ? fwd_data : rfex_tdata.operands.op1;
-    rflsu_tdata.operands.op2 = (wbrf_axis_if.tvalid && rfex_tdata.id_data.fwd_rs2.ex) ? fwd_data : rfex_tdata.rs2_data;
+    rflsu_tdata.operands.op1 = fwd_rs1 ? fwd_rs1_data : rfex_tdata.operands.op1;
+    rflsu_tdata.operands.op2 = fwd_rs2 ? fwd_rs2_data : rfex_tdata.rs2_data;
     rflsu_tdata.offset = rfex_tdata.id_data.immediate;
     rflsu_tdata.cmd = rfex_tdata.id_data.lsu_cmd;
+    rflsu_tdata.pc = rfex_tdata.id_data.pc;
     rflsu_axis_if.tdata = rflsu_tdata;
     rflsu_axis_if.tvalid = exwb_slice_if.tvalid && rfex_tdata.id_data.lsu_cmd_vld && rfex_axis_if.tready;
 
-    exwb_tdata.rf_data = rfex_tdata;
+    // ALU (second issue slot)
+    rfalu1_tdata.operands.op1 = fwd_rs1_1 ? fwd_rs1_1_data : rfex1_tdata.operands.op1;
+    rfalu1_tdata.operands.op2 = fwd_rs2_1 ? fwd_rs2_1_data : rfex1_tdata.operands.op2;
+    rfalu1_tdata.cmd = rfex1_tdata.id_data.alu_cmd;
+    rfalu1_axis_if.tdata = rfalu1_tdata;
+    rfalu1_axis_if.tvalid = exwb1_slice_if.tvalid;
+
+    exwb_tdata = to_exwb(rfex_tdata);
     exwb_slice_if.tdata = exwb_tdata;
+    exwb1_tdata = to_exwb(rfex1_tdata);
+    exwb1_slice_if.tdata = exwb1_tdata;
   end
 
   axis_sync_fifo #(
@@ -93,4 +181,14 @@ module dispatcher
       .invalidate(invalidate)
   );
 
+  axis_sync_fifo #(
+      .DEPTH(FIFO_DEPTH)
+  ) exwb1_fifo (
+      .clk(clk),
+      .rst(rst),
+      .axis_mif(exwb1_axis_if),
+      .axis_sif(exwb1_slice_if),
+      .invalidate(invalidate)
+  );
+
 endmodule
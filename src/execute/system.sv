@@ -29,22 +29,40 @@ module system
     syswb_tdata.csr_wdata = rfsys_tdata.csr_rdata;
     syswb_tdata.csr_update = 1'b0;
     syswb_tdata.trap_cause = rfsys_tdata.trap_cause;
-    new_pc = rfsys_tdata.this_pc + 'd4;
+    new_pc = rfsys_tdata.next_pc;
     unique case (rfsys_tdata.cmd) inside
       CSRRW, CSRRWI: syswb_tdata.csr_wdata = operand;
       CSRRS, CSRRSI: syswb_tdata.csr_wdata = (rfsys_tdata.csr_rdata | operand);
       CSRRC, CSRRCI: syswb_tdata.csr_wdata = (rfsys_tdata.csr_rdata & ~operand);
-      ECALL:
-      syswb_tdata.trap_cause[EXC_ECM] = 1'b1; // TODO: Support other privilege levels (currently only M-mode is supported)
-      MRET, SRET: new_pc = rfsys_tdata.mepc;
+      ECALL: begin
+        unique case (rfsys_tdata.priv)
+          PRIV_U: syswb_tdata.trap_cause[EXC_ECU] = 1'b1;
+          PRIV_S: syswb_tdata.trap_cause[EXC_ECS] = 1'b1;
+          default: syswb_tdata.trap_cause[EXC_ECM] = 1'b1;
+        endcase
+      end
+      MRET: begin
+        if (rfsys_tdata.priv != PRIV_M) syswb_tdata.trap_cause[EXC_II] = 1'b1;
+        new_pc = rfsys_tdata.mepc;
+      end
+      SRET: begin
+        if (rfsys_tdata.priv == PRIV_U) syswb_tdata.trap_cause[EXC_II] = 1'b1;
+        new_pc = rfsys_tdata.sepc;
+      end
+      SFENCE_VMA: begin
+        if (rfsys_tdata.priv == PRIV_U) syswb_tdata.trap_cause[EXC_II] = 1'b1;
+      end
       default: begin
         // TODO: Handle other system commands
       end
     endcase
+    if ((rfsys_tdata.cmd inside {CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI}) && rfsys_tdata.csr_illegal)
+      syswb_tdata.trap_cause[EXC_II] = 1'b1;
     syswb_tdata.csr_update = (rfsys_tdata.csr_rdata != syswb_tdata.csr_wdata);
     syswb_tdata.trap = (syswb_tdata.trap_cause != '0);
-    syswb_tdata.new_pc = (syswb_tdata.trap) ? rfsys_tdata.mtvec : new_pc;
-    syswb_tdata.use_new_pc = syswb_tdata.csr_update || (rfsys_tdata.cmd inside {MRET, SRET}) || syswb_tdata.trap;
+    syswb_tdata.new_pc = new_pc;  // The committer takes the trap vector from the CSRs
+    // SFENCE.VMA also refetches, so that younger instructions see the new translations
+    syswb_tdata.use_new_pc = syswb_tdata.csr_update || (rfsys_tdata.cmd inside {MRET, SRET, SFENCE_VMA}) || syswb_tdata.trap;
 
     // Slice connection
     syswb_slice_if.tdata = syswb_tdata;
@@ -2,7 +2,7 @@
 
 // Instruction Fetch Unit
 module ifu
-  import offnariscv_pkg::*, cache_pkg::*;
+  import riscv_pkg::*, offnariscv_pkg::*, cache_pkg::*;
 #(
     parameter RESET_VECTOR = 0,
     parameter CACHE_SIZE   = 4096  // 4 KiB
@@ -23,16 +23,39 @@ module ifu
     cache_dir_if.req l1i_dir_if,
     cache_mem_if.req l1i_mem_if,
 
-    input logic invalidate
+    // Predecode for Program Counter Generator
+    input logic [XLEN-1:0] predecode_pc,
+    output logic predecode_vld,
+    output logic predecode_rvc,
+
+    // Address translation
+    csr_pif.req csr_pif,
+    tlb_if.req l1itlb_if,
+    ptw_if.req ptw_ifu_if,
+
+    // The LSU drops the block at this physical address from the L1 I-Cache,
+    // so a refill of it in flight is stale
+    input logic l1i_inval_vld,
+    input logic [XLEN-1:0] l1i_inval_addr,
+
+    input logic invalidate,
+    input logic flush,  // FENCE.I
+    input logic sfence  // SFENCE.VMA
 );
 
   // Define local parameters
   localparam ADDR_WIDTH = ifu_ace_if.ACE_AXADDR_WIDTH;
-  localparam BLOCK_SIZE = ifu_ace_if.ACE_XDATA_WIDTH;
+  localparam BLOCK_SIZE = l1i_mem_if.BLOCK_SIZE;
   localparam BLOCK_OFFSET_WIDTH = $clog2(BLOCK_SIZE / 8);
-  localparam BLOCK_SEL_WIDTH = $clog2(BLOCK_SIZE / XLEN);
+  localparam BUS_WIDTH = ifu_ace_if.ACE_XDATA_WIDTH;
+  localparam BUS_OFFSET_WIDTH = $clog2(BUS_WIDTH / 8);
+  localparam BEATS = BLOCK_SIZE / BUS_WIDTH;  // A refill is a burst of this many beats
+  localparam BEAT_SEL_WIDTH = (BEATS > 1) ? $clog2(BEATS) : 1;
+  localparam HALVES_PER_BEAT = BUS_WIDTH / 16;
+  localparam HALF_SEL_WIDTH = $clog2(BLOCK_SIZE / 16);  // Instructions are 16-bit aligned (RV32C)
   localparam INDEX_WIDTH = l1i_dir_if.INDEX_WIDTH;
   localparam TAG_WIDTH = l1i_dir_if.TAG_WIDTH;
+  localparam BLOCK_ADDR_WIDTH = ADDR_WIDTH - BLOCK_OFFSET_WIDTH;
 
   // Assert conditions
   initial begin
@@ -42,20 +65,38 @@ module ifu
     else $fatal("inst_axis_if.TDATA_WIDTH must match ifid_tdata_t");
     assert (TAG_WIDTH + INDEX_WIDTH + BLOCK_OFFSET_WIDTH == ADDR_WIDTH)
     else $fatal("TAG_WIDTH + INDEX_WIDTH + BLOCK_OFFSET_WIDTH must equal ADDR_WIDTH");
-    assert (l1i_mem_if.BLOCK_SIZE == BLOCK_SIZE)
-    else $fatal("l1i_mem_if.BLOCK_SIZE must match BLOCK_SIZE");
+    assert (TAG_WIDTH == 20)
+    else $fatal("The L1 I-Cache must be indexed within the page offset, so the tag is the PPN");
+    assert ((BEATS * BUS_WIDTH == BLOCK_SIZE) && (BEATS inside {1, 2, 4, 8, 16}))
+    else $fatal("A block must be a wrapping burst of 1, 2, 4, 8 or 16 beats");
     assert (l1i_mem_if.INDEX_WIDTH == INDEX_WIDTH)
     else $fatal("l1i_mem_if.INDEX_WIDTH must match INDEX_WIDTH");
   end
 
   // Define types
-  typedef enum logic [1:0] {
+  typedef enum logic [2:0] {
     IDLE,
     PTW,
     LOAD,
-    WAIT
+    STRADDLE,  // Looking up the block holding the upper half of a straddling instruction
+    FAULT  // Delivering an instruction page or access fault
   } state_e;
 
+  // Instruction starting at halfword `sel` of `block`; the upper half is
+  // zero for the last halfword
+  function automatic logic [XLEN-1:0] extract(logic [BLOCK_SIZE-1:0] block,
+                                              logic [HALF_SEL_WIDTH-1:0] sel);
+    return XLEN'({16'b0, block} >> (sel * 16));
+  endfunction
+
+  function automatic logic is_rvc(logic [15:0] half);
+    return half[1:0] != 2'b11;
+  endfunction
+
+  function automatic logic [BEAT_SEL_WIDTH-1:0] beat_of(logic [HALF_SEL_WIDTH-1:0] sel);
+    return BEAT_SEL_WIDTH'(sel / HALVES_PER_BEAT);
+  endfunction
+
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(pcgif_tdata_t))) pcgif_pipe_reg_if ();
   axis_if #(.TDATA_WIDTH($bits(ifid_tdata_t))) ifid_pipe_reg_if ();
@@ -66,19 +107,67 @@ module ifu
   logic rready_q, rready_d;
   logic [BLOCK_SIZE-1:0] rdata_q, rdata_d;
   logic [$bits(ifu_ace_if.rresp)-1:0] rresp_q, rresp_d;
+
+  // A refill is a wrapping burst that starts at the beat of the fetch address;
+  // the beats are collected in rdata_q as they arrive
+  logic [BEAT_SEL_WIDTH-1:0] beat_q, beat_d;  // Beat expected next
+  logic [BEATS-1:0] arrived_q, arrived_d;
+  logic [ADDR_WIDTH-1:0] fill_addr_q, fill_addr_d;  // Virtual address of the first beat
+  logic [INDEX_WIDTH-1:0] fill_index_q, fill_index_d;
   logic l1ic_hit_q, l1ic_hit_d;
   logic invalidate_q, invalidate_d;
+  logic stale_q, stale_d;  // The block being refilled was dropped, so it is delivered but not kept
 
   logic [INDEX_WIDTH-1:0] l1ic_dir_index_q, l1ic_dir_index_d;
   logic [INDEX_WIDTH-1:0] l1ic_mem_index_q, l1ic_mem_index_d;
 
+  // A 32-bit instruction at the last halfword of a block continues in the
+  // next block; its lower half is kept while the next block is fetched
+  logic straddle_q, straddle_d;
+  logic [15:0] low_half_q, low_half_d;
+
+  // Line buffer holding the block of the last delivered instruction, so that
+  // sequential fetches within it need not read the L1 I-cache again
+  logic lb_vld_q, lb_vld_d;
+  logic [BLOCK_ADDR_WIDTH-1:0] lb_addr_q, lb_addr_d;
+  logic [BLOCK_SIZE-1:0] lb_data_q, lb_data_d;
+  priv_e lb_priv_q, lb_priv_d;  // The line buffer is looked up by virtual address
+
+  logic [TAG_WIDTH-1:0] ptag_q, ptag_d;  // Physical tag of the block being loaded
+  trap_cause_t fault_q, fault_d;
+  logic walked_q, walked_d;  // The ITLB entry was just refilled, so the lookup is not counted again
+  logic [19:0] walk_vpn_q, walk_vpn_d;  // The PC may be invalidated and replaced during the walk
+
+`ifndef SYNTHESIS
+  logic [63:0] fetch_count_q, fetch_count_d;  // Instructions delivered
+  logic [63:0] lb_hit_count_q, lb_hit_count_d;  // ... of which were served by the line buffer
+  logic [63:0] refill_count_q, refill_count_d;  // L1 I-Cache refills
+`endif
+
   // Declare wires
   pcgif_tdata_t pcgif_tdata;
   pcgif_tdata_t pcgif_pipe_tdata;
   logic pcgif_ack;
-  logic l1itlb_hit;
+  logic translate;
+  logic l1itlb_hit;  // The ITLB has a usable translation
+  logic l1itlb_walk;  // ... has none, or Svadu has to set its A bit
+  logic l1itlb_fault;
+  logic [ADDR_WIDTH-1:0] fetch_addr;  // Address of the block being looked up
   logic [TAG_WIDTH-1:0] tag;
-  logic [((BLOCK_SEL_WIDTH>0)?BLOCK_SEL_WIDTH : 1)-1:0] block_sel;
+  logic [HALF_SEL_WIDTH-1:0] half_sel;
+  logic last_half;  // The PC is at the last halfword of its block
+  logic l1ic_hit;
+  logic [BLOCK_SIZE-1:0] hit_data;
+  logic lb_hit;
+  logic lb_next_vld;
+  logic [BLOCK_ADDR_WIDTH-1:0] lb_next_addr;
+  logic same_block;
+  logic straddle_start;  // Switch the lookup to the next block
+  logic [BLOCK_SIZE-1:0] pd_block;
+  logic [HALF_SEL_WIDTH-1:0] pd_sel;
+  logic in_fill;  // The PC is in the block being refilled
+  logic fill_hit;  // ... and the beats holding its instruction have arrived
+  logic fill_inval;  // The LSU drops the block being refilled
 
   ifid_tdata_t ifid_tdata;
 
@@ -86,10 +175,76 @@ module ifu
   assign pcgif_tdata = pcgif_axis_if.tdata;
   assign pcgif_pipe_tdata = pcgif_pipe_reg_if.tdata;
   assign pcgif_ack = pcgif_axis_if.tvalid && pcgif_axis_if.tready;
-  assign l1itlb_hit = 1'b1;  // TODO
 
-  assign l1i_dir_if.index = l1ic_dir_index_q;
-  assign l1i_mem_if.index = l1ic_mem_index_q;
+  // The index follows the PCs delivered early during a refill, so the refill
+  // keeps its own for the write at the end
+  assign l1i_dir_if.index = (state_q == LOAD) ? fill_index_q : l1ic_dir_index_q;
+  assign l1i_mem_if.index = (state_q == LOAD) ? fill_index_q : l1ic_mem_index_q;
+  // ... and those registers take their next values here, for SRAMs with a synchronous read
+  assign l1i_dir_if.next_index = (state_d == LOAD) ? fill_index_d : l1ic_dir_index_d;
+  assign l1i_mem_if.next_index = (state_d == LOAD) ? fill_index_d : l1ic_mem_index_d;
+
+  assign half_sel = pcgif_pipe_tdata.pc[BLOCK_OFFSET_WIDTH-1:1];
+  assign last_half = (half_sel == '1);
+  assign fetch_addr = straddle_q ?
+      {pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] + BLOCK_ADDR_WIDTH'(1), BLOCK_OFFSET_WIDTH'(0)} :
+      pcgif_pipe_tdata.pc;
+
+  // Address translation
+  assign translate = csr_pif.satp.mode && (csr_pif.priv != PRIV_M);
+  assign l1itlb_if.vpn = fetch_addr[ADDR_WIDTH-1-:20];
+  assign l1itlb_if.asid = csr_pif.satp.asid;
+  assign l1itlb_if.refill = (state_q == PTW) && ptw_ifu_if.done && !ptw_ifu_if.page_fault &&
+      !ptw_ifu_if.access_fault;
+  assign l1itlb_if.refill_entry = ptw_ifu_if.entry;
+  assign l1itlb_fault = translate && l1itlb_if.hit &&
+      (!tlb_permits(l1itlb_if.entry, csr_pif.priv, csr_pif.sum, csr_pif.mxr, 1'b1, 1'b0) ||
+       (!csr_pif.adue && !l1itlb_if.entry.a));
+  assign l1itlb_walk = translate && !l1itlb_fault && (!l1itlb_if.hit || !l1itlb_if.entry.a);
+  assign l1itlb_hit = !l1itlb_walk && !l1itlb_fault;
+  assign ptw_ifu_if.valid = (state_q == PTW);
+  assign ptw_ifu_if.vpn = walk_vpn_q;
+  assign ptw_ifu_if.store = 1'b0;
+
+  assign tag = translate ? l1itlb_if.ppn : fetch_addr[ADDR_WIDTH-1-:TAG_WIDTH];
+  assign in_fill = pcgif_pipe_reg_if.tvalid &&
+      (pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] == fill_addr_q[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH]);
+  // A refill enters the directory only at its end, and may have read the
+  // block before the LSU dropped it
+  assign fill_inval = (state_q == LOAD) && l1i_inval_vld &&
+      (l1i_inval_addr[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH] == {ptag_q, fill_index_q});
+  assign lb_hit = lb_vld_q && (lb_priv_q == csr_pif.priv) &&
+      (pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] == lb_addr_q);
+  assign l1ic_hit = l1i_dir_if.current_state.v && (l1i_dir_if.current_tag == tag);
+  assign hit_data = lb_hit ? lb_data_q : l1i_mem_if.rdata;
+
+  // The line buffer will hold the block of the instruction in the pipeline
+  // register if that one is delivered, so a PC accepted now in the same block
+  // hits the line buffer and does not need a new I-cache lookup. Instructions
+  // at the last halfword may straddle, so they do not fill the line buffer.
+  assign lb_next_vld = !flush && !sfence &&
+      ((pcgif_pipe_reg_if.tvalid && !invalidate) ? !last_half : lb_vld_q);
+  assign lb_next_addr = (pcgif_pipe_reg_if.tvalid && !invalidate) ?
+      pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] : lb_addr_q;
+  assign same_block = lb_next_vld && (pcgif_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] == lb_next_addr);
+
+  // Predecode for the PC generator: the length of the instruction at
+  // predecode_pc is known if its block is in the line buffer or is being
+  // read from the I-cache for the instruction in the pipeline register
+  assign pd_sel = predecode_pc[BLOCK_OFFSET_WIDTH-1:1];
+  always_comb begin
+    predecode_vld = 1'b0;
+    pd_block = lb_data_q;
+    if (lb_vld_q && (lb_priv_q == csr_pif.priv) &&
+        (predecode_pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] == lb_addr_q)) begin
+      predecode_vld = 1'b1;
+    end else if ((state_q == IDLE) && pcgif_pipe_reg_if.tvalid && l1itlb_hit && l1ic_hit &&
+                 (predecode_pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH] == pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH])) begin
+      predecode_vld = 1'b1;
+      pd_block = l1i_mem_if.rdata;
+    end
+    predecode_rvc = is_rvc(16'(pd_block >> (pd_sel * 16)));
+  end
 
   // State machine logic
   always_comb begin
@@ -99,19 +254,34 @@ module ifu
     l1ic_hit_d = l1ic_hit_q;
     rdata_d = rdata_q;
     rresp_d = rresp_q;
+    beat_d = beat_q;
+    arrived_d = arrived_q;
+    fill_addr_d = fill_addr_q;
+    fill_index_d = fill_index_q;
+    fill_hit = 1'b0;
     invalidate_d = invalidate_q;
+    stale_d = stale_q || fill_inval;
+    straddle_d = straddle_q;
+    low_half_d = low_half_q;
+    lb_vld_d = lb_vld_q;
+    lb_addr_d = lb_addr_q;
+    lb_data_d = lb_data_q;
+    lb_priv_d = lb_priv_q;
+    ptag_d = ptag_q;
+    fault_d = fault_q;
+    walked_d = walked_q;
+    walk_vpn_d = (state_q == PTW) ? walk_vpn_q : fetch_addr[ADDR_WIDTH-1-:20];
+    straddle_start = 1'b0;
+    l1itlb_if.lookup = 1'b0;
 
     pcgif_pipe_reg_if.tready = '0;
     ifid_pipe_reg_if.tvalid = '0;
 
-    tag = pcgif_pipe_tdata.pc[ADDR_WIDTH-1 -: TAG_WIDTH]; // TODO: The tag will be obtained from TLB when implemented
-    block_sel = (BLOCK_SEL_WIDTH==0) ? '0 : pcgif_pipe_tdata.pc[BLOCK_OFFSET_WIDTH-1 -: BLOCK_SEL_WIDTH];
-
-    ifid_tdata.inst = l1i_mem_if.rdata[block_sel*XLEN+:XLEN];
+    ifid_tdata.inst = extract(hit_data, half_sel);
     ifid_tdata.trap_cause = '0;  // TODO
     ifid_tdata.pcg_data = pcgif_pipe_tdata;
 
-    l1i_dir_if.next_tag = tag;
+    l1i_dir_if.next_tag = ptag_q;
     l1i_dir_if.next_state = '{default: '0, v: 1'b1};
     l1i_dir_if.write = '0;
 
@@ -120,70 +290,217 @@ module ifu
     unique case (state_q)
       IDLE: begin
         if (pcgif_pipe_reg_if.tvalid && !invalidate) begin
-          if (l1itlb_hit) begin
-            if (l1i_dir_if.current_state.v && (l1i_dir_if.current_tag == tag)) begin
-              l1ic_hit_d = 1'b1;
+          if (lb_hit || (l1itlb_hit && l1ic_hit)) begin
+            l1ic_hit_d = 1'b1;
+            if (last_half && !is_rvc(ifid_tdata.inst[15:0])) begin
+              low_half_d = ifid_tdata.inst[15:0];
+              straddle_d = 1'b1;
+              straddle_start = 1'b1;
+              state_d = STRADDLE;
+            end else begin
               ifid_pipe_reg_if.tvalid = 1'b1;
               if (ifid_pipe_reg_if.tready) begin
                 pcgif_pipe_reg_if.tready = 1'b1;
+                lb_vld_d = !last_half;
+                lb_addr_d = pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH];
+                lb_data_d = hit_data;
+                lb_priv_d = csr_pif.priv;
               end
-            end else begin
-              l1ic_hit_d = 1'b0;
-              arvalid_d = 1'b1;
-              rready_d = 1'b1;
-              state_d = LOAD;
             end
-          end else begin
+          end else if (l1itlb_fault) begin
+            fault_d = '0;
+            fault_d[EXC_IPF] = 1'b1;
+            state_d = FAULT;
+          end else if (l1itlb_walk) begin
             state_d = PTW;
+          end else begin
+            l1ic_hit_d = 1'b0;
+            arvalid_d = 1'b1;
+            rready_d = 1'b1;
+            ptag_d = tag;
+            state_d = LOAD;
           end
+          l1itlb_if.lookup = !lb_hit && translate && !walked_q && (state_d != IDLE || ifid_pipe_reg_if.tready);
         end
       end
       PTW: begin
-        // TODO
+        if (ptw_ifu_if.done) begin
+          walked_d = 1'b1;
+          fault_d  = '0;
+          if (invalidate_q || invalidate) begin
+            state_d = IDLE;
+          end else if (ptw_ifu_if.access_fault) begin
+            fault_d[EXC_IAF] = 1'b1;
+            state_d = FAULT;
+          end else if (ptw_ifu_if.page_fault) begin
+            fault_d[EXC_IPF] = 1'b1;
+            state_d = FAULT;
+          end else begin
+            state_d = straddle_q ? STRADDLE : IDLE;  // Look up again with the refilled entry
+          end
+        end
       end
       LOAD: begin
         if (ifu_ace_if.arready) begin
           arvalid_d = '0;
         end
-        if (ifu_ace_if.rvalid) begin
-          rready_d = '0;
-          rresp_d  = ifu_ace_if.rresp;
-          rdata_d  = ifu_ace_if.rdata;
+        if (ifu_ace_if.rvalid && rready_q) begin
+          rdata_d[BUS_WIDTH*beat_q+:BUS_WIDTH] = ifu_ace_if.rdata;
+          rresp_d = ifu_ace_if.rresp;
+          arrived_d[beat_q] = 1'b1;
+          beat_d = beat_q + BEAT_SEL_WIDTH'(1);
+          rready_d = !(&arrived_d);
         end
-        if (!rready_d) begin
-          ifid_tdata.inst = rdata_d[block_sel*XLEN+:XLEN];
-          if (!invalidate_q) begin
+        // Early restart: an instruction in the block is delivered as soon as
+        // the beats holding it have arrived. One at the last halfword may
+        // straddle, so it waits for the whole block.
+        fill_hit = in_fill && !straddle_q && !last_half && !invalidate && !invalidate_q &&
+            arrived_d[beat_of(half_sel)] && arrived_d[beat_of(half_sel+HALF_SEL_WIDTH'(1))];
+        if (rready_d) begin
+          if (fill_hit) begin
+            ifid_tdata.inst = extract(rdata_d, half_sel);
             ifid_pipe_reg_if.tvalid = 1'b1;
-            l1i_dir_if.write = 1'b1;  // TODO: Update the cache with appropriate index
+            pcgif_pipe_reg_if.tready = ifid_pipe_reg_if.tready;
+          end
+        end else begin
+          ifid_tdata.inst = straddle_q ? {rdata_d[15:0], low_half_q} : extract(rdata_d, half_sel);
+          if (!invalidate_q && !stale_d) begin
+            l1i_dir_if.write = 1'b1;
             l1i_mem_if.wstrb = '1;
           end
-          if (ifid_pipe_reg_if.tready) begin
+          if (!invalidate_q && !straddle_q && !in_fill) begin
+            // What was fetched from this block has all been delivered early
+            state_d = IDLE;
+          end else if (!invalidate_q && !invalidate && !straddle_q && last_half &&
+              !is_rvc(ifid_tdata.inst[15:0])) begin
+            low_half_d = ifid_tdata.inst[15:0];
+            straddle_d = 1'b1;
+            straddle_start = 1'b1;
+            state_d = STRADDLE;
+          end else begin
             if (!invalidate_q) begin
-              pcgif_pipe_reg_if.tready = 1'b1;
+              ifid_pipe_reg_if.tvalid = 1'b1;
+            end
+            if (ifid_pipe_reg_if.tready) begin
+              if (!invalidate_q) begin
+                pcgif_pipe_reg_if.tready = 1'b1;
+                lb_vld_d = !last_half;
+                lb_addr_d = pcgif_pipe_tdata.pc[ADDR_WIDTH-1-:BLOCK_ADDR_WIDTH];
+                lb_data_d = rdata_d;
+                lb_priv_d = csr_pif.priv;
+              end
+              state_d = IDLE;
             end
+          end
+        end
+      end
+      STRADDLE: begin
+        ifid_tdata.inst = {l1i_mem_if.rdata[15:0], low_half_q};
+        // The lower half may be of a fetch invalidated while its block arrived
+        if (invalidate || invalidate_q) begin
+          state_d = IDLE;
+        end else if (l1itlb_hit && l1ic_hit) begin
+          ifid_pipe_reg_if.tvalid = 1'b1;
+          if (ifid_pipe_reg_if.tready) begin
+            pcgif_pipe_reg_if.tready = 1'b1;
+            lb_vld_d = 1'b0;
             state_d = IDLE;
           end
+        end else if (l1itlb_fault) begin
+          fault_d = '0;
+          fault_d[EXC_IPF] = 1'b1;
+          state_d = FAULT;
+        end else if (l1itlb_walk) begin
+          state_d = PTW;
+        end else begin
+          arvalid_d = 1'b1;
+          rready_d = 1'b1;
+          ptag_d = tag;
+          state_d = LOAD;
         end
+        l1itlb_if.lookup = !invalidate && !invalidate_q && translate && !walked_q &&
+            (state_d != STRADDLE || ifid_pipe_reg_if.tready);
       end
-      WAIT: begin
+      FAULT: begin
+        // The faulting fetch goes down the pipeline without an instruction, and
+        // traps when it reaches the system unit
+        ifid_tdata.inst = '0;
+        ifid_tdata.trap_cause = fault_q;
+        if (invalidate) begin
+          state_d = IDLE;
+        end else begin
+          ifid_pipe_reg_if.tvalid = 1'b1;
+          if (ifid_pipe_reg_if.tready) begin
+            pcgif_pipe_reg_if.tready = 1'b1;
+            lb_vld_d = 1'b0;
+            state_d = IDLE;
+          end
+        end
       end
       default: begin
       end
     endcase
 
+    ifid_tdata.compressed = is_rvc(ifid_tdata.inst[15:0]);
     ifid_pipe_reg_if.tdata = ifid_tdata;
 
     l1i_mem_if.wdata = rdata_d;
 
-    if (invalidate && (state_q != IDLE)) begin
+    if (invalidate && !(state_q inside {IDLE, STRADDLE, FAULT})) begin
       if (!ifid_pipe_reg_if.tvalid) begin
         invalidate_d = 1'b1;
       end
     end
 
-    if (invalidate_q && !rready_d) begin
+    if (invalidate_q && !rready_d && (state_q != PTW)) begin
+      invalidate_d = '0;
+    end
+    if ((state_q == PTW) && ptw_ifu_if.done) begin
       invalidate_d = '0;
     end
+
+    if ((state_q != LOAD) && (state_d == LOAD)) begin
+      beat_d = BEAT_SEL_WIDTH'(fetch_addr[BLOCK_OFFSET_WIDTH-1:0] >> BUS_OFFSET_WIDTH);
+      arrived_d = '0;
+      fill_addr_d = {fetch_addr[ADDR_WIDTH-1:BUS_OFFSET_WIDTH], BUS_OFFSET_WIDTH'(0)};
+      fill_index_d = l1ic_dir_index_q;
+      stale_d = 1'b0;
+    end
+
+    if (state_d == IDLE) begin
+      straddle_d = 1'b0;
+    end
+    if (state_q inside {IDLE, STRADDLE}) begin
+      walked_d = 1'b0;
+    end
+
+    if (flush || sfence) begin
+      lb_vld_d = 1'b0;
+    end
+
+`ifndef SYNTHESIS
+    fetch_count_d  = fetch_count_q;
+    lb_hit_count_d = lb_hit_count_q;
+    refill_count_d = refill_count_q + 64'((state_q != LOAD) && (state_d == LOAD));
+    if (pcgif_pipe_reg_if.tvalid && pcgif_pipe_reg_if.tready && !invalidate) begin
+      fetch_count_d = fetch_count_q + 64'(1);
+      if ((state_q == IDLE) && lb_hit) begin
+        lb_hit_count_d = lb_hit_count_q + 64'(1);
+      end
+    end
+`endif
+  end
+
+  // A straddling instruction looks up the next block; otherwise the index
+  // follows accepted PCs, and is kept on line buffer hits to keep the SRAMs idle
+  always_comb begin
+    l1ic_dir_index_d = l1ic_dir_index_q;
+    if (straddle_start) begin
+      l1ic_dir_index_d = pcgif_pipe_tdata.pc[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH] + INDEX_WIDTH'(1);
+    end else if (pcgif_ack && !same_block) begin
+      l1ic_dir_index_d = pcgif_tdata.pc[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+    end
+    l1ic_mem_index_d = l1ic_dir_index_d;
   end
 
   // Update registers
@@ -196,6 +513,11 @@ module ifu
       rresp_q <= '0;
       l1ic_hit_q <= '0;
       invalidate_q <= '0;
+      stale_q <= '0;
+      straddle_q <= '0;
+      lb_vld_q <= '0;
+      fault_q <= '0;
+      walked_q <= '0;
     end else begin
       state_q <= state_d;
       arvalid_q <= arvalid_d;
@@ -204,15 +526,45 @@ module ifu
       rresp_q <= rresp_d;
       l1ic_hit_q <= l1ic_hit_d;
       invalidate_q <= invalidate_d;
+      stale_q <= stale_d;
+      straddle_q <= straddle_d;
+      lb_vld_q <= lb_vld_d;
+      fault_q <= fault_d;
+      walked_q <= walked_d;
     end
   end
 
-  always_ff @(posedge clk) begin  // Expecting to be synthesized to dedicated RAM elements
-    if (pcgif_ack) begin
-      l1ic_dir_index_q <= pcgif_tdata.pc[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
-      l1ic_mem_index_q <= pcgif_tdata.pc[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+  always_ff @(posedge clk) begin
+    low_half_q <= low_half_d;
+    lb_addr_q <= lb_addr_d;
+    lb_data_q <= lb_data_d;
+    lb_priv_q <= lb_priv_d;
+    ptag_q <= ptag_d;
+    walk_vpn_q <= walk_vpn_d;
+    beat_q <= beat_d;
+    arrived_q <= arrived_d;
+    fill_addr_q <= fill_addr_d;
+    fill_index_q <= fill_index_d;
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      fetch_count_q  <= '0;
+      lb_hit_count_q <= '0;
+      refill_count_q <= '0;
+    end else begin
+      fetch_count_q  <= fetch_count_d;
+      lb_hit_count_q <= lb_hit_count_d;
+      refill_count_q <= refill_count_d;
     end
   end
+`endif
+
+  always_ff @(posedge clk) begin  // Expecting to be synthesized to dedicated RAM elements
+    l1ic_dir_index_q <= l1ic_dir_index_d;
+    l1ic_mem_index_q <= l1ic_mem_index_d;
+  end
 
   axis_slice pcgif_slice (
       .clk(clk),
@@ -257,10 +609,10 @@ module ifu
 
   //// AR channel signals
   assign ifu_ace_if.arid = '0;  // TODO
-  assign ifu_ace_if.araddr = pcgif_pipe_tdata.pc;
-  assign ifu_ace_if.arlen = '0;  // TODO
-  assign ifu_ace_if.arsize = '0;  // TODO
-  assign ifu_ace_if.arburst = '0;  // TODO
+  assign ifu_ace_if.araddr = {ptag_q, fill_addr_q[ADDR_WIDTH-TAG_WIDTH-1:0]};  // Critical beat first
+  assign ifu_ace_if.arlen = ACE_AXLEN_WIDTH'(BEATS - 1);
+  assign ifu_ace_if.arsize = ACE_AXSIZE_WIDTH'(BUS_OFFSET_WIDTH);
+  assign ifu_ace_if.arburst = (BEATS > 1) ? ACE_BURST_WRAP : ACE_BURST_INCR;
   assign ifu_ace_if.arlock = '0;  // TODO
   assign ifu_ace_if.arcache = '0;  // TODO
   assign ifu_ace_if.arprot = '0;  // TODO
@@ -268,8 +620,10 @@ module ifu
   assign ifu_ace_if.arregion = '0;  // TODO
   assign ifu_ace_if.aruser = '0;  // TODO
   assign ifu_ace_if.arvalid = arvalid_q;
-  assign ifu_ace_if.arsnoop = '0;  // TODO
-  assign ifu_ace_if.ardomain = '0;  // TODO
+  // Other harts give up their dirty copies and keep clean shared ones, so
+  // that their next store to the block snoops this core and invalidates it
+  assign ifu_ace_if.arsnoop = ACE_READ_CLEAN;
+  assign ifu_ace_if.ardomain = ACE_DOMAIN_INNER_SHAREABLE;
   assign ifu_ace_if.arbar = '0;  // TODO
 
   //// R channel signals
@@ -288,7 +642,7 @@ module ifu
   assign ifu_ace_if.cdlast = '0;  // TODO
 
   //// Acknowledgment signals
-  assign ifu_ace_if.rack = rready_q && ifu_ace_if.rvalid; // NOTE: This might have to be delayed until the cache state is successfully updated
+  assign ifu_ace_if.rack = rready_q && ifu_ace_if.rvalid && ifu_ace_if.rlast; // NOTE: This might have to be delayed until the cache state is successfully updated
   assign ifu_ace_if.wack = '0;  // Unused
 
 endmodule
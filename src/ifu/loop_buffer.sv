@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+
+// Loop buffer between the IFU and the decoder
+//
+// It records the instructions the IFU delivers since the last redirect. If
+// a backward branch arrives whose target is the first one recorded, the run
+// is a whole loop body: the branch is predicted taken, and from then on the
+// PC generator is answered from the buffer, with the IFU and the L1 I-Cache
+// idle. The end of the body predecodes as a jump back to its head, so the
+// loop turns around without a redirect. The loop is left through any
+// redirect: the mispredicted branch at its exit, a trap or a FENCE.I.
+// Bodies with a SYSTEM instruction or a FENCE.I are not captured, and the
+// buffer is dropped on every exit, so its contents never outlive a change
+// of the address space or of the code.
+module loop_buffer
+  import riscv_pkg::*, offnariscv_pkg::*;
+#(
+    parameter DEPTH = 16  // Instructions; 0 disables the loop buffer
+) (
+    input logic clk,
+    input logic rst,
+
+    // From/To Program Counter Generator
+    axis_if.s pcgif_axis_if,
+    output logic predecode_vld,
+    output logic predecode_rvc,
+    output logic predecode_taken,  // ... and it ends the loop, whose head is predecode_target
+    output logic [XLEN-1:0] predecode_target,
+
+    // From/To Instruction Fetch Unit
+    axis_if.m lbif_axis_if,
+    axis_if.s iflb_axis_if,
+    input logic ifu_predecode_vld,
+    input logic ifu_predecode_rvc,
+
+    // To Decoder
+    axis_if.m ifid_axis_if,
+    output logic loop_taken,  // The branch at ifid_axis_if closes the loop
+
+    input logic invalidate,  // Back-end redirect
+    input logic fe_invalidate  // Any redirect, the decoder's included
+);
+
+  // Define local parameters
+  localparam ENTRIES = (DEPTH > 0) ? DEPTH : 1;
+  localparam PTR_WIDTH = (ENTRIES > 1) ? $clog2(ENTRIES) : 1;
+  localparam CNT_WIDTH = $clog2(ENTRIES + 1);
+
+  // Assert conditions
+  initial begin
+    assert (pcgif_axis_if.TDATA_WIDTH == $bits(pcgif_tdata_t))
+    else $fatal("pcgif_axis_if.TDATA_WIDTH must match pcgif_tdata_t");
+    assert (ifid_axis_if.TDATA_WIDTH == $bits(ifid_tdata_t))
+    else $fatal("ifid_axis_if.TDATA_WIDTH must match ifid_tdata_t");
+  end
+
+  // Declare registers and their next states
+  logic replay_q, replay_d;  // Serving the PC generator from the buffer
+  logic [CNT_WIDTH-1:0] count_q, count_d;  // Instructions recorded since the last redirect
+  logic capturable_q, capturable_d;  // ... none of which rules the run out
+  logic [XLEN-1:0] head_pc_q, head_pc_d;  // PC of the first one
+  logic [PTR_WIDTH-1:0] last_q, last_d;  // Entry of the branch that closes the loop
+  logic [PTR_WIDTH-1:0] rptr_q, rptr_d;  // Entry at the PC the PC generator offers
+  logic [XLEN-1:0] loop_mem[ENTRIES];
+  logic [ENTRIES-1:0] rvc_mem;
+
+`ifndef SYNTHESIS
+  logic [63:0] capture_count_q, capture_count_d;  // Loops captured
+  logic [63:0] replay_cycle_count_q, replay_cycle_count_d;  // Cycles served from the buffer
+  logic [63:0] replay_count_q, replay_count_d;  // ... and the instructions delivered in them
+`endif
+
+  // Declare wires
+  pcgif_tdata_t pcgif_tdata;
+  ifid_tdata_t iflb_tdata;
+  ifid_tdata_t replay_tdata;
+  logic iflb_ack;
+  logic record;  // Write iflb_tdata to the next entry
+  logic closing;  // iflb_tdata is a backward branch to head_pc_q
+  logic rules_out;  // iflb_tdata may not be replayed
+  logic capture;
+  logic [XLEN-1:0] branch_target;
+
+  always_comb begin
+    pcgif_tdata = pcgif_axis_if.tdata;
+    iflb_tdata = iflb_axis_if.tdata;
+
+    replay_tdata.inst = loop_mem[rptr_q];
+    replay_tdata.compressed = rvc_mem[rptr_q];
+    replay_tdata.trap_cause = '0;
+    replay_tdata.pcg_data = pcgif_tdata;
+
+    // Only the 32-bit branches are recognized; C.BEQZ/C.BNEZ leave the run
+    // going, and a loop closed by one is fetched as usual
+    branch_target = iflb_tdata.pcg_data.pc +
+        {{(XLEN - 12) {iflb_tdata.inst[31]}}, iflb_tdata.inst[7], iflb_tdata.inst[30:25],
+         iflb_tdata.inst[11:8], 1'b0};
+    closing = (DEPTH > 0) && !iflb_tdata.compressed &&
+        (iflb_tdata.inst[6:2] == BRANCH) && iflb_tdata.inst[31] &&
+        (branch_target == head_pc_q);
+    rules_out = !iflb_tdata.compressed &&
+        ((iflb_tdata.inst[6:2] == SYSTEM) ||
+         ((iflb_tdata.inst[6:2] == MISC_MEM) && (iflb_tdata.inst[14:12] == 3'b001)));  // FENCE.I
+
+    if (replay_q) begin
+      ifid_axis_if.tdata = replay_tdata;
+      ifid_axis_if.tvalid = pcgif_axis_if.tvalid;
+      pcgif_axis_if.tready = ifid_axis_if.tready;
+      lbif_axis_if.tvalid = 1'b0;
+      iflb_axis_if.tready = 1'b0;
+      loop_taken = (rptr_q == last_q);
+    end else begin
+      ifid_axis_if.tdata = iflb_tdata;
+      ifid_axis_if.tvalid = iflb_axis_if.tvalid;
+      iflb_axis_if.tready = ifid_axis_if.tready;
+      lbif_axis_if.tvalid = pcgif_axis_if.tvalid;
+      pcgif_axis_if.tready = lbif_axis_if.tready;
+      loop_taken = closing && capturable_q && (count_q != '0) && (count_q < CNT_WIDTH'(DEPTH)) &&
+          (iflb_tdata.trap_cause == '0);
+    end
+    lbif_axis_if.tdata = pcgif_axis_if.tdata;
+
+    predecode_vld = replay_q || ifu_predecode_vld;
+    predecode_rvc = replay_q ? rvc_mem[rptr_q] : ifu_predecode_rvc;
+    predecode_taken = replay_q && (rptr_q == last_q);
+    predecode_target = head_pc_q;
+
+    iflb_ack = !replay_q && iflb_axis_if.tvalid && iflb_axis_if.tready;
+    capture = iflb_ack && loop_taken;
+    record = iflb_ack && (count_q < CNT_WIDTH'(DEPTH));
+
+    replay_d = replay_q;
+    count_d = count_q;
+    capturable_d = capturable_q;
+    head_pc_d = head_pc_q;
+    last_d = last_q;
+    rptr_d = rptr_q;
+    if (invalidate) begin
+      replay_d = 1'b0;
+      count_d = '0;
+    end else if (capture) begin  // The decoder redirects the PC generator to head_pc_q
+      replay_d = 1'b1;
+      last_d = PTR_WIDTH'(count_q);
+      rptr_d = '0;
+    end else if (fe_invalidate) begin
+      replay_d = 1'b0;
+      count_d = '0;
+    end else if (replay_q) begin
+      if (pcgif_axis_if.tvalid && pcgif_axis_if.tready) begin
+        rptr_d = (rptr_q == last_q) ? '0 : rptr_q + PTR_WIDTH'(1);
+      end
+    end else if (iflb_ack) begin
+      if (iflb_tdata.trap_cause != '0) begin
+        count_d = '0;
+      end else begin
+        if (count_q == '0) begin
+          capturable_d = 1'b1;
+          head_pc_d = iflb_tdata.pcg_data.pc;
+        end
+        if (rules_out) capturable_d = 1'b0;
+        if (count_q < CNT_WIDTH'(DEPTH)) count_d = count_q + CNT_WIDTH'(1);
+      end
+    end
+
+`ifndef SYNTHESIS
+    capture_count_d = capture_count_q + 64'(capture && !invalidate);
+    replay_cycle_count_d = replay_cycle_count_q + 64'(replay_q);
+    replay_count_d = replay_count_q +
+        64'(replay_q && pcgif_axis_if.tvalid && pcgif_axis_if.tready && !invalidate);
+`endif
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      replay_q <= 1'b0;
+      count_q <= '0;
+      capturable_q <= 1'b0;
+      head_pc_q <= '0;
+      last_q <= '0;
+      rptr_q <= '0;
+    end else begin
+      replay_q <= replay_d;
+      count_q <= count_d;
+      capturable_q <= capturable_d;
+      head_pc_q <= head_pc_d;
+      last_q <= last_d;
+      rptr_q <= rptr_d;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (record) begin
+      loop_mem[PTR_WIDTH'(count_q)] <= iflb_tdata.inst;
+      rvc_mem[PTR_WIDTH'(count_q)] <= iflb_tdata.compressed;
+    end
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      capture_count_q <= '0;
+      replay_cycle_count_q <= '0;
+      replay_count_q <= '0;
+    end else begin
+      capture_count_q <= capture_count_d;
+      replay_cycle_count_q <= replay_cycle_count_d;
+      replay_count_q <= replay_count_d;
+    end
+  end
+`endif
+
+endmodule
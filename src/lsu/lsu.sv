@@ -1,8 +1,12 @@
 // SPDX-License-Identifier: MIT
 
 module lsu
-  import offnariscv_pkg::*;
-(
+  import riscv_pkg::*, offnariscv_pkg::*;
+#(
+    parameter PREFETCH_DEGREE = 2,  // Blocks prefetched per trigger; 0 disables the prefetcher
+    parameter PREFETCH_DISTANCE = 1,  // Strides between the trigger and the first of them
+    parameter PREFETCH_BUFFER = 4  // Prefetched blocks waiting for a load
+) (
     input clk,
     input rst,
 
@@ -15,18 +19,40 @@ module lsu
     // To L1 D-Cache
     cache_dir_if.req l1d_dir_if,
     cache_mem_if.req l1d_mem_if,
+    cache_dir_if.req l1d_snoop_dir_if,  // Second port, for the snoop responder
+    cache_mem_if.req l1d_snoop_mem_if,
 
-    input logic invalidate
+    // Address translation
+    csr_pif.req csr_pif,
+    tlb_if.req l1dtlb_if,
+    ptw_if.req ptw_lsu_if,
+
+    // Accesses to the CLINT bypass the L1D
+    clint_if.req lsu_clint_if,
+
+    // Second port of the L1 I-Cache directory. Stores and invalidating snoops
+    // drop the block from the L1I, so FENCE.I need not flush it.
+    cache_dir_if.req l1i_dir_if,
+    output logic l1i_inval_vld,
+    output logic [XLEN-1:0] l1i_inval_addr,
+
+    input logic invalidate,
+    input logic demand_busy  // The IFU or PTW reads over the shared port
 );
 
   // Define local parameters
   localparam ADDR_WIDTH = lsu_ace_if.ACE_AXADDR_WIDTH;
-  localparam BLOCK_SIZE = lsu_ace_if.ACE_XDATA_WIDTH;
+  localparam BLOCK_SIZE = l1d_mem_if.BLOCK_SIZE;
   localparam BLOCK_OFFSET_WIDTH = $clog2(BLOCK_SIZE / 8);
-  localparam BLOCK_SEL_WIDTH = $clog2(BLOCK_SIZE / XLEN);
+  localparam BUS_WIDTH = lsu_ace_if.ACE_XDATA_WIDTH;
+  localparam BUS_OFFSET_WIDTH = $clog2(BUS_WIDTH / 8);
+  localparam BEATS = BLOCK_SIZE / BUS_WIDTH;  // A line moves in a burst of this many beats
+  localparam BEAT_SEL_WIDTH = (BEATS > 1) ? $clog2(BEATS) : 1;
   localparam INDEX_WIDTH = l1d_dir_if.INDEX_WIDTH;
   localparam TAG_WIDTH = l1d_dir_if.TAG_WIDTH;
   localparam STRB_WIDTH = l1d_mem_if.STRB_WIDTH;
+  localparam BLOCK_ADDR_WIDTH = ADDR_WIDTH - BLOCK_OFFSET_WIDTH;
+  localparam PF_SEL_WIDTH = (PREFETCH_BUFFER > 1) ? $clog2(PREFETCH_BUFFER) : 1;
 
   // Assert conditions
   initial begin
@@ -34,45 +60,103 @@ module lsu
     else $fatal("lsu_ace_if.ADDR_WIDTH must be equal to XLEN for now");
     assert (TAG_WIDTH + INDEX_WIDTH + BLOCK_OFFSET_WIDTH == ADDR_WIDTH)
     else $fatal("TAG_WIDTH + INDEX_WIDTH + BLOCK_OFFSET_WIDTH must equal ADDR_WIDTH");
-    assert (l1d_mem_if.BLOCK_SIZE == BLOCK_SIZE)
-    else $fatal("l1d_mem_if.BLOCK_SIZE must match BLOCK_SIZE");
+    assert (TAG_WIDTH == 20)
+    else $fatal("The L1 D-Cache must be indexed within the page offset, so the tag is the PPN");
+    assert ((BEATS * BUS_WIDTH == BLOCK_SIZE) && (BEATS inside {1, 2, 4, 8, 16}))
+    else $fatal("A block must be a wrapping burst of 1, 2, 4, 8 or 16 beats");
     assert (l1d_mem_if.INDEX_WIDTH == INDEX_WIDTH)
     else $fatal("l1d_mem_if.INDEX_WIDTH must match INDEX_WIDTH");
+    assert ((l1i_dir_if.INDEX_WIDTH == INDEX_WIDTH) && (l1i_dir_if.TAG_WIDTH == TAG_WIDTH))
+    else $fatal("The L1 I-Cache must have the geometry of the L1 D-Cache");
+    assert (PREFETCH_BUFFER == 2 ** PF_SEL_WIDTH)
+    else $fatal("PREFETCH_BUFFER must be a power of 2");
   end
 
   // Define types
-  typedef enum logic [1:0] {
+  typedef enum logic [2:0] {
     IDLE,
     COMPARE,
-    WAIT
-  } state_e;  // TODO: There might be more states for AMO in the future
+    WAIT,
+    PTW,
+    FAULT
+  } state_e;
+
+  typedef enum logic [1:0] {
+    SNOOP_IDLE,
+    SNOOP_LOOKUP,
+    SNOOP_RESP
+  } snoop_state_e;
+
+  typedef enum logic [1:0] {
+    PF_IDLE,
+    PF_AR,
+    PF_R
+  } pf_state_e;
 
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(lsuwb_tdata_t))) lsuwb_slice_if ();
 
   // Define functions
+  function automatic logic [3:0] byte_mask(lsu_cmd_e cmd);
+    unique case (cmd)
+      LSU_LH, LSU_LHU, LSU_SH: byte_mask = 4'b0011;
+      LSU_LB, LSU_LBU, LSU_SB: byte_mask = 4'b0001;
+      default: byte_mask = 4'b1111;  // Words, LR/SC and AMOs
+    endcase
+  endfunction
+
+  // Any byte offset works, so a misaligned access within the block is no
+  // slower than an aligned one
   function automatic logic [XLEN-1:0] slice_load(logic [BLOCK_SIZE-1:0] block, lsu_cmd_e cmd,
                                                  logic [BLOCK_OFFSET_WIDTH-1:0] offset);
-    slice_load = '0;
+    logic [XLEN-1:0] word;
+    word = XLEN'(block >> (8 * offset));
+    slice_load = word;
     case (cmd)
-      LSU_LW:  slice_load = block[XLEN*offset[2+:BLOCK_SEL_WIDTH]+:XLEN];
-      LSU_LH:  slice_load = XLEN'(signed'(block[16*offset[1+:BLOCK_SEL_WIDTH+1]+:16]));
-      LSU_LB:  slice_load = XLEN'(signed'(block[8*offset[0+:BLOCK_SEL_WIDTH+2]+:8]));
-      LSU_LHU: slice_load = XLEN'(unsigned'(block[16*offset[1+:BLOCK_SEL_WIDTH+1]+:16]));
-      LSU_LBU: slice_load = XLEN'(unsigned'(block[8*offset[0+:BLOCK_SEL_WIDTH+2]+:8]));
+      LSU_LH:  slice_load = XLEN'(signed'(word[15:0]));
+      LSU_LB:  slice_load = XLEN'(signed'(word[7:0]));
+      LSU_LHU: slice_load = XLEN'(unsigned'(word[15:0]));
+      LSU_LBU: slice_load = XLEN'(unsigned'(word[7:0]));
       default: begin
       end
     endcase
   endfunction
 
-  function automatic logic [STRB_WIDTH-1:0] get_strb(lsu_cmd_e cmd,
-                                                     logic [BLOCK_OFFSET_WIDTH-1:0] offset);
-    get_strb = '0;
+  // The upper half holds the bytes that spill into the next block
+  function automatic logic [2*STRB_WIDTH-1:0] get_strb(lsu_cmd_e cmd,
+                                                       logic [BLOCK_OFFSET_WIDTH-1:0] offset);
+    get_strb = (2 * STRB_WIDTH)'(byte_mask(cmd)) << offset;
+  endfunction
+
+  // Beats of the block that hold any of the bytes in `strb`
+  function automatic logic [BEATS-1:0] beats_of(logic [STRB_WIDTH-1:0] strb);
+    for (int i = 0; i < BEATS; i++) begin
+      beats_of[i] = |strb[BUS_WIDTH/8*i+:BUS_WIDTH/8];
+    end
+  endfunction
+
+  function automatic logic is_amo(lsu_cmd_e cmd);
+    return cmd inside {LSU_AMOSWAP, LSU_AMOADD, LSU_AMOXOR, LSU_AMOAND, LSU_AMOOR, LSU_AMOMIN,
+                       LSU_AMOMAX, LSU_AMOMINU, LSU_AMOMAXU};
+  endfunction
+
+  function automatic logic is_cbo(lsu_cmd_e cmd);
+    return cmd inside {LSU_CBO_CLEAN, LSU_CBO_FLUSH, LSU_CBO_INVAL, LSU_CBO_ZERO};
+  endfunction
+
+  function automatic logic [XLEN-1:0] amo_compute(lsu_cmd_e cmd, logic [XLEN-1:0] mem,
+                                                  logic [XLEN-1:0] src);
+    amo_compute = src;
     case (cmd)
-      LSU_SW: get_strb[4*offset[2+:BLOCK_SEL_WIDTH]+:4] = '1;
-      LSU_SH: get_strb[2*offset[1+:BLOCK_SEL_WIDTH+1]+:2] = '1;
-      LSU_SB: get_strb[offset[0+:BLOCK_SEL_WIDTH+2]] = '1;
-      default: begin
+      LSU_AMOADD:  amo_compute = mem + src;
+      LSU_AMOXOR:  amo_compute = mem ^ src;
+      LSU_AMOAND:  amo_compute = mem & src;
+      LSU_AMOOR:   amo_compute = mem | src;
+      LSU_AMOMIN:  amo_compute = ($signed(mem) < $signed(src)) ? mem : src;
+      LSU_AMOMAX:  amo_compute = ($signed(mem) < $signed(src)) ? src : mem;
+      LSU_AMOMINU: amo_compute = (mem < src) ? mem : src;
+      LSU_AMOMAXU: amo_compute = (mem < src) ? src : mem;
+      default: begin  // LSU_AMOSWAP
       end
     endcase
   endfunction
@@ -98,18 +182,133 @@ module lsu
   logic store_q, store_d;
   lsu_cmd_e cmd_q, cmd_d;
   logic [XLEN-1:0] op2_q, op2_d;
+  trap_cause_t fault_q, fault_d;
+  logic walked_q, walked_d;  // The DTLB entry was just refilled, so the lookup is not counted again
+  logic arlock_q, arlock_d;  // Exclusive read, for LR and for the upgrade of SC
+
+  // A refill is a wrapping burst that starts at the beat of the access, and a
+  // plain load returns as soon as its beats have arrived (early restart); the
+  // line is written to the L1D once the burst is complete
+  logic [BEAT_SEL_WIDTH-1:0] rbeat_q, rbeat_d;  // Beat expected next
+  logic [BEATS-1:0] arrived_q, arrived_d;
+  logic early_q, early_d;  // The load has already returned
+  logic [BEAT_SEL_WIDTH-1:0] wbeat_q, wbeat_d;  // Beat of the write-back being sent
+
+  // An access that crosses a block is split into two, one per block. A store
+  // that also crosses a page first looks up the translation of the second
+  // page (probe), so that a fault there leaves memory untouched.
+  logic [ADDR_WIDTH-1:0] vaddr_q, vaddr_d;  // Virtual address of the whole access
+  logic split_q, split_d;
+  logic second_q, second_d;  // Working on the second block
+  logic probe_q, probe_d;
+  logic [XLEN-1:0] lo_data_q, lo_data_d;  // Last word of the first block, for a split load
+
+  // LR/SC reservation, on a physical block. It is lost when the line is
+  // invalidated by a snoop or evicted, so a successful SC always writes a line
+  // that has stayed in this cache since the LR.
+  logic rsv_vld_q, rsv_vld_d;
+  logic [ADDR_WIDTH-BLOCK_OFFSET_WIDTH-1:0] rsv_addr_q, rsv_addr_d;
 
   logic [INDEX_WIDTH-1:0] l1dc_dir_index_q, l1dc_dir_index_d;
   logic [INDEX_WIDTH-1:0] l1dc_mem_index_q, l1dc_mem_index_d;
 
+  // Snoop responder
+  snoop_state_e snoop_state_q, snoop_state_d;
+  logic [ADDR_WIDTH-1:0] acaddr_q, acaddr_d;
+  ace_snoop_e acsnoop_q, acsnoop_d;
+  logic crvalid_q, crvalid_d;
+  ace_crresp_t crresp_q, crresp_d;
+  logic cdvalid_q, cdvalid_d;
+  logic [BLOCK_SIZE-1:0] cddata_q, cddata_d;
+  logic [BEAT_SEL_WIDTH-1:0] cdbeat_q, cdbeat_d;
+
+  // Prefetcher. Its reads use the AR and R channels between demand reads,
+  // one at a time, and fill a small buffer instead of the L1D; a load that
+  // misses the L1D takes its line from there, as a shared clean one. Only
+  // clean copies are read, so a buffered block is dropped by any snoop to
+  // it and by any other access of this hart to it, and a prefetch still in
+  // flight is not installed.
+  logic [XLEN-1:0] pc_q, pc_d;  // Of the access
+  logic [TAG_WIDTH-1:0] pf_ppn_q, pf_ppn_d;  // Of the page of the last trigger
+  logic pf_req_vld_q, pf_req_vld_d;  // A prefetch waits for the bus
+  logic [BLOCK_ADDR_WIDTH-1:0] pf_req_addr_q, pf_req_addr_d;
+  pf_state_e pf_state_q, pf_state_d;
+  logic [BLOCK_ADDR_WIDTH-1:0] pf_addr_q, pf_addr_d;  // Block in flight
+  logic [BEAT_SEL_WIDTH-1:0] pf_beat_q, pf_beat_d;
+  logic [BLOCK_SIZE-1:0] pf_rdata_q, pf_rdata_d;
+  logic pf_poison_q, pf_poison_d;  // ... which is not to be installed
+  logic [PREFETCH_BUFFER-1:0] pf_buf_vld_q, pf_buf_vld_d;
+  logic [PF_SEL_WIDTH-1:0] pf_wptr_q, pf_wptr_d;  // Entry filled next, round robin
+  logic [BLOCK_ADDR_WIDTH-1:0] pf_buf_addr_mem[PREFETCH_BUFFER];
+  logic [BLOCK_SIZE-1:0] pf_buf_data_mem[PREFETCH_BUFFER];
+
+`ifndef SYNTHESIS
+  logic [63:0] pf_fill_count_q, pf_fill_count_d;  // Prefetched blocks put into the buffer
+  logic [63:0] pf_hit_count_q, pf_hit_count_d;  // ... and taken by a load that missed the L1D
+  logic [63:0] pf_drop_count_q, pf_drop_count_d;  // Prefetches dropped for a demand read
+  logic [63:0] load_miss_count_q, load_miss_count_d;  // Loads that missed both and read the bus
+`endif
+
   // Declare wires
   rflsu_tdata_t rflsu_tdata;
   logic [XLEN-1:0] effective_addr;
-  logic l1dtlb_hit;
+  logic translate;
+  logic l1dtlb_hit;  // The DTLB has a usable translation
+  logic l1dtlb_walk;  // ... has none, or Svadu has to set its A/D bits
+  logic l1dtlb_fault;
+  logic [TAG_WIDTH-1:0] ptag;  // Physical tag
   lsuwb_tdata_t lsuwb_tdata;
   logic [BLOCK_SIZE-1:0] store_data;
+  logic l1d_hit;
+  logic snoop_lookup;  // The snoop responder owns the directory entries in this cycle
+  logic snoop_hit;
+  logic l1i_snoop_hit;  // The L1I holds the snooped line too
+  logic rsv_match;  // The reservation covers the block being accessed
+  logic sc_fail;
+  logic exokay;  // The exclusive read was granted
+  logic [XLEN-1:0] amo_mem;  // Old value of the word an AMO works on
+  logic [BLOCK_OFFSET_WIDTH-1:0] offset;  // Byte offset of the access in its first block
+  logic [ADDR_WIDTH-1:0] next_block_addr;
+  logic [BLOCK_SIZE-1:0] load_block;
+  logic [XLEN-1:0] load_result;
+  logic [XLEN-1:0] store_word;
+  logic misaligned;
+  logic [2*STRB_WIDTH-1:0] issue_strb;  // Byte strobes of the incoming access, over two blocks
+  logic [2*STRB_WIDTH-1:0] access_strb;  // ... of the current one
+  logic next_part;  // Moving on to the other block of a split access
+  logic early_hit;  // The beats of a plain load have arrived before the end of the refill
+  logic [ADDR_WIDTH-1:0] paddr;  // Physical address in COMPARE
+  logic clint_access;
+  logic clint_fault;  // The CLINT only takes aligned loads and stores
+  logic cbo_manage;  // cbo.clean, cbo.flush or cbo.inval
+  logic [TAG_WIDTH-1:0] l1i_inval_tag;
+  logic store_fault;  // Faults are reported as store ones, for stores and all CBOs
+  logic demand_read;  // A miss goes to the bus
+  logic [PREFETCH_BUFFER-1:0] pf_buf_match;  // Entries holding the block in COMPARE
+  logic pf_buf_hit;  // ... which a load that missed the L1D takes
+  logic [PF_SEL_WIDTH-1:0] pf_buf_sel;
+  logic [BLOCK_ADDR_WIDTH-1:0] victim_addr;  // Block written back on a miss
+  logic pf_train;
+  logic pf_trigger;
+  logic pf_fire;  // The trigger starts a run of prefetches, from its page
+  logic pf_cand_vld;
+  logic [XLEN-1:0] pf_cand_addr;
+  logic pf_cand_ready;
+  logic [BLOCK_ADDR_WIDTH-1:0] pf_cand_block;
+  logic pf_cand_skip;
+  logic pf_fill;  // The prefetch in flight goes into the buffer
+  logic pf_ar;  // The AR channel carries a prefetch
 
   assign rflsu_axis_if.tready = rflsu_tready_q;
+  assign snoop_lookup = (snoop_state_q == SNOOP_LOOKUP);
+
+  // The indices of the next cycle, for SRAMs with a synchronous read
+  assign l1d_dir_if.next_index = l1dc_dir_index_d;
+  assign l1d_mem_if.next_index = l1dc_mem_index_d;
+  assign l1d_snoop_dir_if.next_index = acaddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+  assign l1d_snoop_mem_if.next_index = acaddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+  assign l1i_dir_if.next_index = (snoop_state_d == SNOOP_LOOKUP) ?
+      acaddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH] : l1dc_dir_index_d;
 
   always_comb begin
     state_d = state_q;
@@ -131,129 +330,627 @@ module lsu
     store_d = store_q;
     cmd_d = cmd_q;
     op2_d = op2_q;
+    fault_d = fault_q;
+    walked_d = walked_q;
+    arlock_d = arlock_q;
+    rbeat_d = rbeat_q;
+    arrived_d = arrived_q;
+    early_d = early_q;
+    wbeat_d = wbeat_q;
+    vaddr_d = vaddr_q;
+    split_d = split_q;
+    second_d = second_q;
+    probe_d = probe_q;
+    lo_data_d = lo_data_q;
+    rsv_vld_d = rsv_vld_q;
+    rsv_addr_d = rsv_addr_q;
+    pc_d = pc_q;
+    pf_ppn_d = pf_ppn_q;
+    pf_req_vld_d = pf_req_vld_q;
+    pf_req_addr_d = pf_req_addr_q;
+    pf_state_d = pf_state_q;
+    pf_addr_d = pf_addr_q;
+    pf_beat_d = pf_beat_q;
+    pf_rdata_d = pf_rdata_q;
+    pf_poison_d = pf_poison_q;
+    pf_buf_vld_d = pf_buf_vld_q;
+    pf_wptr_d = pf_wptr_q;
 
     l1dc_dir_index_d = l1dc_dir_index_q;
     l1dc_mem_index_d = l1dc_mem_index_q;
 
     rflsu_tdata = rflsu_axis_if.tdata;
     effective_addr = rflsu_tdata.operands.op1 + rflsu_tdata.offset;
-    l1dtlb_hit = 1'b1;  // TODO
+    if (is_cbo(rflsu_tdata.cmd)) effective_addr[BLOCK_OFFSET_WIDTH-1:0] = '0;
+    misaligned = (byte_mask(rflsu_tdata.cmd) == 4'b1111) ? |effective_addr[1:0] :
+        (byte_mask(rflsu_tdata.cmd) == 4'b0011) && effective_addr[0];
+    issue_strb = get_strb(rflsu_tdata.cmd, effective_addr[BLOCK_OFFSET_WIDTH-1:0]);
+    offset = vaddr_q[BLOCK_OFFSET_WIDTH-1:0];
+    access_strb = get_strb(cmd_q, offset);
+    next_block_addr = {vaddr_q[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH] + 1'b1, BLOCK_OFFSET_WIDTH'(0)};
+    next_part = 1'b0;
+
+    // cbo.zero is a store of a whole block. The other CBOs may be done on any
+    // page that can be either loaded from or stored to, and do not set D.
+    cbo_manage = cmd_q inside {LSU_CBO_CLEAN, LSU_CBO_FLUSH, LSU_CBO_INVAL};
+    store_fault = store_q || cbo_manage;
+
+    // Address translation, with the privilege level after MPRV
+    translate = csr_pif.satp.mode && (csr_pif.ls_priv != PRIV_M);
+    l1dtlb_if.vpn = araddr_q[ADDR_WIDTH-1-:20];
+    l1dtlb_if.asid = csr_pif.satp.asid;
+    l1dtlb_if.refill = (state_q == PTW) && ptw_lsu_if.done && !ptw_lsu_if.page_fault &&
+        !ptw_lsu_if.access_fault;
+    l1dtlb_if.refill_entry = ptw_lsu_if.entry;
+    l1dtlb_fault = translate && l1dtlb_if.hit &&
+        ((!tlb_permits(l1dtlb_if.entry, csr_pif.ls_priv, csr_pif.sum, csr_pif.mxr, 1'b0, store_q) &&
+          !(cbo_manage &&
+            tlb_permits(l1dtlb_if.entry, csr_pif.ls_priv, csr_pif.sum, csr_pif.mxr, 1'b0, 1'b1))) ||
+         (!csr_pif.adue && (!l1dtlb_if.entry.a || (store_q && !l1dtlb_if.entry.d))));
+    l1dtlb_walk = translate && !l1dtlb_fault &&
+        (!l1dtlb_if.hit || !l1dtlb_if.entry.a || (store_q && !l1dtlb_if.entry.d));
+    l1dtlb_hit = !l1dtlb_walk && !l1dtlb_fault;
+    ptag = translate ? l1dtlb_if.ppn : tag_q;
+    paddr = {ptag, araddr_q[ADDR_WIDTH-TAG_WIDTH-1:0]};
+    ptw_lsu_if.valid = (state_q == PTW);
+    ptw_lsu_if.vpn = araddr_q[ADDR_WIDTH-1-:20];
+    ptw_lsu_if.store = store_q;
+
     lsuwb_tdata = '0;
-    lsuwb_tdata.result = slice_load(l1d_mem_if.rdata, cmd_q, araddr_q[BLOCK_OFFSET_WIDTH-1:0]);
     l1d_dir_if.index = l1dc_dir_index_q;
     l1d_dir_if.next_tag = tag_q;
     l1d_dir_if.next_state = '{default: '0, v: 1'b1};
+    // MESI: a store needs the line in a unique state, a load takes whatever the interconnect grants
+    l1d_dir_if.next_state.d = rresp_d[2];  // PassDirty
+    l1d_dir_if.next_state.u = store_q || !rresp_d[3];  // IsShared
+    l1d_hit = l1d_dir_if.current_state.v && (l1d_dir_if.current_tag == ptag) &&
+        (!store_q || l1d_dir_if.current_state.u);
     l1d_dir_if.write = '0;
     lsuwb_slice_if.tvalid = '0;
 
-    if (lsu_ace_if.arready) begin  // AR channel
+    pf_ar = (pf_state_q == PF_AR);
+    if (lsu_ace_if.arready && !pf_ar) begin  // AR channel
       arvalid_d = '0;
     end
-    if (lsu_ace_if.rvalid) begin  // R channel
-      rready_d = '0;
-      rdata_d  = lsu_ace_if.rdata;
-      rresp_d  = lsu_ace_if.rresp;
+    if (lsu_ace_if.rvalid && rready_q && (pf_state_q != PF_R)) begin  // R channel
+      rdata_d[BUS_WIDTH*rbeat_q+:BUS_WIDTH] = lsu_ace_if.rdata;
+      rresp_d = lsu_ace_if.rresp;
+      arrived_d[rbeat_q] = 1'b1;
+      rbeat_d = rbeat_q + BEAT_SEL_WIDTH'(1);
+      rready_d = !(&arrived_d);
     end
     if (lsu_ace_if.awready) begin  // AW channel
       awvalid_d = '0;
     end
-    if (lsu_ace_if.wready) begin  // W channel
-      wvalid_d = '0;
+    if (lsu_ace_if.wready && wvalid_q) begin  // W channel
+      wbeat_d = wbeat_q + BEAT_SEL_WIDTH'(1);
+      wvalid_d = (wbeat_q != BEAT_SEL_WIDTH'(BEATS - 1));
     end
     if (lsu_ace_if.bvalid) begin  // B channel
       bready_d = '0;
       bresp_d  = lsu_ace_if.bresp;
     end
 
-    store_data = '0;
-    unique case (cmd_q)
-      LSU_SW: store_data = {(BLOCK_SIZE / 32) {op2_q}};
-      LSU_SH: store_data = {(BLOCK_SIZE / 16) {op2_q[15:0]}};
-      LSU_SB: store_data = {(BLOCK_SIZE / 8) {op2_q[7:0]}};
-      default: begin
-      end
-    endcase
+    // The second access of a split load joins the last word of the first block
+    // with the first word of the second; a split access starts in that last word
+    load_block = (state_q == WAIT) ? rdata_d : l1d_mem_if.rdata;
+    load_result = second_q ?
+        slice_load(BLOCK_SIZE'({load_block[XLEN-1:0], lo_data_q}), cmd_q,
+                   BLOCK_OFFSET_WIDTH'(offset[1:0])) : slice_load(load_block, cmd_q, offset);
+    lsuwb_tdata.result = load_result;
+    early_hit = rready_d && load_q && (cmd_q != LSU_LR) && !split_q && !early_q &&
+        ((beats_of(access_strb[STRB_WIDTH-1:0]) & ~arrived_d) == '0);
+
+    // In WAIT, the tag is already physical. An SC upgrade succeeds only if no
+    // snoop took the line meanwhile and the interconnect granted the exclusive read.
+    rsv_match = rsv_vld_q && (rsv_addr_q == {(state_q == WAIT) ? tag_q : ptag, index_q});
+    exokay = (rresp_d[1:0] == ACE_RESP_EXOKAY);
+    sc_fail = (cmd_q == LSU_SC) && !(rsv_match && ((state_q != WAIT) || exokay));
+    // The read-modify-write of an AMO happens on the line itself: on a hit the
+    // old word comes from the L1D read in COMPARE and the new one is written
+    // back in the same cycle, and on a miss it is merged into the refill
+    amo_mem = slice_load(load_block, LSU_LW, offset);
+
+    // Rotated, so that byte i of the block takes byte (i - offset) % 4 of the
+    // word. This also holds for the bytes that a split store puts in the next block.
+    store_word = is_amo(cmd_q) ? amo_compute(cmd_q, amo_mem, op2_q) : op2_q;
+    store_data = {(BLOCK_SIZE / XLEN) {(store_word << (8 * offset[1:0])) |
+                                       (store_word >> (XLEN - 8 * offset[1:0]))}};
 
     l1d_mem_if.index = l1dc_mem_index_q;
     l1d_mem_if.wstrb = '0;
     l1d_mem_if.wdata = rdata_d;
-    if (store_q) begin
+    if (store_q && !sc_fail) begin
       l1d_dir_if.next_state.d = 1'b1;
       for (int i = 0; i < STRB_WIDTH; i++) begin
         if (wstrb_q[i]) begin
-          l1d_mem_if.wdata[8*i+:8] = store_data[8*(i%4)+:8];
+          l1d_mem_if.wdata[8*i+:8] = store_data[8*i+:8];
         end
       end
     end
+    // The other CBOs keep the tag, and clean or drop the line only if it is still there
+    if (cbo_manage) begin
+      l1d_dir_if.next_tag = l1d_dir_if.current_tag;
+      l1d_dir_if.next_state = l1d_dir_if.current_state;
+      if (l1d_dir_if.current_tag == tag_q) begin
+        l1d_dir_if.next_state.d = 1'b0;
+        if (cmd_q != LSU_CBO_CLEAN) l1d_dir_if.next_state = '0;
+      end
+    end
+
+    // CLINT, in COMPARE
+    clint_access = (paddr[ADDR_WIDTH-1:CLINT_ADDR_WIDTH] == CLINT_BASE[ADDR_WIDTH-1:CLINT_ADDR_WIDTH]);
+    clint_fault = split_q || (cmd_q inside {LSU_LR, LSU_SC}) || is_amo(cmd_q) || is_cbo(cmd_q) ||
+        ((byte_mask(cmd_q) == 4'b1111) ? |offset[1:0] : (byte_mask(cmd_q) == 4'b0011) && offset[0]);
+    lsu_clint_if.valid = 1'b0;
+    lsu_clint_if.write = store_q;
+    lsu_clint_if.addr = paddr[CLINT_ADDR_WIDTH-1:0];
+    lsu_clint_if.wdata = op2_q << (8 * offset[1:0]);
+    lsu_clint_if.wstrb = byte_mask(cmd_q) << offset[1:0];
+
+    // Prefetch buffer, in COMPARE. Any access to a buffered block but a
+    // load that misses the L1D drops it, as the L1D has or takes the line.
+    demand_read = 1'b0;
+    pf_trigger = 1'b0;
+    pf_buf_sel = '0;
+    for (int i = 0; i < PREFETCH_BUFFER; i++) begin
+      pf_buf_match[i] = pf_buf_vld_q[i] && (pf_buf_addr_mem[i] == {ptag, index_q});
+      if (pf_buf_match[i]) pf_buf_sel = PF_SEL_WIDTH'(i);
+    end
+    pf_buf_hit = 1'b0;
+    victim_addr = {l1d_dir_if.current_tag, index_q};
 
     unique case (state_q)
       IDLE: begin
-        araddr_d = effective_addr;
-        tag_d = effective_addr[ADDR_WIDTH-1-:TAG_WIDTH];
-        index_d = effective_addr[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
-        load_d = rflsu_tdata.cmd inside {LSU_LW, LSU_LH, LSU_LB, LSU_LHU, LSU_LBU};
-        store_d = rflsu_tdata.cmd inside {LSU_SW, LSU_SH, LSU_SB};
+        vaddr_d = effective_addr;
+        load_d = rflsu_tdata.cmd inside {LSU_LW, LSU_LH, LSU_LB, LSU_LHU, LSU_LBU, LSU_LR};
+        // SC, AMOs and cbo.zero need the line in a unique state, just as stores do
+        store_d = rflsu_tdata.cmd inside {LSU_SW, LSU_SH, LSU_SB, LSU_SC, LSU_CBO_ZERO} ||
+            is_amo(rflsu_tdata.cmd);
         cmd_d = rflsu_tdata.cmd;
         op2_d = rflsu_tdata.operands.op2;
-        l1dc_dir_index_d = effective_addr[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
-        l1dc_mem_index_d = effective_addr[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+        pc_d = rflsu_tdata.pc;
+        split_d = |issue_strb[2*STRB_WIDTH-1:STRB_WIDTH];
+        second_d = 1'b0;
+        probe_d = split_d && store_d &&
+            (&effective_addr[ADDR_WIDTH-TAG_WIDTH-1:BLOCK_OFFSET_WIDTH]);  // Last block of the page
+        araddr_d = probe_d ?
+            {effective_addr[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH] + 1'b1, BLOCK_OFFSET_WIDTH'(0)} :
+            effective_addr;
+        tag_d = araddr_d[ADDR_WIDTH-1-:TAG_WIDTH];
+        index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+        l1dc_dir_index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+        l1dc_mem_index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
         if (store_d) begin
-          wstrb_d = get_strb(cmd_d, effective_addr[BLOCK_OFFSET_WIDTH-1:0]);
+          // cbo.zero stores op2, which is x0, to every byte of the block
+          wstrb_d = (rflsu_tdata.cmd == LSU_CBO_ZERO) ? '1 : issue_strb[STRB_WIDTH-1:0];
         end
+        walked_d = 1'b0;
         if (rflsu_axis_if.tvalid && !invalidate) begin
           state_d = COMPARE;
+          // LR/SC and AMOs must be naturally aligned
+          if (misaligned && (cmd_d inside {LSU_LR, LSU_SC} || is_amo(cmd_d))) begin
+            araddr_d = effective_addr;
+            fault_d = '0;
+            fault_d[store_d ? EXC_SAM : EXC_LAM] = 1'b1;
+            state_d = FAULT;
+          end
         end
       end
       COMPARE: begin
-        if (l1dtlb_hit) begin
-          if (l1d_dir_if.current_state.v && (l1d_dir_if.current_tag == tag_q)) begin  // Hit
+        if (!snoop_lookup && l1dtlb_fault) begin
+          fault_d = '0;
+          fault_d[store_fault ? EXC_SPF : EXC_LPF] = 1'b1;
+          state_d = FAULT;
+        end else if (!snoop_lookup && l1dtlb_walk) begin
+          state_d = PTW;
+        end else if (l1dtlb_hit && !snoop_lookup) begin
+          if (!(load_q && (cmd_q != LSU_LR))) begin
+            pf_buf_vld_d &= ~pf_buf_match;
+            if ((pf_state_q != PF_IDLE) && (pf_addr_q == {ptag, index_q})) pf_poison_d = 1'b1;
+          end
+          if (probe_q) begin  // The second page is fine, so start with the first block
+            next_part = 1'b1;
+          end else if (clint_access && clint_fault) begin
+            fault_d = '0;
+            fault_d[store_fault ? EXC_SAF : EXC_LAF] = 1'b1;
+            state_d = FAULT;
+          end else if (clint_access) begin
+            lsuwb_slice_if.tvalid = 1'b1;
+            lsuwb_tdata.result = slice_load(BLOCK_SIZE'(lsu_clint_if.rdata), cmd_q,
+                                            BLOCK_OFFSET_WIDTH'(offset[1:0]));
+            if (lsuwb_slice_if.tready) begin
+              lsu_clint_if.valid = 1'b1;
+              state_d = IDLE;
+            end
+          end else if (cbo_manage) begin
+            // Write a dirty copy back, and have the interconnect clean (or
+            // clean and invalidate) every other copy with a dataless read;
+            // the directory entry is updated once both are done
+            arvalid_d = 1'b1;
+            rready_d  = 1'b1;
+            rbeat_d   = '0;
+            arrived_d = ~BEATS'(1);  // A single beat comes back
+            early_d   = 1'b0;
+            wbeat_d   = '0;
+            araddr_d  = paddr;
+            tag_d     = ptag;
+            awaddr_d  = paddr;
+            wdata_d   = l1d_mem_if.rdata;
+            if (l1d_hit && l1d_dir_if.current_state.d) begin
+              awvalid_d = 1'b1;
+              wvalid_d  = 1'b1;
+              bready_d  = 1'b1;
+            end
+            state_d = WAIT;
+          end else if (sc_fail) begin  // Fail without touching the line
             lsuwb_slice_if.tvalid = 1'b1;
+            lsuwb_tdata.result = XLEN'(1);
+            if (lsuwb_slice_if.tready) begin
+              rsv_vld_d = 1'b0;
+              state_d = IDLE;
+            end
+          end else if (l1d_hit && split_q && !second_q) begin  // Hit, first block
+            if (store_q) begin
+              l1d_dir_if.write = 1'b1;
+              l1d_mem_if.wstrb = wstrb_q;
+            end
+            next_part = 1'b1;
+          end else if (l1d_hit) begin  // Hit
+            lsuwb_slice_if.tvalid = 1'b1;
+            if (cmd_q == LSU_SC) lsuwb_tdata.result = '0;
             if (lsuwb_slice_if.tready) begin
               if (store_q) begin
                 l1d_dir_if.write = 1'b1;
                 l1d_mem_if.wstrb = wstrb_q;
               end
+              if (cmd_q inside {LSU_LR, LSU_SC}) begin
+                rsv_vld_d  = (cmd_q == LSU_LR);
+                rsv_addr_d = {ptag, index_q};
+              end
               state_d = IDLE;
             end
           end else begin  // Miss
             arvalid_d = 1'b1;
             rready_d  = 1'b1;
+            arlock_d  = cmd_q inside {LSU_LR, LSU_SC};
+            rbeat_d   = BEAT_SEL_WIDTH'(araddr_q[BLOCK_OFFSET_WIDTH-1:0] >> BUS_OFFSET_WIDTH);
+            // cbo.zero overwrites the whole line, so it only takes ownership
+            // with a dataless MakeUnique instead of reading the line
+            arrived_d = (cmd_q == LSU_CBO_ZERO) ? ~(BEATS'(1) << rbeat_d) : '0;
+            early_d   = 1'b0;
+            wbeat_d   = '0;
+            araddr_d  = {ptag, araddr_q[ADDR_WIDTH-TAG_WIDTH-1:0]};
+            tag_d     = ptag;
             awaddr_d  = {l1d_dir_if.current_tag, index_q, BLOCK_OFFSET_WIDTH'(0)};
             wdata_d   = l1d_mem_if.rdata;
+            if (l1d_dir_if.current_state.v && (l1d_dir_if.current_tag != ptag) &&
+                (rsv_addr_q == {l1d_dir_if.current_tag, index_q})) begin  // Eviction
+              rsv_vld_d = 1'b0;
+            end
+            // A store to a shared line is an upgrade: the line is clean, so it is just re-read
             if (l1d_dir_if.current_state.v && l1d_dir_if.current_state.d) begin  // Write back
               awvalid_d = 1'b1;
               wvalid_d  = 1'b1;
               bready_d  = 1'b1;
+              // A block prefetched while the line was dirty here is stale
+              for (int i = 0; i < PREFETCH_BUFFER; i++) begin
+                if (pf_buf_addr_mem[i] == victim_addr) pf_buf_vld_d[i] = 1'b0;
+              end
+              if ((pf_state_q != PF_IDLE) && (pf_addr_q == victim_addr)) pf_poison_d = 1'b1;
+            end
+            pf_trigger = load_q && (cmd_q != LSU_LR);
+            // The line is installed in WAIT, so a snoop accepted now would look
+            // up neither the L1D nor the buffer entry; read the line instead
+            pf_buf_hit = pf_trigger && (|pf_buf_match) && (snoop_state_q == SNOOP_IDLE) &&
+                !lsu_ace_if.acvalid;
+            if (pf_buf_hit) begin  // Take the line from the prefetch buffer, clean and shared
+              arvalid_d  = 1'b0;
+              rready_d   = 1'b0;
+              arrived_d  = '1;
+              rdata_d    = pf_buf_data_mem[pf_buf_sel];
+              rresp_d    = '0;
+              rresp_d[3] = 1'b1;  // IsShared
+              pf_buf_vld_d[pf_buf_sel] = 1'b0;
+            end else begin
+              demand_read = 1'b1;
+              pf_buf_vld_d &= ~pf_buf_match;  // Stores to the line would leave it stale
+              // The demand read brings the line in; a prefetch of it is late
+              if ((pf_state_q != PF_IDLE) && (pf_addr_q == {ptag, index_q})) pf_poison_d = 1'b1;
             end
             state_d = WAIT;
           end
         end
       end
       WAIT: begin
-        if (!rready_d && !bready_d) begin
+        if (early_hit) begin
+          lsuwb_slice_if.tvalid = 1'b1;
+          early_d = lsuwb_slice_if.tready;
+        end
+        if (!rready_d && !bready_d && !snoop_lookup && early_q) begin
+          l1d_dir_if.write = 1'b1;
+          l1d_mem_if.wstrb = '1;
+          state_d = IDLE;
+        end else if (!rready_d && !bready_d && !snoop_lookup && split_q && !second_q) begin
+          l1d_dir_if.write = 1'b1;
+          l1d_mem_if.wstrb = '1;
+          next_part = 1'b1;
+        end else if (!rready_d && !bready_d && !snoop_lookup) begin
           lsuwb_slice_if.tvalid = 1'b1;
-          lsuwb_tdata.result = slice_load(rdata_d, cmd_q, araddr_q[BLOCK_OFFSET_WIDTH-1:0]);
+          lsuwb_tdata.result = (cmd_q == LSU_SC) ? XLEN'(sc_fail) : load_result;
           if (lsuwb_slice_if.tready) begin
             l1d_dir_if.write = 1'b1;
-            l1d_mem_if.wstrb = '1;
-            state_d = IDLE;
+            l1d_mem_if.wstrb = cbo_manage ? '0 : '1;
+            if (cmd_q inside {LSU_LR, LSU_SC}) begin
+              rsv_vld_d  = (cmd_q == LSU_LR) && exokay;
+              rsv_addr_d = {tag_q, index_q};
+            end
+            if ((cmd_q inside {LSU_CBO_FLUSH, LSU_CBO_INVAL}) && (rsv_addr_q == {tag_q, index_q})) begin
+              rsv_vld_d = 1'b0;
+            end
+            arlock_d = 1'b0;
+            state_d  = IDLE;
+          end
+        end
+      end
+      PTW: begin
+        if (ptw_lsu_if.done) begin
+          walked_d = 1'b1;
+          fault_d  = '0;
+          if (ptw_lsu_if.access_fault) begin
+            fault_d[store_fault ? EXC_SAF : EXC_LAF] = 1'b1;
+            state_d = FAULT;
+          end else if (ptw_lsu_if.page_fault) begin
+            fault_d[store_fault ? EXC_SPF : EXC_LPF] = 1'b1;
+            state_d = FAULT;
+          end else begin
+            state_d = COMPARE;  // Look up again with the refilled entry
           end
         end
       end
+      FAULT: begin
+        lsuwb_slice_if.tvalid = 1'b1;
+        lsuwb_tdata.trap_cause = fault_q;
+        lsuwb_tdata.trap = 1'b1;
+        lsuwb_tdata.tval = araddr_q;
+        if (lsuwb_slice_if.tready) begin
+          state_d = IDLE;
+        end
+      end
       default: begin
       end
     endcase
 
+    if (next_part) begin
+      // After the probe, the first block; after the first block, the second
+      second_d = !probe_q;
+      probe_d = 1'b0;
+      lo_data_d = load_block[BLOCK_SIZE-1-:XLEN];
+      araddr_d = probe_q ? vaddr_q : next_block_addr;
+      tag_d = araddr_d[ADDR_WIDTH-1-:TAG_WIDTH];
+      index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+      l1dc_dir_index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+      l1dc_mem_index_d = araddr_d[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+      if (store_q) begin
+        wstrb_d = probe_q ? access_strb[STRB_WIDTH-1:0] : access_strb[2*STRB_WIDTH-1:STRB_WIDTH];
+      end
+      walked_d = 1'b0;
+      arlock_d = 1'b0;
+      state_d = COMPARE;
+    end
+
     rflsu_tready_d = (state_d == IDLE);
+    l1dtlb_if.lookup = (state_q == COMPARE) && ((state_d != COMPARE) || next_part) && translate &&
+        !walked_q;
+
+    // Snoop responder, on the second port of the L1D. It takes one snoop at a
+    // time; its directory update happens in SNOOP_LOOKUP, during which the
+    // LSU holds back its own directory accesses, so snoops and accesses to
+    // the same line are serialized in either order.
+    snoop_state_d = snoop_state_q;
+    acaddr_d = acaddr_q;
+    acsnoop_d = acsnoop_q;
+    crvalid_d = crvalid_q;
+    crresp_d = crresp_q;
+    cdvalid_d = cdvalid_q;
+    cddata_d = cddata_q;
+
+    l1d_snoop_dir_if.index = acaddr_q[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+    l1d_snoop_dir_if.next_tag = l1d_snoop_dir_if.current_tag;
+    l1d_snoop_dir_if.next_state = l1d_snoop_dir_if.current_state;
+    l1d_snoop_dir_if.write = 1'b0;
+    l1d_snoop_mem_if.index = acaddr_q[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+    l1d_snoop_mem_if.wdata = '0;
+    l1d_snoop_mem_if.wstrb = '0;
+    snoop_hit = l1d_snoop_dir_if.current_state.v &&
+        (l1d_snoop_dir_if.current_tag == acaddr_q[ADDR_WIDTH-1-:TAG_WIDTH]);
+    l1i_snoop_hit = l1i_dir_if.current_state.v &&
+        (l1i_dir_if.current_tag == acaddr_q[ADDR_WIDTH-1-:TAG_WIDTH]);
+
+    cdbeat_d = cdbeat_q;
+    if (lsu_ace_if.crready) crvalid_d = 1'b0;
+    if (lsu_ace_if.cdready && cdvalid_q) begin
+      cdbeat_d  = cdbeat_q + BEAT_SEL_WIDTH'(1);
+      cdvalid_d = (cdbeat_q != BEAT_SEL_WIDTH'(BEATS - 1));
+    end
+
+    unique case (snoop_state_q)
+      SNOOP_IDLE: begin
+        if (lsu_ace_if.acvalid) begin
+          acaddr_d = lsu_ace_if.acaddr;
+          acsnoop_d = ace_snoop_e'(lsu_ace_if.acsnoop);
+          snoop_state_d = SNOOP_LOOKUP;
+        end
+      end
+      SNOOP_LOOKUP: begin
+        crresp_d = '0;
+        cddata_d = l1d_snoop_mem_if.rdata;
+        if (snoop_hit) begin
+          crresp_d.was_unique = l1d_snoop_dir_if.current_state.u;
+          unique case (acsnoop_q)
+            ACE_READ_ONCE: begin
+              crresp_d.data_transfer = 1'b1;
+              crresp_d.is_shared = 1'b1;
+            end
+            ACE_READ_SHARED, ACE_READ_CLEAN, ACE_READ_NOT_SHARED_DIRTY: begin
+              // Hand the dirty data over and keep a clean shared copy
+              crresp_d.data_transfer = 1'b1;
+              crresp_d.pass_dirty = l1d_snoop_dir_if.current_state.d;
+              crresp_d.is_shared = 1'b1;
+              l1d_snoop_dir_if.next_state = '{v: 1'b1, d: 1'b0, u: 1'b0};
+              l1d_snoop_dir_if.write = 1'b1;
+            end
+            ACE_READ_UNIQUE: begin
+              crresp_d.data_transfer = 1'b1;
+              crresp_d.pass_dirty = l1d_snoop_dir_if.current_state.d;
+              l1d_snoop_dir_if.next_state = '0;
+              l1d_snoop_dir_if.write = 1'b1;
+            end
+            ACE_CLEAN_SHARED: begin
+              crresp_d.data_transfer = l1d_snoop_dir_if.current_state.d;
+              crresp_d.pass_dirty = l1d_snoop_dir_if.current_state.d;
+              crresp_d.is_shared = 1'b1;
+              l1d_snoop_dir_if.next_state.d = 1'b0;
+              l1d_snoop_dir_if.write = 1'b1;
+            end
+            ACE_CLEAN_INVALID: begin
+              crresp_d.data_transfer = l1d_snoop_dir_if.current_state.d;
+              crresp_d.pass_dirty = l1d_snoop_dir_if.current_state.d;
+              l1d_snoop_dir_if.next_state = '0;
+              l1d_snoop_dir_if.write = 1'b1;
+            end
+            ACE_MAKE_INVALID, ACE_MAKE_UNIQUE: begin  // The line is about to be overwritten
+              l1d_snoop_dir_if.next_state = '0;
+              l1d_snoop_dir_if.write = 1'b1;
+            end
+            default: begin
+            end
+          endcase
+        end
+        // A line held only by the L1I is still a copy: the requester must not
+        // take it unique, or it could store to it without an invalidating snoop
+        // and leave this hart running stale code. Invalidating snoops drop it
+        // from the L1I below instead.
+        if (l1i_snoop_hit && !(acsnoop_q inside {ACE_READ_UNIQUE, ACE_CLEAN_INVALID,
+                                                 ACE_MAKE_INVALID, ACE_MAKE_UNIQUE})) begin
+          crresp_d.is_shared = 1'b1;
+        end
+        // Another master is taking the line, so this hart's SC must fail. The
+        // LSU does not complete an access in this cycle, so this cannot race
+        // with an LR setting the reservation.
+        if ((acsnoop_q inside {ACE_READ_UNIQUE, ACE_CLEAN_INVALID, ACE_MAKE_INVALID, ACE_MAKE_UNIQUE}) &&
+            (acaddr_q[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH] == rsv_addr_q)) begin
+          rsv_vld_d = 1'b0;
+        end
+        // The prefetch buffer does not answer snoops, so the requester may
+        // take the line unique; any snoop drops the block from it
+        for (int i = 0; i < PREFETCH_BUFFER; i++) begin
+          if (pf_buf_addr_mem[i] == acaddr_q[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH]) pf_buf_vld_d[i] = 1'b0;
+        end
+        if ((pf_state_q != PF_IDLE) && (pf_addr_q == acaddr_q[ADDR_WIDTH-1:BLOCK_OFFSET_WIDTH])) begin
+          pf_poison_d = 1'b1;
+        end
+        crvalid_d = 1'b1;
+        cdvalid_d = crresp_d.data_transfer;
+        cdbeat_d = '0;
+        snoop_state_d = SNOOP_RESP;
+      end
+      SNOOP_RESP: begin
+        if (!crvalid_d && !cdvalid_d) snoop_state_d = SNOOP_IDLE;
+      end
+      default: begin
+      end
+    endcase
+
+    // Prefetcher. It trains on the loads that complete their lookup, and a
+    // miss drops the prefetch waiting for the bus and what the prefetcher has
+    // left. A prefetch goes out only when no demand read or write-back is
+    // outstanding, so the buffer never reads a block ahead of its write-back,
+    // and not while the IFU or PTW reads, so it never delays a fetch or walk.
+    pf_train = (state_q == COMPARE) && l1dtlb_hit && !snoop_lookup && !probe_q && !second_q &&
+        load_q && (cmd_q != LSU_LR) && !clint_access && ((state_d != COMPARE) || next_part);
+    if (pf_fire) pf_ppn_d = ptag;
+    pf_cand_block = {pf_ppn_q, pf_cand_addr[ADDR_WIDTH-TAG_WIDTH-1:BLOCK_OFFSET_WIDTH]};
+    pf_cand_ready = !pf_req_vld_q && !demand_read;
+    if (demand_read) pf_req_vld_d = 1'b0;
+    // Blocks already buffered or in flight and the CLINT are not prefetched
+    pf_cand_skip = ((pf_state_q != PF_IDLE) && (pf_addr_q == pf_cand_block)) ||
+        (pf_cand_block[BLOCK_ADDR_WIDTH-1-:ADDR_WIDTH-CLINT_ADDR_WIDTH] ==
+         CLINT_BASE[ADDR_WIDTH-1:CLINT_ADDR_WIDTH]);
+    for (int i = 0; i < PREFETCH_BUFFER; i++) begin
+      if (pf_buf_vld_q[i] && (pf_buf_addr_mem[i] == pf_cand_block)) pf_cand_skip = 1'b1;
+    end
+    if (pf_cand_vld && pf_cand_ready) begin
+      pf_req_vld_d = !pf_cand_skip;
+      pf_req_addr_d = pf_cand_block;
+    end
+
+    pf_fill = 1'b0;
+    unique case (pf_state_q)
+      PF_IDLE: begin
+        if (pf_req_vld_q && !demand_read && !demand_busy && !arvalid_d && !rready_d && !bready_d) begin
+          pf_req_vld_d = 1'b0;
+          pf_addr_d = pf_req_addr_q;
+          pf_beat_d = '0;
+          pf_poison_d = 1'b0;
+          pf_state_d = PF_AR;
+        end
+      end
+      PF_AR: begin
+        if (lsu_ace_if.arready) pf_state_d = PF_R;
+      end
+      PF_R: begin
+        if (lsu_ace_if.rvalid) begin
+          pf_rdata_d[BUS_WIDTH*pf_beat_q+:BUS_WIDTH] = lsu_ace_if.rdata;
+          if (lsu_ace_if.rresp[1:0] != ACE_RESP_OKAY) pf_poison_d = 1'b1;  // Not memory
+          pf_beat_d = pf_beat_q + BEAT_SEL_WIDTH'(1);
+          if (lsu_ace_if.rlast) begin
+            pf_fill = !pf_poison_d;
+            pf_state_d = PF_IDLE;
+          end
+        end
+      end
+      default: begin
+      end
+    endcase
+    if (pf_fill) begin
+      pf_buf_vld_d[pf_wptr_q] = 1'b1;
+      pf_wptr_d = pf_wptr_q + PF_SEL_WIDTH'(1);
+    end
 
 `ifndef SYNTHESIS
-    lsuwb_tdata.addr  = araddr_q;
-    lsuwb_tdata.wdata = op2_q;
-    lsuwb_tdata.store = store_q;
+    pf_fill_count_d = pf_fill_count_q + 64'(pf_fill);
+    pf_hit_count_d = pf_hit_count_q + 64'(pf_buf_hit);
+    pf_drop_count_d = pf_drop_count_q + 64'(demand_read && pf_req_vld_q);
+    load_miss_count_d = load_miss_count_q + 64'(demand_read && pf_trigger);
+
+    lsuwb_tdata.addr  = (state_q == COMPARE) ? {ptag, araddr_q[ADDR_WIDTH-TAG_WIDTH-1:0]} : araddr_q;
+    lsuwb_tdata.wdata = store_word;  // What an AMO stores, not its operand
+    lsuwb_tdata.store = store_q && !lsuwb_tdata.trap && !sc_fail;
 `endif
     lsuwb_slice_if.tdata = lsuwb_tdata;
   end
 
+  // The LSU writes the L1D only outside SNOOP_LOOKUP, so the snoop responder
+  // and the store path take turns on the L1I directory as they do on the L1D one
+  always_comb begin
+    if (snoop_lookup) begin
+      l1i_dir_if.index = acaddr_q[BLOCK_OFFSET_WIDTH+:INDEX_WIDTH];
+      l1i_inval_tag = acaddr_q[ADDR_WIDTH-1-:TAG_WIDTH];
+      l1i_inval_vld = acsnoop_q inside {ACE_READ_UNIQUE, ACE_CLEAN_INVALID, ACE_MAKE_INVALID,
+                                        ACE_MAKE_UNIQUE};
+    end else begin
+      l1i_dir_if.index = l1d_dir_if.index;
+      l1i_inval_tag = (state_q == COMPARE) ? ptag : tag_q;
+      l1i_inval_vld = l1d_dir_if.write && store_q;
+    end
+    l1i_inval_addr = {l1i_inval_tag, l1i_dir_if.index, BLOCK_OFFSET_WIDTH'(0)};
+    l1i_dir_if.next_tag = l1i_dir_if.current_tag;
+    l1i_dir_if.next_state = '0;
+    l1i_dir_if.write = l1i_inval_vld && l1i_dir_if.current_state.v &&
+        (l1i_dir_if.current_tag == l1i_inval_tag);
+  end
+
   always_ff @(posedge clk) begin
     if (rst) begin
       state_q <= IDLE;
@@ -276,6 +973,20 @@ module lsu
       store_q <= 0;
       cmd_q <= LSU_LW;
       op2_q <= '0;
+      fault_q <= '0;
+      walked_q <= 1'b0;
+      arlock_q <= 1'b0;
+      rbeat_q <= '0;
+      arrived_q <= '0;
+      early_q <= 1'b0;
+      wbeat_q <= '0;
+      vaddr_q <= '0;
+      split_q <= 1'b0;
+      second_q <= 1'b0;
+      probe_q <= 1'b0;
+      lo_data_q <= '0;
+      rsv_vld_q <= 1'b0;
+      rsv_addr_q <= '0;
     end else begin
       state_q <= state_d;
       rflsu_tready_q <= rflsu_tready_d;
@@ -297,11 +1008,26 @@ module lsu
       store_q <= store_d;
       cmd_q <= cmd_d;
       op2_q <= op2_d;
+      fault_q <= fault_d;
+      walked_q <= walked_d;
+      arlock_q <= arlock_d;
+      rbeat_q <= rbeat_d;
+      arrived_q <= arrived_d;
+      early_q <= early_d;
+      wbeat_q <= wbeat_d;
+      vaddr_q <= vaddr_d;
+      split_q <= split_d;
+      second_q <= second_d;
+      probe_q <= probe_d;
+      lo_data_q <= lo_data_d;
+      rsv_vld_q <= rsv_vld_d;
+      rsv_addr_q <= rsv_addr_d;
+`ifndef OFFNARISCV_QUIET
       $write(
           "LSU: state=%s, arvalid=%b, rready=%b, awvalid=%b, wvalid=%b, wdata=0x%h, wstrb=0x%h, bready=%b, bresp=0x%h, addr=0x%h\n",
           state_q.name(), arvalid_q, rready_q, awvalid_q, wvalid_q, wdata_q, wstrb_q, bready_q,
           bresp_q, araddr_q);
-      if ((state_q == COMPARE) && l1dtlb_hit && l1d_dir_if.current_state.v && (l1d_dir_if.current_tag == tag_q))
+      if ((state_q == COMPARE) && l1dtlb_hit && l1d_dir_if.current_state.v && (l1d_dir_if.current_tag == ptag))
         $write(
             "LSU: Cache hit... araddr=0x%h, tag=0x%h, index=0x%h, rdata=0x%h\n",
             araddr_q,
@@ -316,6 +1042,7 @@ module lsu
             l1d_mem_if.wdata,
             wstrb_q
         );
+`endif
     end
   end
 
@@ -324,6 +1051,97 @@ module lsu
     l1dc_mem_index_q <= l1dc_mem_index_d;
   end
 
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      snoop_state_q <= SNOOP_IDLE;
+      acaddr_q <= '0;
+      acsnoop_q <= ACE_READ_ONCE;
+      crvalid_q <= 1'b0;
+      crresp_q <= '0;
+      cdvalid_q <= 1'b0;
+      cddata_q <= '0;
+      cdbeat_q <= '0;
+    end else begin
+      snoop_state_q <= snoop_state_d;
+      acaddr_q <= acaddr_d;
+      acsnoop_q <= acsnoop_d;
+      crvalid_q <= crvalid_d;
+      crresp_q <= crresp_d;
+      cdvalid_q <= cdvalid_d;
+      cddata_q <= cddata_d;
+      cdbeat_q <= cdbeat_d;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      pc_q <= '0;
+      pf_ppn_q <= '0;
+      pf_req_vld_q <= 1'b0;
+      pf_req_addr_q <= '0;
+      pf_state_q <= PF_IDLE;
+      pf_addr_q <= '0;
+      pf_beat_q <= '0;
+      pf_rdata_q <= '0;
+      pf_poison_q <= 1'b0;
+      pf_buf_vld_q <= '0;
+      pf_wptr_q <= '0;
+    end else begin
+      pc_q <= pc_d;
+      pf_ppn_q <= pf_ppn_d;
+      pf_req_vld_q <= pf_req_vld_d;
+      pf_req_addr_q <= pf_req_addr_d;
+      pf_state_q <= pf_state_d;
+      pf_addr_q <= pf_addr_d;
+      pf_beat_q <= pf_beat_d;
+      pf_rdata_q <= pf_rdata_d;
+      pf_poison_q <= pf_poison_d;
+      pf_buf_vld_q <= pf_buf_vld_d;
+      pf_wptr_q <= pf_wptr_d;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (pf_fill) begin
+      pf_buf_addr_mem[pf_wptr_q] <= pf_addr_q;
+      pf_buf_data_mem[pf_wptr_q] <= pf_rdata_d;
+    end
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      pf_fill_count_q <= '0;
+      pf_hit_count_q <= '0;
+      pf_drop_count_q <= '0;
+      load_miss_count_q <= '0;
+    end else begin
+      pf_fill_count_q <= pf_fill_count_d;
+      pf_hit_count_q <= pf_hit_count_d;
+      pf_drop_count_q <= pf_drop_count_d;
+      load_miss_count_q <= load_miss_count_d;
+    end
+  end
+`endif
+
+  stride_prefetcher #(
+      .DEGREE(PREFETCH_DEGREE),
+      .DISTANCE(PREFETCH_DISTANCE),
+      .BLOCK_OFFSET_WIDTH(BLOCK_OFFSET_WIDTH)
+  ) stride_prefetcher_inst (
+      .clk(clk),
+      .rst(rst),
+      .train(pf_train),
+      .train_pc(pc_q),
+      .train_addr(vaddr_q),
+      .trigger(pf_trigger),
+      .fire(pf_fire),
+      .req_vld(pf_cand_vld),
+      .req_addr(pf_cand_addr),
+      .req_ready(pf_cand_ready),
+      .cancel(demand_read)
+  );
+
   axis_skid_buffer lsuwb_slice_inst (
       .clk(clk),
       .rst(rst),
@@ -337,24 +1155,24 @@ module lsu
   assign lsu_ace_if.awvalid = awvalid_q;
   assign lsu_ace_if.awid = '0;  // TODO
   assign lsu_ace_if.awaddr = awaddr_q;
-  assign lsu_ace_if.awlen = '0;  // TODO
-  assign lsu_ace_if.awsize = '0;  // TODO
-  assign lsu_ace_if.awburst = '0;  // TODO
-  assign lsu_ace_if.awlock = '0;  // TODO
+  assign lsu_ace_if.awlen = ACE_AXLEN_WIDTH'(BEATS - 1);
+  assign lsu_ace_if.awsize = ACE_AXSIZE_WIDTH'(BUS_OFFSET_WIDTH);
+  assign lsu_ace_if.awburst = ACE_BURST_INCR;
+  assign lsu_ace_if.awlock = 1'b0;  // Only write-backs; a successful SC completes in the L1D
   assign lsu_ace_if.awcache = '0;  // TODO
   assign lsu_ace_if.awprot = '0;  // TODO
   assign lsu_ace_if.awqos = '0;  // TODO
   assign lsu_ace_if.awregion = '0;  // TODO
   assign lsu_ace_if.awuser = '0;  // TODO
-  assign lsu_ace_if.awsnoop = '0;  // TODO
-  assign lsu_ace_if.awdomain = '0;  // TODO
+  assign lsu_ace_if.awsnoop = ACE_WRITE_BACK;
+  assign lsu_ace_if.awdomain = ACE_DOMAIN_INNER_SHAREABLE;
   assign lsu_ace_if.awbar = '0;  // TODO
 
   //// W channel signals
   assign lsu_ace_if.wvalid = wvalid_q;
-  assign lsu_ace_if.wdata = wdata_q;
+  assign lsu_ace_if.wdata = wdata_q[BUS_WIDTH*wbeat_q+:BUS_WIDTH];
   assign lsu_ace_if.wstrb = '1;  // For write back
-  assign lsu_ace_if.wlast = 1'b1;  // TODO
+  assign lsu_ace_if.wlast = (wbeat_q == BEAT_SEL_WIDTH'(BEATS - 1));
   assign lsu_ace_if.wuser = '0;  // TODO
 
   //// B channel signals
@@ -362,35 +1180,46 @@ module lsu
 
   //// AR channel signals
   assign lsu_ace_if.arid = '0;  // TODO
-  assign lsu_ace_if.araddr = araddr_q;
-  assign lsu_ace_if.arlen = '0;  // TODO
-  assign lsu_ace_if.arsize = '0;  // TODO
-  assign lsu_ace_if.arburst = '0;  // TODO
-  assign lsu_ace_if.arlock = '0;  // TODO
+  assign lsu_ace_if.araddr = pf_ar ? {pf_addr_q, BLOCK_OFFSET_WIDTH'(0)} :
+      {araddr_q[ADDR_WIDTH-1:BUS_OFFSET_WIDTH], BUS_OFFSET_WIDTH'(0)};  // Critical beat first
+  assign lsu_ace_if.arlen = (is_cbo(cmd_q) && !pf_ar) ? '0 : ACE_AXLEN_WIDTH'(BEATS - 1);  // CBOs are dataless
+  assign lsu_ace_if.arsize = ACE_AXSIZE_WIDTH'(BUS_OFFSET_WIDTH);
+  assign lsu_ace_if.arburst = ((BEATS > 1) && !is_cbo(cmd_q) && !pf_ar) ? ACE_BURST_WRAP :
+      ACE_BURST_INCR;  // A prefetch starts at the first beat
+  assign lsu_ace_if.arlock = arlock_q && !pf_ar;
   assign lsu_ace_if.arcache = '0;  // TODO
   assign lsu_ace_if.arprot = '0;  // TODO
   assign lsu_ace_if.arqos = '0;  // TODO
   assign lsu_ace_if.arregion = '0;  // TODO
   assign lsu_ace_if.aruser = '0;  // TODO
-  assign lsu_ace_if.arvalid = arvalid_q;
-  assign lsu_ace_if.arsnoop = '0;  // TODO
-  assign lsu_ace_if.ardomain = '0;  // TODO
+  // A demand read waits for the prefetch in flight
+  assign lsu_ace_if.arvalid = pf_ar || (arvalid_q && (pf_state_q == PF_IDLE));
+  always_comb begin
+    unique case (cmd_q)
+      LSU_CBO_ZERO: lsu_ace_if.arsnoop = ACE_MAKE_UNIQUE;
+      LSU_CBO_CLEAN: lsu_ace_if.arsnoop = ACE_CLEAN_SHARED;
+      LSU_CBO_FLUSH, LSU_CBO_INVAL: lsu_ace_if.arsnoop = ACE_CLEAN_INVALID;
+      default: lsu_ace_if.arsnoop = store_q ? ACE_READ_UNIQUE : ACE_READ_SHARED;
+    endcase
+    if (pf_ar) lsu_ace_if.arsnoop = ACE_READ_CLEAN;  // Leaves other copies in place
+  end
+  assign lsu_ace_if.ardomain = ACE_DOMAIN_INNER_SHAREABLE;
   assign lsu_ace_if.arbar = '0;  // TODO
 
   //// R channel signals
-  assign lsu_ace_if.rready = rready_q;
+  assign lsu_ace_if.rready = rready_q || (pf_state_q == PF_R);
 
   //// AC channel signals
-  assign lsu_ace_if.acready = '0;  // TODO
+  assign lsu_ace_if.acready = (snoop_state_q == SNOOP_IDLE);
 
   //// CR channel signals
-  assign lsu_ace_if.crvalid = '0;  // TODO
-  assign lsu_ace_if.crresp = '0;  // TODO
+  assign lsu_ace_if.crvalid = crvalid_q;
+  assign lsu_ace_if.crresp = crresp_q;
 
   //// CD channel signals
-  assign lsu_ace_if.cdvalid = '0;  // TODO
-  assign lsu_ace_if.cddata = '0;  // TODO
-  assign lsu_ace_if.cdlast = '0;  // TODO
+  assign lsu_ace_if.cdvalid = cdvalid_q;
+  assign lsu_ace_if.cddata = cddata_q[BUS_WIDTH*cdbeat_q+:BUS_WIDTH];
+  assign lsu_ace_if.cdlast = (cdbeat_q == BEAT_SEL_WIDTH'(BEATS - 1));
 
   //// Acknowledgment signals
   assign lsu_ace_if.rack = '0;  // TODO
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+
+// Stride prefetcher of the LSU
+//
+// A table indexed by the PC of a load keeps the page offset of its last
+// address, the stride between its last two and a confidence counter, which
+// counts up while the stride repeats. A load that misses the L1D (or hits a
+// block prefetched for it) triggers DEGREE prefetches once its entry is
+// confident, starting DISTANCE steps ahead. A step is the stride, or a block
+// in its direction if the stride is shorter, so a stream of small strides
+// asks for every block once. Only the page of the trigger is prefetched
+// from, so the LSU needs no translation of its own for them.
+module stride_prefetcher
+  import riscv_pkg::*;
+#(
+    parameter ENTRIES = 16,
+    parameter DEGREE = 2,  // Prefetches per trigger; 0 disables the prefetcher
+    parameter DISTANCE = 1,  // Steps between the trigger and its first prefetch
+    parameter BLOCK_OFFSET_WIDTH = 5
+) (
+    input logic clk,
+    input logic rst,
+
+    // A load in COMPARE, once per access
+    input logic train,
+    input logic [XLEN-1:0] train_pc,
+    input logic [XLEN-1:0] train_addr,  // Virtual
+    input logic trigger,  // ... and it missed, or hit the prefetch buffer
+    output logic fire,  // ... and starts a run of prefetches
+
+    // Virtual address to prefetch, in the page of train_addr
+    output logic req_vld,
+    output logic [XLEN-1:0] req_addr,
+    input logic req_ready,
+    input logic cancel  // Drop what has not been taken yet
+);
+
+  // Define local parameters
+  localparam PAGE_OFFSET_WIDTH = 12;
+  localparam INDEX_WIDTH = (ENTRIES > 1) ? $clog2(ENTRIES) : 1;
+  localparam PC_TAG_WIDTH = 8;  // Partial; an alias only costs accuracy
+  localparam STRIDE_WIDTH = PAGE_OFFSET_WIDTH + 1;
+  localparam CNT_WIDTH = $clog2(((DEGREE > 0) ? DEGREE : 1) + 1);
+  localparam logic [1:0] CONFIDENT = 2'd2;
+
+  // Assert conditions
+  initial begin
+    assert (ENTRIES == 2 ** INDEX_WIDTH)
+    else $fatal("ENTRIES must be a power of 2");
+    assert (DEGREE >= 0)
+    else $fatal("DEGREE must not be negative");
+    assert (DISTANCE > 0)
+    else $fatal("DISTANCE must be greater than 0");
+  end
+
+  // Define types
+  typedef struct packed {
+    logic vld;
+    logic [PC_TAG_WIDTH-1:0] tag;
+    logic [PAGE_OFFSET_WIDTH-1:0] last;  // Page offset of the last address
+    logic [STRIDE_WIDTH-1:0] stride;
+    logic [1:0] conf;
+  } entry_t;
+
+  // Declare registers and their next states
+  entry_t table_q[ENTRIES];
+  logic [CNT_WIDTH-1:0] gen_cnt_q, gen_cnt_d;  // Prefetches left of the last trigger
+  logic [XLEN-1:0] gen_addr_q, gen_addr_d;  // ... the next of which is here
+  logic [XLEN-1:0] gen_step_q, gen_step_d;
+  logic [XLEN-PAGE_OFFSET_WIDTH-1:0] gen_page_q, gen_page_d;  // Page of the trigger
+
+  // Declare wires
+  logic [INDEX_WIDTH-1:0] index;
+  logic [PC_TAG_WIDTH-1:0] tag;
+  entry_t entry;
+  entry_t next_entry;
+  logic entry_hit;
+  logic [STRIDE_WIDTH-1:0] new_stride;
+  logic stride_match;
+  logic [STRIDE_WIDTH-1:0] stride_mag;
+  logic [XLEN-1:0] step;
+
+  always_comb begin
+    // Instructions are at least 2-byte aligned
+    index = train_pc[1+:INDEX_WIDTH];
+    tag = train_pc[1+INDEX_WIDTH+:PC_TAG_WIDTH];
+    entry = table_q[index];
+    entry_hit = entry.vld && (entry.tag == tag);
+    // Page offsets, so a stride is only right within a page; one across a
+    // page boundary just costs some confidence
+    new_stride = {1'b0, train_addr[PAGE_OFFSET_WIDTH-1:0]} - {1'b0, entry.last};
+    stride_match = entry_hit && (new_stride == entry.stride) && (new_stride != '0);
+
+    next_entry = entry;
+    next_entry.last = train_addr[PAGE_OFFSET_WIDTH-1:0];
+    if (!entry_hit) begin
+      next_entry = '{vld: 1'b1, tag: tag, last: train_addr[PAGE_OFFSET_WIDTH-1:0], default: '0};
+    end else if (stride_match) begin
+      if (entry.conf != '1) next_entry.conf = entry.conf + 2'd1;
+    end else if (entry.conf != '0) begin
+      next_entry.conf = entry.conf - 2'd1;
+    end else begin
+      next_entry.stride = new_stride;
+    end
+
+    stride_mag = entry.stride[STRIDE_WIDTH-1] ? -entry.stride : entry.stride;
+    if (stride_mag < STRIDE_WIDTH'(2 ** BLOCK_OFFSET_WIDTH)) begin
+      step = entry.stride[STRIDE_WIDTH-1] ? -XLEN'(2 ** BLOCK_OFFSET_WIDTH) :
+          XLEN'(2 ** BLOCK_OFFSET_WIDTH);
+    end else begin
+      step = XLEN'(signed'(entry.stride));
+    end
+    fire = (DEGREE > 0) && train && trigger && stride_match && (next_entry.conf >= CONFIDENT);
+
+    gen_cnt_d = gen_cnt_q;
+    gen_addr_d = gen_addr_q;
+    gen_step_d = gen_step_q;
+    gen_page_d = gen_page_q;
+    req_vld = (gen_cnt_q != '0) && (gen_addr_q[XLEN-1:PAGE_OFFSET_WIDTH] == gen_page_q);
+    req_addr = gen_addr_q;
+    if (fire) begin
+      gen_cnt_d = CNT_WIDTH'(DEGREE);
+      gen_addr_d = train_addr + step * XLEN'(DISTANCE);
+      gen_step_d = step;
+      gen_page_d = train_addr[XLEN-1:PAGE_OFFSET_WIDTH];
+    end else if (cancel || ((gen_cnt_q != '0) && !req_vld)) begin  // ... or left the page
+      gen_cnt_d = '0;
+    end else if (req_vld && req_ready) begin
+      gen_cnt_d = gen_cnt_q - CNT_WIDTH'(1);
+      gen_addr_d = gen_addr_q + gen_step_q;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      for (int i = 0; i < ENTRIES; i++) begin
+        table_q[i].vld <= 1'b0;
+      end
+      gen_cnt_q <= '0;
+      gen_addr_q <= '0;
+      gen_step_q <= '0;
+      gen_page_q <= '0;
+    end else begin
+      if (train) table_q[index] <= next_entry;
+      gen_cnt_q <= gen_cnt_d;
+      gen_addr_q <= gen_addr_d;
+      gen_step_q <= gen_step_d;
+      gen_page_q <= gen_page_d;
+    end
+  end
+
+endmodule
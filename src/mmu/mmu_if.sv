@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: MIT
+
+// TLB interface
+interface tlb_if;
+  import offnariscv_pkg::*;
+
+  logic [19:0] vpn;
+  logic [8:0] asid;
+  logic lookup;  // The result is used in this cycle; only counts hits and misses
+  logic hit;
+  tlb_entry_t entry;
+  logic [19:0] ppn;  // Physical page of `vpn`, with the offset within a megapage filled in
+  logic refill;
+  tlb_entry_t refill_entry;
+
+  // Request modport (IFU/LSU side)
+  modport req(output vpn, asid, lookup, refill, refill_entry, input hit, entry, ppn);
+
+  // Response modport (TLB side)
+  modport rsp(input vpn, asid, lookup, refill, refill_entry, output hit, entry, ppn);
+
+endinterface
+
+// Page-table walker interface
+interface ptw_if;
+  import offnariscv_pkg::*;
+
+  logic valid;  // Held until `done`
+  logic [19:0] vpn;
+  logic store;  // For Svadu, also set the D bit
+  logic done;
+  logic page_fault;
+  logic access_fault;
+  tlb_entry_t entry;
+
+  // Request modport (IFU/LSU side)
+  modport req(output valid, vpn, store, input done, page_fault, access_fault, entry);
+
+  // Response modport (walker side)
+  modport rsp(input valid, vpn, store, output done, page_fault, access_fault, entry);
+
+endinterface
@@ -0,0 +1,384 @@
+// SPDX-License-Identifier: MIT
+
+// Sv32 hardware page-table walker, shared by the L1 ITLB and DTLB
+module ptw
+  import riscv_pkg::*, offnariscv_pkg::*;
+#(
+    parameter PTE_CACHE_ENTRIES = 4
+) (
+    input logic clk,
+    input logic rst,
+
+    // To lower level memory, through the core arbiter
+    ace_if.m ptw_ace_if,
+
+    ptw_if.rsp ptw_ifu_if,  // From IFU
+    ptw_if.rsp ptw_lsu_if,  // From LSU
+
+    csr_pif.req csr_pif,
+
+    input logic flush  // SFENCE.VMA
+);
+
+  // Define local parameters
+  localparam ADDR_WIDTH = ptw_ace_if.ACE_AXADDR_WIDTH;
+  localparam BUS_WIDTH = ptw_ace_if.ACE_XDATA_WIDTH;  // A PTE is read and written in a single beat
+  localparam WORD_SEL_WIDTH = $clog2(BUS_WIDTH / XLEN);
+  localparam PTE_CACHE_SEL_WIDTH = $clog2(PTE_CACHE_ENTRIES);
+
+  // Assert conditions
+  initial begin
+    assert (ADDR_WIDTH == XLEN)
+    else $fatal("ptw_ace_if.ADDR_WIDTH must be equal to XLEN for now");
+    assert (PTE_CACHE_ENTRIES > 1 && 2 ** PTE_CACHE_SEL_WIDTH == PTE_CACHE_ENTRIES)
+    else $fatal("PTE_CACHE_ENTRIES must be a power of 2 greater than 1");
+  end
+
+  // Define types
+  typedef enum logic [1:0] {
+    IDLE,
+    READ,
+    UPDATE,  // Svadu: write the A and D bits back to the leaf PTE
+    DONE
+  } state_e;
+
+  // Upper-level PTEs, i.e. the pointers to second-level tables, by root table and VPN[1]
+  typedef struct packed {
+    logic [21:0] root;
+    logic [9:0] vpn1;
+    logic [21:0] ppn;
+  } pte_cache_entry_t;
+
+  // Declare registers and their next states
+  state_e state_q, state_d;
+  logic lsu_q, lsu_d;  // Walking for the LSU, otherwise for the IFU
+  logic [19:0] vpn_q, vpn_d;
+  logic store_q, store_d;
+  logic level_q, level_d;  // 1: first-level table, 0: second-level table
+  logic [ADDR_WIDTH-1:0] pte_addr_q, pte_addr_d;
+  sv32_pte_t pte_q, pte_d;
+  logic page_fault_q, page_fault_d;
+  logic access_fault_q, access_fault_d;
+  logic arvalid_q, arvalid_d;
+  logic rready_q, rready_d;
+  logic awvalid_q, awvalid_d;
+  logic wvalid_q, wvalid_d;
+  logic bready_q, bready_d;
+
+  logic [PTE_CACHE_ENTRIES-1:0] pc_vld_q, pc_vld_d;
+  pte_cache_entry_t pc_entries_q[PTE_CACHE_ENTRIES];
+  logic [PTE_CACHE_SEL_WIDTH-1:0] pc_victim_q, pc_victim_d;
+
+`ifndef SYNTHESIS
+  logic [63:0] walk_count_q, walk_count_d;
+  logic [63:0] pte_cache_hit_count_q, pte_cache_hit_count_d;
+`endif
+
+  // Declare wires
+  logic start;
+  logic start_lsu;
+  logic [19:0] start_vpn;
+  logic pc_hit;
+  logic [21:0] pc_ppn;
+  logic pc_fill;
+  sv32_pte_t rpte;
+  logic [33:0] next_addr;  // Physical addresses are 34 bits in Sv32
+  logic leaf_permits;
+  priv_e priv;
+  tlb_entry_t entry;
+
+  always_comb begin
+    state_d = state_q;
+    lsu_d = lsu_q;
+    vpn_d = vpn_q;
+    store_d = store_q;
+    level_d = level_q;
+    pte_addr_d = pte_addr_q;
+    pte_d = pte_q;
+    page_fault_d = page_fault_q;
+    access_fault_d = access_fault_q;
+    arvalid_d = arvalid_q;
+    rready_d = rready_q;
+    awvalid_d = awvalid_q;
+    wvalid_d = wvalid_q;
+    bready_d = bready_q;
+    pc_vld_d = pc_vld_q;
+    pc_victim_d = pc_victim_q;
+    pc_fill = 1'b0;
+
+    // The LSU has priority, as it holds the oldest instruction
+    start_lsu = ptw_lsu_if.valid;
+    start = (state_q == IDLE) && (ptw_lsu_if.valid || ptw_ifu_if.valid);
+    start_vpn = start_lsu ? ptw_lsu_if.vpn : ptw_ifu_if.vpn;
+
+    pc_hit = 1'b0;
+    pc_ppn = '0;
+    for (int i = 0; i < PTE_CACHE_ENTRIES; ++i) begin
+      if (pc_vld_q[i] && (pc_entries_q[i].root == csr_pif.satp.ppn) &&
+          (pc_entries_q[i].vpn1 == start_vpn[19:10])) begin
+        pc_hit = 1'b1;
+        pc_ppn = pc_entries_q[i].ppn;
+      end
+    end
+
+    rpte = ptw_ace_if.rdata[XLEN*pte_addr_q[2+:WORD_SEL_WIDTH]+:XLEN];
+    priv = lsu_q ? csr_pif.ls_priv : csr_pif.priv;
+    entry = '{
+        vpn: vpn_q,
+        asid: csr_pif.satp.asid,
+        ppn: {pte_q.ppn1, pte_q.ppn0},
+        superpage: level_q,
+        d: pte_q.d,
+        a: pte_q.a,
+        g: pte_q.g,
+        u: pte_q.u,
+        x: pte_q.x,
+        w: pte_q.w,
+        r: pte_q.r
+    };
+    leaf_permits = tlb_permits(entry, priv, csr_pif.sum, csr_pif.mxr, !lsu_q, store_q);
+    next_addr = '0;
+
+    if (ptw_ace_if.arready) arvalid_d = 1'b0;
+    if (ptw_ace_if.awready) awvalid_d = 1'b0;
+    if (ptw_ace_if.wready) wvalid_d = 1'b0;
+    if (ptw_ace_if.bvalid) begin
+      bready_d = 1'b0;
+      if (ptw_ace_if.bresp[1]) access_fault_d = 1'b1;  // SLVERR or DECERR
+    end
+
+    unique case (state_q)
+      IDLE: begin
+        if (start) begin
+          lsu_d = start_lsu;
+          vpn_d = start_vpn;
+          store_d = start_lsu && ptw_lsu_if.store;
+          page_fault_d = 1'b0;
+          access_fault_d = 1'b0;
+          if (pc_hit) begin
+            level_d = 1'b0;
+            next_addr = {pc_ppn, start_vpn[9:0], 2'b00};
+          end else begin
+            level_d = 1'b1;
+            next_addr = {csr_pif.satp.ppn, start_vpn[19:10], 2'b00};
+          end
+          pte_addr_d = next_addr[ADDR_WIDTH-1:0];
+          if (next_addr[33:32] != '0) begin
+            access_fault_d = 1'b1;
+            state_d = DONE;
+          end else begin
+            arvalid_d = 1'b1;
+            rready_d = 1'b1;
+            state_d = READ;
+          end
+        end
+      end
+      READ: begin
+        if (ptw_ace_if.rvalid && rready_q) begin
+          rready_d = 1'b0;
+          pte_d = rpte;
+          state_d = DONE;
+          if (ptw_ace_if.rresp[1]) begin
+            access_fault_d = 1'b1;
+          end else if (!rpte.v || (!rpte.r && rpte.w)) begin
+            page_fault_d = 1'b1;
+          end else if (!rpte.r && !rpte.x) begin  // Pointer to the next level
+            if (!level_q) begin
+              page_fault_d = 1'b1;
+            end else begin
+              next_addr = {rpte.ppn1, rpte.ppn0, vpn_q[9:0], 2'b00};
+              pc_fill = 1'b1;
+              level_d = 1'b0;
+              pte_addr_d = next_addr[ADDR_WIDTH-1:0];
+              if (next_addr[33:32] != '0) begin
+                access_fault_d = 1'b1;
+              end else begin
+                arvalid_d = 1'b1;
+                rready_d = 1'b1;
+                state_d = READ;
+              end
+            end
+          end else if (level_q && (rpte.ppn0 != '0)) begin  // Misaligned megapage
+            page_fault_d = 1'b1;
+          end
+        end
+      end
+      UPDATE: begin
+        if (!awvalid_d && !wvalid_d && !bready_d) begin
+          state_d = DONE;
+        end
+      end
+      DONE: begin
+        state_d = IDLE;
+      end
+      default: begin
+      end
+    endcase
+
+    // Leaf checks, one cycle after the read so that they work on the registered PTE
+    if ((state_q == DONE) && !page_fault_q && !access_fault_q && !awvalid_q && !bready_q &&
+        (pte_q.r || pte_q.x)) begin
+      if (!leaf_permits) begin
+        page_fault_d = 1'b1;
+      end else if (pte_q.ppn1[11:10] != '0) begin  // Beyond the 32-bit physical address space
+        access_fault_d = 1'b1;
+      end else if (!pte_q.a || (store_q && !pte_q.d)) begin
+        if (csr_pif.adue) begin
+          pte_d.a = 1'b1;
+          pte_d.d = pte_q.d || store_q;
+          awvalid_d = 1'b1;
+          wvalid_d = 1'b1;
+          bready_d = 1'b1;
+          state_d = UPDATE;
+        end
+        // Otherwise, Svade: the requester raises the page fault on the returned entry
+      end
+    end
+
+    if (flush) begin
+      pc_vld_d = '0;
+    end else if (pc_fill) begin
+      pc_vld_d[pc_victim_q] = 1'b1;
+      pc_victim_d = pc_victim_q + PTE_CACHE_SEL_WIDTH'(1);
+    end
+
+    // Responses
+    ptw_ifu_if.done = (state_q == DONE) && (state_d == IDLE) && !lsu_q;
+    ptw_lsu_if.done = (state_q == DONE) && (state_d == IDLE) && lsu_q;
+    ptw_ifu_if.page_fault = page_fault_d;
+    ptw_lsu_if.page_fault = page_fault_d;
+    ptw_ifu_if.access_fault = access_fault_d;
+    ptw_lsu_if.access_fault = access_fault_d;
+    ptw_ifu_if.entry = entry;
+    ptw_lsu_if.entry = entry;
+
+`ifndef SYNTHESIS
+    walk_count_d = walk_count_q;
+    pte_cache_hit_count_d = pte_cache_hit_count_q;
+    if (start) begin
+      walk_count_d = walk_count_q + 64'(1);
+      if (pc_hit) pte_cache_hit_count_d = pte_cache_hit_count_q + 64'(1);
+    end
+`endif
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      state_q <= IDLE;
+      lsu_q <= 1'b0;
+      vpn_q <= '0;
+      store_q <= 1'b0;
+      level_q <= 1'b1;
+      pte_addr_q <= '0;
+      pte_q <= '0;
+      page_fault_q <= 1'b0;
+      access_fault_q <= 1'b0;
+      arvalid_q <= 1'b0;
+      rready_q <= 1'b0;
+      awvalid_q <= 1'b0;
+      wvalid_q <= 1'b0;
+      bready_q <= 1'b0;
+      pc_vld_q <= '0;
+      pc_victim_q <= '0;
+    end else begin
+      state_q <= state_d;
+      lsu_q <= lsu_d;
+      vpn_q <= vpn_d;
+      store_q <= store_d;
+      level_q <= level_d;
+      pte_addr_q <= pte_addr_d;
+      pte_q <= pte_d;
+      page_fault_q <= page_fault_d;
+      access_fault_q <= access_fault_d;
+      arvalid_q <= arvalid_d;
+      rready_q <= rready_d;
+      awvalid_q <= awvalid_d;
+      wvalid_q <= wvalid_d;
+      bready_q <= bready_d;
+      pc_vld_q <= pc_vld_d;
+      pc_victim_q <= pc_victim_d;
+`ifndef OFFNARISCV_QUIET
+      if (state_q != IDLE)
+        $write("PTW: state=%s, lsu=%b, vpn=0x%h, level=%0d, pte_addr=0x%h, pte=0x%h\n",
+               state_q.name(), lsu_q, vpn_q, level_q, pte_addr_q, pte_q);
+`endif
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (!flush && pc_fill) pc_entries_q[pc_victim_q] <= '{root: csr_pif.satp.ppn, vpn1: vpn_q[19:10], ppn: {rpte.ppn1, rpte.ppn0}};
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      walk_count_q <= '0;
+      pte_cache_hit_count_q <= '0;
+    end else begin
+      walk_count_q <= walk_count_d;
+      pte_cache_hit_count_q <= pte_cache_hit_count_d;
+    end
+  end
+`endif
+
+  // External wire assignments
+  //// AW channel signals
+  assign ptw_ace_if.awvalid = awvalid_q;
+  assign ptw_ace_if.awid = '0;  // TODO
+  assign ptw_ace_if.awaddr = pte_addr_q;
+  assign ptw_ace_if.awlen = '0;
+  assign ptw_ace_if.awsize = ACE_AXSIZE_WIDTH'($clog2(XLEN / 8));
+  assign ptw_ace_if.awburst = ACE_BURST_INCR;
+  assign ptw_ace_if.awlock = '0;  // TODO
+  assign ptw_ace_if.awcache = '0;  // TODO
+  assign ptw_ace_if.awprot = '0;  // TODO
+  assign ptw_ace_if.awqos = '0;  // TODO
+  assign ptw_ace_if.awregion = '0;  // TODO
+  assign ptw_ace_if.awuser = '0;  // TODO
+  assign ptw_ace_if.awsnoop = ACE_WRITE_UNIQUE;
+  assign ptw_ace_if.awdomain = ACE_DOMAIN_INNER_SHAREABLE;
+  assign ptw_ace_if.awbar = '0;  // TODO
+
+  //// W channel signals
+  assign ptw_ace_if.wvalid = wvalid_q;
+  assign ptw_ace_if.wdata = {(BUS_WIDTH / XLEN) {pte_q}};
+  assign ptw_ace_if.wstrb = (BUS_WIDTH / 8)'(4'hf) << (4 * pte_addr_q[2+:WORD_SEL_WIDTH]);
+  assign ptw_ace_if.wlast = 1'b1;
+  assign ptw_ace_if.wuser = '0;  // TODO
+
+  //// B channel signals
+  assign ptw_ace_if.bready = bready_q;
+
+  //// AR channel signals
+  assign ptw_ace_if.arid = '0;  // TODO
+  assign ptw_ace_if.araddr = pte_addr_q;
+  assign ptw_ace_if.arlen = '0;
+  assign ptw_ace_if.arsize = ACE_AXSIZE_WIDTH'($clog2(XLEN / 8));
+  assign ptw_ace_if.arburst = ACE_BURST_INCR;
+  assign ptw_ace_if.arlock = '0;  // TODO
+  assign ptw_ace_if.arcache = '0;  // TODO
+  assign ptw_ace_if.arprot = '0;  // TODO
+  assign ptw_ace_if.arqos = '0;  // TODO
+  assign ptw_ace_if.arregion = '0;  // TODO
+  assign ptw_ace_if.aruser = '0;  // TODO
+  assign ptw_ace_if.arvalid = arvalid_q;
+  assign ptw_ace_if.arsnoop = ACE_READ_ONCE;
+  assign ptw_ace_if.ardomain = ACE_DOMAIN_INNER_SHAREABLE;
+  assign ptw_ace_if.arbar = '0;  // TODO
+
+  //// R channel signals
+  assign ptw_ace_if.rready = rready_q;
+
+  //// AC/CR/CD channel signals: the walker holds no lines
+  assign ptw_ace_if.acready = 1'b1;
+  assign ptw_ace_if.crvalid = 1'b0;
+  assign ptw_ace_if.crresp = '0;
+  assign ptw_ace_if.cdvalid = 1'b0;
+  assign ptw_ace_if.cddata = '0;
+  assign ptw_ace_if.cdlast = 1'b0;
+
+  //// Acknowledgment signals
+  assign ptw_ace_if.rack = '0;  // TODO
+  assign ptw_ace_if.wack = '0;  // TODO
+
+endmodule
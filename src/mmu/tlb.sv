@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+
+// Fully-associative L1 TLB for Sv32
+module tlb
+  import offnariscv_pkg::*;
+#(
+    parameter ENTRIES = 8
+) (
+    input logic clk,
+    input logic rst,
+
+    tlb_if.rsp tlb_rsp_if,
+
+    input logic flush  // SFENCE.VMA
+);
+
+  // Define local parameters
+  localparam SEL_WIDTH = $clog2(ENTRIES);
+
+  // Assert conditions
+  initial begin
+    assert (ENTRIES > 1 && 2 ** SEL_WIDTH == ENTRIES)
+    else $fatal("ENTRIES must be a power of 2 greater than 1");
+  end
+
+  // Define functions
+  function automatic logic matches(tlb_entry_t entry, logic [19:0] vpn, logic [8:0] asid);
+    return (entry.g || (entry.asid == asid)) &&
+        (entry.vpn[19:10] == vpn[19:10]) && (entry.superpage || (entry.vpn[9:0] == vpn[9:0]));
+  endfunction
+
+  // Declare registers and their next states
+  logic [ENTRIES-1:0] vld_q, vld_d;
+  tlb_entry_t entries_q[ENTRIES];
+  logic [SEL_WIDTH-1:0] victim_q, victim_d;  // Round-robin replacement
+
+`ifndef SYNTHESIS
+  logic [63:0] hit_count_q, hit_count_d;
+  logic [63:0] miss_count_q, miss_count_d;
+`endif
+
+  // Declare wires
+  logic [ENTRIES-1:0] match;
+  logic [ENTRIES-1:0] refill_match;  // Entries the refill replaces, so that no two entries overlap
+  logic [SEL_WIDTH-1:0] refill_sel;
+
+  always_comb begin
+    tlb_rsp_if.hit = 1'b0;
+    tlb_rsp_if.entry = '0;
+    for (int i = 0; i < ENTRIES; ++i) begin
+      match[i] = vld_q[i] && matches(entries_q[i], tlb_rsp_if.vpn, tlb_rsp_if.asid);
+      refill_match[i] = vld_q[i] &&
+          matches(entries_q[i], tlb_rsp_if.refill_entry.vpn, tlb_rsp_if.refill_entry.asid);
+      if (match[i]) begin
+        tlb_rsp_if.hit = 1'b1;
+        tlb_rsp_if.entry = entries_q[i];
+      end
+    end
+    tlb_rsp_if.ppn = tlb_rsp_if.entry.superpage ?
+        {tlb_rsp_if.entry.ppn[19:10], tlb_rsp_if.vpn[9:0]} : tlb_rsp_if.entry.ppn[19:0];
+
+    vld_d = vld_q;
+    victim_d = victim_q;
+    refill_sel = victim_q;
+    for (int i = 0; i < ENTRIES; ++i) begin
+      if (refill_match[i]) refill_sel = SEL_WIDTH'(i);
+    end
+    if (flush) begin
+      vld_d = '0;
+    end else if (tlb_rsp_if.refill) begin
+      vld_d[refill_sel] = 1'b1;
+      if (refill_match == '0) victim_d = victim_q + SEL_WIDTH'(1);
+    end
+
+`ifndef SYNTHESIS
+    hit_count_d  = hit_count_q;
+    miss_count_d = miss_count_q;
+    if (tlb_rsp_if.lookup) begin
+      if (tlb_rsp_if.hit) hit_count_d = hit_count_q + 64'(1);
+      else miss_count_d = miss_count_q + 64'(1);
+    end
+`endif
+  end
+
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      vld_q <= '0;
+      victim_q <= '0;
+    end else begin
+      vld_q <= vld_d;
+      victim_q <= victim_d;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (!flush && tlb_rsp_if.refill) entries_q[refill_sel] <= tlb_rsp_if.refill_entry;
+  end
+
+`ifndef SYNTHESIS
+  always_ff @(posedge clk) begin
+    if (rst) begin
+      hit_count_q  <= '0;
+      miss_count_q <= '0;
+    end else begin
+      hit_count_q  <= hit_count_d;
+      miss_count_q <= miss_count_d;
+    end
+  end
+`endif
+
+endmodule
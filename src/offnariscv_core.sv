@@ -3,28 +3,50 @@
 module offnariscv_core
   import offnariscv_pkg::*;
 #(
-    parameter RESET_VECTOR = 0
+    parameter RESET_VECTOR = 0,
+    // 2 adds a second back-end slot for ALU instructions. Fetch and decode
+    // stay one instruction per cycle, so it only drains the decode FIFO
+    // backlog faster after a stall; the IPC stays at or below 1.
+    parameter ISSUE_WIDTH = 1,
+    parameter MHARTID = 0,
+    parameter BLOCK_SIZE = 256,  // Cache line; moved over the ACE ports in bursts
+    parameter LOOP_BUFFER = 16,  // Instructions of a loop replayed without the IFU; 0 disables it
+    parameter PREFETCH_DEGREE = 2,  // Blocks the LSU prefetches per strided miss; 0 disables it
+    parameter PREFETCH_DISTANCE = 1,  // ... starting this many strides ahead
+    parameter SYNC_READ = 0  // 1 reads the L1 caches a cycle ahead, from BRAM-mappable arrays
 ) (
     input clk,
     input rst,
 
     ace_if.m ifu_ace_if,
-    ace_if.m lsu_ace_if
+    ace_if.m lsu_ace_if,
+    ace_if.m ptw_ace_if,
+
+    clint_if.req clint_if,  // This hart's port of the CLINT
+
+    input logic demand_busy  // From the core arbiter; holds back the LSU prefetches
 );
 
-  localparam BLOCK_SIZE = ifu_ace_if.ACE_XDATA_WIDTH;
   localparam INDEX_WIDTH = 12 - $clog2(BLOCK_SIZE / 8);
   localparam TAG_WIDTH = ifu_ace_if.ACE_AXADDR_WIDTH - INDEX_WIDTH - $clog2(BLOCK_SIZE / 8);
 
   // Assert conditions
   initial begin
-    assert (BLOCK_SIZE == lsu_ace_if.ACE_XDATA_WIDTH)
-    else $fatal("BLOCK_SIZE must match lsu_ace_if.ACE_XDATA_WIDTH for now");
+    assert (ifu_ace_if.ACE_XDATA_WIDTH == lsu_ace_if.ACE_XDATA_WIDTH)
+    else $fatal("ifu_ace_if and lsu_ace_if must have the same data width");
+    assert ((BLOCK_SIZE % ifu_ace_if.ACE_XDATA_WIDTH == 0) &&
+            (BLOCK_SIZE >= ifu_ace_if.ACE_XDATA_WIDTH))
+    else $fatal("BLOCK_SIZE must be a multiple of ACE_XDATA_WIDTH");
+    assert (ISSUE_WIDTH == 1 || ISSUE_WIDTH == 2)
+    else $fatal("ISSUE_WIDTH must be 1 or 2");
   end
 
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(pcgif_tdata_t))) pcgif_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(pcgif_tdata_t))) lbif_axis_if ();  // Loop buffer to IFU
+  axis_if #(.TDATA_WIDTH($bits(ifid_tdata_t))) iflb_axis_if ();  // IFU to loop buffer
   axis_if #(.TDATA_WIDTH(XLEN)) wbpcg_axis_if ();
+  axis_if #(.TDATA_WIDTH(XLEN)) idpcg_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(ifid_tdata_t))) ifid_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(idrf_tdata_t))) idrf_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(rfex_tdata_t))) rfex_axis_if ();
@@ -39,8 +61,22 @@ module offnariscv_core
   axis_if #(.TDATA_WIDTH($bits(lsuwb_tdata_t))) lsuwb_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(wbrf_tdata_t))) wbrf_axis_if ();
 
+  // Second issue slot
+  axis_if #(.TDATA_WIDTH($bits(idrf_tdata_t))) idrf1_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(rfex_tdata_t))) rfex1_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(rfalu_tdata_t))) rfalu1_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(exwb_tdata_t))) exwb1_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(aluwb_tdata_t))) aluwb1_axis_if ();
+  axis_if #(.TDATA_WIDTH($bits(wbrf_tdata_t))) wbrf1_axis_if ();
+
   csr_rif rfcsr_rif ();
   csr_wif wbcsr_wif ();
+  csr_pif mmucsr_pif ();
+
+  tlb_if l1itlb_if ();
+  tlb_if l1dtlb_if ();
+  ptw_if ptw_ifu_if ();
+  ptw_if ptw_lsu_if ();
 
   cache_dir_if #(
       .INDEX_WIDTH(INDEX_WIDTH),
@@ -77,17 +113,54 @@ module offnariscv_core
   ) l1d_mem_if_1 ();
 
   logic invalidate;
-  logic flush;
+  logic fe_invalidate;  // Squashes the IFU only
+  logic flush;  // FENCE.I; the LSU keeps the L1I coherent, so the IFU only drops its line buffer
+  logic sfence;
+  logic l1i_inval_vld;
+  logic [XLEN-1:0] l1i_inval_addr;
+  logic [XLEN-1:0] predecode_pc;
+  logic predecode_vld, predecode_rvc;
+  logic predecode_taken;
+  logic [XLEN-1:0] predecode_target;
+  logic ifu_predecode_vld, ifu_predecode_rvc;
+  logic loop_taken;
 
   // Wire assignments
   assign invalidate = wbpcg_axis_if.ack();
-  assign flush = wbpcg_axis_if.tvalid && committer_inst.exwb_tdata.rf_data.id_data.fence_i;
+  assign fe_invalidate = invalidate || idpcg_axis_if.ack();
+  assign flush = wbpcg_axis_if.tvalid && committer_inst.exwb_tdata.fence_i;
 
   pcgen pcgen_inst (
       .clk(clk),
       .rst(rst),
       .pcgif_axis_if(pcgif_axis_if),
-      .wbpcg_axis_if(wbpcg_axis_if)
+      .wbpcg_axis_if(wbpcg_axis_if),
+      .idpcg_axis_if(idpcg_axis_if),
+      .predecode_pc(predecode_pc),
+      .predecode_vld(predecode_vld),
+      .predecode_rvc(predecode_rvc),
+      .predecode_taken(predecode_taken),
+      .predecode_target(predecode_target)
+  );
+
+  loop_buffer #(
+      .DEPTH(LOOP_BUFFER)
+  ) loop_buffer_inst (
+      .clk(clk),
+      .rst(rst),
+      .pcgif_axis_if(pcgif_axis_if),
+      .predecode_vld(predecode_vld),
+      .predecode_rvc(predecode_rvc),
+      .predecode_taken(predecode_taken),
+      .predecode_target(predecode_target),
+      .lbif_axis_if(lbif_axis_if),
+      .iflb_axis_if(iflb_axis_if),
+      .ifu_predecode_vld(ifu_predecode_vld),
+      .ifu_predecode_rvc(ifu_predecode_rvc),
+      .ifid_axis_if(ifid_axis_if),
+      .loop_taken(loop_taken),
+      .invalidate(invalidate),
+      .fe_invalidate(fe_invalidate)
   );
 
   ifu #(
@@ -96,22 +169,43 @@ module offnariscv_core
       .clk(clk),
       .rst(rst),
       .ifu_ace_if(ifu_ace_if),
-      .pcgif_axis_if(pcgif_axis_if),
-      .inst_axis_if(ifid_axis_if),
+      .pcgif_axis_if(lbif_axis_if),
+      .inst_axis_if(iflb_axis_if),
       .l1i_dir_if(l1i_dir_if_0),
       .l1i_mem_if(l1i_mem_if_0),
-      .invalidate(invalidate)
+      .predecode_pc(predecode_pc),
+      .predecode_vld(ifu_predecode_vld),
+      .predecode_rvc(ifu_predecode_rvc),
+      .csr_pif(mmucsr_pif),
+      .l1itlb_if(l1itlb_if),
+      .ptw_ifu_if(ptw_ifu_if),
+      .l1i_inval_vld(l1i_inval_vld),
+      .l1i_inval_addr(l1i_inval_addr),
+      .invalidate(fe_invalidate),
+      .flush(flush),
+      .sfence(sfence)
+  );
+
+  tlb l1itlb_inst (
+      .clk(clk),
+      .rst(rst),
+      .tlb_rsp_if(l1itlb_if),
+      .flush(sfence)
   );
 
-  cache_directory l1i_dir_inst (
+  cache_directory #(
+      .SYNC_READ(SYNC_READ)
+  ) l1i_dir_inst (
       .clk(clk),
       .rst(rst),
       .cache_dir_rsp_if_0(l1i_dir_if_0),
       .cache_dir_rsp_if_1(l1i_dir_if_1),
-      .flush(flush)  // TODO
+      .flush('0)
   );
 
-  cache_memory l1i_mem_inst (
+  cache_memory #(
+      .SYNC_READ(SYNC_READ)
+  ) l1i_mem_inst (
       .clk(clk),
       .rst(rst),
       .cache_mem_rsp_if_0(l1i_mem_if_0),
@@ -119,12 +213,16 @@ module offnariscv_core
   );
 
   decoder #(
-      .FIFO_DEPTH(9)
+      .FIFO_DEPTH (9),
+      .ISSUE_WIDTH(ISSUE_WIDTH)
   ) decoder_inst (
       .clk(clk),
       .rst(rst),
       .ifid_axis_if(ifid_axis_if),
       .idrf_axis_if(idrf_axis_if),
+      .idrf1_axis_if(idrf1_axis_if),
+      .idpcg_axis_if(idpcg_axis_if),
+      .loop_taken(loop_taken),
       .invalidate(invalidate)
   );
 
@@ -132,29 +230,41 @@ module offnariscv_core
       .clk(clk),
       .rst(rst),
       .idrf_axis_if(idrf_axis_if),
+      .idrf1_axis_if(idrf1_axis_if),
       .rfex_axis_if(rfex_axis_if),
+      .rfex1_axis_if(rfex1_axis_if),
       .wbrf_axis_if(wbrf_axis_if),
+      .wbrf1_axis_if(wbrf1_axis_if),
       .rfcsr_rif(rfcsr_rif),
       .invalidate(invalidate)
   );
 
-  csr csr_inst (
+  csr #(
+      .MHARTID(MHARTID)
+  ) csr_inst (
       .clk(clk),
       .rst(rst),
       .csr_rif_rsp(rfcsr_rif),
-      .csr_wif_rsp(wbcsr_wif)
+      .csr_wif_rsp(wbcsr_wif),
+      .csr_pif_rsp(mmucsr_pif),
+      .mtip(clint_if.mtip),
+      .msip(clint_if.msip)
   );
 
   dispatcher dispatcher_inst (
       .clk(clk),
       .rst(rst),
       .rfex_axis_if(rfex_axis_if),
+      .rfex1_axis_if(rfex1_axis_if),
       .rfalu_axis_if(rfalu_axis_if),
+      .rfalu1_axis_if(rfalu1_axis_if),
       .rfbru_axis_if(rfbru_axis_if),
       .rfsys_axis_if(rfsys_axis_if),
       .rflsu_axis_if(rflsu_axis_if),
       .exwb_axis_if(exwb_axis_if),
+      .exwb1_axis_if(exwb1_axis_if),
       .wbrf_axis_if(wbrf_axis_if),  // For forwarding
+      .wbrf1_axis_if(wbrf1_axis_if),  // For forwarding
       .invalidate(invalidate)
   );
 
@@ -166,6 +276,22 @@ module offnariscv_core
       .invalidate(invalidate)
   );
 
+  generate
+    if (ISSUE_WIDTH == 2) begin : gen_alu1
+      alu alu1_inst (
+          .clk(clk),
+          .rst(rst),
+          .rfalu_axis_if(rfalu1_axis_if),
+          .aluwb_axis_if(aluwb1_axis_if),
+          .invalidate(invalidate)
+      );
+    end else begin : gen_no_alu1  // The second slot never issues
+      assign rfalu1_axis_if.tready = 1'b1;
+      assign aluwb1_axis_if.tvalid = 1'b0;
+      assign aluwb1_axis_if.tdata = '0;
+    end
+  endgenerate
+
   bru bru_inst (
       .clk(clk),
       .rst(rst),
@@ -186,16 +312,23 @@ module offnariscv_core
       .clk(clk),
       .rst(rst),
       .exwb_axis_if(exwb_axis_if),
+      .exwb1_axis_if(exwb1_axis_if),
       .aluwb_axis_if(aluwb_axis_if),
+      .aluwb1_axis_if(aluwb1_axis_if),
       .bruwb_axis_if(bruwb_axis_if),
       .syswb_axis_if(syswb_axis_if),
       .lsuwb_axis_if(lsuwb_axis_if),
       .wbrf_axis_if(wbrf_axis_if),
+      .wbrf1_axis_if(wbrf1_axis_if),
       .wbpcg_axis_if(wbpcg_axis_if),
-      .wbcsr_wif(wbcsr_wif)
+      .wbcsr_wif(wbcsr_wif),
+      .sfence(sfence)
   );
 
-  lsu lsu_inst (
+  lsu #(
+      .PREFETCH_DEGREE  (PREFETCH_DEGREE),
+      .PREFETCH_DISTANCE(PREFETCH_DISTANCE)
+  ) lsu_inst (
       .clk(clk),
       .rst(rst),
       .lsu_ace_if(lsu_ace_if),
@@ -203,10 +336,39 @@ module offnariscv_core
       .lsuwb_axis_if(lsuwb_axis_if),
       .l1d_dir_if(l1d_dir_if_0),
       .l1d_mem_if(l1d_mem_if_0),
-      .invalidate(invalidate)
+      .l1d_snoop_dir_if(l1d_dir_if_1),
+      .l1d_snoop_mem_if(l1d_mem_if_1),
+      .csr_pif(mmucsr_pif),
+      .l1dtlb_if(l1dtlb_if),
+      .ptw_lsu_if(ptw_lsu_if),
+      .lsu_clint_if(clint_if),
+      .l1i_dir_if(l1i_dir_if_1),
+      .l1i_inval_vld(l1i_inval_vld),
+      .l1i_inval_addr(l1i_inval_addr),
+      .invalidate(invalidate),
+      .demand_busy(demand_busy)
+  );
+
+  tlb l1dtlb_inst (
+      .clk(clk),
+      .rst(rst),
+      .tlb_rsp_if(l1dtlb_if),
+      .flush(sfence)
+  );
+
+  ptw ptw_inst (
+      .clk(clk),
+      .rst(rst),
+      .ptw_ace_if(ptw_ace_if),
+      .ptw_ifu_if(ptw_ifu_if),
+      .ptw_lsu_if(ptw_lsu_if),
+      .csr_pif(mmucsr_pif),
+      .flush(sfence)
   );
 
-  cache_directory l1d_dir_inst (
+  cache_directory #(
+      .SYNC_READ(SYNC_READ)
+  ) l1d_dir_inst (
       .clk(clk),
       .rst(rst),
       .cache_dir_rsp_if_0(l1d_dir_if_0),
@@ -214,7 +376,9 @@ module offnariscv_core
       .flush('0)
   );
 
-  cache_memory l1d_mem_inst (
+  cache_memory #(
+      .SYNC_READ(SYNC_READ)
+  ) l1d_mem_inst (
       .clk(clk),
       .rst(rst),
       .cache_mem_rsp_if_0(l1d_mem_if_0),
@@ -33,12 +33,48 @@ package offnariscv_pkg;
     ACE_RESP_DECERR = 2'b11
   } ace_resp_e;
 
+  // ARSNOOP/ACSNOOP encodings used by the L1D (AWSNOOP has its own width)
+  typedef enum logic [ACE_ARSNOOP_WIDTH-1:0] {
+    ACE_READ_ONCE             = 4'b0000,  // ReadNoSnoop when the domain is non-shareable
+    ACE_READ_SHARED           = 4'b0001,
+    ACE_READ_CLEAN            = 4'b0010,
+    ACE_READ_NOT_SHARED_DIRTY = 4'b0011,
+    ACE_READ_UNIQUE           = 4'b0111,
+    ACE_CLEAN_SHARED          = 4'b1000,
+    ACE_CLEAN_INVALID         = 4'b1001,
+    ACE_CLEAN_UNIQUE          = 4'b1011,
+    ACE_MAKE_UNIQUE           = 4'b1100,
+    ACE_MAKE_INVALID          = 4'b1101
+  } ace_snoop_e;
+
+  localparam logic [ACE_AWSNOOP_WIDTH-1:0] ACE_WRITE_UNIQUE = 3'b000;
+  localparam logic [ACE_AWSNOOP_WIDTH-1:0] ACE_WRITE_BACK = 3'b011;
+  localparam logic [ACE_DOMAIN_WIDTH-1:0] ACE_DOMAIN_NON_SHAREABLE = 2'b00;
+  localparam logic [ACE_DOMAIN_WIDTH-1:0] ACE_DOMAIN_INNER_SHAREABLE = 2'b01;
+  localparam logic [ACE_AXBURST_WIDTH-1:0] ACE_BURST_INCR = 2'b01;
+  localparam logic [ACE_AXBURST_WIDTH-1:0] ACE_BURST_WRAP = 2'b10;
+
+  // Core-Local Interruptor; accesses to it bypass the L1D
+  localparam logic [XLEN-1:0] CLINT_BASE = 32'h0200_0000;
+  localparam CLINT_ADDR_WIDTH = 16;  // 64 KiB
+
+  typedef struct packed {
+    logic was_unique;
+    logic is_shared;
+    logic pass_dirty;
+    logic error;
+    logic data_transfer;
+  } ace_crresp_t;
+
   // typedef union packed {
   //   interrupt_codes_e int_code;
   //   exception_codes_e exc_code;
   // } int_exc_code_u;
 
   localparam INST_ID_WIDTH = 64;
+  // Tags of the instructions past the decoder; more than can be in flight
+  // behind it, so that a tag is never reused before its instruction retires
+  localparam INST_TAG_WIDTH = 8;
 
   typedef struct packed {
     logic [XLEN-1:0] pc;
@@ -49,14 +85,15 @@ package offnariscv_pkg;
   } pcgif_tdata_t;
 
   typedef struct packed {
-    logic [XLEN-1:0] inst;
+    logic [XLEN-1:0] inst;  // Only inst[15:0] is valid if compressed
+    logic compressed;  // RV32C instruction, 2 bytes long
     // logic int_exc_valid; // TODO
     // int_exc_code_u int_exc_code; // TODO
     trap_cause_t trap_cause;
     pcgif_tdata_t pcg_data;
   } ifid_tdata_t;
 
-  typedef enum logic [3:0] {
+  typedef enum logic [4:0] {
     ADD,
     SUB,
     SLL,
@@ -66,7 +103,29 @@ package offnariscv_pkg;
     SRL,
     SRA,
     OR,
-    AND
+    AND,
+    // Zba
+    SH1ADD,
+    SH2ADD,
+    SH3ADD,
+    // Zbb
+    ANDN,
+    ORN,
+    XNOR,
+    CLZ,
+    CTZ,
+    CPOP,
+    MAX,
+    MAXU,
+    MIN,
+    MINU,
+    SEXTB,
+    SEXTH,
+    ZEXTH,
+    ROL,
+    ROR,
+    ORCB,
+    REV8
   } alu_cmd_e;
 
   typedef enum logic [2:0] {
@@ -95,7 +154,7 @@ package offnariscv_pkg;
     SFENCE_VMA
   } system_cmd_e;
 
-  typedef enum logic [2:0] {
+  typedef enum logic [4:0] {
     LSU_LW,
     LSU_LH,
     LSU_LB,
@@ -103,8 +162,24 @@ package offnariscv_pkg;
     LSU_LBU,
     LSU_SW,
     LSU_SH,
-    LSU_SB
-  } lsu_cmd_e;  // TODO: AMO and LR/SC
+    LSU_SB,
+    LSU_LR,
+    LSU_SC,
+    LSU_AMOSWAP,
+    LSU_AMOADD,
+    LSU_AMOXOR,
+    LSU_AMOAND,
+    LSU_AMOOR,
+    LSU_AMOMIN,
+    LSU_AMOMAX,
+    LSU_AMOMINU,
+    LSU_AMOMAXU,
+    // Zicbom and Zicboz, on the cache block that holds the address
+    LSU_CBO_CLEAN,
+    LSU_CBO_FLUSH,
+    LSU_CBO_INVAL,
+    LSU_CBO_ZERO
+  } lsu_cmd_e;
 
   typedef struct packed {
     logic rf;  // Forwarding is needed at RF stage
@@ -128,8 +203,20 @@ package offnariscv_pkg;
     logic sys_cmd_vld;
     lsu_cmd_e lsu_cmd;
     logic lsu_cmd_vld;
-    ifid_tdata_t if_data;
+    logic [XLEN-1:0] pc;
+    logic compressed;
+    trap_cause_t trap_cause;
     logic fence_i;
+    logic pred_taken;  // The decoder has already redirected the front-end to the target
+    // Macro-op fusion: the op stands for this instruction and the next one,
+    // which shares its rd. Traps and the commit stream still see both.
+    logic fused;
+    logic fused_compressed;  // The second instruction is an RV32C one
+    logic [XLEN-1:0] fused_rd_data;  // rd after the first instruction, if it is a constant
+    logic [4:0] fused_shamt;  // SLLI+SRLI: rd after the first instruction is the result << shamt
+`ifndef SYNTHESIS
+    logic [INST_TAG_WIDTH-1:0] tag;  // Index of the decoder's inst_info_mem
+`endif
   } idrf_tdata_t;
 
   typedef struct packed {
@@ -141,8 +228,10 @@ package offnariscv_pkg;
     operands_t operands;
     logic [XLEN-1:0] rs2_data;  // For store
     logic [XLEN-1:0] csr_rdata;
-    logic [XLEN-1:0] mtvec;
+    logic csr_illegal;  // The CSR does not exist at the current privilege level
     logic [XLEN-1:0] mepc;
+    logic [XLEN-1:0] sepc;
+    priv_e priv;
     idrf_tdata_t id_data;
   } rfex_tdata_t;
 
@@ -155,26 +244,54 @@ package offnariscv_pkg;
     operands_t operands;
     logic [XLEN-1:0] offset;
     logic [XLEN-1:0] this_pc;
+    logic [XLEN-1:0] next_pc;  // Address of the sequentially following instruction
     bru_cmd_e cmd;
   } rfbru_tdata_t;
 
   typedef struct packed {
     operands_t operands;
     logic [XLEN-1:0] csr_rdata;
+    logic csr_illegal;
     system_cmd_e cmd;
     trap_cause_t trap_cause;
     logic [XLEN-1:0] this_pc;
-    logic [XLEN-1:0] mtvec;
+    logic [XLEN-1:0] next_pc;
     logic [XLEN-1:0] mepc;
+    logic [XLEN-1:0] sepc;
+    priv_e priv;
   } rfsys_tdata_t;
 
   typedef struct packed {
     operands_t operands;
     logic [XLEN-1:0] offset;
     lsu_cmd_e cmd;
+    logic [XLEN-1:0] pc;  // Trains the stride prefetcher
   } rflsu_tdata_t;
 
-  typedef struct packed {rfex_tdata_t rf_data;} exwb_tdata_t;
+  // What the committer needs of an instruction once it has been dispatched
+  typedef struct packed {
+    logic [4:0] rd;
+    logic [11:0] csr_addr;
+    logic [XLEN-1:0] csr_rdata;
+    logic alu_cmd_vld;
+    logic bru_cmd_vld;
+    system_cmd_e sys_cmd;
+    logic sys_cmd_vld;
+    logic lsu_cmd_vld;
+    logic [XLEN-1:0] pc;
+    logic compressed;
+    trap_cause_t trap_cause;
+    logic fence_i;
+    logic pred_taken;
+    logic fused;
+    logic fused_compressed;
+    logic [XLEN-1:0] fused_rd_data;
+`ifndef SYNTHESIS
+    alu_cmd_e alu_cmd;  // For the commit stream of a fused op
+    logic [4:0] fused_shamt;
+    logic [INST_TAG_WIDTH-1:0] tag;
+`endif
+  } exwb_tdata_t;
 
   typedef struct packed {
     logic [XLEN-1:0] wdata;
@@ -203,6 +320,7 @@ package offnariscv_pkg;
     logic [XLEN-1:0] result;
     trap_cause_t trap_cause;
     logic trap;
+    logic [XLEN-1:0] tval;  // Faulting virtual address
 `ifndef SYNTHESIS
     logic [XLEN-1:0] addr;
     logic [XLEN-1:0] wdata;
@@ -210,6 +328,49 @@ package offnariscv_pkg;
 `endif
   } lsuwb_tdata_t;
 
+  typedef struct packed {
+    logic [19:0] vpn;
+    logic [8:0] asid;
+    logic [21:0] ppn;
+    logic superpage;  // 4 MiB megapage; vpn[9:0] and ppn[9:0] are not used
+    logic d;
+    logic a;
+    logic g;
+    logic u;
+    logic x;
+    logic w;
+    logic r;
+  } tlb_entry_t;
+
+`ifndef SYNTHESIS
+  // Kept by the decoder for each tag, for the commit stream and the pipeline
+  // trace; the payloads past it carry only the tag
+  typedef struct packed {
+    logic [XLEN-1:0] pc;
+    logic [XLEN-1:0] inst;
+    logic [INST_ID_WIDTH-1:0] id;
+  } inst_info_t;
+`endif
+
+  // Address of the instruction after the one at `pc`, after both halves if it is fused
+  function automatic logic [XLEN-1:0] seq_next_pc(logic [XLEN-1:0] pc, logic compressed,
+                                                  logic fused, logic fused_compressed);
+    logic [XLEN-1:0] next_pc;
+    next_pc = pc + (compressed ? XLEN'(2) : XLEN'(4));
+    if (fused) next_pc = next_pc + (fused_compressed ? XLEN'(2) : XLEN'(4));
+    return next_pc;
+  endfunction
+
+  // Whether a translation allows an access at `priv`; the A and D bits are
+  // checked separately, since Svadu walks the table again to set them
+  function automatic logic tlb_permits(tlb_entry_t entry, priv_e priv, logic sum, logic mxr,
+                                       logic fetch, logic store);
+    if ((priv == PRIV_U) ? !entry.u : (entry.u && (fetch || !sum))) return 1'b0;
+    if (fetch) return entry.x;
+    if (store) return entry.w;
+    return entry.r || (mxr && entry.x);
+  endfunction
+
 endpackage
 
 `endif
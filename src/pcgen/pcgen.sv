@@ -11,15 +11,25 @@ module pcgen
 
     // From/To Instruction Fetch Unit
     axis_if.m pcgif_axis_if,
+    output logic [XLEN-1:0] predecode_pc,
+    input logic predecode_vld,  // The IFU has the halfword at predecode_pc
+    input logic predecode_rvc,  // ... and it starts a compressed instruction
+    input logic predecode_taken,  // ... and it is a branch predicted taken to predecode_target
+    input logic [XLEN-1:0] predecode_target,
 
     // From Branch Resolution Unit
-    axis_if.s wbpcg_axis_if
+    axis_if.s wbpcg_axis_if,
+
+    // From Decoder
+    axis_if.s idpcg_axis_if
 );
 
   // Assert conditions
   initial begin
     assert (wbpcg_axis_if.TDATA_WIDTH == XLEN)
     else $fatal("wbpcg_axis_if.TDATA_WIDTH must be equal to XLEN");
+    assert (idpcg_axis_if.TDATA_WIDTH == XLEN)
+    else $fatal("idpcg_axis_if.TDATA_WIDTH must be equal to XLEN");
   end
 
   // Declare registers and their next states
@@ -31,26 +41,34 @@ module pcgen
 
   // Declare wires
   pcgif_tdata_t pcgif_tdata;
+  logic [XLEN-1:0] seq_pc;  // Predicted fall-through of pc_q; PC+4 unless known to be compressed
+  logic [XLEN-1:0] pred_pc;  // Predicted next PC: seq_pc unless the branch at pc_q is taken
 
   // Wire assignments
   assign wbpcg_axis_if.tready = 1'b1;
+  assign idpcg_axis_if.tready = !wbpcg_axis_if.tvalid;  // The back-end redirect is older
   assign pcgif_axis_if.tvalid = 1'b1;
+  assign predecode_pc = pc_q;
+  assign seq_pc = pc_q + ((predecode_vld && predecode_rvc) ? XLEN'(2) : XLEN'(4));
+  assign pred_pc = (predecode_vld && predecode_taken) ? predecode_target : seq_pc;
 
   always_comb begin
     pc_d = pc_q;
 
     pcgif_tdata.pc = pc_q;
-    pcgif_tdata.untaken_pc = '0;  // TODO
+    pcgif_tdata.untaken_pc = pred_pc;  // The decoder checks it against the actual next PC
 
     if (wbpcg_axis_if.tvalid) begin
       pc_d = wbpcg_axis_if.tdata;
+    end else if (idpcg_axis_if.tvalid) begin
+      pc_d = idpcg_axis_if.tdata;
     end else if (pcgif_axis_if.tready) begin
-      pc_d = pc_q + XLEN'(4);
+      pc_d = pred_pc;
     end
 
 `ifndef SYNTHESIS
     inst_id_d = inst_id_q;
-    if (wbpcg_axis_if.tvalid || pcgif_axis_if.tready) begin
+    if (wbpcg_axis_if.tvalid || idpcg_axis_if.tvalid || pcgif_axis_if.tready) begin
       inst_id_d = inst_id_q + INST_ID_WIDTH'(1);
     end
 
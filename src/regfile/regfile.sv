@@ -7,10 +7,13 @@ module regfile
     input logic clk,
     input logic rst,
 
-    axis_if.s idrf_axis_if,  // From Decoder
-    axis_if.m rfex_axis_if,  // To Execution Units
+    axis_if.s idrf_axis_if,   // From Decoder
+    axis_if.s idrf1_axis_if,  // From Decoder (second issue slot)
+    axis_if.m rfex_axis_if,   // To Execution Units
+    axis_if.m rfex1_axis_if,  // To Execution Units (second issue slot)
 
-    axis_if.s wbrf_axis_if,  // From Write Back
+    axis_if.s wbrf_axis_if,   // From Write Back
+    axis_if.s wbrf1_axis_if,  // From Write Back (second issue slot)
 
     csr_rif.req rfcsr_rif,  // CSR read interface
 
@@ -19,9 +22,13 @@ module regfile
 
   // Declare parameters
   parameter RF_DEPTH = 32;
+  // In-flight writers of a register: the RFEX slice and the one-entry EXWB
+  // FIFO, whose depth the dispatcher asserts
+  localparam PENDING_WIDTH = 2;
 
   // Declare interfaces
   axis_if #(.TDATA_WIDTH($bits(rfex_tdata_t))) rfex_slice_if ();
+  axis_if #(.TDATA_WIDTH($bits(rfex_tdata_t))) rfex1_slice_if ();  // Moves in lockstep with rfex_slice_if
 
   // Declare memory array
   logic [XLEN-1:0] rf_mem[0:RF_DEPTH-1];
@@ -32,45 +39,163 @@ module regfile
     end
   end
 
+  // Declare registers and their next states
+  // Scoreboard: the number of instructions past this stage that will write each register
+  logic [PENDING_WIDTH-1:0] pending_q[RF_DEPTH], pending_d[RF_DEPTH];
+
   // Declare wires
-  idrf_tdata_t idrf_tdata;
-  rfex_tdata_t rfex_tdata;
-  wbrf_tdata_t wbrf_tdata;
+  idrf_tdata_t idrf_tdata, idrf1_tdata;
+  rfex_tdata_t rfex_tdata, rfex_prev_tdata;
+  rfex_tdata_t rfex1_tdata, rfex1_prev_tdata;
+  wbrf_tdata_t wbrf_tdata, wbrf1_tdata;
   logic [XLEN-1:0] rs1_data, rs2_data;
+  logic [XLEN-1:0] rs1_data_1, rs2_data_1;
+  logic [4:0] commit_rd, commit1_rd;
+  logic commit, commit1;
+  fwd_t fwd_rs1, fwd_rs2;
+  fwd_t fwd_rs1_1, fwd_rs2_1;
+  logic stall_rs1, stall_rs2;
+  logic stall_rs1_1, stall_rs2_1;
+  logic issue, issue1;  // Each slot moves into the RFEX slices
+  logic pairable;  // The second slot may issue together with the first
+
+  // Resolve a source operand against the in-flight writers:
+  // - An instruction in the RFEX slices writes rs: wait for it in the dispatcher (fwd.ex)
+  // - An older one, in the EXWB FIFO, writes rs and is not committing now:
+  //   also fwd.ex if it will be among the immediately preceding instructions
+  //   at dispatch (the RFEX slices are empty), otherwise stall
+  // - It is committing now: take its value from the write back (fwd.rf)
+  // The two instructions of an issued pair never write the same register, so
+  // at most one lane of each stage can match.
+  function automatic void resolve(input logic [4:0] rs, input logic rs_vld,
+                                  input logic [PENDING_WIDTH-1:0] pending, input logic ex_vld,
+                                  input logic [4:0] ex_rd, input logic ex1_vld,
+                                  input logic [4:0] ex1_rd, input logic wb_vld,
+                                  input logic [4:0] wb_rd, input logic wb1_vld,
+                                  input logic [4:0] wb1_rd, output fwd_t fwd, output logic stall);
+    logic ex_hit, wb_hit;
+    ex_hit = rs_vld && ((ex_vld && (ex_rd == rs)) || (ex1_vld && (ex1_rd == rs)));
+    wb_hit = rs_vld && ((wb_vld && (wb_rd == rs)) || (wb1_vld && (wb1_rd == rs)));
+    fwd.ex = ex_hit || (rs_vld && (pending != '0) && !wb_hit && !ex_vld);
+    fwd.rf = !ex_hit && wb_hit;
+    stall = !ex_hit && rs_vld && (pending != '0) && !wb_hit && ex_vld;
+  endfunction
 
   // Wire assignments
   assign idrf_tdata = idrf_axis_if.tdata;
+  assign idrf1_tdata = idrf1_axis_if.tdata;
   assign rfex_tdata.csr_rdata = rfcsr_rif.rdata;
-  assign rfex_tdata.mtvec = rfcsr_rif.mtvec;
+  assign rfex_tdata.csr_illegal = rfcsr_rif.exception;
   assign rfex_tdata.mepc = rfcsr_rif.mepc;
+  assign rfex_tdata.sepc = rfcsr_rif.sepc;
+  assign rfex_tdata.priv = rfcsr_rif.priv;
+  assign rfex1_tdata.csr_rdata = '0;  // The second slot only takes ALU instructions
+  assign rfex1_tdata.csr_illegal = '0;
+  assign rfex1_tdata.mepc = '0;
+  assign rfex1_tdata.sepc = '0;
+  assign rfex1_tdata.priv = rfcsr_rif.priv;
 
   always_comb begin
     wbrf_tdata = wbrf_axis_if.tdata;
+    wbrf1_tdata = wbrf1_axis_if.tdata;
+    rfex_prev_tdata = rfex_axis_if.tdata;
+    rfex1_prev_tdata = rfex1_axis_if.tdata;
+    commit_rd = wbrf_tdata.ex_data.rd;
+    commit = wbrf_axis_if.tvalid && wbrf_axis_if.tready && (commit_rd != '0);
+    commit1_rd = wbrf1_tdata.ex_data.rd;
+    commit1 = wbrf1_axis_if.tvalid && wbrf1_axis_if.tready && (commit1_rd != '0);
 
     rfcsr_rif.addr = idrf_tdata.csr_addr;  // Is this evaluated before rfcsr_rif.rdata is used?
 
-    rs1_data = (idrf_tdata.fwd_rs1.rf && (idrf_tdata.rs1 == wbrf_tdata.ex_data.rf_data.id_data.rd) && wbrf_axis_if.tvalid) ? wbrf_tdata.wdata : rf_mem[idrf_tdata.rs1];
-    rs2_data = (idrf_tdata.fwd_rs2.rf && (idrf_tdata.rs2 == wbrf_tdata.ex_data.rf_data.id_data.rd) && wbrf_axis_if.tvalid) ? wbrf_tdata.wdata : rf_mem[idrf_tdata.rs2];
+    resolve(idrf_tdata.rs1, idrf_tdata.fwd_rs1.rf, pending_q[idrf_tdata.rs1],
+            rfex_axis_if.tvalid, rfex_prev_tdata.id_data.rd, rfex1_axis_if.tvalid,
+            rfex1_prev_tdata.id_data.rd, commit, commit_rd, commit1, commit1_rd, fwd_rs1,
+            stall_rs1);
+    resolve(idrf_tdata.rs2, idrf_tdata.fwd_rs2.rf, pending_q[idrf_tdata.rs2],
+            rfex_axis_if.tvalid, rfex_prev_tdata.id_data.rd, rfex1_axis_if.tvalid,
+            rfex1_prev_tdata.id_data.rd, commit, commit_rd, commit1, commit1_rd, fwd_rs2,
+            stall_rs2);
+    resolve(idrf1_tdata.rs1, idrf1_tdata.fwd_rs1.rf, pending_q[idrf1_tdata.rs1],
+            rfex_axis_if.tvalid, rfex_prev_tdata.id_data.rd, rfex1_axis_if.tvalid,
+            rfex1_prev_tdata.id_data.rd, commit, commit_rd, commit1, commit1_rd, fwd_rs1_1,
+            stall_rs1_1);
+    resolve(idrf1_tdata.rs2, idrf1_tdata.fwd_rs2.rf, pending_q[idrf1_tdata.rs2],
+            rfex_axis_if.tvalid, rfex_prev_tdata.id_data.rd, rfex1_axis_if.tvalid,
+            rfex1_prev_tdata.id_data.rd, commit, commit_rd, commit1, commit1_rd, fwd_rs2_1,
+            stall_rs2_1);
+
+    rs1_data = fwd_rs1.rf ? ((commit1 && (commit1_rd == idrf_tdata.rs1)) ? wbrf1_tdata.wdata : wbrf_tdata.wdata) : rf_mem[idrf_tdata.rs1];
+    rs2_data = fwd_rs2.rf ? ((commit1 && (commit1_rd == idrf_tdata.rs2)) ? wbrf1_tdata.wdata : wbrf_tdata.wdata) : rf_mem[idrf_tdata.rs2];
+    rs1_data_1 = fwd_rs1_1.rf ? ((commit1 && (commit1_rd == idrf1_tdata.rs1)) ? wbrf1_tdata.wdata : wbrf_tdata.wdata) : rf_mem[idrf1_tdata.rs1];
+    rs2_data_1 = fwd_rs2_1.rf ? ((commit1 && (commit1_rd == idrf1_tdata.rs2)) ? wbrf1_tdata.wdata : wbrf_tdata.wdata) : rf_mem[idrf1_tdata.rs2];
 
     rfex_tdata.operands.op1 = rs1_data | idrf_tdata.auipc;  // Assuming rs1 and auipc are exclusive
     rfex_tdata.operands.op2 = rs2_data | idrf_tdata.immediate; // Assuming rs2 and immediate are exclusive
     rfex_tdata.rs2_data = rs2_data;  // For store
 
     rfex_tdata.id_data = idrf_tdata;
+    rfex_tdata.id_data.fwd_rs1 = fwd_rs1;
+    rfex_tdata.id_data.fwd_rs2 = fwd_rs2;
+
+    rfex1_tdata.operands.op1 = rs1_data_1 | idrf1_tdata.auipc;
+    rfex1_tdata.operands.op2 = rs2_data_1 | idrf1_tdata.immediate;
+    rfex1_tdata.rs2_data = rs2_data_1;
+
+    rfex1_tdata.id_data = idrf1_tdata;
+    rfex1_tdata.id_data.fwd_rs1 = fwd_rs1_1;
+    rfex1_tdata.id_data.fwd_rs2 = fwd_rs2_1;
+
+    // Pairing rules: the second slot only issues alongside the first one,
+    // holds an ALU instruction that cannot trap, and neither reads nor
+    // rewrites the register written by the first slot
+    pairable = idrf1_tdata.alu_cmd_vld && (idrf1_tdata.trap_cause == '0) &&
+        !stall_rs1_1 && !stall_rs2_1 &&
+        ((idrf_tdata.rd == '0) ||
+         (!(idrf1_tdata.fwd_rs1.rf && (idrf1_tdata.rs1 == idrf_tdata.rd)) &&
+          !(idrf1_tdata.fwd_rs2.rf && (idrf1_tdata.rs2 == idrf_tdata.rd)) &&
+          (idrf1_tdata.rd != idrf_tdata.rd)));
 
     // Slice connection
+    issue = idrf_axis_if.tvalid && rfex_slice_if.tready && !stall_rs1 && !stall_rs2;
+    issue1 = issue && idrf1_axis_if.tvalid && rfex1_slice_if.tready && pairable;
     rfex_slice_if.tdata = rfex_tdata;
-    rfex_slice_if.tvalid = idrf_axis_if.tvalid;
-    idrf_axis_if.tready = rfex_slice_if.tready;
+    rfex_slice_if.tvalid = idrf_axis_if.tvalid && !stall_rs1 && !stall_rs2;
+    idrf_axis_if.tready = rfex_slice_if.tready && !stall_rs1 && !stall_rs2;
+    rfex1_slice_if.tdata = rfex1_tdata;
+    rfex1_slice_if.tvalid = issue1;
+    idrf1_axis_if.tready = issue1;
 
     // Write Back
     wbrf_axis_if.tready = 1'b1;
+    wbrf1_axis_if.tready = 1'b1;
+
+    // Scoreboard
+    for (int i = 0; i < RF_DEPTH; i++) begin
+      pending_d[i] = pending_q[i];
+      if (issue && (idrf_tdata.rd == i) && (i != 0)) pending_d[i] = pending_d[i] + 1'b1;
+      if (issue1 && (idrf1_tdata.rd == i) && (i != 0)) pending_d[i] = pending_d[i] + 1'b1;
+      if (commit && (commit_rd == i)) pending_d[i] = pending_d[i] - 1'b1;
+      if (commit1 && (commit1_rd == i)) pending_d[i] = pending_d[i] - 1'b1;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    for (int i = 0; i < RF_DEPTH; i++) begin
+      if (rst || invalidate) begin  // Every in-flight instruction is flushed
+        pending_q[i] <= '0;
+      end else begin
+        pending_q[i] <= pending_d[i];
+      end
+    end
   end
 
   always_ff @(posedge clk) begin
     if (!rst) begin
-      if (wbrf_axis_if.tvalid && wbrf_axis_if.tready && (wbrf_tdata.ex_data.rf_data.id_data.rd != 0) /* && !invalidate */) begin // Is `invalidate` useful?
-        rf_mem[wbrf_tdata.ex_data.rf_data.id_data.rd] <= wbrf_tdata.wdata;
+      if (wbrf_axis_if.tvalid && wbrf_axis_if.tready && (wbrf_tdata.ex_data.rd != 0) /* && !invalidate */) begin // Is `invalidate` useful?
+        rf_mem[wbrf_tdata.ex_data.rd] <= wbrf_tdata.wdata;
+      end
+      if (commit1) begin  // Never the same register as the first lane
+        rf_mem[commit1_rd] <= wbrf1_tdata.wdata;
       end
     end
   end
@@ -83,4 +208,12 @@ module regfile
       .invalidate(invalidate)
   );
 
+  axis_slice rfex1_slice (
+      .clk(clk),
+      .rst(rst),
+      .axis_mif(rfex1_axis_if),
+      .axis_sif(rfex1_slice_if),
+      .invalidate(invalidate)
+  );
+
 endmodule
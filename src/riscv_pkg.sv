@@ -89,6 +89,32 @@ package riscv_pkg;
     UNKNOWN
   } opcode_e;
 
+  typedef enum logic [1:0] {
+    PRIV_U = 2'b00,
+    PRIV_S = 2'b01,
+    PRIV_M = 2'b11
+  } priv_e;
+
+  typedef struct packed {
+    logic mode;  // 0: Bare, 1: Sv32
+    logic [8:0] asid;
+    logic [21:0] ppn;
+  } satp_t;
+
+  typedef struct packed {
+    logic [11:0] ppn1;
+    logic [9:0] ppn0;
+    logic [1:0] rsw;
+    logic d;
+    logic a;
+    logic g;
+    logic u;
+    logic x;
+    logic w;
+    logic r;
+    logic v;
+  } sv32_pte_t;
+
   typedef struct packed {
     logic sd;
     logic [5:0] wpri0;
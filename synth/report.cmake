@@ -0,0 +1,42 @@
+# SPDX-License-Identifier: MIT
+
+# Summarizes the stat.txt and sta.txt written by synth.ys in DIR:
+#   cmake -DVARIANT=<name> -DDIR=<dir> -P report.cmake
+
+# The count of a cell type in the output of stat, which puts it either
+# before or after the name depending on the Yosys version
+function(cell_count out stat cell)
+  set(count 0)
+  string(REGEX MATCHALL "[0-9]+ +${cell}[ \n]|${cell} +[0-9]+" lines "${stat}")
+  foreach(line IN LISTS lines)
+    string(REGEX MATCH "[0-9]+" n "${line}")
+    math(EXPR count "${count} + ${n}")
+  endforeach()
+  set(${out} ${count} PARENT_SCOPE)
+endfunction()
+
+file(READ ${DIR}/stat.txt stat)
+file(READ ${DIR}/sta.txt sta)
+
+set(luts 0)
+foreach(cell LUT1 LUT2 LUT3 LUT4 LUT5 LUT6)
+  cell_count(n "${stat}" ${cell})
+  math(EXPR luts "${luts} + ${n}")
+endforeach()
+set(ffs 0)
+foreach(cell FDRE FDSE FDCE FDPE)
+  cell_count(n "${stat}" ${cell})
+  math(EXPR ffs "${ffs} + ${n}")
+endforeach()
+set(lutrams 0)
+foreach(cell RAM32X1D RAM64X1D RAM128X1D RAM32M RAM64M RAM32M16 RAM64M8)
+  cell_count(n "${stat}" ${cell})
+  math(EXPR lutrams "${lutrams} + ${n}")
+endforeach()
+cell_count(ramb36 "${stat}" RAMB36E1)
+cell_count(ramb18 "${stat}" RAMB18E1)
+string(REGEX MATCH "Latest arrival time in '[^']*' is ([0-9]+)" unused "${sta}")
+set(arrival ${CMAKE_MATCH_1})
+
+message("${VARIANT}: ${luts} LUTs, ${ffs} FFs, ${lutrams} LUT-RAM cells, "
+        "${ramb36} RAMB36E1, ${ramb18} RAMB18E1, critical path ${arrival} ps before routing")
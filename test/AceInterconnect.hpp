@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MIT
+
+#include <array>
+#include <cstdint>
+#include <print>
+
+#include "AceMemory.hpp"
+
+// Snooping interconnect in front of an AceMemory, driving the smp_ace_* ports
+// of offnariscv_smp_wrap. Writes go straight to memory; reads are served one
+// at a time in round-robin order, and a read in a shareable domain first sends
+// the same snoop to every other core and waits for all of their responses.
+// Dirty data passed back by a snoop is written to memory before the read
+// completes, so a requester never receives PassDirty. Exclusive reads are
+// always granted (EXOKAY): they are serialized with every other read, and the
+// ReadUnique of an SC snoops away every other copy, and with it any competing
+// reservation.
+// Call respond() before the clock edge and retire() after it.
+template <int NUM_CORES>
+class AceInterconnect {
+ public:
+  static constexpr std::uint32_t BLOCK_BYTES = AceMemory::BLOCK_BYTES;
+  static constexpr std::uint32_t BLOCK_MASK = AceMemory::BLOCK_MASK;
+  static constexpr int BUS_BYTES = AceMemory::BUS_BYTES;
+  static constexpr int BEATS = BLOCK_BYTES / BUS_BYTES;
+
+  // crresp bits
+  static constexpr std::uint32_t CR_DATA_TRANSFER = 1 << 0;
+  static constexpr std::uint32_t CR_PASS_DIRTY = 1 << 2;
+  static constexpr std::uint32_t CR_IS_SHARED = 1 << 3;
+
+  // rresp bits
+  static constexpr std::uint32_t R_PASS_DIRTY = 1 << 2;
+  static constexpr std::uint32_t R_IS_SHARED = 1 << 3;
+
+  static constexpr std::uint32_t READ_SHARED = 0b0001;
+
+  AceMemory memory;
+  bool verbose = false;
+
+  // Statistics
+  std::uint64_t reads = 0;
+  std::uint64_t writes = 0;
+  std::uint64_t snoops = 0;
+  std::uint64_t snoop_data = 0;  // Snoops that were answered with data
+
+  template <class T>
+  void init(T& dut) {
+    for (int c = 0; c < NUM_CORES; ++c) {
+      dut->smp_ace_awready[c] = 0;
+      dut->smp_ace_wready[c] = 0;
+      dut->smp_ace_bresp[c] = 0;
+      dut->smp_ace_bvalid[c] = 0;
+      dut->smp_ace_arready[c] = 0;
+      dut->smp_ace_rdata[c] = 0;
+      dut->smp_ace_rresp[c] = 0;
+      dut->smp_ace_rlast[c] = 0;
+      dut->smp_ace_rvalid[c] = 0;
+      dut->smp_ace_acvalid[c] = 0;
+      dut->smp_ace_acaddr[c] = 0;
+      dut->smp_ace_acsnoop[c] = 0;
+      dut->smp_ace_crready[c] = 0;
+      dut->smp_ace_cdready[c] = 0;
+    }
+    state = State::IDLE;
+    next_initiator = 0;
+    writing.fill(false);
+  }
+
+  template <class T>
+  void respond(T& dut) {
+    // AW/W/B channel
+    for (int c = 0; c < NUM_CORES; ++c) {
+      bready[c] = dut->smp_ace_bready[c];
+      dut->smp_ace_awready[c] = !writing[c] && !dut->smp_ace_bvalid[c];
+      dut->smp_ace_wready[c] = 0;
+      if (dut->smp_ace_awready[c] && dut->smp_ace_awvalid[c]) {
+        writing[c] = true;
+        awaddr[c] = dut->smp_ace_awaddr[c];
+        wbeat[c] = 0;
+        bresp[c] = 0;
+        if (verbose) std::print("[{}] write {:#010x}\n", c, awaddr[c]);
+        ++writes;
+      }
+      if (writing[c] && dut->smp_ace_wvalid[c]) {
+        auto addr = AceMemory::beat_addr(awaddr[c], wbeat[c]++);
+        dut->smp_ace_wready[c] = 1;
+        if (memory.contains(addr)) {
+          auto& p = memory.page(addr);
+          auto offset = addr & AceMemory::PAGE_OFFSET_MASK;
+          for (int i = 0; i < BUS_BYTES; ++i) {
+            if ((dut->smp_ace_wstrb[c] >> i) & 1) {
+              p[offset + i] = dut->smp_ace_wdata[c] >> (8 * i);
+            }
+          }
+        } else {
+          bresp[c] = 2;  // SLVERR
+        }
+        if (dut->smp_ace_wlast[c]) {
+          writing[c] = false;
+          dut->smp_ace_bvalid[c] = 1;
+          dut->smp_ace_bresp[c] = bresp[c];
+        }
+      }
+    }
+
+    // AR/R and AC/CR/CD channels
+    for (int c = 0; c < NUM_CORES; ++c) {
+      dut->smp_ace_arready[c] = 0;
+      dut->smp_ace_crready[c] = 1;
+      dut->smp_ace_cdready[c] = 1;
+    }
+    switch (state) {
+      case State::IDLE:
+        for (int k = 0; k < NUM_CORES; ++k) {
+          int c = (next_initiator + k) % NUM_CORES;
+          if (dut->smp_ace_arvalid[c]) {
+            dut->smp_ace_arready[c] = 1;
+            initiator = c;
+            araddr = dut->smp_ace_araddr[c];
+            rbeats = dut->smp_ace_arlen[c] + 1;
+            arsnoop = dut->smp_ace_arsnoop[c];
+            arlock = dut->smp_ace_arlock[c];
+            ardomain = dut->smp_ace_ardomain[c];
+            break;
+          }
+        }
+        break;
+      case State::SNOOP:
+        for (int c = 0; c < NUM_CORES; ++c) {
+          if (dut->smp_ace_acvalid[c] && dut->smp_ace_acready[c]) ac_done[c] = true;
+          if (dut->smp_ace_crvalid[c]) {
+            auto crresp = dut->smp_ace_crresp[c];
+            cr_done[c] = true;
+            cd_pending[c] = crresp & CR_DATA_TRANSFER;
+            if (crresp & CR_IS_SHARED) shared = true;
+            if (crresp & CR_PASS_DIRTY) dirty = true;
+          }
+          if (dut->smp_ace_cdvalid[c]) {  // The snooped line comes in beats from its start
+            line[cd_beat[c]++] = dut->smp_ace_cddata[c];
+            if (dut->smp_ace_cdlast[c]) {
+              cd_pending[c] = false;
+              cd_received = true;
+            }
+          }
+        }
+        break;
+      case State::RESP: {
+        auto addr = AceMemory::beat_addr(araddr, rbeat);
+        rready = dut->smp_ace_rready[initiator];
+        dut->smp_ace_rvalid[initiator] = 1;
+        dut->smp_ace_rdata[initiator] = line[(addr & ~BLOCK_MASK) / BUS_BYTES];
+        dut->smp_ace_rlast[initiator] = (rbeat == rbeats - 1);
+        break;
+      }
+    }
+  }
+
+  template <class T>
+  void retire(T& dut) {
+    for (int c = 0; c < NUM_CORES; ++c) {
+      if (bready[c]) dut->smp_ace_bvalid[c] = 0;
+    }
+
+    switch (state) {
+      case State::IDLE:
+        if (initiator < 0) break;
+        ++reads;
+        next_initiator = (initiator + 1) % NUM_CORES;
+        shared = false;
+        dirty = false;
+        cd_received = false;
+        if (ardomain != 0 && NUM_CORES > 1) {
+          for (int c = 0; c < NUM_CORES; ++c) {
+            bool snooped = (c != initiator);
+            ac_done[c] = !snooped;
+            cr_done[c] = !snooped;
+            cd_pending[c] = false;
+            cd_beat[c] = 0;
+            dut->smp_ace_acvalid[c] = snooped;
+            dut->smp_ace_acaddr[c] = araddr & BLOCK_MASK;
+            dut->smp_ace_acsnoop[c] = arsnoop;
+          }
+          snoops += NUM_CORES - 1;
+          state = State::SNOOP;
+        } else {
+          complete(dut);
+        }
+        break;
+      case State::SNOOP: {
+        bool done = true;
+        for (int c = 0; c < NUM_CORES; ++c) {
+          if (ac_done[c]) dut->smp_ace_acvalid[c] = 0;
+          done = done && ac_done[c] && cr_done[c] && !cd_pending[c];
+        }
+        if (done) complete(dut);
+        break;
+      }
+      case State::RESP:
+        if (rready && ++rbeat == rbeats) {
+          dut->smp_ace_rvalid[initiator] = 0;
+          dut->smp_ace_rlast[initiator] = 0;
+          initiator = -1;
+          state = State::IDLE;
+        }
+        break;
+    }
+  }
+
+ private:
+  enum class State { IDLE, SNOOP, RESP };
+
+  State state = State::IDLE;
+  int next_initiator = 0;
+  int initiator = -1;
+  std::uint32_t araddr = 0;
+  int rbeats = 0;
+  int rbeat = 0;
+  std::uint32_t arsnoop = 0;
+  std::uint32_t ardomain = 0;
+  bool arlock = false;
+
+  std::array<bool, NUM_CORES> ac_done{};
+  std::array<bool, NUM_CORES> cr_done{};
+  std::array<bool, NUM_CORES> cd_pending{};
+  std::array<int, NUM_CORES> cd_beat{};
+  std::array<bool, NUM_CORES> bready{};
+  std::array<bool, NUM_CORES> writing{};
+  std::array<std::uint32_t, NUM_CORES> awaddr{};
+  std::array<int, NUM_CORES> wbeat{};
+  std::array<std::uint32_t, NUM_CORES> bresp{};
+  std::array<std::uint64_t, BEATS> line{};
+  bool shared = false;
+  bool dirty = false;
+  bool cd_received = false;
+  bool rready = false;
+
+  // Serve the line on the R channel of the initiator, from a snooped cache if
+  // one supplied it and from memory otherwise, critical beat first
+  template <class T>
+  void complete(T& dut) {
+    auto base = araddr & BLOCK_MASK;
+    bool ok = memory.contains(base);
+    if (cd_received) {
+      ++snoop_data;
+      if (dirty && ok) {
+        memory.write(base, reinterpret_cast<const std::uint8_t*>(line.data()), BLOCK_BYTES);
+      }
+    } else if (ok) {
+      for (int i = 0; i < BEATS; ++i) {
+        line[i] = memory.read64(base + BUS_BYTES * i);
+      }
+    }
+    rbeat = 0;
+    std::uint32_t rresp = !ok ? 2 : arlock ? 1 : 0;  // SLVERR, EXOKAY or OKAY
+    if (shared && arsnoop == READ_SHARED) rresp |= R_IS_SHARED;
+    dut->smp_ace_rresp[initiator] = rresp;
+    if (verbose) {
+      std::print("[{}] read {:#010x} snoop={:#x} rresp={:#x}{}\n", initiator, araddr, arsnoop,
+                 rresp, cd_received ? " (from cache)" : "");
+    }
+    state = State::RESP;
+  }
+};
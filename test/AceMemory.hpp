@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstdint>
+#include <print>
+#include <unordered_map>
+#include <vector>
+
+// Sparse main memory behind the core_ace_* ports of offnariscv_core_wrap. It
+// serves one read and one write burst at a time, a beat per cycle.
+// Call respond() before the clock edge and retire() after it.
+class AceMemory {
+ public:
+  static constexpr std::uint32_t PAGE_SIZE = 4096;
+  static constexpr std::uint32_t PAGE_OFFSET_MASK = PAGE_SIZE - 1;
+  static constexpr std::uint32_t PAGE_NUMBER_MASK = ~PAGE_OFFSET_MASK;
+
+  static constexpr std::uint32_t BLOCK_BYTES = 32;  // Assuming each block is 32 bytes (256 bits)
+  static constexpr std::uint32_t BLOCK_MASK = ~(BLOCK_BYTES - 1);
+  static constexpr int BUS_BYTES = 8;  // ... moved in bursts over a 64-bit bus
+
+  bool verbose = false;
+
+  bool contains(std::uint32_t addr) const { return pages.contains(addr & PAGE_NUMBER_MASK); }
+  bool empty() const { return pages.empty(); }
+  void clear() { pages.clear(); }
+
+  // Returns the page containing addr, allocating a zero-filled one if needed
+  std::vector<std::uint8_t>& page(std::uint32_t addr) {
+    auto& p = pages[addr & PAGE_NUMBER_MASK];
+    if (p.size() < PAGE_SIZE) p.resize(PAGE_SIZE);
+    return p;
+  }
+
+  void write(std::uint32_t addr, const std::uint8_t* data, std::size_t size) {
+    while (size > 0) {
+      auto& p = page(addr);
+      auto offset = addr & PAGE_OFFSET_MASK;
+      auto n = std::min<std::size_t>(size, PAGE_SIZE - offset);
+      std::copy(data, data + n, p.begin() + offset);
+      addr += n;
+      data += n;
+      size -= n;
+    }
+  }
+
+  void write32(std::uint32_t addr, std::uint32_t value) {
+    write(addr, reinterpret_cast<const std::uint8_t*>(&value), sizeof(value));
+  }
+
+  std::uint32_t read32(std::uint32_t addr) {
+    return *reinterpret_cast<const std::uint32_t*>(&page(addr)[addr & PAGE_OFFSET_MASK]);
+  }
+
+  template <class T>
+  void init(T& dut) {
+    dut->core_ace_awready = 0;
+    dut->core_ace_wready = 0;
+    dut->core_ace_bid = 0;
+    dut->core_ace_bresp = 0;
+    dut->core_ace_buser = 0;
+    dut->core_ace_bvalid = 0;
+    dut->core_ace_arready = 0;
+    dut->core_ace_rid = 0;
+    dut->core_ace_rdata = 0;
+    dut->core_ace_rresp = 0;
+    dut->core_ace_rlast = 0;
+    dut->core_ace_ruser = 0;
+    dut->core_ace_rvalid = 0;
+    dut->core_ace_acvalid = 0;
+    dut->core_ace_acaddr = 0;
+    dut->core_ace_acsnoop = 0;
+    dut->core_ace_acprot = 0;
+    dut->core_ace_crready = 0;
+    dut->core_ace_cdready = 0;
+    rready = false;
+    bready = false;
+    reading = false;
+    writing = false;
+  }
+
+  // Address of beat `beat` of a burst starting at `addr`. Bursts never leave
+  // their block: a refill wraps around it, and the others start at its first
+  // beat or have a single one.
+  static std::uint32_t beat_addr(std::uint32_t addr, int beat) {
+    auto first = (addr & ~BLOCK_MASK) / BUS_BYTES;
+    return (addr & BLOCK_MASK) + (first + beat) % (BLOCK_BYTES / BUS_BYTES) * BUS_BYTES;
+  }
+
+  std::uint64_t read64(std::uint32_t addr) {
+    return *reinterpret_cast<const std::uint64_t*>(&page(addr)[addr & PAGE_OFFSET_MASK]);
+  }
+
+  template <class T>
+  void respond(T& dut) {
+    // NOTE: This method might not work, if there is a load/store queue
+    rready = dut->core_ace_rready;
+    dut->core_ace_arready = !reading;
+    if (!reading && dut->core_ace_arvalid) {
+      reading = true;
+      araddr = dut->core_ace_araddr;
+      arlock = dut->core_ace_arlock;
+      rbeats = dut->core_ace_arlen + 1;
+      rbeat = 0;
+      if (verbose) std::print("araddr: {:#010x}, arlen: {}\n", araddr, rbeats - 1);
+    }
+    if (reading) {
+      auto addr = beat_addr(araddr, rbeat);
+      dut->core_ace_rvalid = 1;
+      dut->core_ace_rlast = (rbeat == rbeats - 1);
+      if (contains(addr)) {
+        dut->core_ace_rdata = read64(addr);
+        if (verbose) std::print("rdata: {:#018x}\n", dut->core_ace_rdata);
+        // There is a single master, so an exclusive read is always granted
+        dut->core_ace_rresp = arlock ? 1 : 0;  // EXOKAY or OKAY
+      } else {
+        if (verbose) std::print("Read from uninitialized memory at {:#010x}\n", addr);
+        dut->core_ace_rresp = 2;  // SLVERR
+      }
+    }
+
+    bready = dut->core_ace_bready;
+    dut->core_ace_awready = !writing && !dut->core_ace_bvalid;
+    dut->core_ace_wready = 0;
+    if (dut->core_ace_awready && dut->core_ace_awvalid) {
+      writing = true;
+      awaddr = dut->core_ace_awaddr;
+      wbeat = 0;
+      bresp = 0;
+    }
+    if (writing && dut->core_ace_wvalid) {
+      auto addr = beat_addr(awaddr, wbeat++);
+      dut->core_ace_wready = 1;
+      if (contains(addr)) {
+        auto& p = page(addr);
+        auto offset = addr & PAGE_OFFSET_MASK;
+        for (int i = 0; i < BUS_BYTES; ++i) {
+          if ((dut->core_ace_wstrb >> i) & 1) {
+            p[offset + i] = dut->core_ace_wdata >> (8 * i);
+          }
+        }
+        if (verbose) {
+          std::print("awaddr: {:#010x}, wdata: {:#018x}, wstrb: {:#04x}\n", addr,
+                     dut->core_ace_wdata, dut->core_ace_wstrb);
+        }
+      } else {
+        bresp = 2;  // SLVERR
+      }
+      if (dut->core_ace_wlast) {
+        writing = false;
+        dut->core_ace_bvalid = 1;
+        dut->core_ace_bresp = bresp;
+      }
+    }
+  }
+
+  // No burst is in flight or being requested, so skipping cycles changes nothing here
+  template <class T>
+  bool idle(T& dut) const {
+    return !reading && !writing && !dut->core_ace_arvalid && !dut->core_ace_awvalid &&
+           !dut->core_ace_bvalid;
+  }
+
+  template <class T>
+  void retire(T& dut) {
+    if (reading && rready) {
+      if (++rbeat == rbeats) {
+        reading = false;
+        dut->core_ace_rvalid = 0;
+        dut->core_ace_rlast = 0;
+      }
+    }
+
+    if (bready) {
+      dut->core_ace_bvalid = 0;
+    }
+  }
+
+ private:
+  std::unordered_map<std::uint32_t, std::vector<std::uint8_t>> pages;
+  bool rready = false;
+  bool bready = false;
+
+  // The burst being served on each of the R and W channels
+  bool reading = false;
+  std::uint32_t araddr = 0;
+  bool arlock = false;
+  int rbeats = 0;
+  int rbeat = 0;
+  bool writing = false;
+  std::uint32_t awaddr = 0;
+  int wbeat = 0;
+  std::uint32_t bresp = 0;
+};
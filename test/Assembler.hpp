@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+
+#include <cstdint>
+#include <vector>
+
+// Minimal in-process RV32IA/Zicsr/Zifencei/Zicbom/Zicboz/Zba/Zbb encoder, so that tests can build
+// programs without a toolchain round-trip. Immediates are taken as the
+// architectural value (byte offsets for branches and jumps) and truncated to
+// the field width.
+namespace rv {
+
+enum Opcode : std::uint32_t {
+  LOAD = 0b0000011,
+  MISC_MEM = 0b0001111,
+  OP_IMM = 0b0010011,
+  AUIPC = 0b0010111,
+  STORE = 0b0100011,
+  AMO = 0b0101111,
+  OP = 0b0110011,
+  LUI = 0b0110111,
+  BRANCH = 0b1100011,
+  JALR = 0b1100111,
+  JAL = 0b1101111,
+  SYSTEM = 0b1110011,
+};
+
+constexpr std::uint32_t r_type(std::uint32_t opcode, std::uint32_t funct3, std::uint32_t funct7,
+                               int rd, int rs1, int rs2) {
+  return (funct7 << 25) | ((rs2 & 0x1f) << 20) | ((rs1 & 0x1f) << 15) | (funct3 << 12) |
+         ((rd & 0x1f) << 7) | opcode;
+}
+
+constexpr std::uint32_t i_type(std::uint32_t opcode, std::uint32_t funct3, int rd, int rs1,
+                               std::int32_t imm) {
+  return ((imm & 0xfff) << 20) | ((rs1 & 0x1f) << 15) | (funct3 << 12) | ((rd & 0x1f) << 7) |
+         opcode;
+}
+
+constexpr std::uint32_t s_type(std::uint32_t opcode, std::uint32_t funct3, int rs1, int rs2,
+                               std::int32_t imm) {
+  return (((imm >> 5) & 0x7f) << 25) | ((rs2 & 0x1f) << 20) | ((rs1 & 0x1f) << 15) |
+         (funct3 << 12) | ((imm & 0x1f) << 7) | opcode;
+}
+
+constexpr std::uint32_t b_type(std::uint32_t funct3, int rs1, int rs2, std::int32_t offset) {
+  return (((offset >> 12) & 1) << 31) | (((offset >> 5) & 0x3f) << 25) | ((rs2 & 0x1f) << 20) |
+         ((rs1 & 0x1f) << 15) | (funct3 << 12) | (((offset >> 1) & 0xf) << 8) |
+         (((offset >> 11) & 1) << 7) | BRANCH;
+}
+
+constexpr std::uint32_t u_type(std::uint32_t opcode, int rd, std::uint32_t imm) {
+  return (imm & 0xfffff000) | ((rd & 0x1f) << 7) | opcode;
+}
+
+constexpr std::uint32_t j_type(int rd, std::int32_t offset) {
+  return (((offset >> 20) & 1) << 31) | (((offset >> 1) & 0x3ff) << 21) |
+         (((offset >> 11) & 1) << 20) | (((offset >> 12) & 0xff) << 12) | ((rd & 0x1f) << 7) |
+         JAL;
+}
+
+// RV32I
+constexpr std::uint32_t lui(int rd, std::uint32_t imm) { return u_type(LUI, rd, imm); }
+constexpr std::uint32_t auipc(int rd, std::uint32_t imm) { return u_type(AUIPC, rd, imm); }
+constexpr std::uint32_t jal(int rd, std::int32_t offset) { return j_type(rd, offset); }
+constexpr std::uint32_t jalr(int rd, int rs1, std::int32_t imm) {
+  return i_type(JALR, 0b000, rd, rs1, imm);
+}
+
+constexpr std::uint32_t beq(int rs1, int rs2, std::int32_t offset) { return b_type(0b000, rs1, rs2, offset); }
+constexpr std::uint32_t bne(int rs1, int rs2, std::int32_t offset) { return b_type(0b001, rs1, rs2, offset); }
+constexpr std::uint32_t blt(int rs1, int rs2, std::int32_t offset) { return b_type(0b100, rs1, rs2, offset); }
+constexpr std::uint32_t bge(int rs1, int rs2, std::int32_t offset) { return b_type(0b101, rs1, rs2, offset); }
+constexpr std::uint32_t bltu(int rs1, int rs2, std::int32_t offset) { return b_type(0b110, rs1, rs2, offset); }
+constexpr std::uint32_t bgeu(int rs1, int rs2, std::int32_t offset) { return b_type(0b111, rs1, rs2, offset); }
+
+constexpr std::uint32_t lb(int rd, int rs1, std::int32_t imm) { return i_type(LOAD, 0b000, rd, rs1, imm); }
+constexpr std::uint32_t lh(int rd, int rs1, std::int32_t imm) { return i_type(LOAD, 0b001, rd, rs1, imm); }
+constexpr std::uint32_t lw(int rd, int rs1, std::int32_t imm) { return i_type(LOAD, 0b010, rd, rs1, imm); }
+constexpr std::uint32_t lbu(int rd, int rs1, std::int32_t imm) { return i_type(LOAD, 0b100, rd, rs1, imm); }
+constexpr std::uint32_t lhu(int rd, int rs1, std::int32_t imm) { return i_type(LOAD, 0b101, rd, rs1, imm); }
+
+constexpr std::uint32_t sb(int rs2, int rs1, std::int32_t imm) { return s_type(STORE, 0b000, rs1, rs2, imm); }
+constexpr std::uint32_t sh(int rs2, int rs1, std::int32_t imm) { return s_type(STORE, 0b001, rs1, rs2, imm); }
+constexpr std::uint32_t sw(int rs2, int rs1, std::int32_t imm) { return s_type(STORE, 0b010, rs1, rs2, imm); }
+
+constexpr std::uint32_t addi(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b000, rd, rs1, imm); }
+constexpr std::uint32_t slti(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b010, rd, rs1, imm); }
+constexpr std::uint32_t sltiu(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b011, rd, rs1, imm); }
+constexpr std::uint32_t xori(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b100, rd, rs1, imm); }
+constexpr std::uint32_t ori(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b110, rd, rs1, imm); }
+constexpr std::uint32_t andi(int rd, int rs1, std::int32_t imm) { return i_type(OP_IMM, 0b111, rd, rs1, imm); }
+constexpr std::uint32_t slli(int rd, int rs1, int shamt) { return i_type(OP_IMM, 0b001, rd, rs1, shamt & 0x1f); }
+constexpr std::uint32_t srli(int rd, int rs1, int shamt) { return i_type(OP_IMM, 0b101, rd, rs1, shamt & 0x1f); }
+constexpr std::uint32_t srai(int rd, int rs1, int shamt) { return i_type(OP_IMM, 0b101, rd, rs1, 0x400 | (shamt & 0x1f)); }
+
+constexpr std::uint32_t add(int rd, int rs1, int rs2) { return r_type(OP, 0b000, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t sub(int rd, int rs1, int rs2) { return r_type(OP, 0b000, 0b0100000, rd, rs1, rs2); }
+constexpr std::uint32_t sll(int rd, int rs1, int rs2) { return r_type(OP, 0b001, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t slt(int rd, int rs1, int rs2) { return r_type(OP, 0b010, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t sltu(int rd, int rs1, int rs2) { return r_type(OP, 0b011, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t xor_(int rd, int rs1, int rs2) { return r_type(OP, 0b100, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t srl(int rd, int rs1, int rs2) { return r_type(OP, 0b101, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t sra(int rd, int rs1, int rs2) { return r_type(OP, 0b101, 0b0100000, rd, rs1, rs2); }
+constexpr std::uint32_t or_(int rd, int rs1, int rs2) { return r_type(OP, 0b110, 0b0000000, rd, rs1, rs2); }
+constexpr std::uint32_t and_(int rd, int rs1, int rs2) { return r_type(OP, 0b111, 0b0000000, rd, rs1, rs2); }
+
+constexpr std::uint32_t fence() { return i_type(MISC_MEM, 0b000, 0, 0, 0x0ff); }  // fence iorw, iorw
+constexpr std::uint32_t fence_i() { return i_type(MISC_MEM, 0b001, 0, 0, 0); }
+constexpr std::uint32_t ecall() { return i_type(SYSTEM, 0b000, 0, 0, 0x000); }
+constexpr std::uint32_t ebreak() { return i_type(SYSTEM, 0b000, 0, 0, 0x001); }
+constexpr std::uint32_t mret() { return i_type(SYSTEM, 0b000, 0, 0, 0x302); }
+constexpr std::uint32_t wfi() { return i_type(SYSTEM, 0b000, 0, 0, 0x105); }
+
+// Zicbom and Zicboz; the address is rs1 alone
+constexpr std::uint32_t cbo_inval(int rs1) { return i_type(MISC_MEM, 0b010, 0, rs1, 0x000); }
+constexpr std::uint32_t cbo_clean(int rs1) { return i_type(MISC_MEM, 0b010, 0, rs1, 0x001); }
+constexpr std::uint32_t cbo_flush(int rs1) { return i_type(MISC_MEM, 0b010, 0, rs1, 0x002); }
+constexpr std::uint32_t cbo_zero(int rs1) { return i_type(MISC_MEM, 0b010, 0, rs1, 0x004); }
+
+// Zicsr
+constexpr std::uint32_t csrrw(int rd, int csr, int rs1) { return i_type(SYSTEM, 0b001, rd, rs1, csr); }
+constexpr std::uint32_t csrrs(int rd, int csr, int rs1) { return i_type(SYSTEM, 0b010, rd, rs1, csr); }
+constexpr std::uint32_t csrrc(int rd, int csr, int rs1) { return i_type(SYSTEM, 0b011, rd, rs1, csr); }
+constexpr std::uint32_t csrrwi(int rd, int csr, int uimm) { return i_type(SYSTEM, 0b101, rd, uimm, csr); }
+constexpr std::uint32_t csrrsi(int rd, int csr, int uimm) { return i_type(SYSTEM, 0b110, rd, uimm, csr); }
+constexpr std::uint32_t csrrci(int rd, int csr, int uimm) { return i_type(SYSTEM, 0b111, rd, uimm, csr); }
+
+// RV32A; the aq and rl bits are left clear
+constexpr std::uint32_t amo_w(std::uint32_t funct5, int rd, int rs1, int rs2) {
+  return r_type(AMO, 0b010, funct5 << 2, rd, rs1, rs2);
+}
+constexpr std::uint32_t lr_w(int rd, int rs1) { return amo_w(0b00010, rd, rs1, 0); }
+constexpr std::uint32_t sc_w(int rd, int rs1, int rs2) { return amo_w(0b00011, rd, rs1, rs2); }
+constexpr std::uint32_t amoswap_w(int rd, int rs1, int rs2) { return amo_w(0b00001, rd, rs1, rs2); }
+constexpr std::uint32_t amoadd_w(int rd, int rs1, int rs2) { return amo_w(0b00000, rd, rs1, rs2); }
+constexpr std::uint32_t amoxor_w(int rd, int rs1, int rs2) { return amo_w(0b00100, rd, rs1, rs2); }
+constexpr std::uint32_t amoand_w(int rd, int rs1, int rs2) { return amo_w(0b01100, rd, rs1, rs2); }
+constexpr std::uint32_t amoor_w(int rd, int rs1, int rs2) { return amo_w(0b01000, rd, rs1, rs2); }
+constexpr std::uint32_t amomin_w(int rd, int rs1, int rs2) { return amo_w(0b10000, rd, rs1, rs2); }
+constexpr std::uint32_t amomax_w(int rd, int rs1, int rs2) { return amo_w(0b10100, rd, rs1, rs2); }
+constexpr std::uint32_t amominu_w(int rd, int rs1, int rs2) { return amo_w(0b11000, rd, rs1, rs2); }
+constexpr std::uint32_t amomaxu_w(int rd, int rs1, int rs2) { return amo_w(0b11100, rd, rs1, rs2); }
+
+// Zba
+constexpr std::uint32_t sh1add(int rd, int rs1, int rs2) { return r_type(OP, 0b010, 0b0010000, rd, rs1, rs2); }
+constexpr std::uint32_t sh2add(int rd, int rs1, int rs2) { return r_type(OP, 0b100, 0b0010000, rd, rs1, rs2); }
+constexpr std::uint32_t sh3add(int rd, int rs1, int rs2) { return r_type(OP, 0b110, 0b0010000, rd, rs1, rs2); }
+
+// Zbb; the unary operations are OP-IMM with rs2 selecting the operation
+constexpr std::uint32_t andn(int rd, int rs1, int rs2) { return r_type(OP, 0b111, 0b0100000, rd, rs1, rs2); }
+constexpr std::uint32_t orn(int rd, int rs1, int rs2) { return r_type(OP, 0b110, 0b0100000, rd, rs1, rs2); }
+constexpr std::uint32_t xnor(int rd, int rs1, int rs2) { return r_type(OP, 0b100, 0b0100000, rd, rs1, rs2); }
+constexpr std::uint32_t min(int rd, int rs1, int rs2) { return r_type(OP, 0b100, 0b0000101, rd, rs1, rs2); }
+constexpr std::uint32_t minu(int rd, int rs1, int rs2) { return r_type(OP, 0b101, 0b0000101, rd, rs1, rs2); }
+constexpr std::uint32_t max(int rd, int rs1, int rs2) { return r_type(OP, 0b110, 0b0000101, rd, rs1, rs2); }
+constexpr std::uint32_t maxu(int rd, int rs1, int rs2) { return r_type(OP, 0b111, 0b0000101, rd, rs1, rs2); }
+constexpr std::uint32_t rol(int rd, int rs1, int rs2) { return r_type(OP, 0b001, 0b0110000, rd, rs1, rs2); }
+constexpr std::uint32_t ror(int rd, int rs1, int rs2) { return r_type(OP, 0b101, 0b0110000, rd, rs1, rs2); }
+constexpr std::uint32_t rori(int rd, int rs1, int shamt) { return i_type(OP_IMM, 0b101, rd, rs1, 0x600 | (shamt & 0x1f)); }
+constexpr std::uint32_t clz(int rd, int rs1) { return i_type(OP_IMM, 0b001, rd, rs1, 0x600); }
+constexpr std::uint32_t ctz(int rd, int rs1) { return i_type(OP_IMM, 0b001, rd, rs1, 0x601); }
+constexpr std::uint32_t cpop(int rd, int rs1) { return i_type(OP_IMM, 0b001, rd, rs1, 0x602); }
+constexpr std::uint32_t sext_b(int rd, int rs1) { return i_type(OP_IMM, 0b001, rd, rs1, 0x604); }
+constexpr std::uint32_t sext_h(int rd, int rs1) { return i_type(OP_IMM, 0b001, rd, rs1, 0x605); }
+constexpr std::uint32_t zext_h(int rd, int rs1) { return r_type(OP, 0b100, 0b0000100, rd, rs1, 0); }
+constexpr std::uint32_t orc_b(int rd, int rs1) { return i_type(OP_IMM, 0b101, rd, rs1, 0x287); }
+constexpr std::uint32_t rev8(int rd, int rs1) { return i_type(OP_IMM, 0b101, rd, rs1, 0x698); }
+
+// Pseudo instructions
+constexpr std::uint32_t nop() { return addi(0, 0, 0); }
+constexpr std::uint32_t mv(int rd, int rs1) { return addi(rd, rs1, 0); }
+constexpr std::uint32_t j(std::int32_t offset) { return jal(0, offset); }
+
+// li as lui + addi, always two instructions so that code layout does not
+// depend on the value
+inline void li(std::vector<std::uint32_t>& text, int rd, std::uint32_t value) {
+  auto lo = static_cast<std::int32_t>(value << 20) >> 20;  // Sign-extended low 12 bits
+  text.push_back(lui(rd, value - lo));
+  text.push_back(addi(rd, rd, lo));
+}
+
+}  // namespace rv
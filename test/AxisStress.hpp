@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+
+template <class T>
+class Dut;
+
+// Random backpressure on the sif_*/mif_* ports of the axis_* wraps in
+// test/common. The source and the sink each follow a Traffic pattern, the
+// source obeys the AXI rule that tvalid stays up until the handshake, and
+// every transfer is checked in order against a reference queue.
+struct Traffic {
+  double duty = 1.0;  // Long-run fraction of cycles the signal is asserted
+  double burst = 1.0;  // Mean run length of asserted cycles, 1 for independent cycles
+
+  static Traffic full() { return {1.0, 1.0}; }
+  static Traffic random(double duty) { return {duty, 1.0}; }
+  static Traffic bursty(double duty, double burst) { return {duty, burst}; }
+};
+
+// Two-state Markov source of a Traffic pattern: on runs average `burst`
+// cycles and off runs are sized so that the duty cycle comes out right
+class TrafficGen {
+  std::bernoulli_distribution to_off;
+  std::bernoulli_distribution to_on;
+  std::bernoulli_distribution independent;
+  Traffic traffic;
+  bool on = false;
+
+ public:
+  explicit TrafficGen(const Traffic& t)
+      : to_off(std::clamp(1.0 / t.burst, 0.0, 1.0)),
+        to_on(t.duty >= 1.0 ? 1.0 : std::clamp(t.duty / (t.burst * (1.0 - t.duty)), 0.0, 1.0)),
+        independent(std::clamp(t.duty, 0.0, 1.0)),
+        traffic(t) {}
+
+  template <class Rng>
+  bool next(Rng& rng) {
+    if (traffic.duty >= 1.0) return true;
+    if (traffic.burst <= 1.0) return independent(rng);
+    on = on ? !to_off(rng) : to_on(rng);
+    return on;
+  }
+};
+
+struct AxisStats {
+  std::uint64_t cycles = 0;
+  std::uint64_t transfers = 0;
+  std::uint64_t source_stalls = 0;  // Source valid, module not ready
+  std::uint64_t bubbles = 0;  // Sink ready and data inside, but nothing offered
+  std::uint64_t errors = 0;  // Out of order, lost or invented transfers
+  std::map<std::uint64_t, std::uint64_t> latency;  // Cycles from sif to mif handshake -> count
+
+  double throughput() const { return cycles ? static_cast<double>(transfers) / cycles : 0.0; }
+
+  // Smallest latency that covers fraction q of the transfers
+  std::uint64_t latency_quantile(double q) const {
+    std::uint64_t seen = 0;
+    for (const auto& [cycles, count] : latency) {
+      seen += count;
+      if (seen >= q * transfers) return cycles;
+    }
+    return latency.empty() ? 0 : latency.rbegin()->first;
+  }
+
+  double latency_mean() const {
+    double sum = 0;
+    for (const auto& [cycles, count] : latency) sum += static_cast<double>(cycles) * count;
+    return transfers ? sum / transfers : 0.0;
+  }
+};
+
+// Run `cycles` cycles on a freshly reset dut
+template <class T>
+AxisStats stress_axis(Dut<T>& dut, const Traffic& source, const Traffic& sink,
+                      std::uint64_t cycles, std::uint32_t seed) {
+  struct Beat {
+    std::uint32_t data;
+    std::uint64_t cycle;
+  };
+  std::mt19937 rng(seed);
+  TrafficGen source_gen(source);
+  TrafficGen sink_gen(sink);
+  std::deque<Beat> inside;
+  AxisStats stats;
+  std::uint32_t next_data = 0;
+  bool valid = false;
+
+  dut->sif_tvalid = 0;
+  dut->sif_tdata = 0;
+  dut->mif_tready = 0;
+  dut->invalidate = 0;
+  dut.reset();
+
+  for (std::uint64_t cycle = 0; cycle < cycles; ++cycle) {
+    valid = valid || source_gen.next(rng);
+    dut->sif_tvalid = valid;
+    dut->sif_tdata = next_data;
+    dut->mif_tready = sink_gen.next(rng);
+    dut->eval();
+
+    if (dut->mif_tready && !dut->mif_tvalid && !inside.empty()) ++stats.bubbles;
+    if (dut->mif_tvalid && dut->mif_tready) {
+      if (inside.empty() || dut->mif_tdata != inside.front().data) {
+        ++stats.errors;
+      } else {
+        ++stats.latency[cycle - inside.front().cycle];
+        inside.pop_front();
+      }
+      ++stats.transfers;
+    }
+    if (valid && !dut->sif_tready) ++stats.source_stalls;
+    if (valid && dut->sif_tready) {
+      inside.push_back({next_data++, cycle});
+      valid = false;
+    }
+    dut.step();
+  }
+  stats.cycles = cycles;
+  return stats;
+}
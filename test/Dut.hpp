@@ -1,31 +1,105 @@
 // SPDX-License-Identifier: MIT
 
-template <class T>
-class Dut {
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <string>
+
+// Cycle driver shared by the unit and core tests. A cycle is a negedge and a
+// posedge evaluation; Derived observes the model between the two in
+// on_negedge() and after the clock edge in on_posedge(). The hooks are bound
+// at compile time (CRTP), so the per-cycle loop has no virtual calls. Dut<T>
+// is the driver without hooks.
+template <class T, class Derived>
+class DutBase {
     T* dut_wrap;
+    std::uint64_t cycle_count = 0;
+    std::uint64_t run_start_cycle = 0;
+    std::chrono::steady_clock::time_point run_start;
+
+    Derived& derived() noexcept {
+        return static_cast<Derived&>(*this);
+    }
+
 public:
-    Dut() {
+    // Advance the VerilatedContext time by one unit per edge, for $time
+    bool advance_time = false;
+
+    struct RunStats {
+        std::uint64_t cycles;
+        double seconds;
+        double cycles_per_second() const {
+            return seconds > 0 ? cycles / seconds : 0.0;
+        }
+    };
+
+    DutBase() {
         dut_wrap = new T();
+        start_run();
     }
-    ~Dut() {
+    ~DutBase() {
         dut_wrap->final();
         delete dut_wrap;
     }
+    DutBase(const DutBase&) = delete;
+    DutBase& operator=(const DutBase&) = delete;
 
     T* operator->() const noexcept {
         return dut_wrap;
     }
+    std::uint64_t cycles() const noexcept {
+        return cycle_count;
+    }
+
+    void on_negedge() {}
+    void on_posedge() {}
+
     void step(int n = 1) {
         for (int i = 0; i < n; i++) {
             dut_wrap->clk = 0;
             dut_wrap->eval();
+            if (advance_time) dut_wrap->contextp()->timeInc(1);
+            derived().on_negedge();
             dut_wrap->clk = 1;
             dut_wrap->eval();
+            if (advance_time) dut_wrap->contextp()->timeInc(1);
+            derived().on_posedge();
+            ++cycle_count;
         }
     }
+
+    // Step until pred() holds, checking it before every cycle, for at most
+    // max_cycles cycles; returns whether it holds in the end
+    template <class Pred>
+    bool run_until(Pred pred, std::uint64_t max_cycles) {
+        for (std::uint64_t i = 0; i < max_cycles; i++) {
+            if (pred()) return true;
+            step();
+        }
+        return pred();
+    }
+
     void reset(int n = 10) {
         dut_wrap->rst = 1;
         step(n);
         dut_wrap->rst = 0;
     }
+
+    // Wall-clock speed since construction or the last start_run()
+    void start_run() {
+        run_start = std::chrono::steady_clock::now();
+        run_start_cycle = cycle_count;
+    }
+    RunStats run_stats() const {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run_start;
+        return {cycle_count - run_start_cycle, elapsed.count()};
+    }
+    void print_run_stats(const std::string& name) const {
+        auto stats = run_stats();
+        std::print("{}: {} cycles in {:.3f} s ({:.0f} cycles/s)\n", name, stats.cycles,
+                   stats.seconds, stats.cycles_per_second());
+    }
 };
+
+template <class T>
+class Dut : public DutBase<T, Dut<T>> {};
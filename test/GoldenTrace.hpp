@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: MIT
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Spike commit traces, recorded once per ELF by golden_trace and checked by
+// later RTL runs without Spike in the loop.
+//
+// A trace file is a Header, then fixed-width Records, then an Index. Every
+// retired instruction is an INST record, whose PC is a 16-bit delta from the
+// previous one; a jump farther than that is preceded by a PC record. The
+// stores of an instruction follow it as STORE records of at most 4 bytes.
+// The Index has the record and the delta base of every index_stride-th
+// instruction, so a reader can start anywhere without decoding from the top.
+//
+// Traces are cached as <hash>.gtrace, where <hash> is that of the ELF, in
+// OFFNARISCV_GOLDEN_DIR, by default the golden directory next to the
+// executables.
+namespace golden {
+
+constexpr char MAGIC[8] = {'O', 'F', 'F', 'N', 'G', 'T', 'R', 'C'};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t INDEX_STRIDE = 1024;
+
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t index_stride;
+  std::uint64_t elf_hash;
+  std::uint64_t instructions;
+  std::uint64_t records;
+  std::uint64_t index_entries;
+  std::uint32_t entry_pc;  // Spike's boot ROM is not traced; the trace starts here
+  std::uint32_t tohost;  // Value stored to tohost at the end, 0 if the run timed out
+};
+
+enum Kind : std::uint8_t { INST, PC, STORE };
+
+struct Record {
+  Kind kind;
+  std::uint8_t arg;  // INST: rd, 0 if none is written; STORE: bytes
+  std::int16_t pc_delta;  // INST: from the previous PC
+  std::uint32_t a;  // INST: value written to rd; PC: the new PC; STORE: address
+  std::uint32_t b;  // INST: the instruction; STORE: data
+};
+static_assert(sizeof(Record) == 12);
+
+// 32-bit fields only, so that the Index stays aligned behind the Records
+struct IndexEntry {
+  std::uint32_t record;  // First record of the instruction
+  std::uint32_t prev_pc;  // ... and the base of its PC delta
+};
+static_assert(sizeof(IndexEntry) == 8);
+
+struct Commit {
+  std::uint32_t pc;
+  int rd;
+  std::uint32_t wdata;
+  std::uint32_t inst;
+};
+
+// FNV-1a over the whole file
+inline std::optional<std::uint64_t> hash_file(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return std::nullopt;
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (auto it = std::istreambuf_iterator<char>(file); it != std::istreambuf_iterator<char>();
+       ++it) {
+    hash = (hash ^ static_cast<std::uint8_t>(*it)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+inline std::filesystem::path cache_dir() {
+  if (auto s = std::getenv("OFFNARISCV_GOLDEN_DIR")) return s;
+  return std::filesystem::read_symlink("/proc/self/exe").parent_path() / "golden";
+}
+
+inline std::filesystem::path cache_path(std::uint64_t elf_hash) {
+  return cache_dir() / std::format("{:016x}.gtrace", elf_hash);
+}
+
+class Writer {
+  Header header{};
+  std::vector<Record> records;
+  std::vector<IndexEntry> index;
+  std::uint32_t prev_pc;
+
+ public:
+  Writer(std::uint64_t elf_hash, std::uint32_t entry_pc) : prev_pc(entry_pc) {
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.index_stride = INDEX_STRIDE;
+    header.elf_hash = elf_hash;
+    header.entry_pc = entry_pc;
+  }
+
+  void commit(std::uint32_t pc, int rd, std::uint32_t wdata, std::uint32_t inst) {
+    if (header.instructions % INDEX_STRIDE == 0) index.push_back({static_cast<std::uint32_t>(records.size()), prev_pc});
+    auto delta = static_cast<std::int32_t>(pc - prev_pc);
+    if (delta != static_cast<std::int16_t>(delta)) {
+      records.push_back({PC, 0, 0, pc, 0});
+      delta = 0;
+    }
+    records.push_back({INST, static_cast<std::uint8_t>(rd), static_cast<std::int16_t>(delta),
+                       rd ? wdata : 0, inst});
+    prev_pc = pc;
+    ++header.instructions;
+  }
+
+  void store(std::uint32_t addr, std::uint32_t data, int bytes) {
+    records.push_back({STORE, static_cast<std::uint8_t>(bytes), 0, addr, data});
+  }
+
+  void finish(std::uint32_t tohost) { header.tohost = tohost; }
+
+  std::uint64_t instructions() const { return header.instructions; }
+
+  // Written under a temporary name and renamed, so a reader never maps a
+  // partial file
+  bool save(const std::filesystem::path& path) {
+    header.records = records.size();
+    header.index_entries = index.size();
+    std::filesystem::create_directories(path.parent_path());
+    auto tmp = path;
+    tmp += std::format(".{}.tmp", getpid());
+    {
+      std::ofstream file(tmp, std::ios::binary);
+      if (!file) return false;
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+      file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(IndexEntry));
+      if (!file) return false;
+    }
+    std::filesystem::rename(tmp, path);
+    return true;
+  }
+};
+
+// A memory-mapped trace, read one instruction at a time
+class Reader {
+  void* map = MAP_FAILED;
+  std::size_t size = 0;
+  const Header* header = nullptr;
+  const Record* records = nullptr;
+  const IndexEntry* index = nullptr;
+  std::uint64_t pos = 0;  // Next record
+  std::uint64_t inst = 0;  // Next instruction
+  std::uint32_t prev_pc = 0;
+
+  Reader() = default;
+
+ public:
+  ~Reader() {
+    if (map != MAP_FAILED) munmap(map, size);
+  }
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // nullptr if the file is missing, from another format version or truncated
+  static std::unique_ptr<Reader> open(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    std::unique_ptr<Reader> r(new Reader);
+    if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(Header)) {
+      r->size = st.st_size;
+      r->map = mmap(nullptr, r->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (r->map == MAP_FAILED) return nullptr;
+
+    r->header = static_cast<const Header*>(r->map);
+    auto& h = *r->header;
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION ||
+        r->size != sizeof(Header) + h.records * sizeof(Record) +
+                       h.index_entries * sizeof(IndexEntry)) {
+      return nullptr;
+    }
+    auto base = static_cast<const char*>(r->map);
+    r->records = reinterpret_cast<const Record*>(base + sizeof(Header));
+    r->index = reinterpret_cast<const IndexEntry*>(base + sizeof(Header) +
+                                                   h.records * sizeof(Record));
+    r->prev_pc = h.entry_pc;
+    return r;
+  }
+
+  const Header& info() const { return *header; }
+  std::uint64_t position() const { return inst; }
+  bool done() const { return inst >= header->instructions; }
+
+  // Continue at instruction n
+  void seek(std::uint64_t n) {
+    auto entry = n / header->index_stride;
+    if (entry >= header->index_entries) {
+      inst = header->instructions;
+      return;
+    }
+    pos = index[entry].record;
+    prev_pc = index[entry].prev_pc;
+    inst = entry * header->index_stride;
+    while (inst < n && next()) {
+    }
+  }
+
+  // The next instruction, with its stores if `stores` is given
+  std::optional<Commit> next(std::vector<Record>* stores = nullptr) {
+    if (stores) stores->clear();
+    while (pos < header->records && records[pos].kind == PC) prev_pc = records[pos++].a;
+    if (pos >= header->records) return std::nullopt;
+    const auto& r = records[pos++];
+    Commit c{prev_pc + static_cast<std::uint32_t>(static_cast<std::int32_t>(r.pc_delta)), r.arg,
+             r.a, r.b};
+    prev_pc = c.pc;
+    ++inst;
+    for (; pos < header->records && records[pos].kind == STORE; ++pos) {
+      if (stores) stores->push_back(records[pos]);
+    }
+    return c;
+  }
+};
+
+// Reads of the counters and of the pending interrupts differ between
+// Spike and the RTL; only the PC and rd of those are compared
+inline bool nondeterministic(std::uint32_t inst) {
+  auto csr = inst >> 20;
+  return ((inst & 0x7f) == 0x73) && ((inst >> 12) & 0x7) != 0 &&
+         ((csr >= 0xc00 && csr <= 0xc1f) || (csr >= 0xc80 && csr <= 0xc9f) ||
+          (csr >= 0xb00 && csr <= 0xb1f) || (csr >= 0xb80 && csr <= 0xb9f) || csr == 0x344 ||
+          csr == 0x144);
+}
+
+// Compares the instructions an RTL run retires, in order, against a trace,
+// and the stores it performs
+class Checker {
+  std::unique_ptr<Reader> reader;
+  // The LSU performs a store before the instructions ahead of it have all
+  // retired, so stores are matched on their own, from a second reader
+  std::unique_ptr<Reader> store_reader;
+  std::vector<Record> stores;
+  std::uint64_t store_count = 0;
+  bool started = false;
+
+ public:
+  std::filesystem::path path;
+  std::string mismatch;  // The first one, empty if none
+
+  // nullptr if the ELF has no trace in the cache yet
+  static std::unique_ptr<Checker> open(const std::filesystem::path& elf) {
+    auto hash = hash_file(elf);
+    if (!hash) return nullptr;
+    auto path = cache_path(*hash);
+    auto reader = Reader::open(path);
+    if (!reader || reader->info().elf_hash != *hash) return nullptr;
+    auto checker = std::make_unique<Checker>();
+    checker->reader = std::move(reader);
+    checker->store_reader = Reader::open(path);
+    if (!checker->store_reader) return nullptr;
+    checker->path = path;
+    return checker;
+  }
+
+  std::uint64_t checked() const { return reader->position(); }
+  std::uint64_t instructions() const { return reader->info().instructions; }
+  std::uint64_t stores_checked() const { return store_count; }
+
+  // Returns false on the first mismatch, and stops checking there. The RTL
+  // boots through its own reset code, so checking starts at the entry of the
+  // trace, and what is retired after its end is not checked.
+  bool check(std::uint32_t pc, int rd, std::uint32_t wdata) {
+    if (!started) {
+      if (pc != reader->info().entry_pc) return true;
+      started = true;
+    }
+    if (!mismatch.empty() || reader->done()) return true;
+    auto n = reader->position();
+    auto expected = *reader->next();
+    if (rd == 0) wdata = 0;
+    std::string what;
+    if (pc != expected.pc) {
+      what = std::format("pc: rtl={:#010x}, spike={:#010x}", pc, expected.pc);
+    } else if (rd != expected.rd ||
+               (wdata != expected.wdata && !nondeterministic(expected.inst))) {
+      what = std::format("rtl: x{}={:#010x}, spike: x{}={:#010x}", rd, wdata, expected.rd,
+                         expected.wdata);
+    } else {
+      return true;
+    }
+    mismatch = std::format("instruction {} ({:08x} at {:#010x}): {}", n, expected.inst,
+                           expected.pc, what);
+    return false;
+  }
+
+  // The same for a store, in program order. The RTL reports the physical
+  // address, so only the page offset is compared, and a cbo.zero, which
+  // Spike records as a block of zeros, only by the block it clears.
+  bool check_store(std::uint32_t addr, std::uint32_t data) {
+    if (!started || !mismatch.empty()) return true;
+    std::optional<Commit> expected;
+    while ((expected = store_reader->next(&stores)) && stores.empty()) {
+    }
+    if (!expected) return true;
+    ++store_count;
+    std::uint32_t bytes = 0;
+    for (const auto& r : stores) bytes += r.arg;
+    bool block = stores.size() > 1;
+    if (block) addr &= ~(bytes - 1);
+    auto mask = (bytes >= 4) ? ~std::uint32_t{0} : (std::uint32_t{1} << (8 * bytes)) - 1;
+    if (((addr ^ stores[0].a) & 0xfff) == 0 && (block || ((data ^ stores[0].b) & mask) == 0)) {
+      return true;
+    }
+    mismatch = std::format(
+        "instruction {} ({:08x} at {:#010x}): store: rtl: [{:#010x}]={:#010x}, spike: "
+        "[{:#010x}]={:#010x} ({} bytes)",
+        store_reader->position() - 1, expected->inst, expected->pc, addr, data & mask,
+        stores[0].a, stores[0].b & mask, bytes);
+    return false;
+  }
+};
+
+}  // namespace golden
@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Assembler.hpp"
+
+// Random RV32I+Zicsr program generator for differential testing against
+// Spike. Programs never trap: memory accesses are naturally aligned and stay
+// inside the data region, only implemented CSRs are touched, and all control
+// flow is forward except for counted loops. Every program ends in a `j 0`
+// self-loop at end_pc.
+//
+// Register usage:
+//   x1..x28  general purpose (x28 is also the temporary of auipc+jalr pairs)
+//   x29, x30 base addresses into the data region, never written by the body
+//   x31      loop counter, only written by loop heads and tails
+
+enum class Profile : std::uint8_t {
+  HAZARD,  // Dense RAW dependencies at distance 1..3 on ALU and load results
+  BRANCH,  // Conditional branches, jumps, jalr and counted loops
+  ALIAS,   // Mixed-size loads and stores to a small window from two bases
+};
+
+struct Program {
+  static constexpr std::uint32_t TEXT_BASE = 0x80000000;
+  static constexpr std::uint32_t DATA_BASE = 0x80004000;
+  static constexpr std::uint32_t DATA_SIZE = 256;
+
+  std::vector<std::uint32_t> text;  // Placed at TEXT_BASE
+  std::vector<std::uint8_t> data;   // Placed at DATA_BASE
+  std::size_t body_begin = 0;       // Index of the first instruction after the prologue
+  std::size_t body_end = 0;         // Index of the final self-loop
+
+  std::uint32_t end_pc() const { return TEXT_BASE + 4 * body_end; }
+};
+
+class ProgramGenerator {
+  static constexpr int CSR_MEPC = 0x341;
+  static constexpr int CSR_MCAUSE = 0x342;
+  static constexpr int TEMP = 28;
+  static constexpr int BASE0 = 29;
+  static constexpr int BASE1 = 30;
+  static constexpr int COUNTER = 31;
+  static constexpr std::int32_t BASE1_OFFSET = 8;  // Overlaps BASE0's window
+  static constexpr std::int32_t WINDOW = 32;       // Bytes reachable by ALIAS accesses
+
+  std::mt19937 rng;
+  Profile profile;
+  std::vector<std::uint32_t>* text = nullptr;
+  int recent[3] = {1, 2, 3};  // Most recently written registers
+
+  // Forward control transfers (index, target) and the second halves of
+  // auipc+jalr, address+load and address+CBO pairs, so that no transfer can skip the
+  // instruction that makes the base and land on its user
+  std::vector<std::pair<std::size_t, std::size_t>> forwards;
+  std::vector<std::size_t> second_halves;
+
+  int uniform(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+  bool chance(double p) { return std::bernoulli_distribution(p)(rng); }
+
+  int pick_rd() {
+    int rd = uniform(1, TEMP);
+    recent[2] = recent[1];
+    recent[1] = recent[0];
+    recent[0] = rd;
+    return rd;
+  }
+
+  int pick_rs() {
+    if (profile == Profile::HAZARD && chance(0.8)) return recent[uniform(0, 2)];
+    if (chance(0.05)) return 0;
+    return uniform(1, 31);
+  }
+
+  std::int32_t imm12() {
+    switch (uniform(0, 3)) {
+      case 0:
+        return uniform(-2048, 2047);
+      case 1:
+        return uniform(-4, 4);
+      case 2:
+        return chance(0.5) ? 2047 : -2048;
+      default:
+        return uniform(0, 31);
+    }
+  }
+
+  void emit(std::uint32_t inst) { text->push_back(inst); }
+
+  void emit_alu() {
+    int rd = pick_rd();
+    int rs1 = pick_rs();
+    int rs2 = pick_rs();
+    switch (uniform(0, 20)) {
+      case 0: emit(rv::addi(rd, rs1, imm12())); break;
+      case 1: emit(rv::slti(rd, rs1, imm12())); break;
+      case 2: emit(rv::sltiu(rd, rs1, imm12())); break;
+      case 3: emit(rv::xori(rd, rs1, imm12())); break;
+      case 4: emit(rv::ori(rd, rs1, imm12())); break;
+      case 5: emit(rv::andi(rd, rs1, imm12())); break;
+      case 6: emit(rv::slli(rd, rs1, uniform(0, 31))); break;
+      case 7: emit(rv::srli(rd, rs1, uniform(0, 31))); break;
+      case 8: emit(rv::srai(rd, rs1, uniform(0, 31))); break;
+      case 9: emit(rv::add(rd, rs1, rs2)); break;
+      case 10: emit(rv::sub(rd, rs1, rs2)); break;
+      case 11: emit(rv::sll(rd, rs1, rs2)); break;
+      case 12: emit(rv::slt(rd, rs1, rs2)); break;
+      case 13: emit(rv::sltu(rd, rs1, rs2)); break;
+      case 14: emit(rv::xor_(rd, rs1, rs2)); break;
+      case 15: emit(rv::srl(rd, rs1, rs2)); break;
+      case 16: emit(rv::sra(rd, rs1, rs2)); break;
+      case 17: emit(rv::or_(rd, rs1, rs2)); break;
+      case 18: emit(rv::and_(rd, rs1, rs2)); break;
+      case 19: emit(rv::lui(rd, static_cast<std::uint32_t>(rng()))); break;
+      default: emit(rv::auipc(rd, static_cast<std::uint32_t>(rng()))); break;
+    }
+  }
+
+  void emit_mem() {
+    int base = chance(0.5) ? BASE0 : BASE1;
+    int size = 1 << uniform(0, 2);
+    std::int32_t span = profile == Profile::ALIAS ? WINDOW : Program::DATA_SIZE - BASE1_OFFSET;
+    std::int32_t offset = uniform(0, span / size - 1) * size;
+    if (base == BASE1) offset -= offset >= BASE1_OFFSET ? BASE1_OFFSET : 0;
+    if (chance(profile == Profile::ALIAS ? 0.5 : 0.4)) {
+      int rs2 = pick_rs();
+      switch (size) {
+        case 1: emit(rv::sb(rs2, base, offset)); break;
+        case 2: emit(rv::sh(rs2, base, offset)); break;
+        default: emit(rv::sw(rs2, base, offset)); break;
+      }
+    } else {
+      int rd = pick_rd();
+      bool is_unsigned = chance(0.5);
+      switch (size) {
+        case 1: emit(is_unsigned ? rv::lbu(rd, base, offset) : rv::lb(rd, base, offset)); break;
+        case 2: emit(is_unsigned ? rv::lhu(rd, base, offset) : rv::lh(rd, base, offset)); break;
+        default: emit(rv::lw(rd, base, offset)); break;
+      }
+    }
+  }
+
+  // Pairs the decoder fuses: the second instruction reads and rewrites the
+  // rd of the first
+  void emit_fusible() {
+    int rd = pick_rd();
+    int size = 1 << uniform(0, 2);
+    std::uint32_t addr = Program::DATA_BASE + uniform(0, Program::DATA_SIZE / size - 1) * size;
+    bool pc_relative = false;
+    switch (uniform(0, 3)) {
+      case 0:
+        rv::li(*text, rd, static_cast<std::uint32_t>(rng()));
+        return;
+      case 1: {  // Zero-extension of the low 32 - k bits
+        int k = uniform(0, 31);
+        emit(rv::slli(rd, pick_rs(), k));
+        emit(rv::srli(rd, rd, k));
+        return;
+      }
+      case 2:
+        pc_relative = true;
+        addr -= Program::TEXT_BASE + 4 * static_cast<std::uint32_t>(text->size());
+        break;
+      default:
+        break;
+    }
+    // lui/auipc rd, %hi(addr); l* rd, %lo(addr)(rd)
+    auto lo = static_cast<std::int32_t>(addr << 20) >> 20;
+    emit(pc_relative ? rv::auipc(rd, addr - lo) : rv::lui(rd, addr - lo));
+    second_halves.push_back(text->size());
+    bool is_unsigned = chance(0.5);
+    switch (size) {
+      case 1: emit(is_unsigned ? rv::lbu(rd, rd, lo) : rv::lb(rd, rd, lo)); break;
+      case 2: emit(is_unsigned ? rv::lhu(rd, rd, lo) : rv::lh(rd, rd, lo)); break;
+      default: emit(rv::lw(rd, rd, lo)); break;
+    }
+  }
+
+  // A cache-block operation on one of the data region's blocks, through a
+  // scratch address register
+  void emit_cbo() {
+    static constexpr std::uint32_t BLOCK = 32;  // The L1D line
+    int rd = pick_rd();
+    emit(rv::addi(rd, BASE0, uniform(0, Program::DATA_SIZE / BLOCK - 1) * BLOCK));
+    second_halves.push_back(text->size());
+    switch (uniform(0, 3)) {
+      case 0: emit(rv::cbo_clean(rd)); break;
+      case 1: emit(rv::cbo_flush(rd)); break;
+      case 2: emit(rv::cbo_inval(rd)); break;
+      default: emit(rv::cbo_zero(rd)); break;
+    }
+  }
+
+  void emit_csr() {
+    int csr = chance(0.5) ? CSR_MEPC : CSR_MCAUSE;
+    int rd = pick_rd();
+    switch (uniform(0, 5)) {
+      case 0: emit(rv::csrrw(rd, csr, pick_rs())); break;
+      case 1: emit(rv::csrrs(rd, csr, pick_rs())); break;
+      case 2: emit(rv::csrrc(rd, csr, pick_rs())); break;
+      case 3: emit(rv::csrrwi(rd, csr, uniform(0, 31))); break;
+      case 4: emit(rv::csrrsi(rd, csr, uniform(0, 31))); break;
+      default: emit(rv::csrrci(rd, csr, uniform(0, 31))); break;
+    }
+  }
+
+  // Forward control transfer skipping up to `room` instructions
+  void emit_forward(int room) {
+    int skip = uniform(0, std::min(room, 6));
+    std::int32_t offset = 4 * (skip + 1);
+    forwards.emplace_back(text->size(), text->size() + skip + 1);
+    switch (uniform(0, 7)) {
+      case 0: emit(rv::beq(pick_rs(), pick_rs(), offset)); break;
+      case 1: emit(rv::bne(pick_rs(), pick_rs(), offset)); break;
+      case 2: emit(rv::blt(pick_rs(), pick_rs(), offset)); break;
+      case 3: emit(rv::bge(pick_rs(), pick_rs(), offset)); break;
+      case 4: emit(rv::bltu(pick_rs(), pick_rs(), offset)); break;
+      case 5: emit(rv::bgeu(pick_rs(), pick_rs(), offset)); break;
+      case 6: emit(rv::jal(pick_rd(), offset)); break;
+      default:
+        if (room < 1) {
+          emit(rv::jal(pick_rd(), offset));
+          break;
+        }
+        // auipc TEMP, 0; jalr rd, offset(TEMP), skipping `skip` instructions after the jalr
+        skip = std::min(skip, room - 1);
+        forwards.back() = {text->size() + 1, text->size() + skip + 2};
+        second_halves.push_back(text->size() + 1);
+        emit(rv::auipc(TEMP, 0));
+        emit(rv::jalr(chance(0.3) ? TEMP : pick_rd(), TEMP, 4 * (skip + 2)));  // Fused if TEMP
+        recent[0] = TEMP;
+        break;
+    }
+  }
+
+  // Move any target that is the second half of a pair back onto the first
+  void retarget(std::vector<std::uint32_t>& t) {
+    for (auto [at, target] : forwards) {
+      if (!std::ranges::binary_search(second_halves, target)) continue;
+      auto inst = t[at];
+      auto offset = 4 * static_cast<std::int32_t>(target - 1 - at);
+      int rd = (inst >> 7) & 0x1f;
+      int rs1 = (inst >> 15) & 0x1f;
+      int rs2 = (inst >> 20) & 0x1f;
+      switch (inst & 0x7f) {
+        case rv::BRANCH:
+          t[at] = rv::b_type((inst >> 12) & 0x7, rs1, rs2, offset);
+          break;
+        case rv::JAL:
+          t[at] = rv::jal(rd, offset);
+          break;
+        default:  // jalr, relative to its auipc
+          t[at] = rv::jalr(rd, rs1, offset + 4);
+          break;
+      }
+    }
+  }
+
+  // Straight-line instruction mix of `n` slots; control transfers never leave it
+  void emit_block(int n, bool allow_loops) {
+    auto end = text->size() + n;
+    while (text->size() < end) {
+      int room = static_cast<int>(end - text->size()) - 1;
+      int r = uniform(0, 99);
+      int branch_pct = profile == Profile::BRANCH ? 35 : 8;
+      int mem_pct = profile == Profile::ALIAS ? 55 : 20;
+      if (allow_loops && profile == Profile::BRANCH && r < 5 && room >= 6) {
+        // addi COUNTER, x0, n; body; addi COUNTER, COUNTER, -1; blt x0, COUNTER, body
+        // A forward branch may land inside the body with COUNTER == 0, so
+        // the loop must also terminate when entered that way
+        int body = uniform(1, std::min(room - 3, 8));
+        emit(rv::addi(COUNTER, 0, uniform(1, 4)));
+        auto head = text->size();
+        emit_block(body, false);
+        emit(rv::addi(COUNTER, COUNTER, -1));
+        emit(rv::blt(0, COUNTER, -4 * static_cast<std::int32_t>(text->size() - head)));
+      } else if (r < branch_pct && room >= 0) {
+        emit_forward(room);
+      } else if (r < branch_pct + mem_pct) {
+        emit_mem();
+      } else if (r < branch_pct + mem_pct + 2) {
+        emit_csr();
+      } else if (r < branch_pct + mem_pct + 3) {
+        emit(chance(0.5) ? rv::fence() : rv::fence_i());
+      } else if (r < branch_pct + mem_pct + 8 && room >= 1) {
+        emit_fusible();
+      } else if (r < branch_pct + mem_pct + 9 && room >= 1) {
+        emit_cbo();
+      } else {
+        emit_alu();
+      }
+    }
+  }
+
+ public:
+  explicit ProgramGenerator(std::uint32_t seed) : rng(seed) {}
+
+  Program generate(Profile p, int length) {
+    profile = p;
+    Program prog;
+    text = &prog.text;
+
+    // Prologue: known state for every architectural register the body can read
+    for (int r = 1; r <= TEMP; ++r) {
+      rv::li(prog.text, r, chance(0.2) ? uniform(-8, 8) : static_cast<std::uint32_t>(rng()));
+    }
+    rv::li(prog.text, BASE0, Program::DATA_BASE);
+    rv::li(prog.text, BASE1, Program::DATA_BASE + BASE1_OFFSET);
+    emit(rv::addi(COUNTER, 0, 0));
+    emit(rv::csrrw(0, CSR_MEPC, 0));
+    emit(rv::csrrw(0, CSR_MCAUSE, 0));
+    prog.body_begin = prog.text.size();
+
+    forwards.clear();
+    second_halves.clear();
+    emit_block(length, true);
+    prog.body_end = prog.text.size();
+    emit(rv::j(0));
+    retarget(prog.text);
+
+    prog.data.resize(Program::DATA_SIZE);
+    for (auto& b : prog.data) b = static_cast<std::uint8_t>(rng());
+    text = nullptr;
+    return prog;
+  }
+};
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: MIT
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Triggered, windowed VCD capture around a Dut<T> or another DutBase<T, ...>.
+// Tracing is off until a trigger fires, and then a bounded window of `window`
+// cycles is written, so a failure at cycle 50M costs a 50M-cycle run without
+// tracing plus the window, not a 50M-cycle dump.
+//
+// With `history` > 0 the cycles before the trigger are kept too: the dump
+// goes to memory in segments of `history` cycles, each starting with a full
+// dump of all signals, and only the last two segments are retained. On the
+// trigger they are written out behind the VCD header, so the file starts
+// between `history` and 2 * `history` cycles before the trigger. A cycle
+// trigger is known in advance, so capture only starts `history` cycles
+// before it; the other triggers need the rolling buffer from the start.
+//
+// Triggers: a cycle number, any condition registered with trigger_when (a
+// PC, an instruction id, ...), an explicit trigger() call (a cosim
+// mismatch), a Verilator error such as an SV assertion, and a Catch2
+// REQUIRE failing while the controller is alive. Only the first one counts.
+//
+// Call sample() after every eval(), from the on_negedge()/on_posedge() hooks
+// of a DutBase, or use step() in place of Dut::step().
+// The model must be verilated with TRACE.
+template <class T>
+class TraceController {
+ public:
+  static constexpr std::uint64_t NEVER = ~std::uint64_t{0};
+
+  struct Config {
+    std::string path;
+    std::uint64_t history = 1000;   // Cycles kept before the trigger
+    std::uint64_t window = 1000;    // Cycles written after the trigger
+    std::uint64_t cycle = NEVER;    // Trigger at this cycle
+    bool on_error = true;           // Trigger on Verilator errors (SV assertions)
+    int depth = 99;                 // Hierarchy levels passed to trace()
+  };
+
+  // OFFNARISCV_TRACE_{HISTORY,WINDOW,CYCLE} override the defaults
+  static Config config_from_env(const std::string& path) {
+    auto env_or = [](const char* name, std::uint64_t value) {
+      auto s = std::getenv(name);
+      return s ? std::strtoull(s, nullptr, 0) : value;
+    };
+    Config config{path};
+    config.history = env_or("OFFNARISCV_TRACE_HISTORY", config.history);
+    config.window = env_or("OFFNARISCV_TRACE_WINDOW", config.window);
+    config.cycle = env_or("OFFNARISCV_TRACE_CYCLE", config.cycle);
+    return config;
+  }
+
+  // Must be constructed before the first eval() of the model
+  template <class D>
+  TraceController(D& dut, Config config)
+      : model(dut.operator->()), config(std::move(config)), buffer(*this), vcd(&buffer) {
+    Verilated::traceEverOn(true);
+    if (this->config.on_error) Verilated::fatalOnError(false);
+    model->trace(&vcd, this->config.depth);
+    if (this->config.history == 0) {
+      start = NEVER;
+    } else if (this->config.cycle != NEVER) {
+      start = this->config.cycle - std::min(this->config.cycle, this->config.history);
+    } else {
+      start = 0;
+    }
+  }
+
+  ~TraceController() {
+    // A failing REQUIRE unwinds through here; keep what led up to it
+    if (std::uncaught_exceptions() > 0 && state == CAPTURING) fire("test failure");
+    if (vcd.isOpen()) vcd.close();
+  }
+
+  TraceController(const TraceController&) = delete;
+  TraceController& operator=(const TraceController&) = delete;
+
+  // Fire when `condition` holds at a sample
+  void trigger_when(std::string reason, std::function<bool()> condition) {
+    conditions.emplace_back(std::move(reason), std::move(condition));
+  }
+
+  // Fire now, e.g. on a cosim mismatch found by the harness
+  void trigger(const std::string& reason) {
+    if (state == IDLE || state == CAPTURING) fire(reason);
+  }
+
+  bool triggered() const { return state == WRITING || state == DONE; }
+  std::uint64_t cycle() const { return time / 2; }
+
+  void sample() {
+    if (state == DONE) return;
+    auto now = cycle();
+    if (state == IDLE && now >= start) begin_capture();
+    if (state == IDLE || state == CAPTURING) {
+      if (now == config.cycle) {
+        fire(std::format("cycle {}", now));
+      } else if (config.on_error && Verilated::gotError()) {
+        fire("Verilator error");
+      } else {
+        for (const auto& [reason, condition] : conditions) {
+          if (condition()) {
+            fire(reason);
+            break;
+          }
+        }
+      }
+    }
+    if (vcd.isOpen()) vcd.dump(time);
+    ++time;
+
+    if (state == CAPTURING && (time % 2 == 0) && now + 1 - segment_start >= config.history) {
+      vcd.openNext(false);  // The next segment starts with a full dump
+      segment_start = now + 1;
+    }
+    if (state == WRITING && (time % 2 == 0) && now + 1 - fired_at >= config.window) {
+      vcd.close();
+      state = DONE;
+      std::print("Trace: wrote cycles up to {} to {}\n", now, config.path);
+      if (error) throw std::runtime_error(std::format("Verilator error at cycle {}", fired_at));
+    }
+  }
+
+  void step(int n = 1) {
+    for (int i = 0; i < n; i++) {
+      model->clk = 0;
+      model->eval();
+      sample();
+      model->clk = 1;
+      model->eval();
+      sample();
+    }
+  }
+
+ private:
+  enum State { IDLE, CAPTURING, WRITING, DONE };
+
+  // Takes what VerilatedVcdC writes: kept in memory, segment by segment,
+  // until the trigger, then appended to the file
+  class Buffer : public VerilatedVcdFile {
+    TraceController& owner;
+
+   public:
+    std::string header;
+    std::deque<std::string> segments;
+    std::ofstream file;
+
+    explicit Buffer(TraceController& owner) : owner(owner) {}
+
+    bool open(const std::string&) override {
+      if (owner.state == CAPTURING) {
+        segments.emplace_back();
+        while (segments.size() > 2) segments.pop_front();
+      }
+      return true;
+    }
+    void close() override {}
+    ssize_t write(const char* bufp, ssize_t len) override {
+      if (owner.state == CAPTURING) {
+        segments.back().append(bufp, len);
+      } else {
+        file.write(bufp, len);
+      }
+      return len;
+    }
+  };
+
+  T* model;
+  Config config;
+  Buffer buffer;
+  VerilatedVcdC vcd;
+  std::vector<std::pair<std::string, std::function<bool()>>> conditions;
+  State state = IDLE;
+  std::uint64_t time = 0;  // Half cycles
+  std::uint64_t start;
+  std::uint64_t segment_start = 0;
+  std::uint64_t fired_at = 0;
+  bool error = false;
+
+  void open_file() {
+    buffer.file.open(config.path, std::ios::binary);
+    if (!buffer.file) std::print(stderr, "Trace: cannot open {}\n", config.path);
+  }
+
+  void begin_capture() {
+    state = CAPTURING;
+    segment_start = cycle();
+    vcd.open(config.path.c_str());
+    vcd.flush();  // The header is written by open() alone; keep it apart
+    buffer.header = std::move(buffer.segments.back());
+    buffer.segments.back().clear();
+  }
+
+  void fire(const std::string& reason) {
+    fired_at = cycle();
+    error = reason == "Verilator error";
+    std::print("Trace: triggered by {} at cycle {}\n", reason, fired_at);
+    if (state == CAPTURING) {
+      vcd.flush();
+      state = WRITING;
+      open_file();
+      buffer.file << buffer.header;
+      for (const auto& s : buffer.segments) buffer.file << s;
+      buffer.segments.clear();
+    } else {
+      state = WRITING;
+      open_file();
+      vcd.open(config.path.c_str());  // Header and a full dump go straight to the file
+    }
+  }
+};
@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: MIT
+
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Functional model of the L1 caches built from cache_directory and
+// cache_memory. The line state mirrors cache_pkg::line_state_t, misses are
+// filled as ifu.sv and lsu.sv do, and dirty victims are written back as lsu.sv
+// does. Data is not modeled; only the directory is.
+
+enum class Replacement : std::uint8_t { LRU, FIFO, RANDOM };
+
+struct CacheConfig {
+  std::uint32_t size = 4096;        // Bytes
+  std::uint32_t ways = 1;           // 1 means direct-mapped, as in the RTL
+  std::uint32_t block_size = 32;    // Bytes (BLOCK_SIZE / 8 in the RTL)
+  Replacement replacement = Replacement::LRU;
+  bool write_allocate = true;       // lsu.sv allocates on store misses
+
+  std::uint32_t sets() const { return size / (ways * block_size); }
+  bool valid() const {
+    return std::has_single_bit(size) && std::has_single_bit(ways) &&
+           std::has_single_bit(block_size) && block_size >= 4 &&
+           size >= ways * block_size;
+  }
+};
+
+struct LineState {
+  bool v = false;  // Valid bit
+  bool d = false;  // Dirty bit
+  bool u = false;  // Unique bit
+
+  std::uint8_t pack() const { return (v << 2) | (d << 1) | u; }  // {v, d, u}
+  static LineState unpack(std::uint8_t bits) {
+    return {(bits & 4) != 0, (bits & 2) != 0, (bits & 1) != 0};
+  }
+};
+
+struct CacheStats {
+  std::uint64_t reads = 0;
+  std::uint64_t writes = 0;
+  std::uint64_t read_misses = 0;
+  std::uint64_t write_misses = 0;
+  std::uint64_t fills = 0;       // Lines read from lower level memory (AR/R)
+  std::uint64_t writebacks = 0;  // Dirty lines written back (AW/W/B)
+
+  std::uint64_t accesses() const { return reads + writes; }
+  std::uint64_t misses() const { return read_misses + write_misses; }
+  double miss_rate() const {
+    return accesses() ? static_cast<double>(misses()) / accesses() : 0.0;
+  }
+};
+
+enum class AccessResult : std::uint8_t { HIT, MISS, MISS_WRITEBACK };
+
+class CacheModel {
+  CacheConfig cfg;
+  std::uint32_t offset_bits;
+  std::uint32_t index_bits;
+  std::uint32_t index_mask;
+  std::vector<std::uint32_t> tags;    // [set * ways + way]
+  std::vector<LineState> states;      // [set * ways + way]
+  std::vector<std::uint32_t> stamps;  // LRU: last use, FIFO: fill time
+  std::uint32_t clock = 0;
+  std::uint32_t rng = 0x12345678;
+  CacheStats st;
+
+  std::uint32_t victim(std::uint32_t base) {
+    for (std::uint32_t w = 0; w < cfg.ways; ++w) {
+      if (!states[base + w].v) return w;  // Prefer an invalid way
+    }
+    if (cfg.replacement == Replacement::RANDOM) {
+      rng ^= rng << 13;  // xorshift32
+      rng ^= rng >> 17;
+      rng ^= rng << 5;
+      return rng & (cfg.ways - 1);
+    }
+    std::uint32_t oldest = 0;
+    for (std::uint32_t w = 1; w < cfg.ways; ++w) {
+      if (stamps[base + w] < stamps[base + oldest]) oldest = w;
+    }
+    return oldest;
+  }
+
+ public:
+  explicit CacheModel(const CacheConfig& config)
+      : cfg(config),
+        offset_bits(std::countr_zero(config.block_size)),
+        index_bits(std::countr_zero(config.sets())),
+        index_mask(config.sets() - 1),
+        tags(config.sets() * config.ways, 0),
+        states(config.sets() * config.ways),
+        stamps(config.sets() * config.ways, 0) {}
+
+  const CacheConfig& config() const { return cfg; }
+  const CacheStats& stats() const { return st; }
+
+  std::uint32_t index_of(std::uint32_t addr) const {
+    return (addr >> offset_bits) & index_mask;
+  }
+  std::uint32_t tag_of(std::uint32_t addr) const {
+    return static_cast<std::uint32_t>(
+        static_cast<std::uint64_t>(addr) >> (offset_bits + index_bits));
+  }
+
+  // Directory entry of a way, as cache_dir_if.current_tag/current_state
+  // would show it
+  std::uint32_t tag(std::uint32_t index, std::uint32_t way = 0) const {
+    return tags[index * cfg.ways + way];
+  }
+  LineState state(std::uint32_t index, std::uint32_t way = 0) const {
+    return states[index * cfg.ways + way];
+  }
+
+  AccessResult access(std::uint32_t addr, bool write) {
+    auto index = index_of(addr);
+    auto t = tag_of(addr);
+    auto base = index * cfg.ways;
+    ++clock;
+    (write ? st.writes : st.reads)++;
+
+    for (std::uint32_t w = 0; w < cfg.ways; ++w) {
+      auto& s = states[base + w];
+      if (s.v && tags[base + w] == t) {  // Hit
+        if (write) s.d = true;
+        if (cfg.replacement == Replacement::LRU) stamps[base + w] = clock;
+        return AccessResult::HIT;
+      }
+    }
+
+    // Miss
+    (write ? st.write_misses : st.read_misses)++;
+    if (write && !cfg.write_allocate) return AccessResult::MISS;
+    auto w = victim(base);
+    auto& s = states[base + w];
+    auto result = AccessResult::MISS;
+    if (s.v && s.d) {  // Write back
+      ++st.writebacks;
+      result = AccessResult::MISS_WRITEBACK;
+    }
+    ++st.fills;
+    tags[base + w] = t;
+    s = {.v = true, .d = write, .u = false};
+    stamps[base + w] = clock;
+    return result;
+  }
+
+  // Clear every valid bit, as cache_directory does on `flush`
+  void flush() {
+    for (auto& s : states) s.v = false;
+  }
+};
+
+// Memory access trace. Instruction fetches and data accesses are kept in one
+// stream so that a unified configuration can be evaluated as well.
+struct TraceRecord {
+  enum Kind : std::uint8_t { FETCH, LOAD, STORE };
+  std::uint32_t addr;
+  Kind kind;
+};
+
+using Trace = std::vector<TraceRecord>;
+
+// Parse a Spike commit log (--log-commits) or the lines printed by cosim.cpp.
+// Each line starts with the PC, optionally preceded by "core   0: 3", and
+// carries "mem <addr>" for loads and "mem <addr> <data>" for stores.
+inline bool parse_commit_log(const std::string& path, Trace& trace) {
+  std::ifstream ifs(path);
+  if (!ifs.is_open()) return false;
+
+  auto parse_hex = [](std::string_view tok, std::uint32_t& value) {
+    if (!tok.starts_with("0x")) return false;
+    tok.remove_prefix(2);
+    std::uint64_t v;  // Spike prints 64-bit values for sign-extended PCs
+    auto [ptr, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), v, 16);
+    if (ec != std::errc() || ptr == tok.data()) return false;
+    value = static_cast<std::uint32_t>(v);
+    return true;
+  };
+
+  std::string line;
+  std::vector<std::string_view> toks;
+  while (std::getline(ifs, line)) {
+    toks.clear();
+    std::string_view sv(line);
+    while (!sv.empty()) {
+      auto b = sv.find_first_not_of(" \t");
+      if (b == std::string_view::npos) break;
+      sv.remove_prefix(b);
+      auto e = sv.find_first_of(" \t");
+      toks.push_back(sv.substr(0, e));
+      sv.remove_prefix(e == std::string_view::npos ? sv.size() : e);
+    }
+
+    std::size_t i = 0;
+    if (i < toks.size() && toks[i] == "core") i += 3;  // "core", "0:", priv
+    std::uint32_t pc;
+    if (i >= toks.size() || !parse_hex(toks[i], pc)) continue;
+    trace.push_back({pc, TraceRecord::FETCH});
+    for (++i; i < toks.size(); ++i) {
+      if (toks[i] != "mem") continue;
+      std::uint32_t addr, data;
+      if (i + 1 >= toks.size() || !parse_hex(toks[i + 1], addr)) continue;
+      bool store = (i + 2 < toks.size()) && parse_hex(toks[i + 2], data);
+      trace.push_back({addr, store ? TraceRecord::STORE : TraceRecord::LOAD});
+      i += store ? 2 : 1;
+    }
+  }
+  return true;
+}
+
+// Compact binary form: one little-endian word per record, with the kind in
+// the two least significant bits (accesses are at least 4-byte granular for
+// the caches modeled here, so the bits are free).
+inline bool save_trace(const std::string& path, const Trace& trace) {
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs.is_open()) return false;
+  std::vector<std::uint32_t> words;
+  words.reserve(trace.size());
+  for (const auto& r : trace) words.push_back((r.addr & ~3u) | r.kind);
+  ofs.write(reinterpret_cast<const char*>(words.data()),
+            words.size() * sizeof(std::uint32_t));
+  return ofs.good();
+}
+
+inline bool load_trace(const std::string& path, Trace& trace) {
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs.is_open()) return false;
+  std::vector<std::uint32_t> words(ifs.tellg() / sizeof(std::uint32_t));
+  ifs.seekg(0);
+  ifs.read(reinterpret_cast<char*>(words.data()),
+           words.size() * sizeof(std::uint32_t));
+  trace.reserve(trace.size() + words.size());
+  for (auto w : words) {
+    trace.push_back({w & ~3u, static_cast<TraceRecord::Kind>(w & 3)});
+  }
+  return ifs.good();
+}
+
+// Replay a trace through split L1 I/D caches, as offnariscv_core instantiates
+// them
+inline void replay(const Trace& trace, CacheModel& l1i, CacheModel& l1d) {
+  for (const auto& r : trace) {
+    if (r.kind == TraceRecord::FETCH) {
+      l1i.access(r.addr, false);
+    } else {
+      l1d.access(r.addr, r.kind == TraceRecord::STORE);
+    }
+  }
+}
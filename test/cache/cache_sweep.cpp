@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+
+// Design-space sweep over L1 cache geometries using CacheModel.
+//
+// Usage: cache_sweep <trace> [<trace>...]
+//   A trace is either a Spike commit log (--log-commits, or the output of
+//   cosim.cpp) or a binary trace written by save_trace (*.bin). A parsed text
+//   trace is saved next to the input as <trace>.bin for faster reuse.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CacheModel.hpp"
+
+struct SweepPoint {
+  CacheConfig l1i;
+  CacheConfig l1d;
+  CacheStats l1i_stats;
+  CacheStats l1d_stats;
+};
+
+static const char* replacement_name(Replacement r) {
+  switch (r) {
+    case Replacement::LRU:
+      return "lru";
+    case Replacement::FIFO:
+      return "fifo";
+    case Replacement::RANDOM:
+      return "random";
+  }
+  return "?";
+}
+
+static std::vector<SweepPoint> make_points() {
+  std::vector<SweepPoint> points;
+  for (std::uint32_t size : {1024u, 2048u, 4096u, 8192u, 16384u, 32768u}) {
+    for (std::uint32_t ways : {1u, 2u, 4u, 8u}) {
+      for (std::uint32_t block_size : {16u, 32u, 64u}) {
+        for (auto repl : {Replacement::LRU, Replacement::FIFO, Replacement::RANDOM}) {
+          if (ways == 1 && repl != Replacement::LRU) continue;  // Same result
+          CacheConfig cfg{.size = size, .ways = ways, .block_size = block_size, .replacement = repl};
+          if (!cfg.valid()) continue;
+          points.push_back({.l1i = cfg, .l1d = cfg});
+        }
+      }
+    }
+  }
+  return points;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::print(stderr, "Usage: {} <trace> [<trace>...]\n", argv[0]);
+    return 1;
+  }
+
+  Trace trace;
+  for (int i = 1; i < argc; ++i) {
+    std::string path = argv[i];
+    bool ok;
+    if (path.ends_with(".bin")) {
+      ok = load_trace(path, trace);
+    } else {
+      Trace t;
+      ok = parse_commit_log(path, t);
+      if (ok) {
+        save_trace(path + ".bin", t);
+        trace.insert(trace.end(), t.begin(), t.end());
+      }
+    }
+    if (!ok) {
+      std::print(stderr, "Failed to read {}\n", path);
+      return 1;
+    }
+  }
+  std::print("{} records\n", trace.size());
+
+  auto points = make_points();
+  std::atomic<std::size_t> next{0};
+  auto n_threads = std::max(1u, std::thread::hardware_concurrency());
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> workers;
+    for (unsigned t = 0; t < n_threads; ++t) {
+      workers.emplace_back([&] {
+        for (auto i = next++; i < points.size(); i = next++) {
+          CacheModel l1i(points[i].l1i);
+          CacheModel l1d(points[i].l1d);
+          replay(trace, l1i, l1d);
+          points[i].l1i_stats = l1i.stats();
+          points[i].l1d_stats = l1d.stats();
+        }
+      });
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::print("{} configurations on {} threads in {:.3f} s ({:.1f} M accesses/s)\n",
+             points.size(), n_threads, elapsed.count(),
+             points.size() * trace.size() / elapsed.count() / 1e6);
+
+  std::ranges::sort(points, [](const SweepPoint& a, const SweepPoint& b) {
+    return a.l1i_stats.misses() + a.l1d_stats.misses() <
+           b.l1i_stats.misses() + b.l1d_stats.misses();
+  });
+  std::print("{:>6} {:>4} {:>5} {:>6} | {:>10} {:>8} | {:>10} {:>8} {:>10}\n", "size", "ways",
+             "block", "repl", "l1i_miss", "l1i_%", "l1d_miss", "l1d_%", "l1d_wb");
+  for (const auto& p : points) {
+    std::print("{:>6} {:>4} {:>5} {:>6} | {:>10} {:>8.3f} | {:>10} {:>8.3f} {:>10}\n", p.l1i.size,
+               p.l1i.ways, p.l1i.block_size, replacement_name(p.l1i.replacement),
+               p.l1i_stats.misses(), 100.0 * p.l1i_stats.miss_rate(), p.l1d_stats.misses(),
+               100.0 * p.l1d_stats.miss_rate(), p.l1d_stats.writebacks);
+  }
+  return 0;
+}
@@ -2,22 +2,236 @@
 
 #include <verilated.h>
 
+#include <array>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
 #include <print>
+#include <random>
 
+#include "CacheModel.hpp"
 #include "Dut.hpp"
 #include "Vcache.h"
+#include "Vcache_sync.h"
+
+// Geometry of cache_wrap: INDEX_WIDTH = 7, TAG_WIDTH = 20, 32-byte blocks
+constexpr CacheConfig L1_CONFIG{.size = 4096, .ways = 1, .block_size = 32};
+
+// The memory side of cache_wrap: 8-byte blocks, one per directory entry
+using MemoryModel = std::array<std::uint64_t, 128>;
+
+template <class T>
+static void init_dut(Dut<T>& dut) {
+  dut->if0_index = 0;
+  dut->if0_next_index = 0;
+  dut->if0_next_tag = 0;
+  dut->if0_next_state = 0;
+  dut->if0_write = 0;
+  dut->if1_index = 0;
+  dut->if1_next_index = 0;
+  dut->if1_next_tag = 0;
+  dut->if1_next_state = 0;
+  dut->if1_write = 0;
+  dut->mem0_wdata = 0;
+  dut->mem0_wstrb = 0;
+  dut->mem1_wdata = 0;
+  dut->mem1_wstrb = 0;
 
-static void init_dut(Dut<Vcache>& dut) {
-  // TODO
   dut.reset();
 }
 
-TEST_CASE("cache_implement_me") {
-  Dut<Vcache> dut;
+// Point port 0 at index. With SYNC_READ the arrays read next_index at the
+// clock edge, so the lookup takes a cycle, as the COMPARE of lsu.sv does
+template <class T>
+static void lookup(Dut<T>& dut, std::uint32_t index, bool sync) {
+  dut->if0_next_index = index;
+  if (sync) dut.step();
+  dut->if0_index = index;
+  dut->eval();
+}
+
+static std::uint64_t merge(std::uint64_t old, std::uint64_t data, std::uint8_t strb) {
+  for (int i = 0; i < 8; ++i) {
+    if (strb & (1 << i)) {
+      old = (old & ~(0xffull << (8 * i))) | (data & (0xffull << (8 * i)));
+    }
+  }
+  return old;
+}
+
+// Drive the directory the way lsu.sv does for one access: look up in COMPARE,
+// set the dirty bit on a store hit, and install the new line after a miss.
+// The memory takes the whole refill on a miss and the stored bytes on a hit,
+// in the same cycle as the directory write.
+template <class T>
+static AccessResult rtl_access(Dut<T>& dut, const CacheModel& model, MemoryModel& memory,
+                               std::uint32_t addr, bool write, std::uint64_t wdata,
+                               std::uint8_t wstrb, bool sync) {
+  auto index = model.index_of(addr);
+  auto tag = model.tag_of(addr);
+  dut->if0_write = 0;
+  lookup(dut, index, sync);
+  auto state = LineState::unpack(dut->if0_current_state);
+  bool hit = state.v && (dut->if0_current_tag == tag);
+  auto result = hit ? AccessResult::HIT
+                    : ((state.v && state.d) ? AccessResult::MISS_WRITEBACK : AccessResult::MISS);
+  if (!hit || write) {
+    dut->if0_next_tag = tag;
+    dut->if0_next_state = LineState{.v = true, .d = write || (hit && state.d)}.pack();
+    dut->if0_write = 1;
+    if (!hit) wstrb = 0xff;
+    dut->mem0_wdata = wdata;
+    dut->mem0_wstrb = wstrb;
+    memory[index] = merge(memory[index], wdata, wstrb);
+    dut.step();  // next_index stays at index, so the write is forwarded
+    dut->if0_write = 0;
+    dut->mem0_wstrb = 0;
+  }
+  return result;
+}
+
+// Replay a random trace on both the models and the RTL, with port 1 reading
+// another line in every cycle, as the snoop responder does
+template <class T>
+static void cross_check(bool sync) {
+  Dut<T> dut;
   init_dut(dut);
+  CacheModel model(L1_CONFIG);
+  MemoryModel memory{};
+
+  std::mt19937 rng(1);
+  // A few hot regions so that hits, conflicts and write backs all occur
+  std::uniform_int_distribution<std::uint32_t> region(0, 3);
+  std::uniform_int_distribution<std::uint32_t> offset(0, 0x17ff);
+  std::uniform_int_distribution<std::uint32_t> snoop_index(0, 127);
+  std::uniform_int_distribution<std::uint64_t> data;
+  std::uniform_int_distribution<int> strb(1, 0xff);
+  std::bernoulli_distribution store(0.3);
+  for (int i = 0; i < 20000; ++i) {
+    std::uint32_t addr = 0x80000000 + region(rng) * 0x10000 + (offset(rng) & ~3u);
+    bool write = store(rng);
+    auto wdata = data(rng);
+    auto wstrb = static_cast<std::uint8_t>(strb(rng));
+    auto snooped = snoop_index(rng);
+    dut->if1_next_index = snooped;
+    auto expected = model.access(addr, write);
+    auto actual = rtl_access(dut, model, memory, addr, write, wdata, wstrb, sync);
+    if (expected != actual) {
+      std::print("i={}: addr={:#010x}, write={}, model={}, rtl={}\n", i, addr, write,
+                 static_cast<int>(expected), static_cast<int>(actual));
+    }
+    REQUIRE(expected == actual);
+
+    auto index = model.index_of(addr);
+    dut->if0_index = index;
+    dut->if1_index = snooped;
+    dut->eval();
+    REQUIRE(dut->if0_current_tag == model.tag(index));
+    REQUIRE(dut->if0_current_state == model.state(index).pack());
+    REQUIRE(dut->mem0_rdata == memory[index]);
+    REQUIRE(dut->if1_current_tag == model.tag(snooped));
+    REQUIRE(dut->if1_current_state == model.state(snooped).pack());
+    REQUIRE(dut->mem1_rdata == memory[snooped]);
+  }
+  std::print("accesses={}, misses={}, writebacks={}\n", model.stats().accesses(),
+             model.stats().misses(), model.stats().writebacks);
+}
+
+TEST_CASE("cache_model_direct_mapped") {
+  CacheModel model(L1_CONFIG);
+
+  std::print("----- Cold miss, then hit\n");
+  REQUIRE(model.access(0x80000000, false) == AccessResult::MISS);
+  REQUIRE(model.access(0x8000001c, false) == AccessResult::HIT);
+
+  std::print("----- Store hit sets the dirty bit\n");
+  REQUIRE(model.access(0x80000004, true) == AccessResult::HIT);
+  REQUIRE(model.state(model.index_of(0x80000000)).d);
+
+  std::print("----- Conflict miss writes back the dirty victim\n");
+  REQUIRE(model.access(0x80001000, false) == AccessResult::MISS_WRITEBACK);
+  REQUIRE(!model.state(model.index_of(0x80001000)).d);
+  REQUIRE(model.access(0x80000000, false) == AccessResult::MISS);
+
+  REQUIRE(model.stats().accesses() == 5);
+  REQUIRE(model.stats().misses() == 3);
+  REQUIRE(model.stats().writebacks == 1);
+}
+
+TEST_CASE("cache_model_lru") {
+  CacheModel model({.size = 256, .ways = 2, .block_size = 32, .replacement = Replacement::LRU});
+  // 4 sets, so 0x000, 0x080, 0x100 map to set 0
+  REQUIRE(model.access(0x000, false) == AccessResult::MISS);
+  REQUIRE(model.access(0x080, false) == AccessResult::MISS);
+  REQUIRE(model.access(0x000, false) == AccessResult::HIT);
+  REQUIRE(model.access(0x100, false) == AccessResult::MISS);  // Evicts 0x080
+  REQUIRE(model.access(0x000, false) == AccessResult::HIT);
+  REQUIRE(model.access(0x080, false) == AccessResult::MISS);
+}
+
+TEST_CASE("cache_model_fifo") {
+  CacheModel model({.size = 256, .ways = 2, .block_size = 32, .replacement = Replacement::FIFO});
+  REQUIRE(model.access(0x000, false) == AccessResult::MISS);
+  REQUIRE(model.access(0x080, false) == AccessResult::MISS);
+  REQUIRE(model.access(0x000, false) == AccessResult::HIT);
+  REQUIRE(model.access(0x100, false) == AccessResult::MISS);  // Evicts 0x000
+  REQUIRE(model.access(0x080, false) == AccessResult::HIT);
+  REQUIRE(model.access(0x000, false) == AccessResult::MISS);
+}
+
+TEST_CASE("cache_model_vs_rtl") {
+  std::print("----- Replay a random trace on both the model and the async arrays\n");
+  cross_check<Vcache>(false);
+}
+
+TEST_CASE("cache_model_vs_rtl_sync_read") {
+  std::print("----- Replay a random trace on both the model and the sync-read arrays\n");
+  cross_check<Vcache_sync>(true);
+}
+
+// Port 1 of the sync-read arrays only changes line states; the snoop
+// responder writes the tag it read back, and nothing writes the memory
+TEST_CASE("cache_sync_read_port1") {
+  Dut<Vcache_sync> dut;
+  init_dut(dut);
+
+  std::print("----- Port 1 changes a line state, seen by both ports in the next cycle\n");
+  dut->if0_next_index = 5;
+  dut->if0_next_tag = 0x12345;
+  dut->if0_next_state = LineState{.v = true, .d = true}.pack();
+  dut->if0_write = 1;
+  dut->if0_index = 5;
+  dut->if1_next_index = 5;
+  dut.step();
+  dut->if0_write = 0;
+  dut->if1_index = 5;
+  dut->eval();
+  REQUIRE(dut->if1_current_tag == 0x12345);
+  dut->if1_next_tag = dut->if1_current_tag;
+  dut->if1_next_state = LineState{.v = true}.pack();
+  dut->if1_write = 1;
+  dut.step();
+  dut->if1_write = 0;
+  dut->eval();
+  REQUIRE(dut->if0_current_tag == 0x12345);
+  REQUIRE(dut->if0_current_state == LineState{.v = true}.pack());
+  REQUIRE(dut->if1_current_state == LineState{.v = true}.pack());
 
-  std::print("----- Implement me\n");
-  REQUIRE(true);
+  std::print("----- A tag write or a memory write through port 1 is fatal\n");
+  auto context = dut->contextp();
+  context->fatalOnError(false);
+  dut->if1_next_tag = 0x54321;
+  dut->if1_write = 1;
+  dut.step();
+  dut->if1_write = 0;
+  CHECK(context->gotError());
+  context->gotError(false);
+  context->gotFinish(false);
+  dut->mem1_wstrb = 1;
+  dut.step();
+  dut->mem1_wstrb = 0;
+  CHECK(context->gotError());
+  context->gotError(false);
+  context->gotFinish(false);
+  context->fatalOnError(true);
 }
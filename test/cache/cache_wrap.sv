@@ -5,12 +5,15 @@ module cache_wrap
 #(
     // localparam ADDR_WIDTH = 32,
     parameter INDEX_WIDTH = 7,
-    parameter TAG_WIDTH   = 20
+    parameter TAG_WIDTH   = 20,
+    parameter BLOCK_SIZE  = 64,  // Of the memory; narrower than the L1D's, to fit in a port
+    parameter SYNC_READ   = 0
 ) (
     input logic clk,
     input logic rst,
 
     input logic [INDEX_WIDTH-1:0] if0_index,
+    input logic [INDEX_WIDTH-1:0] if0_next_index,
     input logic [TAG_WIDTH-1:0] if0_next_tag,
     input logic [$bits(line_state_t)-1:0] if0_next_state,
     input logic if0_write,
@@ -18,11 +21,21 @@ module cache_wrap
     output logic [$bits(line_state_t)-1:0] if0_current_state,
 
     input logic [INDEX_WIDTH-1:0] if1_index,
+    input logic [INDEX_WIDTH-1:0] if1_next_index,
     input logic [TAG_WIDTH-1:0] if1_next_tag,
     input logic [$bits(line_state_t)-1:0] if1_next_state,
     input logic if1_write,
     output logic [TAG_WIDTH-1:0] if1_current_tag,
-    output logic [$bits(line_state_t)-1:0] if1_current_state
+    output logic [$bits(line_state_t)-1:0] if1_current_state,
+
+    // The memory shares the indices of the directory ports
+    input logic [BLOCK_SIZE-1:0] mem0_wdata,
+    input logic [BLOCK_SIZE/8-1:0] mem0_wstrb,
+    output logic [BLOCK_SIZE-1:0] mem0_rdata,
+
+    input logic [BLOCK_SIZE-1:0] mem1_wdata,
+    input logic [BLOCK_SIZE/8-1:0] mem1_wstrb,
+    output logic [BLOCK_SIZE-1:0] mem1_rdata
 );
 
   cache_dir_if #(
@@ -33,10 +46,19 @@ module cache_wrap
       .INDEX_WIDTH(INDEX_WIDTH),
       .TAG_WIDTH  (TAG_WIDTH)
   ) if1 ();
+  cache_mem_if #(
+      .BLOCK_SIZE (BLOCK_SIZE),
+      .INDEX_WIDTH(INDEX_WIDTH)
+  ) mem0 ();
+  cache_mem_if #(
+      .BLOCK_SIZE (BLOCK_SIZE),
+      .INDEX_WIDTH(INDEX_WIDTH)
+  ) mem1 ();
 
   always_comb begin
     // if0
     if0.index = if0_index;
+    if0.next_index = if0_next_index;
     if0.next_tag = if0_next_tag;
     if0.next_state = if0_next_state;
     if0.write = if0_write;
@@ -45,14 +67,31 @@ module cache_wrap
 
     // if1
     if1.index = if1_index;
+    if1.next_index = if1_next_index;
     if1.next_tag = if1_next_tag;
     if1.next_state = if1_next_state;
     if1.write = if1_write;
     if1_current_tag = if1.current_tag;
     if1_current_state = if1.current_state;
+
+    // mem0
+    mem0.index = if0_index;
+    mem0.next_index = if0_next_index;
+    mem0.wdata = mem0_wdata;
+    mem0.wstrb = mem0_wstrb;
+    mem0_rdata = mem0.rdata;
+
+    // mem1
+    mem1.index = if1_index;
+    mem1.next_index = if1_next_index;
+    mem1.wdata = mem1_wdata;
+    mem1.wstrb = mem1_wstrb;
+    mem1_rdata = mem1.rdata;
   end
 
-  cache_directory directory_inst (
+  cache_directory #(
+      .SYNC_READ(SYNC_READ)
+  ) directory_inst (
       .clk(clk),
       .rst(rst),
       .cache_dir_rsp_if_0(if0),
@@ -60,4 +99,13 @@ module cache_wrap
       .flush('0)  // TODO
   );
 
+  cache_memory #(
+      .SYNC_READ(SYNC_READ)
+  ) memory_inst (
+      .clk(clk),
+      .rst(rst),
+      .cache_mem_rsp_if_0(mem0),
+      .cache_mem_rsp_if_1(mem1)
+  );
+
 endmodule
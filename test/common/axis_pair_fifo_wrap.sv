@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MIT
+
+module axis_pair_fifo_wrap #(
+    localparam TDATA_WIDTH = 32,
+    localparam DEPTH = 4  // 2**n
+) (
+    input logic clk,
+    input logic rst,
+
+    input logic sif_tvalid,
+    input logic [TDATA_WIDTH-1:0] sif_tdata,
+    output logic sif_tready,
+
+    output logic mif_0_tvalid,
+    output logic [TDATA_WIDTH-1:0] mif_0_tdata,
+    input logic mif_0_tready,
+
+    output logic mif_1_tvalid,
+    output logic [TDATA_WIDTH-1:0] mif_1_tdata,
+    input logic mif_1_tready,
+
+    input logic invalidate
+);
+
+  axis_if #(.TDATA_WIDTH(TDATA_WIDTH)) axis_mif_0 ();
+  axis_if #(.TDATA_WIDTH(TDATA_WIDTH)) axis_mif_1 ();
+  axis_if #(.TDATA_WIDTH(TDATA_WIDTH)) axis_sif ();
+
+  assign axis_sif.tvalid = sif_tvalid;
+  assign axis_sif.tdata = sif_tdata;
+  assign sif_tready = axis_sif.tready;
+
+  assign mif_0_tvalid = axis_mif_0.tvalid;
+  assign mif_0_tdata = axis_mif_0.tdata;
+  assign axis_mif_0.tready = mif_0_tready;
+
+  assign mif_1_tvalid = axis_mif_1.tvalid;
+  assign mif_1_tdata = axis_mif_1.tdata;
+  assign axis_mif_1.tready = mif_1_tready;
+
+  axis_pair_fifo #(.DEPTH(DEPTH)) axis_pair_fifo (.*);
+
+endmodule
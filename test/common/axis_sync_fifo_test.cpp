@@ -23,12 +23,8 @@ TEST_CASE("axis_sync_fifo_ready") {
 
   std::print("----- Wait for ready signal to be asserted\n");
   REQUIRE(dut->mif_tvalid == 0);
-  for (int i = 0; i < 8; ++i) {
-    // Wait for the ready signal to be asserted, since its reset value is 0
-    std::print("i={}: sif_tready={}\n", i, dut->sif_tready);
-    if (dut->sif_tready == 1) break;
-    dut.step();
-  }
+  // Wait for the ready signal to be asserted, since its reset value is 0
+  dut.run_until([&] { return dut->sif_tready == 1; }, 8);
   REQUIRE(dut->sif_tready == 1);
 }
 
@@ -38,11 +34,7 @@ TEST_CASE("axis_sync_fifo_pass") {
 
   std::print("----- Wait for ready signal to be asserted\n");
   // Refer to axis_sync_fifo_readt test
-  for (int i = 0; i < 8; ++i) {
-    std::print("i={}: sif_tready={}\n", i, dut->sif_tready);
-    if (dut->sif_tready == 1) break;
-    dut.step();
-  }
+  dut.run_until([&] { return dut->sif_tready == 1; }, 8);
 
   std::print("----- Pass data\n");
   dut->mif_tready = 1;
@@ -72,11 +64,7 @@ TEST_CASE("axis_sync_fifo_hold_and_pass") {
 
   std::print("----- Wait for ready signal to be asserted\n");
   // Refer to axis_sync_fifo_readt test
-  for (int i = 0; i < 8; ++i) {
-    std::print("i={}: sif_tready={}\n", i, dut->sif_tready);
-    if (dut->sif_tready == 1) break;
-    dut.step();
-  }
+  dut.run_until([&] { return dut->sif_tready == 1; }, 8);
 
   std::print("----- Hold data\n");
   dut->sif_tvalid = 1;
@@ -106,11 +94,7 @@ TEST_CASE("axis_sync_fifo_full_empty_twice") {
 
   std::print("----- Wait for ready signal to be asserted\n");
   // Refer to axis_sync_fifo_readt test
-  for (int i = 0; i < 8; ++i) {
-    std::print("i={}: sif_tready={}\n", i, dut->sif_tready);
-    if (dut->sif_tready == 1) break;
-    dut.step();
-  }
+  dut.run_until([&] { return dut->sif_tready == 1; }, 8);
 
   for (int j = 0; j < 2; ++j) {
     std::print("----- Hold data until full (j = {})\n", j);
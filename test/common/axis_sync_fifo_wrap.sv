@@ -2,7 +2,7 @@
 
 module axis_sync_fifo_wrap #(
     localparam TDATA_WIDTH = 32,
-    localparam DEPTH = 5  // 2**n + 1
+    parameter DEPTH = 5  // 1, 2 or 2**n + 1
 ) (
     input logic clk,
     input logic rst,
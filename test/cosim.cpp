@@ -47,14 +47,14 @@ void init_spike(const std::string& test) {
   uint16_t rbb_port = 0;
   bool use_rbb = false;
   unsigned dmi_rti = 0;
-  reg_t blocksz = 64;
+  reg_t blocksz = 32;  // The L1D line, which the CBOs operate on
   std::optional<unsigned long long> instructions;
   debug_module_config_t dm_config;
   cfg_arg_t<size_t> nprocs(1);
 
   cfg_t cfg;
-  cfg.isa = "rv32ima_zicsr_zifencei_zicntr";
-  // cfg.misaligned = true;
+  cfg.isa = "rv32imac_zicsr_zifencei_zicntr_zba_zbb_zicbom_zicboz";
+  cfg.misaligned = true;  // Like the LSU, which handles misaligned accesses in hardware
 
   FILE* cmd_file = NULL;
 
@@ -77,6 +77,7 @@ void init_spike(const std::string& test) {
   s->set_debug(debug);
   s->configure_log(log, log_commits);
   s->set_histogram(histogram);
+  s->get_core(0)->get_mmu()->set_cache_blocksz(blocksz);
 
   s->start_htif();
 }
@@ -169,11 +170,31 @@ TEST_CASE("riscv-tests/isa/rv32ui-p") {
       "rv32ui-p-slt", "rv32ui-p-slti", "rv32ui-p-sltiu", "rv32ui-p-sltu",
       "rv32ui-p-sra", "rv32ui-p-srai", "rv32ui-p-srl", "rv32ui-p-srli",
       "rv32ui-p-st_ld", "rv32ui-p-sub", "rv32ui-p-sw", "rv32ui-p-xor",
-      "rv32ui-p-xori"  //, "rv32ui-p-ma_data"
+      "rv32ui-p-xori", "rv32ui-p-ma_data"
   );
   REQUIRE(runner(test) == 1);
 }
 
+TEST_CASE("riscv-tests/isa/rv32uc-p") {
+  auto test = GENERATE("rv32uc-p-rvc");
+  REQUIRE(runner(test) == 1);
+}
+
+TEST_CASE("riscv-tests/isa/rv32uzba-p") {
+  auto test = GENERATE("rv32uzba-p-sh1add", "rv32uzba-p-sh2add", "rv32uzba-p-sh3add");
+  REQUIRE(runner(test) == 1);
+}
+
+TEST_CASE("riscv-tests/isa/rv32uzbb-p") {
+  auto test = GENERATE(
+      "rv32uzbb-p-andn", "rv32uzbb-p-clz", "rv32uzbb-p-cpop", "rv32uzbb-p-ctz",
+      "rv32uzbb-p-max", "rv32uzbb-p-maxu", "rv32uzbb-p-min", "rv32uzbb-p-minu",
+      "rv32uzbb-p-orc_b", "rv32uzbb-p-orn", "rv32uzbb-p-rev8", "rv32uzbb-p-rol",
+      "rv32uzbb-p-ror", "rv32uzbb-p-rori", "rv32uzbb-p-sext_b", "rv32uzbb-p-sext_h",
+      "rv32uzbb-p-xnor", "rv32uzbb-p-zext_h");
+  REQUIRE(runner(test) == 1);
+}
+
 /*
 TEST_CASE("riscv-tests/isa/rv32um-p") {
   auto test = GENERATE("rv32um-p-div", "rv32um-p-divu", "rv32um-p-mul",
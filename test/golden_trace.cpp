@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+
+// Runs Spike once per ELF and stores its commit trace in the golden-trace
+// cache (see GoldenTrace.hpp), where offnariscv_core_test finds and checks it.
+// An ELF whose trace is already cached is skipped.
+//
+// Usage: golden_trace [ELF...]
+//   With no ELF, every rv32 test under ext/riscv-tests/riscv-tests/isa.
+//
+// Environment:
+//   OFFNARISCV_GOLDEN_DIR        Cache directory (default: golden next to the executables)
+//   OFFNARISCV_GOLDEN_MAX_STEPS  Steps before a run is cut off (default 1000000)
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "GoldenTrace.hpp"
+#include "SimSpike.hpp"
+#include "cfg.h"
+#include "mmu.h"
+
+static std::uint64_t max_steps() {
+  auto s = std::getenv("OFFNARISCV_GOLDEN_MAX_STEPS");
+  return s ? std::strtoull(s, nullptr, 0) : 1000000;
+}
+
+// The same configuration as the lockstep tests
+static golden::Writer run_spike(const std::filesystem::path& elf, std::uint64_t hash) {
+  cfg_t cfg;
+  cfg.isa = "rv32imac_zicsr_zifencei_zicntr_zba_zbb_zicbom_zicboz";
+  cfg.misaligned = true;  // Like the LSU, which handles misaligned accesses in hardware
+  std::vector<std::pair<reg_t, abstract_mem_t*>> mems;
+  for (const auto& c : cfg.mem_layout) {
+    mems.push_back(std::make_pair(c.get_base(), new mem_t(c.get_size())));
+  }
+  std::vector<device_factory_sargs_t> plugin_device_factories;
+  std::vector<std::string> htif_args = {elf.string()};
+  debug_module_config_t dm_config;
+  auto sim = std::make_unique<SimSpike>(&cfg, false, mems, plugin_device_factories, htif_args,
+                                        dm_config, "/dev/null", true, nullptr, false, nullptr,
+                                        std::nullopt);
+  sim->configure_log(false, true);
+  auto core = sim->get_core(0);
+  core->get_mmu()->set_cache_blocksz(32);  // The L1D line, which the CBOs operate on
+  sim->start_htif();
+  core->reset();
+
+  auto entry = static_cast<std::uint32_t>(sim->get_entry_point());
+  auto tohost_addr = sim->get_tohost_addr();
+  golden::Writer writer(hash, entry);
+  auto state = core->get_state();
+  bool started = false;
+  bool done = false;
+  for (std::uint64_t i = 0, n = max_steps(); i < n && !done; ++i) {
+    auto pc = static_cast<std::uint32_t>(state->pc);
+    started = started || pc == entry;
+    std::uint32_t inst = 0;
+    if (started) {
+      try {
+        inst = static_cast<std::uint32_t>(core->get_mmu()->load_insn(pc).insn.bits());
+      } catch (trap_t&) {
+        // A fetch fault; the step below takes it
+      }
+    }
+    core->step(1);
+    if (!started) continue;
+
+    int rd = 0;
+    std::uint32_t wdata = 0;
+    for (const auto& [key, value] : state->log_reg_write) {
+      if ((key & 0xf) != 0 || (key >> 4) == 0) continue;  // Only x1..x31
+      rd = key >> 4;
+      wdata = static_cast<std::uint32_t>(value.v[0]);
+    }
+    writer.commit(pc, rd, wdata, inst);
+    for (const auto& [addr, value, size] : state->log_mem_write) {
+      // Split into 32-bit pieces; a CBO.ZERO writes a whole block of zeros
+      for (std::uint64_t offset = 0; offset < size; offset += 4) {
+        auto data = offset < 8 ? static_cast<std::uint32_t>(value >> (8 * offset)) : 0;
+        writer.store(static_cast<std::uint32_t>(addr + offset), data,
+                     static_cast<int>(std::min<std::uint64_t>(size - offset, 4)));
+      }
+      if (tohost_addr != 0 && addr == tohost_addr) {
+        writer.finish(static_cast<std::uint32_t>(value));
+        done = true;
+      }
+    }
+  }
+
+  sim.reset();
+  for (auto& [base, mem] : mems) delete mem;
+  return writer;
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::filesystem::path> elfs(argv + 1, argv + argc);
+  if (elfs.empty()) {
+    auto isa_dir = std::filesystem::read_symlink("/proc/self/exe").parent_path() /
+                   "../ext/riscv-tests/riscv-tests/isa";
+    for (const auto& entry : std::filesystem::directory_iterator(isa_dir)) {
+      auto name = entry.path().filename().string();
+      if (entry.is_regular_file() && name.starts_with("rv32") && !entry.path().has_extension()) {
+        elfs.push_back(entry.path());
+      }
+    }
+    std::sort(elfs.begin(), elfs.end());
+  }
+
+  int failures = 0;
+  for (const auto& elf : elfs) {
+    auto hash = golden::hash_file(elf);
+    if (!hash) {
+      std::print(stderr, "{}: cannot read\n", elf.string());
+      ++failures;
+      continue;
+    }
+    auto path = golden::cache_path(*hash);
+    if (golden::Reader::open(path)) {
+      std::print("{}: cached in {}\n", elf.filename().string(), path.string());
+      continue;
+    }
+    auto writer = run_spike(elf, *hash);
+    if (!writer.save(path)) {
+      std::print(stderr, "{}: cannot write {}\n", elf.string(), path.string());
+      ++failures;
+      continue;
+    }
+    std::print("{}: {} instructions to {}\n", elf.filename().string(), writer.instructions(),
+               path.string());
+  }
+  return failures ? 1 : 0;
+}
@@ -1,13 +1,14 @@
 // SPDX-License-Identifier: MIT
 
 #include <verilated.h>
-#include <verilated_fst_c.h>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
+#include <cstdint>
 #include <print>
 
 #include "Dut.hpp"
+#include "TraceController.hpp"
 #include "Vifu.h"
 
 static void init_dut(Dut<Vifu>& dut) {
@@ -31,35 +32,34 @@ static void init_dut(Dut<Vifu>& dut) {
   dut->next_pc_tvalid = 0;
   dut->inst_tready = 0;
   dut->invalidate = 0;
+  dut->flush = 0;
 
   dut.reset();
 }
 
 TEST_CASE("ifu_load") {
   Dut<Vifu> dut;
-  Verilated::traceEverOn(true);
-  VerilatedFstC* tfp = new VerilatedFstC;
-  dut->trace(tfp, 100);
-  tfp->open("simx.fst");
+  // Writes ifu_load.vcd only if a REQUIRE below fails
+  TraceController<Vifu> trace(dut, {.path = "ifu_load.vcd", .history = 50, .window = 0});
   init_dut(dut);
 
   std::print("----- First step\n");
   for (int i = 0; i < 10; ++i) {
     std::print("next_pc_tready={}\n", dut->next_pc_tready);
     if (dut->next_pc_tready == 1) break;
-    dut.step();
+    trace.step();
   }
   REQUIRE(dut->next_pc_tready == 1);
   dut->next_pc_tvalid = 1;
   dut->next_pc_tdata = 0;
-  dut.step();
+  trace.step();
 
   std::print("----- Wait for the first instruction load\n");
   for (int i = 0; i < 10; ++i) {
     std::print("arvalid={}, araddr=0x{:08x}, rready={}\n", dut->ifu_ace_arvalid,
                dut->ifu_ace_araddr, dut->ifu_ace_rready);
     if (dut->ifu_ace_arvalid == 1) break;
-    dut.step();
+    trace.step();
   }
   REQUIRE(dut->ifu_ace_arvalid == 1);
   REQUIRE(dut->ifu_ace_araddr ==
@@ -68,7 +68,7 @@ TEST_CASE("ifu_load") {
 
   std::print("----- Respond on AR channel\n");
   dut->ifu_ace_arready = 1;
-  dut.step();
+  trace.step();
   std::print("arvalid={}, rready={}\n", dut->ifu_ace_arvalid,
              dut->ifu_ace_rready);
   REQUIRE(dut->ifu_ace_arvalid == 0);
@@ -87,7 +87,7 @@ TEST_CASE("ifu_load") {
   dut->ifu_ace_rdata[7] = 0xfeedface;
   dut->ifu_ace_rresp = 0;  // OKAY
   dut->ifu_ace_rvalid = 1;
-  dut.step();
+  trace.step();
   std::print("arvalid={}, rready={}\n", dut->ifu_ace_arvalid,
              dut->ifu_ace_rready);
   REQUIRE(dut->ifu_ace_arvalid == 0);
@@ -97,3 +97,101 @@ TEST_CASE("ifu_load") {
   REQUIRE(dut->inst_tvalid == 1);
   REQUIRE(dut->ifid_tdata_inst == 0x12345678);
 }
+
+// Fetch `count` sequential instructions from `pc`, answering reads from a
+// single block; returns the number of AR requests issued
+static int fetch_sequential(Dut<Vifu>& dut, std::uint32_t pc, int count,
+                            const std::uint32_t (&block)[8]) {
+  int reads = 0;
+  int delivered = 0;
+  bool outstanding = false;
+  for (int i = 0; i < 20 * count && delivered < count; ++i) {
+    dut->next_pc_tdata = pc;
+    dut->next_pc_tvalid = 1;
+    dut->inst_tready = 1;
+    dut->ifu_ace_arready = 1;
+    dut->ifu_ace_rvalid = outstanding;
+    for (int j = 0; j < 8; ++j) dut->ifu_ace_rdata[j] = block[j];
+    dut->eval();
+
+    if (dut->inst_tvalid) {
+      REQUIRE(dut->ifid_tdata_inst == block[delivered % 8]);
+      ++delivered;
+    }
+    if (dut->ifu_ace_arvalid) {
+      ++reads;
+      outstanding = true;
+    }
+    if (dut->ifu_ace_rvalid && dut->ifu_ace_rready) outstanding = false;
+    if (dut->next_pc_tready) pc += 4;
+    dut.step();
+  }
+  dut->next_pc_tvalid = 0;
+  dut->ifu_ace_rvalid = 0;
+  REQUIRE(delivered == count);
+  return reads;
+}
+
+TEST_CASE("ifu_line_buffer") {
+  Dut<Vifu> dut;
+  init_dut(dut);
+  const std::uint32_t block[8] = {0x00000013, 0x00100093, 0x00200113, 0x00300193,
+                                  0x00400213, 0x00500293, 0x00600313, 0x00700393};
+
+  std::print("----- One refill serves the whole block\n");
+  REQUIRE(fetch_sequential(dut, 0, 8, block) == 1);
+
+  std::print("----- FENCE.I drops the line buffer\n");
+  dut->invalidate = 1;
+  dut->flush = 1;
+  dut.step();
+  dut->invalidate = 0;
+  dut->flush = 0;
+  REQUIRE(fetch_sequential(dut, 0, 4, block) == 1);
+}
+
+TEST_CASE("ifu_compressed_straddle") {
+  Dut<Vifu> dut;
+  init_dut(dut);
+  // c.nop at 0x1c, addi x1, x0, 1 at 0x1e straddling into the next block,
+  // then addi x2, x0, 2 at 0x22
+  std::uint32_t blocks[2][8] = {{0, 0, 0, 0, 0, 0, 0, 0x00930001},
+                                {0x01130010, 0x00000020, 0, 0, 0, 0, 0, 0}};
+  const std::uint32_t pcs[] = {0x1c, 0x1e, 0x22};
+  const std::uint32_t expected[] = {0x0001, 0x00100093, 0x00200113};
+  const bool compressed[] = {true, false, false};
+
+  int sent = 0;
+  int delivered = 0;
+  int reads = 0;
+  bool outstanding = false;
+  std::uint32_t araddr = 0;
+  for (int i = 0; i < 100 && delivered < 3; ++i) {
+    dut->next_pc_tdata = pcs[sent < 3 ? sent : 2];
+    dut->next_pc_tvalid = sent < 3;
+    dut->inst_tready = 1;
+    dut->ifu_ace_arready = 1;
+    dut->ifu_ace_rvalid = outstanding;
+    for (int j = 0; j < 8; ++j) dut->ifu_ace_rdata[j] = blocks[araddr >= 0x20][j];
+    dut->eval();
+
+    if (dut->inst_tvalid) {
+      auto inst = dut->ifid_tdata_inst & (compressed[delivered] ? 0xffff : 0xffffffff);
+      std::print("inst={:#010x}, compressed={}\n", inst, dut->ifid_tdata_compressed);
+      REQUIRE(inst == expected[delivered]);
+      REQUIRE(dut->ifid_tdata_compressed == compressed[delivered]);
+      ++delivered;
+    }
+    if (dut->ifu_ace_arvalid) {
+      std::print("araddr={:#010x}\n", dut->ifu_ace_araddr);
+      araddr = dut->ifu_ace_araddr;
+      ++reads;
+      outstanding = true;
+    }
+    if (dut->ifu_ace_rvalid && dut->ifu_ace_rready) outstanding = false;
+    if (dut->next_pc_tvalid && dut->next_pc_tready) ++sent;
+    dut.step();
+  }
+  REQUIRE(delivered == 3);
+  REQUIRE(reads == 2);  // One refill per block
+}
@@ -66,10 +66,12 @@ module ifu_wrap
 
     // To Decoder
     output logic [XLEN-1:0] ifid_tdata_inst,
+    output logic ifid_tdata_compressed,
     output logic inst_tvalid,
     input logic inst_tready,
 
-    input logic invalidate
+    input logic invalidate,
+    input logic flush
 );
 
   ace_if #(.ACE_XDATA_WIDTH(ACE_XDATA_WIDTH)) ifu_ace_if ();
@@ -77,6 +79,25 @@ module ifu_wrap
   axis_if #(.TDATA_WIDTH($bits(pcgif_tdata_t))) pcgif_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(ifid_tdata_t))) inst_axis_if ();
 
+  // Translation is off (M-mode, bare satp), so the TLB and the walker are never used
+  csr_pif csr_pif ();
+  tlb_if l1itlb_if ();
+  ptw_if ptw_ifu_if ();
+
+  assign csr_pif.priv = riscv_pkg::PRIV_M;
+  assign csr_pif.ls_priv = riscv_pkg::PRIV_M;
+  assign csr_pif.satp = '0;
+  assign csr_pif.sum = 1'b0;
+  assign csr_pif.mxr = 1'b0;
+  assign csr_pif.adue = 1'b0;
+  assign l1itlb_if.hit = 1'b0;
+  assign l1itlb_if.entry = '0;
+  assign l1itlb_if.ppn = '0;
+  assign ptw_ifu_if.done = 1'b0;
+  assign ptw_ifu_if.page_fault = 1'b0;
+  assign ptw_ifu_if.access_fault = 1'b0;
+  assign ptw_ifu_if.entry = '0;
+
   cache_dir_if #(
       .INDEX_WIDTH(INDEX_WIDTH),
       .TAG_WIDTH  (TAG_WIDTH)
@@ -157,6 +178,7 @@ module ifu_wrap
   assign inst_axis_if.tready = inst_tready;
 
   assign ifid_tdata_inst = ifid_tdata.inst;
+  assign ifid_tdata_compressed = ifid_tdata.compressed;
 
   ifu ifu_inst (
       .clk(clk),
@@ -166,7 +188,17 @@ module ifu_wrap
       .inst_axis_if(inst_axis_if),
       .l1i_dir_if(l1i_dir_if_0),
       .l1i_mem_if(l1i_mem_if_0),
-      .invalidate(invalidate)
+      .predecode_pc('0),
+      .predecode_vld(),
+      .predecode_rvc(),
+      .csr_pif(csr_pif),
+      .l1itlb_if(l1itlb_if),
+      .ptw_ifu_if(ptw_ifu_if),
+      .l1i_inval_vld(1'b0),
+      .l1i_inval_addr('0),
+      .invalidate(invalidate),
+      .flush(flush),
+      .sfence(1'b0)
   );
 
   cache_directory l1i_dir_inst (
@@ -174,7 +206,7 @@ module ifu_wrap
       .rst(rst),
       .cache_dir_rsp_if_0(l1i_dir_if_0),
       .cache_dir_rsp_if_1(l1i_dir_if_1),
-      .flush('0)  // TODO
+      .flush(flush)
   );
 
 endmodule
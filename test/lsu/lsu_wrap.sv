@@ -101,6 +101,32 @@ module lsu_wrap
   axis_if #(.TDATA_WIDTH($bits(rflsu_tdata_t))) rflsu_axis_if ();
   axis_if #(.TDATA_WIDTH($bits(lsuwb_tdata_t))) lsuwb_axis_if ();
 
+  // Translation is off (M-mode, bare satp), so the TLB and the walker are never used
+  csr_pif csr_pif ();
+  tlb_if l1dtlb_if ();
+  ptw_if ptw_lsu_if ();
+
+  assign csr_pif.priv = riscv_pkg::PRIV_M;
+  assign csr_pif.ls_priv = riscv_pkg::PRIV_M;
+  assign csr_pif.satp = '0;
+  assign csr_pif.sum = 1'b0;
+  assign csr_pif.mxr = 1'b0;
+  assign csr_pif.adue = 1'b0;
+  assign l1dtlb_if.hit = 1'b0;
+  assign l1dtlb_if.entry = '0;
+  assign l1dtlb_if.ppn = '0;
+  assign ptw_lsu_if.done = 1'b0;
+  assign ptw_lsu_if.page_fault = 1'b0;
+  assign ptw_lsu_if.access_fault = 1'b0;
+  assign ptw_lsu_if.entry = '0;
+
+  // Nothing is mapped at the CLINT
+  clint_if lsu_clint_if ();
+
+  assign lsu_clint_if.rdata = '0;
+  assign lsu_clint_if.mtip = 1'b0;
+  assign lsu_clint_if.msip = 1'b0;
+
   cache_dir_if #(
       .INDEX_WIDTH(INDEX_WIDTH),
       .TAG_WIDTH  (TAG_WIDTH)
@@ -118,6 +144,15 @@ module lsu_wrap
       .INDEX_WIDTH(INDEX_WIDTH)
   ) l1d_mem_if_1 ();
 
+  // There is no L1I to keep coherent, so its directory is always empty
+  cache_dir_if #(
+      .INDEX_WIDTH(INDEX_WIDTH),
+      .TAG_WIDTH  (TAG_WIDTH)
+  ) l1i_dir_if ();
+
+  assign l1i_dir_if.current_tag = '0;
+  assign l1i_dir_if.current_state = '0;
+
   // AW channel signals
   assign lsu_ace_awid = lsu_ace_if.awid;
   assign lsu_ace_awaddr = lsu_ace_if.awaddr;
@@ -208,7 +243,17 @@ module lsu_wrap
       .lsuwb_axis_if(lsuwb_axis_if),
       .l1d_dir_if(l1d_dir_if_0),
       .l1d_mem_if(l1d_mem_if_0),
-      .invalidate(invalidate)
+      .l1d_snoop_dir_if(l1d_dir_if_1),
+      .l1d_snoop_mem_if(l1d_mem_if_1),
+      .csr_pif(csr_pif),
+      .l1dtlb_if(l1dtlb_if),
+      .ptw_lsu_if(ptw_lsu_if),
+      .lsu_clint_if(lsu_clint_if),
+      .l1i_dir_if(l1i_dir_if),
+      .l1i_inval_vld(),
+      .l1i_inval_addr(),
+      .invalidate(invalidate),
+      .demand_busy('0)
   );
 
   cache_directory l1d_dir_inst (
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+
+#include <verilated.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <print>
+
+#include "Dut.hpp"
+#include "Vtlb.h"
+
+static void init_dut(Dut<Vtlb>& dut) {
+  dut->vpn = 0;
+  dut->asid = 0;
+  dut->lookup = 0;
+  dut->refill = 0;
+  dut->refill_vpn = 0;
+  dut->refill_asid = 0;
+  dut->refill_ppn = 0;
+  dut->refill_superpage = 0;
+  dut->refill_g = 0;
+  dut->flush = 0;
+
+  dut.reset();
+}
+
+static void refill(Dut<Vtlb>& dut, std::uint32_t vpn, std::uint32_t asid, std::uint32_t ppn,
+                   bool superpage = false, bool g = false) {
+  dut->refill_vpn = vpn;
+  dut->refill_asid = asid;
+  dut->refill_ppn = ppn;
+  dut->refill_superpage = superpage;
+  dut->refill_g = g;
+  dut->refill = 1;
+  dut.step();
+  dut->refill = 0;
+}
+
+static bool lookup(Dut<Vtlb>& dut, std::uint32_t vpn, std::uint32_t asid) {
+  dut->vpn = vpn;
+  dut->asid = asid;
+  dut->eval();
+  return dut->hit;
+}
+
+TEST_CASE("tlb_hit_miss") {
+  Dut<Vtlb> dut;
+  init_dut(dut);
+
+  std::print("----- Empty TLB misses\n");
+  REQUIRE(!lookup(dut, 0x12345, 1));
+
+  std::print("----- 4 KiB page\n");
+  refill(dut, 0x12345, 1, 0x0abcd);
+  REQUIRE(lookup(dut, 0x12345, 1));
+  REQUIRE(dut->ppn == 0x0abcd);
+  REQUIRE(!lookup(dut, 0x12346, 1));
+
+  std::print("----- Megapage fills in the offset within it\n");
+  refill(dut, 0x40000, 1, 0x00c00, true);
+  REQUIRE(lookup(dut, 0x40123, 1));
+  REQUIRE(dut->ppn == 0x00d23);
+  REQUIRE(!lookup(dut, 0x40523, 1));
+
+  std::print("----- Hits and misses are counted on lookup only\n");
+  dut->lookup = 1;
+  lookup(dut, 0x12345, 1);
+  dut.step();
+  lookup(dut, 0x54321, 1);
+  dut.step();
+  dut->lookup = 0;
+  dut.step();
+  REQUIRE(dut->hit_count == 1);
+  REQUIRE(dut->miss_count == 1);
+}
+
+TEST_CASE("tlb_asid") {
+  Dut<Vtlb> dut;
+  init_dut(dut);
+
+  refill(dut, 0x00010, 1, 0x00100);
+  refill(dut, 0x00020, 1, 0x00200, false, true);
+
+  std::print("----- Non-global entries belong to one address space\n");
+  REQUIRE(lookup(dut, 0x00010, 1));
+  REQUIRE(!lookup(dut, 0x00010, 2));
+
+  std::print("----- Global entries match every ASID\n");
+  REQUIRE(lookup(dut, 0x00020, 2));
+  REQUIRE(dut->ppn == 0x00200);
+
+  std::print("----- Same VPN in another address space\n");
+  refill(dut, 0x00010, 2, 0x00300);
+  REQUIRE(lookup(dut, 0x00010, 1));
+  REQUIRE(dut->ppn == 0x00100);
+  REQUIRE(lookup(dut, 0x00010, 2));
+  REQUIRE(dut->ppn == 0x00300);
+}
+
+TEST_CASE("tlb_flush_and_replacement") {
+  Dut<Vtlb> dut;
+  init_dut(dut);
+
+  std::print("----- Refilling a present page replaces its entry\n");
+  refill(dut, 0x00001, 0, 0x00011);
+  refill(dut, 0x00001, 0, 0x00022);
+  REQUIRE(lookup(dut, 0x00001, 0));
+  REQUIRE(dut->ppn == 0x00022);
+
+  std::print("----- Round-robin replacement evicts the oldest entry\n");
+  for (std::uint32_t vpn = 2; vpn <= 4; ++vpn) refill(dut, vpn, 0, vpn << 4);
+  for (std::uint32_t vpn = 1; vpn <= 4; ++vpn) REQUIRE(lookup(dut, vpn, 0));
+  refill(dut, 0x00005, 0, 0x00050);
+  REQUIRE(!lookup(dut, 0x00001, 0));
+  for (std::uint32_t vpn = 2; vpn <= 5; ++vpn) REQUIRE(lookup(dut, vpn, 0));
+
+  std::print("----- SFENCE.VMA drops everything\n");
+  dut->flush = 1;
+  dut.step();
+  dut->flush = 0;
+  for (std::uint32_t vpn = 1; vpn <= 5; ++vpn) REQUIRE(!lookup(dut, vpn, 0));
+}
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+
+module tlb_wrap
+  import offnariscv_pkg::*;
+#(
+    parameter ENTRIES = 4
+) (
+    input clk,
+    input rst,
+
+    input logic [19:0] vpn,
+    input logic [8:0] asid,
+    input logic lookup,
+    output logic hit,
+    output logic [19:0] ppn,
+
+    input logic refill,
+    input logic [19:0] refill_vpn,
+    input logic [8:0] refill_asid,
+    input logic [21:0] refill_ppn,
+    input logic refill_superpage,
+    input logic refill_g,
+
+    input logic flush,
+
+    output logic [63:0] hit_count,
+    output logic [63:0] miss_count
+);
+
+  tlb_if tlb_if ();
+
+  assign tlb_if.vpn = vpn;
+  assign tlb_if.asid = asid;
+  assign tlb_if.lookup = lookup;
+  assign hit = tlb_if.hit;
+  assign ppn = tlb_if.ppn;
+
+  assign tlb_if.refill = refill;
+  always_comb begin
+    tlb_if.refill_entry = '{default: '0, a: 1'b1, d: 1'b1, r: 1'b1, w: 1'b1, x: 1'b1};
+    tlb_if.refill_entry.vpn = refill_vpn;
+    tlb_if.refill_entry.asid = refill_asid;
+    tlb_if.refill_entry.ppn = refill_ppn;
+    tlb_if.refill_entry.superpage = refill_superpage;
+    tlb_if.refill_entry.g = refill_g;
+  end
+
+  assign hit_count = tlb_inst.hit_count_q;
+  assign miss_count = tlb_inst.miss_count_q;
+
+  tlb #(
+      .ENTRIES(ENTRIES)
+  ) tlb_inst (
+      .clk(clk),
+      .rst(rst),
+      .tlb_rsp_if(tlb_if),
+      .flush(flush)
+  );
+
+endmodule
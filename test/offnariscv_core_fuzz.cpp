@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: MIT
+
+// Random-program differential test of offnariscv_core against Spike.
+//
+// Programs come from ProgramGenerator and are written straight into both the
+// RTL memory model and Spike's memory, so no toolchain is involved. One Dut
+// and one Spike instance are reused for the whole batch; each program only
+// costs a reset. Every retired instruction is compared in lockstep (PC, rd
+// and the written value). A failing program is shrunk by replacing body
+// instructions with nops while the same instruction keeps mismatching.
+//
+// The issue2 target builds the same core with ISSUE_WIDTH=2, so the fuzzer
+// also checks the second back-end slot. That slot still sits behind a
+// one-instruction-per-cycle front end, so its IPC is no measure of dual issue.
+// A fused op retires as its two instructions, so it is checked as two.
+//
+// Environment:
+//   OFFNARISCV_FUZZ_SEED      First seed of the batch (default 1)
+//   OFFNARISCV_FUZZ_PROGRAMS  Number of programs (default 300)
+//   OFFNARISCV_TRACE          Dump offnariscv_core_fuzz.vcd around the first
+//                             mismatch; see TraceController.hpp for the rest
+
+#include <verilated.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <optional>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "AceMemory.hpp"
+#include "Dut.hpp"
+#include "RandomProgram.hpp"
+#include "SimSpike.hpp"
+#include "TraceController.hpp"
+#include "Voffnariscv_core.h"
+#include "cfg.h"
+#include "mmu.h"
+
+struct Commit {
+  std::uint32_t pc;
+  int rd;  // 0 if no register is written
+  std::uint32_t wdata;
+};
+
+struct Mismatch {
+  std::uint32_t pc;
+  std::uint32_t inst;
+  std::string what;
+};
+
+class SpikeRunner {
+  cfg_t cfg;
+  std::vector<std::pair<reg_t, abstract_mem_t*>> mems;
+  std::unique_ptr<SimSpike> sim;
+  processor_t* core;
+
+  void store(std::uint32_t addr, const std::uint8_t* data, std::size_t size) {
+    for (auto& [base, mem] : mems) {
+      if (addr >= base && addr - base < mem->size()) {
+        mem->store(addr - base, size, data);
+        return;
+      }
+    }
+  }
+
+ public:
+  SpikeRunner() {
+    cfg.isa = "rv32imac_zicsr_zifencei_zicntr_zicbom_zicboz";
+    cfg.misaligned = true;  // Misaligned loads and stores complete in the LSU
+    for (const auto& c : cfg.mem_layout) {
+      mems.push_back(std::make_pair(c.get_base(), new mem_t(c.get_size())));
+    }
+    std::vector<device_factory_sargs_t> plugin_device_factories;
+    std::vector<std::string> htif_args = {"none"};  // Programs are stored directly
+    debug_module_config_t dm_config;
+    sim = std::make_unique<SimSpike>(&cfg, false, mems, plugin_device_factories, htif_args,
+                                     dm_config, "/dev/null", true, nullptr, false, nullptr,
+                                     std::nullopt);
+    sim->configure_log(false, true);
+    core = sim->get_core(0);
+    core->get_mmu()->set_cache_blocksz(32);  // The L1D line, which the CBOs operate on
+  }
+
+  ~SpikeRunner() {
+    sim.reset();
+    for (auto& [base, mem] : mems) delete mem;
+  }
+
+  void load(const Program& prog) {
+    store(Program::TEXT_BASE, reinterpret_cast<const std::uint8_t*>(prog.text.data()),
+          prog.text.size() * sizeof(std::uint32_t));
+    store(Program::DATA_BASE, prog.data.data(), prog.data.size());
+    core->reset();
+    core->get_mmu()->flush_tlb();
+    core->get_mmu()->flush_icache();  // Decoded instructions of the previous program
+    core->get_state()->pc = Program::TEXT_BASE;
+  }
+
+  Commit step() {
+    auto state = core->get_state();
+    Commit c{static_cast<std::uint32_t>(state->pc), 0, 0};
+    core->step(1);
+    for (const auto& [key, value] : state->log_reg_write) {
+      if ((key & 0xf) != 0 || (key >> 4) == 0) continue;  // Only x1..x31
+      c.rd = key >> 4;
+      c.wdata = static_cast<std::uint32_t>(value.v[0]);
+    }
+    return c;
+  }
+};
+
+// Collects the retired instructions between the clock edges
+class CoreDut : public DutBase<Voffnariscv_core, CoreDut> {
+ public:
+  std::vector<Commit> retired;
+  std::uint64_t fused = 0;  // Fused ops retired, each covering two instructions
+  TraceController<Voffnariscv_core>* trace = nullptr;
+
+  void on_negedge() {
+    if (trace) trace->sample();
+    retired.clear();
+    if ((*this)->core_commit_fused) {
+      ++fused;
+      retired.push_back({(*this)->core_commit_fused_pc, (*this)->core_commit_fused_rd,
+                         (*this)->core_commit_fused_wdata});
+    }
+    if ((*this)->core_commit_valid) {
+      retired.push_back({(*this)->core_commit_pc, (*this)->core_commit_rd,
+                         (*this)->core_commit_wdata});
+    }
+    if ((*this)->core_commit1_valid) {
+      retired.push_back({(*this)->core_commit1_pc, (*this)->core_commit1_rd,
+                         (*this)->core_commit1_wdata});
+    }
+    for (auto& c : retired) {
+      if (c.rd == 0) c.wdata = 0;
+    }
+  }
+
+  void on_posedge() {
+    if (trace) trace->sample();
+  }
+};
+
+class CoreRunner {
+  CoreDut dut;
+  AceMemory memory;
+  std::unique_ptr<TraceController<Voffnariscv_core>> trace;
+
+ public:
+  std::uint64_t cycles = 0;
+
+  std::uint64_t fused() const { return dut.fused; }
+
+  CoreRunner() {
+    if (std::getenv("OFFNARISCV_TRACE")) {
+      trace = std::make_unique<TraceController<Voffnariscv_core>>(
+          dut, TraceController<Voffnariscv_core>::config_from_env("offnariscv_core_fuzz.vcd"));
+      dut.trace = trace.get();
+    }
+  }
+
+  void trigger_trace(const std::string& reason) {
+    if (trace) trace->trigger(reason);
+  }
+
+  void load(const Program& prog) {
+    memory.clear();
+    memory.write32(0, rv::lui(1, Program::TEXT_BASE));  // Reset vector of offnariscv_core_wrap
+    memory.write32(4, rv::jalr(0, 1, 0));
+    memory.write(Program::TEXT_BASE, reinterpret_cast<const std::uint8_t*>(prog.text.data()),
+                 prog.text.size() * sizeof(std::uint32_t));
+    memory.write(Program::DATA_BASE, prog.data.data(), prog.data.size());
+    memory.init(dut);
+    dut.reset();
+  }
+
+  // Advance one cycle; returns the instructions retired in it, oldest first
+  const std::vector<Commit>& step() {
+    memory.respond(dut);
+    dut.step();
+    memory.retire(dut);
+    ++cycles;
+    return dut.retired;
+  }
+};
+
+class Fuzzer {
+  SpikeRunner spike;
+  CoreRunner core;
+
+ public:
+  std::uint64_t instructions = 0;
+
+  std::optional<Mismatch> run(const Program& prog) {
+    spike.load(prog);
+    core.load(prog);
+    auto max_cycles = 64 * prog.text.size() + 4096;
+    auto inst_at = [&](std::uint32_t pc) {
+      auto i = (pc - Program::TEXT_BASE) / 4;
+      return i < prog.text.size() ? prog.text[i] : 0;
+    };
+    auto mismatch = [&](Mismatch m) {
+      core.trigger_trace(std::format("mismatch at {:#010x}", m.pc));
+      return m;
+    };
+    for (std::size_t i = 0; i < max_cycles; ++i) {
+      for (const auto& actual : core.step()) {
+        if (actual.pc < Program::TEXT_BASE) continue;  // Boot code is not in Spike
+        auto expected = spike.step();
+        ++instructions;
+        if (actual.pc != expected.pc) {
+          return mismatch({expected.pc, inst_at(expected.pc),
+                           std::format("pc: rtl={:#010x}, spike={:#010x}", actual.pc, expected.pc)});
+        }
+        if (actual.rd != expected.rd || actual.wdata != expected.wdata) {
+          return mismatch({expected.pc, inst_at(expected.pc),
+                           std::format("rtl: x{}={:#010x}, spike: x{}={:#010x}", actual.rd,
+                                       actual.wdata, expected.rd, expected.wdata)});
+        }
+        if (actual.pc == prog.end_pc()) return std::nullopt;
+      }
+    }
+    return mismatch({0, 0, "timeout"});
+  }
+
+  // Replace body instructions by nops, in halving chunks, as long as the
+  // same instruction still mismatches
+  Program minimize(Program prog, const Mismatch& first) {
+    auto reproduces = [&](const Program& p) {
+      auto m = run(p);
+      return m && m->inst == first.inst && m->what != "timeout";
+    };
+    auto n = prog.body_end - prog.body_begin;
+    for (auto chunk = n / 2; chunk > 0;) {
+      bool progress = false;
+      for (auto start = prog.body_begin; start < prog.body_end; start += chunk) {
+        auto trial = prog;
+        bool changed = false;
+        for (auto i = start; i < std::min(start + chunk, prog.body_end); ++i) {
+          changed |= trial.text[i] != rv::nop();
+          trial.text[i] = rv::nop();
+        }
+        if (changed && reproduces(trial)) {
+          prog = std::move(trial);
+          progress = true;
+        }
+      }
+      if (!progress) chunk /= 2;
+    }
+    return prog;
+  }
+
+  std::uint64_t cycles() const { return core.cycles; }
+  std::uint64_t fused() const { return core.fused(); }
+};
+
+static std::uint32_t env_or(const char* name, std::uint32_t value) {
+  auto s = std::getenv(name);
+  return s ? static_cast<std::uint32_t>(std::strtoul(s, nullptr, 0)) : value;
+}
+
+TEST_CASE("offnariscv_core/fuzz") {
+  auto seed = env_or("OFFNARISCV_FUZZ_SEED", 1);
+  auto programs = env_or("OFFNARISCV_FUZZ_PROGRAMS", 300);
+  const char* profile_names[] = {"hazard", "branch", "alias"};
+
+  Fuzzer fuzzer;
+  int failures = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0; i < programs; ++i) {
+    ProgramGenerator gen(seed + i);
+    auto profile = static_cast<Profile>((seed + i) % 3);
+    auto prog = gen.generate(profile, 64 + (seed + i) % 192);
+    auto mismatch = fuzzer.run(prog);
+    if (!mismatch) continue;
+
+    ++failures;
+    std::print("Mismatch in seed {} ({}): pc={:#010x}, {}\n", seed + i,
+               profile_names[(seed + i) % 3], mismatch->pc, mismatch->what);
+    auto reduced = fuzzer.minimize(prog, *mismatch);
+    std::print("Reduced program (prologue omitted, nops removed):\n");
+    for (auto j = reduced.body_begin; j <= reduced.body_end; ++j) {
+      if (reduced.text[j] == rv::nop()) continue;
+      std::print("  {:#010x}: {:08x}{}\n", Program::TEXT_BASE + 4 * j, reduced.text[j],
+                 Program::TEXT_BASE + 4 * j == mismatch->pc ? "  <-" : "");
+    }
+    std::print("Reproduce with OFFNARISCV_FUZZ_SEED={} OFFNARISCV_FUZZ_PROGRAMS=1\n", seed + i);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::print("{} programs, {} instructions, {} cycles in {:.3f} s ({:.0f} programs/s, IPC {:.3f})\n",
+             programs, fuzzer.instructions, fuzzer.cycles(), elapsed.count(),
+             programs / elapsed.count(),
+             static_cast<double>(fuzzer.instructions) / fuzzer.cycles());
+  std::print("{} fused pairs\n", fuzzer.fused());
+  REQUIRE(failures == 0);
+}
@@ -4,60 +4,170 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstdlib>
 #include <elfio/elfio.hpp>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <print>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "AceMemory.hpp"
+#include "Assembler.hpp"
 #include "Dut.hpp"
+#include "GoldenTrace.hpp"
+#include "TraceController.hpp"
 #include "Voffnariscv_core.h"
 
-constexpr int PAGE_SIZE = 4096;
-constexpr int PAGE_OFFSET_MASK = PAGE_SIZE - 1;
-constexpr int PAGE_NUMBER_MASK = ~PAGE_OFFSET_MASK;
+// Observes the core between the clock edges, for the trace, the Kanata log
+// and the golden-trace check
+class CoreDut : public DutBase<Voffnariscv_core, CoreDut> {
+ public:
+  TraceController<Voffnariscv_core>* trace = nullptr;
+  std::ofstream* kanata_log = nullptr;
+  std::uint64_t kanata_cycles = 1;  // Cycles covered by the next Kanata C record
+  golden::Checker* golden = nullptr;
+
+  void golden_mismatch() {
+    std::print("Golden trace mismatch at {}\n", golden->mismatch);
+    if (trace) trace->trigger("golden trace mismatch");
+  }
+
+  void check_golden(std::uint32_t pc, int rd, std::uint32_t wdata) {
+    if (!golden->check(pc, rd, wdata)) golden_mismatch();
+  }
+
+  void on_negedge() {
+    if (trace) trace->sample();
+
+    if (golden) {  // Oldest first
+      if ((*this)->core_commit_fused) {
+        check_golden((*this)->core_commit_fused_pc, (*this)->core_commit_fused_rd,
+                     (*this)->core_commit_fused_wdata);
+      }
+      if ((*this)->core_commit_valid) {
+        check_golden((*this)->core_commit_pc, (*this)->core_commit_rd,
+                     (*this)->core_commit_wdata);
+      }
+      if ((*this)->core_commit1_valid) {
+        check_golden((*this)->core_commit1_pc, (*this)->core_commit1_rd,
+                     (*this)->core_commit1_wdata);
+      }
+      if ((*this)->core_lsu_store &&
+          !golden->check_store((*this)->core_lsu_addr, (*this)->core_lsu_wdata)) {
+        golden_mismatch();
+      }
+    }
 
-constexpr int BLOCK_BYTES = 32;  // Assuming each block is 32 bytes (256 bits)
-constexpr int BLOCK_MASK = ~(BLOCK_BYTES - 1);
+    // To observe the internal state of the DUT, we should do it between
+    // negedge evaluation and posedge evaluation
+
+    //  Update Kanata log
+    if (kanata_log) {
+      const char* kanata_log_buf;
+      svSetScope(svGetScopeFromName("TOP.offnariscv_core_wrap"));
+      (*this)->kanata_log_dut(&kanata_log_buf);
+      std::print(*kanata_log,
+                 "{}"
+                 "C\t{}\n",
+                 kanata_log_buf, kanata_cycles);
+    }
+  }
+
+  void on_posedge() {
+    if (trace) trace->sample();
+  }
+};
 
 class Tester {
-  Dut<Voffnariscv_core> dut;
-  std::unordered_map<std::uint32_t, std::vector<std::uint8_t>> memory;
+  CoreDut dut;
+  AceMemory memory;
   bool kanata_log_enabled;
   std::ofstream kanata_log;
   std::uint32_t tohost_addr;
+  std::unique_ptr<TraceController<Voffnariscv_core>> trace;
+  std::unique_ptr<golden::Checker> golden;
 
   void init_dut();
+  void open_kanata_log(const std::string& test);
+  void open_trace(const std::string& test);
 
  public:
   Tester(const std::string& test);
+  // Runs `text` from 0x80000000 in M-mode, until it stores to `tohost`
+  Tester(const std::vector<std::uint32_t>& text, std::uint32_t tohost);
   void step();
+  void print_tlb_stats();
+  void print_commit_stats();
+  void print_fetch_stats();
+  void print_prefetch_stats();
+  // Empty if the run matches the golden trace or there is none
+  std::string check_golden();
+  std::uint64_t l1i_refills() const { return dut->core_l1i_refills; }
+  std::uint64_t loop_replayed() const { return dut->core_loop_replayed; }
+  std::uint64_t prefetch_hits() const { return dut->core_prefetch_hits; }
+  std::uint64_t retired() const { return dut->core_retired; }
+  void print_run_stats() const { dut.print_run_stats("Simulation"); }
   bool tohost_written;
   std::uint32_t tohost_data;
+
+  // While the core sleeps in WFI and the bus is idle, nothing happens until
+  // the timer fires, so jump mtime there in one step instead of stepping
+  // through every idle cycle
+  bool fast_forward = true;
+  std::uint64_t cycles = 0;  // Simulated cycles, including the skipped ones
+  std::uint64_t steps = 0;   // ... and the ones actually evaluated
 };
 
 void Tester::init_dut() {
-  dut->core_ace_arready = 0;
-  dut->core_ace_rid = 0;
-  for (int i = 0; i < 8; ++i) {
-    // Assuming the block size is 256 bits (8 * 32 bits)
-    dut->core_ace_rdata[i] = 0;
-  }
-  dut->core_ace_rresp = 0;
-  dut->core_ace_rlast = 0;
-  dut->core_ace_ruser = 0;
-  dut->core_ace_rvalid = 0;
-  dut->core_ace_acvalid = 0;
-  dut->core_ace_acaddr = 0;
-  dut->core_ace_acsnoop = 0;
-  dut->core_ace_acprot = 0;
-  dut->core_ace_crready = 0;
-  dut->core_ace_cdready = 0;
-
+  memory.init(dut);
+  dut->core_clint_rdata = 0;
+  dut->core_clint_mtip = 0;
+  dut->core_clint_msip = 0;
+  dut->clint_skip = 0;
   dut.reset();
+
+  // Reset cycles are neither logged nor traced
+  if (kanata_log_enabled) dut.kanata_log = &kanata_log;
+  dut.trace = trace.get();
+  dut.golden = golden.get();
+}
+
+void Tester::open_kanata_log(const std::string& test) {
+  kanata_log.open(test + ".kanata.log");
+  REQUIRE(kanata_log.is_open());
+  std::print(kanata_log,
+             "Kanata\t0004\n"
+             "C=\t0\n"
+             "I\t0\t0\t0\n"
+             "S\t0\t0\tPC\n"
+             "L\t0\t0\t00000000\n");
+}
+
+// Set OFFNARISCV_TRACE to dump <test>.vcd around a trigger: a cycle
+// (OFFNARISCV_TRACE_CYCLE), a committed PC (OFFNARISCV_TRACE_PC), a committed
+// instruction id (OFFNARISCV_TRACE_ID), an RTL error or a failing REQUIRE
+void Tester::open_trace(const std::string& test) {
+  if (!std::getenv("OFFNARISCV_TRACE")) return;
+  trace = std::make_unique<TraceController<Voffnariscv_core>>(
+      dut, TraceController<Voffnariscv_core>::config_from_env(test + ".vcd"));
+  if (auto s = std::getenv("OFFNARISCV_TRACE_PC")) {
+    auto pc = static_cast<std::uint32_t>(std::strtoul(s, nullptr, 0));
+    trace->trigger_when(std::format("pc {:#010x}", pc),
+                        [this, pc] { return dut->core_commit_valid && dut->core_commit_pc == pc; });
+  }
+  if (auto s = std::getenv("OFFNARISCV_TRACE_ID")) {
+    auto id = std::strtoull(s, nullptr, 0);
+    trace->trigger_when(std::format("id {}", id),
+                        [this, id] { return dut->core_commit_valid && dut->core_commit_id == id; });
+  }
 }
 
 Tester::Tester(const std::string& test) {
@@ -86,109 +196,45 @@ Tester::Tester(const std::string& test) {
       tohost_addr = addr;
       std::print("Found .tohost section at address: {:#010x}\n", addr);
     }
-    auto data = section->get_data();
-    auto end_data = data + size;
-    for (auto p = data; p < end_data; p += PAGE_SIZE) {
-      // Assuming each section starts at a page-aligned address
-      // and never crosses a page boundary
-      auto ppn = addr & PAGE_NUMBER_MASK;
-      memory.emplace(ppn, std::vector<std::uint8_t>(p, std::min(p + PAGE_SIZE, end_data)));
-      if (p + PAGE_SIZE != end_data) {
-        // Fill the last page with zeros if it is not fully filled
-        memory[ppn].resize(PAGE_SIZE);
-      }
-      addr += PAGE_SIZE;
-    }
+    memory.write(addr, reinterpret_cast<const std::uint8_t*>(section->get_data()), size);
   }
   REQUIRE(!memory.empty());
   REQUIRE(!memory.contains(0));
   REQUIRE(text_init == 0x80000000);  // Assuming text_init is at this address
 
-  memory.emplace(0, std::vector<std::uint8_t>(PAGE_SIZE));
-  auto& init_data = memory[0];
-  // lui x1, 0x80000000
-  init_data[0] = 0xb7;
-  init_data[1] = 0x00;
-  init_data[2] = 0x00;
-  init_data[3] = 0x80;
-  // jalr x0, 0(x1); Jump to text_init
-  init_data[4] = 0x67;
-  init_data[5] = 0x80;
-  init_data[6] = 0x00;
-  init_data[7] = 0x00;
-
-  // // Dump memory
-  // for (const auto& [ppn, data] : memory) {
-  //   std::print("Memory at {:#010x}:\n", ppn);
-  //   for (int i = 0; i < data.size(); i += 4) {
-  //     std::print("{} {:#010x}\n", i,
-  //                *reinterpret_cast<const uint32_t*>(&data[i]));
-  //   }
-  // }
+  memory.write32(0, rv::lui(1, 0x80000000));  // lui x1, 0x80000000
+  memory.write32(4, rv::jalr(0, 1, 0));       // jalr x0, 0(x1); Jump to text_init
+  memory.verbose = true;
 
   // Set up Kanata log
   kanata_log_enabled = true;  // Change this to false to disable Kanata logging
-  if (kanata_log_enabled) {
-    kanata_log.open(test + ".kanata.log");
-    REQUIRE(kanata_log.is_open());
-    std::print(kanata_log,
-               "Kanata\t0004\n"
-               "C=\t0\n"
-               "I\t0\t0\t0\n"
-               "S\t0\t0\tPC\n"
-               "L\t0\t0\t00000000\n");
-  }
+  if (kanata_log_enabled) open_kanata_log(test);
+  open_trace(test);
+
+  // Recorded by golden_trace; without it only the tohost value is checked
+  golden = golden::Checker::open(test_path);
+  if (golden) std::print("Golden trace: {}\n", golden->path.string());
 
   tohost_written = false;
 
   init_dut();
 }
 
-void Tester::step() {
-  // NOTE: This method might not work, if there is a load/store queue
-  auto rready = dut->core_ace_rready;
-  dut->core_ace_arready = 1;
-  if (dut->core_ace_arvalid) {
-    auto araddr = dut->core_ace_araddr;
-    dut->core_ace_rvalid = 1;
-    auto ppn = araddr & PAGE_NUMBER_MASK;
-    if (memory.contains(ppn)) {
-      std::print("araddr: {:#010x}\n", araddr);
-      std::print("rdata:");
-      auto offset = araddr & PAGE_OFFSET_MASK & BLOCK_MASK;  // e.g. araddr[11:6]
-      for (int i = 0; i < BLOCK_BYTES / 4; ++i) {
-        dut->core_ace_rdata[i] = *reinterpret_cast<const uint32_t*>(&memory[ppn][offset + 4 * i]);
-        std::print(" {:#010x}", dut->core_ace_rdata[i]);
-      }
-      std::print("\n");
-      dut->core_ace_rresp = 0;  // OKAY
-    } else {
-      std::print("Read from uninitialized memory at {:#010x}\n", araddr);
-      dut->core_ace_rresp = 2;  // SLVERR
-    }
-  }
+Tester::Tester(const std::vector<std::uint32_t>& text, std::uint32_t tohost) {
+  memory.write(0x80000000, reinterpret_cast<const std::uint8_t*>(text.data()), text.size() * 4);
+  memory.write32(tohost, 0);
+  memory.write32(0, rv::lui(1, 0x80000000));
+  memory.write32(4, rv::jalr(0, 1, 0));
+  tohost_addr = tohost;
+  kanata_log_enabled = false;
+  open_trace("text");
+  tohost_written = false;
 
-  auto bready = dut->core_ace_bready;
-  dut->core_ace_awready = 1;
-  dut->core_ace_wready = 1;
-  if (dut->core_ace_awvalid) {
-    auto awaddr = dut->core_ace_awaddr;
-    dut->core_ace_bvalid = 1;
-    auto ppn = awaddr & PAGE_NUMBER_MASK;
-    if (memory.contains(ppn)) {
-      std::print("awaddr: {:#010x}\n", awaddr);
-      std::print("wdata:");
-      auto offset = awaddr & PAGE_OFFSET_MASK & BLOCK_MASK;
-      for (int i = 0; i < BLOCK_BYTES; ++i) {
-        if ((dut->core_ace_wstrb >> i) & 1) {
-          memory[ppn][offset + i] = dut->core_ace_wdata[i / 4] >> (8 * (i % 4));
-        }
-        std::print(" {:#04x}", memory[ppn][offset + i]);
-      }
-      std::print("\n");
-      std::print("wstrb: {:#010x}\n", dut->core_ace_wstrb);
-    }
-  }
+  init_dut();
+}
+
+void Tester::step() {
+  memory.respond(dut);
 
   if (dut->core_lsu_store && (dut->core_lsu_addr == tohost_addr)) {
     tohost_written = true;
@@ -196,37 +242,59 @@ void Tester::step() {
     std::print("tohost written: {:#010x}\n", tohost_data);
   }
 
-  dut->clk = 0;
-  dut->eval();
-
-  // To observe the internal state of the DUT, we should do it between
-  // negedge evaluation and posedge evaluation
-
-  //  Update Kanata log
-  if (kanata_log_enabled) {
-    const char* kanata_log_buf;
-    svSetScope(svGetScopeFromName("TOP.offnariscv_core_wrap"));
-    dut->kanata_log_dut(&kanata_log_buf);
-    std::print(kanata_log,
-               "{}"
-               "C\t1\n",
-               kanata_log_buf);
+  std::uint64_t skip = 0;
+  if (fast_forward && dut->core_sleep && memory.idle(dut) &&
+      (dut->clint_mtimecmp != std::numeric_limits<std::uint64_t>::max()) &&
+      (dut->clint_mtimecmp > dut->clint_mtime + 1)) {
+    skip = dut->clint_mtimecmp - dut->clint_mtime - 1;  // mtime reaches mtimecmp at this edge
   }
+  dut->clint_skip = skip;
+  dut.kanata_cycles = 1 + skip;
 
-  dut->clk = 1;
-  dut->eval();
+  dut.step();
 
-  if (rready) {
-    dut->core_ace_rvalid = 0;
-  }
+  memory.retire(dut);
+  cycles += 1 + skip;
+  ++steps;
+}
 
-  if (bready) {
-    dut->core_ace_bvalid = 0;
-  }
+void Tester::print_tlb_stats() {
+  std::print("ITLB: {} hits, {} misses\n", dut->core_itlb_hits, dut->core_itlb_misses);
+  std::print("DTLB: {} hits, {} misses\n", dut->core_dtlb_hits, dut->core_dtlb_misses);
+}
+
+void Tester::print_commit_stats() {
+  std::print("Retired: {} instructions, {} fused pairs, IPC {:.3f}\n", dut->core_retired,
+             dut->core_fused, cycles ? static_cast<double>(dut->core_retired) / cycles : 0.0);
+}
+
+std::string Tester::check_golden() {
+  if (!golden) return "";
+  std::print("Golden trace: {} of {} instructions and {} stores checked\n", golden->checked(),
+             golden->instructions(), golden->stores_checked());
+  return golden->mismatch;
 }
 
-static int run_simulation(Tester& tester) {
-  for (int i = 0; i < 3000; ++i) {
+void Tester::print_fetch_stats() {
+  std::print("Fetch: {} instructions, {} L1I refills\n", dut->core_fetched, dut->core_l1i_refills);
+  std::print("Loop buffer: {} instructions in {} cycles\n", dut->core_loop_replayed,
+             dut->core_loop_cycles);
+}
+
+// Accuracy is the share of prefetched blocks that a load took, and coverage
+// the share of L1D load misses that the prefetch buffer served
+void Tester::print_prefetch_stats() {
+  auto fills = dut->core_prefetch_fills;
+  auto hits = dut->core_prefetch_hits;
+  auto misses = dut->core_load_misses;
+  std::print("Prefetch: {} blocks, {} taken, {} dropped; accuracy {:.1f}%, coverage {:.1f}%\n",
+             fills, hits, dut->core_prefetch_drops,
+             fills ? 100.0 * hits / fills : 0.0,
+             hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+}
+
+static int run_simulation(Tester& tester, int max_cycles) {
+  for (int i = 0; i < max_cycles; ++i) {
     if (tester.tohost_written) {
       return tester.tohost_data;
     }
@@ -235,14 +303,329 @@ static int run_simulation(Tester& tester) {
   return 0;
 }
 
-static int runner(const std::string& test) {
+// Timer interrupts from the CLINT: the program sleeps in WFI, and the handler
+// re-arms mtimecmp TIMER_DELAY cycles later, until it has run TIMER_TICKS
+// times and stores 1 to tohost. Almost all of the run is spent asleep.
+constexpr std::uint32_t CLINT_MTIMECMP = 0x02004000;
+constexpr std::uint32_t CLINT_MTIME = 0x0200bff8;
+constexpr std::uint32_t TIMER_TOHOST = 0x80001000;
+constexpr int TIMER_DELAY = 2000;
+constexpr int TIMER_TICKS = 8;
+
+static std::vector<std::uint32_t> build_timer_program() {
+  constexpr int T0 = 5, T2 = 7, T3 = 28, T5 = 30, T6 = 31, S0 = 8, S1 = 9, A0 = 10, A1 = 11;
+  constexpr int MSTATUS = 0x300, MIE = 0x304, MTVEC = 0x305;
+
+  std::vector<std::uint32_t> text;
+  text.resize(2);  // li t0, handler
+  text.push_back(rv::csrrw(0, MTVEC, T0));
+  rv::li(text, T5, CLINT_MTIMECMP);
+  rv::li(text, T3, CLINT_MTIME);
+  rv::li(text, T6, TIMER_DELAY);
+  rv::li(text, S1, TIMER_TICKS);
+  rv::li(text, A1, TIMER_TOHOST);
+  text.push_back(rv::mv(S0, 0));
+  text.push_back(rv::sw(0, T5, 4));  // mtime stays below 2^32, so clear the upper half first
+  text.push_back(rv::lw(T2, T3, 0));
+  text.push_back(rv::add(T2, T2, T6));
+  text.push_back(rv::sw(T2, T5, 0));
+  rv::li(text, T0, 1 << 7);  // MTIE
+  text.push_back(rv::csrrs(0, MIE, T0));
+  text.push_back(rv::csrrsi(0, MSTATUS, 1 << 3));  // MIE
+  auto sleep = text.size();
+  text.push_back(rv::wfi());
+  text.push_back(rv::j(4 * (static_cast<int>(sleep) - static_cast<int>(text.size()))));
+
+  auto handler = text.size();
+  text.push_back(rv::lw(T2, T5, 0));
+  text.push_back(rv::add(T2, T2, T6));
+  text.push_back(rv::sw(T2, T5, 0));
+  text.push_back(rv::addi(S0, S0, 1));
+  text.push_back(rv::bne(S0, S1, 4 * 4));
+  rv::li(text, A0, 1);
+  text.push_back(rv::sw(A0, A1, 0));
+  text.push_back(rv::mret());
+
+  std::vector<std::uint32_t> head;
+  rv::li(head, T0, 0x80000000 + 4 * static_cast<std::uint32_t>(handler));
+  std::copy(head.begin(), head.end(), text.begin());
+  return text;
+}
+
+// Code patching, as a JIT does: every iteration rewrites the immediate of an
+// instruction in the loop and runs it after a FENCE.I. Stores drop only the
+// patched block from the L1I, so the rest of the loop stays cached.
+// Stores 1 to tohost if the patched and the plain sums are both right, 3 otherwise.
+constexpr std::uint32_t PATCH_TOHOST = 0x80001000;
+constexpr int PATCH_ITERATIONS = 64;
+constexpr int PATCH_BODY = 48;  // Unpatched instructions in the loop, six blocks
+
+static std::vector<std::uint32_t> build_patch_program() {
+  constexpr int T1 = 6, T2 = 7, T3 = 28, T4 = 29, S0 = 8, S1 = 9, A0 = 10, A1 = 11, A2 = 12;
+
+  std::vector<std::uint32_t> text;
+  text.resize(2);  // li t3, patch
+  rv::li(text, T2, rv::addi(A0, A0, 0));
+  rv::li(text, S1, PATCH_ITERATIONS);
+  rv::li(text, A2, PATCH_TOHOST);
+  text.push_back(rv::mv(S0, 0));
+  text.push_back(rv::mv(A0, 0));
+  text.push_back(rv::mv(A1, 0));
+  auto loop = text.size();
+  text.push_back(rv::addi(S0, S0, 1));
+  text.push_back(rv::slli(T1, S0, 20));
+  text.push_back(rv::or_(T1, T1, T2));
+  text.push_back(rv::sw(T1, T3, 0));
+  text.push_back(rv::fence_i());
+  auto patch = text.size();
+  text.push_back(rv::addi(A0, A0, 0));  // addi a0, a0, s0 once patched
+  for (int i = 0; i < PATCH_BODY; ++i) text.push_back(rv::addi(A1, A1, 1));
+  text.push_back(rv::bne(S0, S1, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+
+  rv::li(text, T4, PATCH_ITERATIONS * (PATCH_ITERATIONS + 1) / 2);
+  text.push_back(rv::sub(T1, A0, T4));
+  rv::li(text, T4, PATCH_ITERATIONS * PATCH_BODY);
+  text.push_back(rv::sub(T4, A1, T4));
+  text.push_back(rv::or_(T1, T1, T4));
+  text.push_back(rv::sltu(T1, 0, T1));
+  text.push_back(rv::slli(T1, T1, 1));
+  text.push_back(rv::addi(T1, T1, 1));
+  text.push_back(rv::sw(T1, A2, 0));
+  text.push_back(rv::j(0));
+
+  std::vector<std::uint32_t> head;
+  rv::li(head, T3, 0x80000000 + 4 * static_cast<std::uint32_t>(patch));
+  std::copy(head.begin(), head.end(), text.begin());
+  return text;
+}
+
+// A tight counting loop, which the loop buffer should replay after two
+// iterations fetched by the IFU.
+// Stores 1 to tohost if both sums are right, 3 otherwise.
+constexpr std::uint32_t LOOP_TOHOST = 0x80001000;
+constexpr int LOOP_ITERATIONS = 256;
+
+static std::vector<std::uint32_t> build_loop_program() {
+  constexpr int T1 = 6, T4 = 29, S0 = 8, S1 = 9, A0 = 10, A1 = 11, A2 = 12;
+
+  std::vector<std::uint32_t> text;
+  rv::li(text, S1, LOOP_ITERATIONS);
+  rv::li(text, A2, LOOP_TOHOST);
+  text.push_back(rv::mv(S0, 0));
+  text.push_back(rv::mv(A0, 0));
+  text.push_back(rv::mv(A1, 0));
+  auto loop = text.size();
+  text.push_back(rv::addi(S0, S0, 1));
+  text.push_back(rv::add(A0, A0, S0));
+  text.push_back(rv::addi(A1, A1, 3));
+  text.push_back(rv::bne(S0, S1, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+
+  rv::li(text, T4, LOOP_ITERATIONS * (LOOP_ITERATIONS + 1) / 2);
+  text.push_back(rv::sub(T1, A0, T4));
+  rv::li(text, T4, LOOP_ITERATIONS * 3);
+  text.push_back(rv::sub(T4, A1, T4));
+  text.push_back(rv::or_(T1, T1, T4));
+  text.push_back(rv::sltu(T1, 0, T1));
+  text.push_back(rv::slli(T1, T1, 1));
+  text.push_back(rv::addi(T1, T1, 1));
+  text.push_back(rv::sw(T1, A2, 0));
+  text.push_back(rv::j(0));
+  return text;
+}
+
+// Sums a page of words, one load per iteration, so that every block but the
+// first few should come from the prefetch buffer.
+// Stores 1 to tohost if the sum is right, 3 otherwise.
+constexpr std::uint32_t STREAM_TOHOST = 0x80001000;
+constexpr std::uint32_t STREAM_DATA = 0x80002000;
+constexpr int STREAM_WORDS = 1024;
+constexpr int STREAM_BLOCKS = STREAM_WORDS * 4 / 32;
+
+static std::vector<std::uint32_t> build_stream_program() {
+  constexpr int T0 = 5, T1 = 6, T2 = 7, T4 = 29, A0 = 10, A2 = 12, A3 = 13;
+
+  std::vector<std::uint32_t> text;
+  rv::li(text, A2, STREAM_TOHOST);
+  rv::li(text, A3, STREAM_DATA);
+  rv::li(text, T2, STREAM_DATA + 4 * STREAM_WORDS);
+  text.push_back(rv::mv(A0, 0));
+  auto loop = text.size();
+  text.push_back(rv::lw(T0, A3, 0));
+  text.push_back(rv::add(A0, A0, T0));
+  text.push_back(rv::addi(A3, A3, 4));
+  text.push_back(rv::bne(A3, T2, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+
+  rv::li(text, T4, STREAM_WORDS * (STREAM_WORDS - 1) / 2);
+  text.push_back(rv::sub(T1, A0, T4));
+  text.push_back(rv::sltu(T1, 0, T1));
+  text.push_back(rv::slli(T1, T1, 1));
+  text.push_back(rv::addi(T1, T1, 1));
+  text.push_back(rv::sw(T1, A2, 0));
+  text.push_back(rv::j(0));
+
+  // The data follows the code in the same image; word i holds i
+  text.resize((STREAM_DATA - 0x80000000) / 4, 0);
+  for (int i = 0; i < STREAM_WORDS; ++i) text.push_back(static_cast<std::uint32_t>(i));
+  return text;
+}
+
+// Repeats one load or store ACCESS_ITERS times, aligned, misaligned within a
+// block and across two blocks, to show what the LSU charges for misaligned
+// accesses. Loads sum what they read; stores read the last value (1) back.
+// Stores 1 to tohost if that is `expected`, 3 otherwise.
+constexpr std::uint32_t ACCESS_TOHOST = 0x80001000;
+constexpr std::uint32_t ACCESS_DATA = 0x80002000;
+constexpr int ACCESS_ITERS = 64;
+constexpr int ACCESS_WORDS = 16;
+
+enum class Access { LW, LH, SW, SH };
+
+// Value of the `size` bytes at ACCESS_DATA + offset; word i holds i + 1
+static std::uint32_t access_data(int offset, int size) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    int addr = offset + i;
+    std::uint32_t byte = ((addr / 4 + 1) >> (8 * (addr % 4))) & 0xff;
+    value |= byte << (8 * i);
+  }
+  return value;
+}
+
+static std::vector<std::uint32_t> build_access_program(Access access, int offset,
+                                                       std::uint32_t expected) {
+  constexpr int T0 = 5, T1 = 6, T4 = 29, S0 = 8, A2 = 12, A3 = 13;
+
+  std::vector<std::uint32_t> text;
+  rv::li(text, A2, ACCESS_TOHOST);
+  rv::li(text, A3, ACCESS_DATA);
+  rv::li(text, T0, ACCESS_ITERS);
+  text.push_back(rv::mv(S0, 0));
+  auto loop = text.size();
+  switch (access) {
+    case Access::LW:
+      text.push_back(rv::lw(T4, A3, offset));
+      text.push_back(rv::add(S0, S0, T4));
+      break;
+    case Access::LH:
+      text.push_back(rv::lh(T4, A3, offset));
+      text.push_back(rv::add(S0, S0, T4));
+      break;
+    case Access::SW:
+      text.push_back(rv::sw(T0, A3, offset));
+      break;
+    case Access::SH:
+      text.push_back(rv::sh(T0, A3, offset));
+      break;
+  }
+  text.push_back(rv::addi(T0, T0, -1));
+  text.push_back(rv::bne(T0, 0, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+  if (access == Access::SW) {
+    text.push_back(rv::lw(S0, A3, offset));
+  } else if (access == Access::SH) {
+    text.push_back(rv::lhu(S0, A3, offset));
+  }
+
+  rv::li(text, T4, expected);
+  text.push_back(rv::sub(T1, S0, T4));
+  text.push_back(rv::sltu(T1, 0, T1));
+  text.push_back(rv::slli(T1, T1, 1));
+  text.push_back(rv::addi(T1, T1, 1));
+  text.push_back(rv::sw(T1, A2, 0));
+  text.push_back(rv::j(0));
+
+  text.resize((ACCESS_DATA - 0x80000000) / 4, 0);
+  for (int i = 0; i < ACCESS_WORDS; ++i) text.push_back(static_cast<std::uint32_t>(i + 1));
+  return text;
+}
+
+// Folds BITMANIP_WORDS array elements into a rotating popcount checksum and a
+// running unsigned maximum, once with RV32I only and once with Zba/Zbb
+// (sh2add, cpop, rori, maxu).
+// Stores 1 to tohost if the checksum is right, 3 otherwise.
+constexpr std::uint32_t BITMANIP_TOHOST = 0x80001000;
+constexpr std::uint32_t BITMANIP_DATA = 0x80002000;
+constexpr int BITMANIP_WORDS = 256;
+
+static std::uint32_t bitmanip_checksum() {
+  std::uint32_t sum = 0, max = 0;
+  for (std::uint32_t x = BITMANIP_WORDS; x > 0; --x) {  // Element i holds i + 1
+    sum = std::rotr(sum, 1) + std::popcount(x);
+    max = std::max(max, x);
+  }
+  return sum ^ max;
+}
+
+static std::vector<std::uint32_t> build_bitmanip_program(bool zb) {
+  constexpr int T0 = 5, T1 = 6, T2 = 7, T3 = 28, T4 = 29, T6 = 31, S0 = 8, S1 = 9, A2 = 12,
+                A3 = 13;
+
+  std::vector<std::uint32_t> text;
+  rv::li(text, A2, BITMANIP_TOHOST);
+  rv::li(text, A3, BITMANIP_DATA);
+  rv::li(text, T0, BITMANIP_WORDS);
+  text.push_back(rv::mv(S0, 0));
+  text.push_back(rv::mv(S1, 0));
+  auto loop = text.size();
+  if (zb) {
+    text.push_back(rv::sh2add(T4, T0, A3));
+    text.push_back(rv::lw(T4, T4, -4));
+    text.push_back(rv::cpop(T6, T4));
+    text.push_back(rv::rori(S0, S0, 1));
+    text.push_back(rv::add(S0, S0, T6));
+    text.push_back(rv::maxu(S1, S1, T4));
+  } else {
+    text.push_back(rv::slli(T4, T0, 2));
+    text.push_back(rv::add(T4, T4, A3));
+    text.push_back(rv::lw(T4, T4, -4));
+    // Popcount by clearing the lowest set bit until none is left
+    text.push_back(rv::mv(T2, T4));
+    text.push_back(rv::mv(T6, 0));
+    auto pop = text.size();
+    text.push_back(rv::beq(T2, 0, 4 * 5));
+    text.push_back(rv::addi(T3, T2, -1));
+    text.push_back(rv::and_(T2, T2, T3));
+    text.push_back(rv::addi(T6, T6, 1));
+    text.push_back(rv::j(4 * (static_cast<int>(pop) - static_cast<int>(text.size()))));
+    text.push_back(rv::srli(T2, S0, 1));
+    text.push_back(rv::slli(T3, S0, 31));
+    text.push_back(rv::or_(S0, T2, T3));
+    text.push_back(rv::add(S0, S0, T6));
+    text.push_back(rv::bgeu(S1, T4, 4 * 2));
+    text.push_back(rv::mv(S1, T4));
+  }
+  text.push_back(rv::addi(T0, T0, -1));
+  text.push_back(rv::bne(T0, 0, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+  text.push_back(rv::xor_(S0, S0, S1));
+
+  rv::li(text, T4, bitmanip_checksum());
+  text.push_back(rv::sub(T1, S0, T4));
+  text.push_back(rv::sltu(T1, 0, T1));
+  text.push_back(rv::slli(T1, T1, 1));
+  text.push_back(rv::addi(T1, T1, 1));
+  text.push_back(rv::sw(T1, A2, 0));
+  text.push_back(rv::j(0));
+
+  text.resize((BITMANIP_DATA - 0x80000000) / 4, 0);
+  for (int i = 0; i < BITMANIP_WORDS; ++i) text.push_back(static_cast<std::uint32_t>(i + 1));
+  return text;
+}
+
+// The -v variants boot a page table and run the test in user mode, so they
+// take many more cycles than the -p ones
+static int runner(const std::string& test, int max_cycles = 3000) {
   std::print(
       "-------------------------------------------------------------------------------\n");
   std::print("{}\n", test);
   std::print(
       "-------------------------------------------------------------------------------\n");
   Tester tester(test);
-  auto return_code = run_simulation(tester);
+  auto return_code = run_simulation(tester, max_cycles);
+  tester.print_tlb_stats();
+  tester.print_fetch_stats();
+  tester.print_prefetch_stats();
+  tester.print_commit_stats();
+  tester.print_run_stats();
+  CHECK(tester.check_golden() == "");
   if (return_code == 1) {
     std::print("Test for {} passed!\n", test);
   } else {
@@ -415,6 +798,259 @@ TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-p-xori") {
   REQUIRE(runner("rv32ui-p-xori") == 1);
 }
 
-// TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-p-ma_data", "[ma_data]") {
-//   REQUIRE(runner("rv32ui-p-ma_data") == 1);
-// }
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uc-p-rvc") {
+  REQUIRE(runner("rv32uc-p-rvc") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amoadd_w") {
+  REQUIRE(runner("rv32ua-p-amoadd_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amoand_w") {
+  REQUIRE(runner("rv32ua-p-amoand_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amomax_w") {
+  REQUIRE(runner("rv32ua-p-amomax_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amomaxu_w") {
+  REQUIRE(runner("rv32ua-p-amomaxu_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amomin_w") {
+  REQUIRE(runner("rv32ua-p-amomin_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amominu_w") {
+  REQUIRE(runner("rv32ua-p-amominu_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amoor_w") {
+  REQUIRE(runner("rv32ua-p-amoor_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amoswap_w") {
+  REQUIRE(runner("rv32ua-p-amoswap_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-amoxor_w") {
+  REQUIRE(runner("rv32ua-p-amoxor_w") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ua-p-lrsc") {
+  REQUIRE(runner("rv32ua-p-lrsc", 100000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-v-simple") {
+  REQUIRE(runner("rv32ui-v-simple", 1000000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-v-add") {
+  REQUIRE(runner("rv32ui-v-add", 1000000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-v-jal") {
+  REQUIRE(runner("rv32ui-v-jal", 1000000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-v-lw") {
+  REQUIRE(runner("rv32ui-v-lw", 1000000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-v-sw") {
+  REQUIRE(runner("rv32ui-v-sw", 1000000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32ui-p-ma_data") {
+  REQUIRE(runner("rv32ui-p-ma_data", 10000) == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzba-p-sh1add") {
+  REQUIRE(runner("rv32uzba-p-sh1add") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzba-p-sh2add") {
+  REQUIRE(runner("rv32uzba-p-sh2add") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzba-p-sh3add") {
+  REQUIRE(runner("rv32uzba-p-sh3add") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-andn") {
+  REQUIRE(runner("rv32uzbb-p-andn") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-clz") {
+  REQUIRE(runner("rv32uzbb-p-clz") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-cpop") {
+  REQUIRE(runner("rv32uzbb-p-cpop") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-ctz") {
+  REQUIRE(runner("rv32uzbb-p-ctz") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-max") {
+  REQUIRE(runner("rv32uzbb-p-max") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-maxu") {
+  REQUIRE(runner("rv32uzbb-p-maxu") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-min") {
+  REQUIRE(runner("rv32uzbb-p-min") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-minu") {
+  REQUIRE(runner("rv32uzbb-p-minu") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-orc_b") {
+  REQUIRE(runner("rv32uzbb-p-orc_b") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-orn") {
+  REQUIRE(runner("rv32uzbb-p-orn") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-rev8") {
+  REQUIRE(runner("rv32uzbb-p-rev8") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-rol") {
+  REQUIRE(runner("rv32uzbb-p-rol") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-ror") {
+  REQUIRE(runner("rv32uzbb-p-ror") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-rori") {
+  REQUIRE(runner("rv32uzbb-p-rori") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-sext_b") {
+  REQUIRE(runner("rv32uzbb-p-sext_b") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-sext_h") {
+  REQUIRE(runner("rv32uzbb-p-sext_h") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-xnor") {
+  REQUIRE(runner("rv32uzbb-p-xnor") == 1);
+}
+
+TEST_CASE("offnariscv_core/riscv-tests/isa/rv32uzbb-p-zext_h") {
+  REQUIRE(runner("rv32uzbb-p-zext_h") == 1);
+}
+
+TEST_CASE("offnariscv_core/clint timer fast-forward") {
+  auto text = build_timer_program();
+  std::print("{:>12} {:>8} {:>8} {:>12}\n", "fast-forward", "cycles", "steps", "cycles/step");
+  std::uint64_t slow_steps = 0;
+  for (bool fast_forward : {false, true}) {
+    Tester tester(text, TIMER_TOHOST);
+    tester.fast_forward = fast_forward;
+    REQUIRE(run_simulation(tester, 4 * TIMER_TICKS * TIMER_DELAY) == 1);
+    CHECK(tester.cycles >= TIMER_TICKS * TIMER_DELAY);
+    if (fast_forward) {
+      CHECK(tester.steps * 10 < slow_steps);
+    } else {
+      slow_steps = tester.steps;
+    }
+    std::print("{:>12} {:>8} {:>8} {:>12.1f}\n", fast_forward ? "on" : "off", tester.cycles,
+               tester.steps, static_cast<double>(tester.cycles) / tester.steps);
+  }
+}
+
+TEST_CASE("offnariscv_core/code patching") {
+  Tester tester(build_patch_program(), PATCH_TOHOST);
+  REQUIRE(run_simulation(tester, 100000) == 1);
+  tester.print_fetch_stats();
+  tester.print_commit_stats();
+  std::print("{:.1f} cycles and {:.2f} L1I refills per patch\n",
+             static_cast<double>(tester.cycles) / PATCH_ITERATIONS,
+             static_cast<double>(tester.l1i_refills()) / PATCH_ITERATIONS);
+  // Flushing the L1I on FENCE.I refilled every block of the loop each time;
+  // only the patched one should be, plus a refill that fetch-ahead may waste
+  CHECK(tester.l1i_refills() < 3 * PATCH_ITERATIONS);
+}
+
+TEST_CASE("offnariscv_core/loop buffer") {
+  Tester tester(build_loop_program(), LOOP_TOHOST);
+  REQUIRE(run_simulation(tester, 20000) == 1);
+  tester.print_fetch_stats();
+  tester.print_commit_stats();
+  std::print("{:.2f} cycles per iteration\n",
+             static_cast<double>(tester.cycles) / LOOP_ITERATIONS);
+  // Every iteration after the two that capture the loop comes from the buffer
+  CHECK(tester.loop_replayed() >= 4 * (LOOP_ITERATIONS - 2));
+}
+
+TEST_CASE("offnariscv_core/stride prefetcher") {
+  Tester tester(build_stream_program(), STREAM_TOHOST);
+  REQUIRE(run_simulation(tester, 40000) == 1);
+  tester.print_prefetch_stats();
+  tester.print_commit_stats();
+  std::print("{:.2f} cycles per load\n", static_cast<double>(tester.cycles) / STREAM_WORDS);
+  // The stride is learnt within the first blocks; the rest are prefetched
+  // one block ahead of the loads
+  CHECK(tester.prefetch_hits() * 2 >= STREAM_BLOCKS);
+}
+
+TEST_CASE("offnariscv_core/misaligned access cost") {
+  std::print("{:>4} {:>10} {:>6} {:>8} {:>11} {:>12}\n", "op", "placement", "offset", "cycles",
+             "cycles/iter", "vs. aligned");
+  for (auto [access, name] : {std::pair{Access::LW, "lw"}, std::pair{Access::LH, "lh"},
+                              std::pair{Access::SW, "sw"}, std::pair{Access::SH, "sh"}}) {
+    std::uint64_t aligned_cycles = 0;
+    for (auto [offset, placement] :
+         {std::pair{0, "aligned"}, std::pair{1, "in block"}, std::pair{31, "crossing"}}) {
+      std::uint32_t expected = 1;
+      if (access == Access::LW) {
+        expected = ACCESS_ITERS * access_data(offset, 4);
+      } else if (access == Access::LH) {
+        expected = ACCESS_ITERS * static_cast<std::uint32_t>(
+                                      static_cast<std::int16_t>(access_data(offset, 2)));
+      }
+      Tester tester(build_access_program(access, offset, expected), ACCESS_TOHOST);
+      REQUIRE(run_simulation(tester, 20000) == 1);
+      if (offset == 0) aligned_cycles = tester.cycles;
+      std::print("{:>4} {:>10} {:>6} {:>8} {:>11.2f} {:>+12.2f}\n", name, placement, offset,
+                 tester.cycles, static_cast<double>(tester.cycles) / ACCESS_ITERS,
+                 (static_cast<double>(tester.cycles) - aligned_cycles) / ACCESS_ITERS);
+    }
+  }
+}
+
+TEST_CASE("offnariscv_core/bit-manipulation kernel") {
+  std::print("{:>7} {:>8} {:>8} {:>6} {:>10} {:>10}\n", "isa", "cycles", "retired", "IPC",
+             "cycles/elt", "insts/elt");
+  std::uint64_t base_cycles = 0, base_retired = 0;
+  for (bool zb : {false, true}) {
+    Tester tester(build_bitmanip_program(zb), BITMANIP_TOHOST);
+    REQUIRE(run_simulation(tester, 40000) == 1);
+    auto cycles = tester.cycles;
+    auto retired = tester.retired();
+    if (!zb) {
+      base_cycles = cycles;
+      base_retired = retired;
+    }
+    std::print("{:>7} {:>8} {:>8} {:>6.3f} {:>10.2f} {:>10.2f}\n", zb ? "zba/zbb" : "rv32i",
+               cycles, retired, static_cast<double>(retired) / cycles,
+               static_cast<double>(cycles) / BITMANIP_WORDS,
+               static_cast<double>(retired) / BITMANIP_WORDS);
+    if (zb) {
+      std::print("reduction: {:.1f}% instructions, {:.1f}% cycles\n",
+                 100.0 * (1.0 - static_cast<double>(retired) / base_retired),
+                 100.0 * (1.0 - static_cast<double>(cycles) / base_cycles));
+      CHECK(retired < base_retired);
+    }
+  }
+}
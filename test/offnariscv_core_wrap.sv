@@ -3,7 +3,12 @@
 module offnariscv_core_wrap
   import offnariscv_pkg::*;
 #(
-    localparam ACE_XDATA_WIDTH  = 256,
+    parameter ISSUE_WIDTH = 1,
+    parameter MHARTID = 0,
+    parameter EXTERNAL_CLINT = 0,  // Bring the CLINT port out instead of a private CLINT
+    parameter SYNC_READ = 0,  // L1 caches on synchronous-read RAMs
+    localparam BLOCK_SIZE = 256,
+    localparam ACE_XDATA_WIDTH = 64,  // A block moves in four beats
     localparam ACE_AXADDR_WIDTH = 32
 ) (
     input clk,
@@ -76,12 +81,64 @@ module offnariscv_core_wrap
 
     output [XLEN-1:0] core_lsu_addr,
     output [XLEN-1:0] core_lsu_wdata,
-    output core_lsu_store
+    output core_lsu_store,
+
+    output core_commit_valid,
+    output [XLEN-1:0] core_commit_pc,
+    output [INST_ID_WIDTH-1:0] core_commit_id,
+    output [4:0] core_commit_rd,
+    output [XLEN-1:0] core_commit_wdata,
+
+    // The first instruction of a fused op, which retires just before the one
+    // on core_commit_*; those then describe the second instruction
+    output core_commit_fused,
+    output [XLEN-1:0] core_commit_fused_pc,
+    output [4:0] core_commit_fused_rd,
+    output [XLEN-1:0] core_commit_fused_wdata,
+
+    // Second retirement lane; only ever valid together with, and younger than, the first
+    output core_commit1_valid,
+    output [XLEN-1:0] core_commit1_pc,
+    output [4:0] core_commit1_rd,
+    output [XLEN-1:0] core_commit1_wdata,
+
+    // CLINT port, only used with EXTERNAL_CLINT
+    output core_clint_valid,
+    output core_clint_write,
+    output [CLINT_ADDR_WIDTH-1:0] core_clint_addr,
+    output [XLEN-1:0] core_clint_wdata,
+    output [XLEN/8-1:0] core_clint_wstrb,
+    input [XLEN-1:0] core_clint_rdata,
+    input core_clint_mtip,
+    input core_clint_msip,
+
+    // For fast-forwarding through WFI; the private CLINT only
+    input [63:0] clint_skip,
+    output [63:0] clint_mtime,
+    output [63:0] clint_mtimecmp,
+    output core_sleep,  // A WFI waits for an interrupt at the head of the pipeline
+
+    output [63:0] core_retired,  // Instructions, both halves of a fused op included
+    output [63:0] core_fused,  // Fused ops retired
+    output [63:0] core_fetched,  // Instructions delivered by the IFU
+    output [63:0] core_l1i_refills,
+    output [63:0] core_loop_cycles,  // Cycles the loop buffer served the decoder
+    output [63:0] core_loop_replayed,  // ... and the instructions it replayed in them
+    output [63:0] core_load_misses,  // Loads that read their line over the bus
+    output [63:0] core_prefetch_fills,  // Blocks the LSU prefetched
+    output [63:0] core_prefetch_hits,  // ... that a load missing the L1D took
+    output [63:0] core_prefetch_drops,  // Prefetches dropped for a demand read
+
+    output [63:0] core_itlb_hits,
+    output [63:0] core_itlb_misses,
+    output [63:0] core_dtlb_hits,
+    output [63:0] core_dtlb_misses
 );
 
-  ace_if core_ace_if ();
-  ace_if ifu_ace_if ();
-  ace_if lsu_ace_if ();
+  ace_if #(.ACE_XDATA_WIDTH(ACE_XDATA_WIDTH)) core_ace_if ();
+  ace_if #(.ACE_XDATA_WIDTH(ACE_XDATA_WIDTH)) ifu_ace_if ();
+  ace_if #(.ACE_XDATA_WIDTH(ACE_XDATA_WIDTH)) lsu_ace_if ();
+  ace_if #(.ACE_XDATA_WIDTH(ACE_XDATA_WIDTH)) ptw_ace_if ();
 
   assign core_ace_awid = core_ace_if.awid;
   assign core_ace_awaddr = core_ace_if.awaddr;
@@ -148,27 +205,126 @@ module offnariscv_core_wrap
   assign core_ace_rack = core_ace_if.rack;
   assign core_ace_wack = core_ace_if.wack;
 
+  clint_if core_clint_if ();
+
+  assign core_clint_valid = core_clint_if.valid;
+  assign core_clint_write = core_clint_if.write;
+  assign core_clint_addr = core_clint_if.addr;
+  assign core_clint_wdata = core_clint_if.wdata;
+  assign core_clint_wstrb = core_clint_if.wstrb;
+  assign core_sleep = offnariscv_core_inst.committer_inst.wfi_stall;
+
+  if (EXTERNAL_CLINT) begin : gen_external_clint
+    assign core_clint_if.rdata = core_clint_rdata;
+    assign core_clint_if.mtip = core_clint_mtip;
+    assign core_clint_if.msip = core_clint_msip;
+    assign clint_mtime = '0;
+    assign clint_mtimecmp = '1;
+  end else begin : gen_clint
+    clint_if clint_ifs[1] ();
+
+    assign clint_ifs[0].valid = core_clint_if.valid;
+    assign clint_ifs[0].write = core_clint_if.write;
+    assign clint_ifs[0].addr = core_clint_if.addr;
+    assign clint_ifs[0].wdata = core_clint_if.wdata;
+    assign clint_ifs[0].wstrb = core_clint_if.wstrb;
+    assign core_clint_if.rdata = clint_ifs[0].rdata;
+    assign core_clint_if.mtip = clint_ifs[0].mtip;
+    assign core_clint_if.msip = clint_ifs[0].msip;
+    assign clint_mtime = clint_inst.mtime_q;
+    assign clint_mtimecmp = clint_inst.mtimecmp_q[0];
+
+    clint #(
+        .NUM_HARTS(1)
+    ) clint_inst (
+        .clk(clk),
+        .rst(rst),
+        .clint_rsp_if(clint_ifs),
+        .skip(clint_skip)
+    );
+  end
+
   lsuwb_tdata_t lsuwb_tdata;
   assign lsuwb_tdata = offnariscv_core_inst.lsuwb_axis_if.tdata;
   assign core_lsu_addr = lsuwb_tdata.addr;
   assign core_lsu_wdata = lsuwb_tdata.wdata;
-  assign core_lsu_store = lsuwb_tdata.store && offnariscv_core_inst.lsuwb_axis_if.tvalid;
+  // Once per store, as it is handed over
+  assign core_lsu_store = lsuwb_tdata.store && offnariscv_core_inst.lsuwb_axis_if.tvalid &&
+      offnariscv_core_inst.lsuwb_axis_if.tready;
+
+  // Past the decoder, the payloads only carry a tag of what it recorded
+  function automatic inst_info_t inst_info(logic [INST_TAG_WIDTH-1:0] tag);
+    return offnariscv_core_inst.decoder_inst.inst_info_mem[tag];
+  endfunction
+
+  wbrf_tdata_t commit_tdata;
+  assign commit_tdata = offnariscv_core_inst.wbrf_axis_if.tdata;
+  assign core_commit_valid = offnariscv_core_inst.wbrf_axis_if.ack();
+  assign core_commit_pc = core_commit_fused ? offnariscv_core_inst.committer_inst.fused_pc :
+      commit_tdata.ex_data.pc;
+  assign core_commit_id = inst_info(commit_tdata.ex_data.tag).id;
+  assign core_commit_rd = (core_commit_fused && offnariscv_core_inst.committer_inst.trap) ? '0 :
+      commit_tdata.ex_data.rd;
+  assign core_commit_wdata = commit_tdata.wdata;
+
+  assign core_commit_fused = core_commit_valid && commit_tdata.ex_data.fused;
+  assign core_commit_fused_pc = commit_tdata.ex_data.pc;
+  assign core_commit_fused_rd = commit_tdata.ex_data.rd;
+  assign core_commit_fused_wdata = (commit_tdata.ex_data.alu_cmd_vld &&
+                                    (commit_tdata.ex_data.alu_cmd == AND)) ?
+      commit_tdata.wdata << commit_tdata.ex_data.fused_shamt : commit_tdata.ex_data.fused_rd_data;
+
+  wbrf_tdata_t commit1_tdata;
+  assign commit1_tdata = offnariscv_core_inst.wbrf1_axis_if.tdata;
+  assign core_commit1_valid = offnariscv_core_inst.wbrf1_axis_if.ack();
+  assign core_commit1_pc = commit1_tdata.ex_data.pc;
+  assign core_commit1_rd = commit1_tdata.ex_data.rd;
+  assign core_commit1_wdata = commit1_tdata.wdata;
+
+  assign core_retired = offnariscv_core_inst.committer_inst.retired_count_q;
+  assign core_fused = offnariscv_core_inst.committer_inst.fused_count_q;
+  assign core_fetched = offnariscv_core_inst.ifu_inst.fetch_count_q;
+  assign core_l1i_refills = offnariscv_core_inst.ifu_inst.refill_count_q;
+  assign core_loop_cycles = offnariscv_core_inst.loop_buffer_inst.replay_cycle_count_q;
+  assign core_loop_replayed = offnariscv_core_inst.loop_buffer_inst.replay_count_q;
+  assign core_load_misses = offnariscv_core_inst.lsu_inst.load_miss_count_q;
+  assign core_prefetch_fills = offnariscv_core_inst.lsu_inst.pf_fill_count_q;
+  assign core_prefetch_hits = offnariscv_core_inst.lsu_inst.pf_hit_count_q;
+  assign core_prefetch_drops = offnariscv_core_inst.lsu_inst.pf_drop_count_q;
+
+  assign core_itlb_hits = offnariscv_core_inst.l1itlb_inst.hit_count_q;
+  assign core_itlb_misses = offnariscv_core_inst.l1itlb_inst.miss_count_q;
+  assign core_dtlb_hits = offnariscv_core_inst.l1dtlb_inst.hit_count_q;
+  assign core_dtlb_misses = offnariscv_core_inst.l1dtlb_inst.miss_count_q;
+
+  logic demand_busy;
 
   offnariscv_core #(
-      .RESET_VECTOR(0)
+      .RESET_VECTOR(0),
+      .ISSUE_WIDTH (ISSUE_WIDTH),
+      .MHARTID     (MHARTID),
+      .BLOCK_SIZE  (BLOCK_SIZE),
+      .SYNC_READ   (SYNC_READ)
   ) offnariscv_core_inst (
       .clk(clk),
       .rst(rst),
       .ifu_ace_if(ifu_ace_if),
-      .lsu_ace_if(lsu_ace_if)
+      .lsu_ace_if(lsu_ace_if),
+      .ptw_ace_if(ptw_ace_if),
+      .clint_if(core_clint_if),
+      .demand_busy(demand_busy)
   );
 
-  core_arbiter core_arbiter_inst (
+  core_arbiter #(
+      .BLOCK_SIZE(BLOCK_SIZE)
+  ) core_arbiter_inst (
       .clk(clk),
       .rst(rst),
       .ifu_ace_if(ifu_ace_if),
       .lsu_ace_if(lsu_ace_if),
-      .core_ace_if(core_ace_if)
+      .ptw_ace_if(ptw_ace_if),
+      .core_ace_if(core_ace_if),
+      .demand_busy(demand_busy)
   );
 
   logic wbpcg_prev_ack;
@@ -178,13 +334,21 @@ module offnariscv_core_wrap
   logic rfex_prev_ack;
   logic exwb_prev_ack;
   logic wbrf_prev_ack;
+  logic rfex1_prev_ack;
+  logic exwb1_prev_ack;
+  logic wbrf1_prev_ack;
   pcgif_tdata_t pcgif_prev_tdata;
   ifid_tdata_t ifid_prev_tdata;
   idrf_tdata_t idrf_prev_tdata;
   rfex_tdata_t rfex_prev_tdata;
   exwb_tdata_t exwb_prev_tdata;
   wbrf_tdata_t wbrf_prev_tdata;
+  rfex_tdata_t rfex1_prev_tdata;
+  exwb_tdata_t exwb1_prev_tdata;
+  wbrf_tdata_t wbrf1_prev_tdata;
   logic prev_invalidate;
+  logic prev_fe_invalidate;
+  logic [INST_ID_WIDTH-1:0] redirect_id;
   always_ff @(posedge clk) begin
     if (rst) begin
       wbpcg_prev_ack <= '0;
@@ -201,22 +365,42 @@ module offnariscv_core_wrap
       rfex_prev_tdata <= '0;
       exwb_prev_tdata <= '0;
       wbrf_prev_tdata <= '0;
+      rfex1_prev_ack <= '0;
+      exwb1_prev_ack <= '0;
+      wbrf1_prev_ack <= '0;
+      rfex1_prev_tdata <= '0;
+      exwb1_prev_tdata <= '0;
+      wbrf1_prev_tdata <= '0;
       prev_invalidate <= '0;
+      prev_fe_invalidate <= '0;
+      redirect_id <= '0;
     end else begin
-      wbpcg_prev_ack <= offnariscv_core_inst.wbpcg_axis_if.ack() || offnariscv_core_inst.pcgif_axis_if.ack();
+      wbpcg_prev_ack <= offnariscv_core_inst.wbpcg_axis_if.ack() || offnariscv_core_inst.idpcg_axis_if.ack() || offnariscv_core_inst.pcgif_axis_if.ack();
       pcgif_prev_ack <= offnariscv_core_inst.pcgif_axis_if.ack();
-      ifid_prev_ack <= offnariscv_core_inst.ifu_inst.ifid_pipe_reg_if.ack();
+      ifid_prev_ack <= offnariscv_core_inst.ifu_inst.ifid_pipe_reg_if.ack() ||
+          (offnariscv_core_inst.loop_buffer_inst.replay_q && offnariscv_core_inst.ifid_axis_if.ack());
       idrf_prev_ack <= offnariscv_core_inst.decoder_inst.idrf_fifo_if.ack();
       rfex_prev_ack <= offnariscv_core_inst.regfile_inst.rfex_slice_if.ack();
       exwb_prev_ack <= offnariscv_core_inst.dispatcher_inst.exwb_slice_if.ack();
       wbrf_prev_ack <= offnariscv_core_inst.wbrf_axis_if.ack();
       pcgif_prev_tdata <= offnariscv_core_inst.pcgif_axis_if.tdata;
-      ifid_prev_tdata <= offnariscv_core_inst.ifu_inst.ifid_pipe_reg_if.tdata;
+      ifid_prev_tdata <= offnariscv_core_inst.loop_buffer_inst.replay_q ?
+          offnariscv_core_inst.ifid_axis_if.tdata : offnariscv_core_inst.ifu_inst.ifid_pipe_reg_if.tdata;
       idrf_prev_tdata <= offnariscv_core_inst.decoder_inst.idrf_fifo_if.tdata;
       rfex_prev_tdata <= offnariscv_core_inst.regfile_inst.rfex_slice_if.tdata;
       exwb_prev_tdata <= offnariscv_core_inst.dispatcher_inst.exwb_slice_if.tdata;
       wbrf_prev_tdata <= offnariscv_core_inst.wbrf_axis_if.tdata;
+      rfex1_prev_ack <= offnariscv_core_inst.regfile_inst.rfex1_slice_if.ack();
+      exwb1_prev_ack <= offnariscv_core_inst.dispatcher_inst.exwb1_slice_if.ack();
+      wbrf1_prev_ack <= offnariscv_core_inst.wbrf1_axis_if.ack();
+      rfex1_prev_tdata <= offnariscv_core_inst.regfile_inst.rfex1_slice_if.tdata;
+      exwb1_prev_tdata <= offnariscv_core_inst.dispatcher_inst.exwb1_slice_if.tdata;
+      wbrf1_prev_tdata <= offnariscv_core_inst.wbrf1_axis_if.tdata;
       prev_invalidate <= offnariscv_core_inst.invalidate;
+      prev_fe_invalidate <= offnariscv_core_inst.idpcg_axis_if.ack() && !offnariscv_core_inst.invalidate;
+      if (offnariscv_core_inst.idpcg_axis_if.ack())
+        redirect_id <= offnariscv_core_inst.decoder_inst.ifid_tdata.pcg_data.id;
+`ifndef OFFNARISCV_QUIET
       $write("pcgif:\ttvalid=%0d, tready=%0d, ack=%0d, pc=%08h, id=%0d\n",
              offnariscv_core_inst.pcgif_axis_if.tvalid, offnariscv_core_inst.pcgif_axis_if.tready,
              offnariscv_core_inst.pcgif_axis_if.ack(),
@@ -236,29 +420,29 @@ module offnariscv_core_wrap
       $write("idrf:\t\ttvalid=%0d, tready=%0d, ack=%0d, pc=%08h, id=%0d\n",
              offnariscv_core_inst.idrf_axis_if.tvalid, offnariscv_core_inst.idrf_axis_if.tready,
              offnariscv_core_inst.idrf_axis_if.ack(),
-             offnariscv_core_inst.idrf_axis_if.tdata[127-:XLEN],
-             offnariscv_core_inst.idrf_axis_if.tdata[63:0]);
+             idrf_tdata_t'(offnariscv_core_inst.idrf_axis_if.tdata).pc,
+             inst_info(idrf_tdata_t'(offnariscv_core_inst.idrf_axis_if.tdata).tag).id);
       $write(
           "rfex:\t\ttvalid=%0d, tready=%0d, ack=%0d, pc=%08h, alu.op1=%016h, alu.op2=%016h, bru.op1=%016h, bru.op2=%016h, id=%0d\n",
           offnariscv_core_inst.rfex_axis_if.tvalid, offnariscv_core_inst.rfex_axis_if.tready,
           offnariscv_core_inst.rfex_axis_if.ack(),
-          offnariscv_core_inst.rfex_axis_if.tdata[127-:XLEN],
+          rfex_tdata_t'(offnariscv_core_inst.rfex_axis_if.tdata).id_data.pc,
           offnariscv_core_inst.rfalu_axis_if.tdata, offnariscv_core_inst.rfalu_axis_if.tdata,
           offnariscv_core_inst.rfbru_axis_if.tdata, offnariscv_core_inst.rfbru_axis_if.tdata,
-          offnariscv_core_inst.rfex_axis_if.tdata[63:0]);
+          inst_info(rfex_tdata_t'(offnariscv_core_inst.rfex_axis_if.tdata).id_data.tag).id);
       $write("exwb:\t\ttvalid=%0d, tready=%0d, ack=%0d, pc=%08h, id=%0d\n",
              offnariscv_core_inst.exwb_axis_if.tvalid, offnariscv_core_inst.exwb_axis_if.tready,
              offnariscv_core_inst.exwb_axis_if.ack(),
-             offnariscv_core_inst.exwb_axis_if.tdata[127-:XLEN],
-             offnariscv_core_inst.exwb_axis_if.tdata[63:0]);
+             exwb_tdata_t'(offnariscv_core_inst.exwb_axis_if.tdata).pc,
+             inst_info(exwb_tdata_t'(offnariscv_core_inst.exwb_axis_if.tdata).tag).id);
       if (0)
         $write(
             "wbrf:\t\ttvalid=%0d, tready=%0d, ack=%0d, pc=%08h, id=%0d\n",
             offnariscv_core_inst.wbrf_axis_if.tvalid,
             offnariscv_core_inst.wbrf_axis_if.tready,
             offnariscv_core_inst.wbrf_axis_if.ack(),
-            offnariscv_core_inst.wbrf_axis_if.tdata[127-:XLEN],
-            offnariscv_core_inst.wbrf_axis_if.tdata[63:0]
+            wbrf_tdata_t'(offnariscv_core_inst.wbrf_axis_if.tdata).ex_data.pc,
+            inst_info(wbrf_tdata_t'(offnariscv_core_inst.wbrf_axis_if.tdata).ex_data.tag).id
         );
       // for (int i = 0; i < 32; i++) begin
       //   $write("rf[%0d] = %08x\n", i, offnariscv_core_inst.regfile_inst.rf_mem[i]);
@@ -267,21 +451,21 @@ module offnariscv_core_wrap
         wbrf_tdata_t tdata;
         assign tdata = offnariscv_core_inst.wbrf_axis_if.tdata;
         $write("wbrf:\t\tid=%0d, rd=%0d, wdata=%08x, pc=%08x, trap=%0d\n",
-               tdata.ex_data.rf_data.id_data.if_data.pcg_data.id, tdata.ex_data.rf_data.id_data.rd,
-               tdata.wdata, tdata.ex_data.rf_data.id_data.if_data.pcg_data.pc,
+               inst_info(tdata.ex_data.tag).id, tdata.ex_data.rd,
+               tdata.wdata, tdata.ex_data.pc,
                offnariscv_core_inst.wbcsr_wif.trap);
-        if (tdata.ex_data.rf_data.id_data.rd != 0)
+        if (tdata.ex_data.rd != 0)
           $write(
               "pc=%08x, rd=%0d, wdata=%08x\n",
-              tdata.ex_data.rf_data.id_data.if_data.pcg_data.pc,
-              tdata.ex_data.rf_data.id_data.rd,
+              tdata.ex_data.pc,
+              tdata.ex_data.rd,
               tdata.wdata
           );
         if (offnariscv_core_inst.wbcsr_wif.valid || offnariscv_core_inst.syswb_axis_if.tvalid)
           $write(
               "csr_addr=%08x, csr_rdata=%08x, csr_wdata=%08x, pc=%08x, cause=%0d\n",
               offnariscv_core_inst.wbcsr_wif.addr,
-              tdata.ex_data.rf_data.csr_rdata,
+              tdata.ex_data.csr_rdata,
               offnariscv_core_inst.wbcsr_wif.data,
               offnariscv_core_inst.wbcsr_wif.pc,
               offnariscv_core_inst.wbcsr_wif.cause
@@ -293,6 +477,7 @@ module offnariscv_core_wrap
         $write("new_pc=%08x\n", offnariscv_core_inst.wbpcg_axis_if.tdata);
       end
       $write("\n");
+`endif
     end
   end
 
@@ -300,7 +485,7 @@ module offnariscv_core_wrap
   export "DPI-C" task kanata_log_dut;
   task kanata_log_dut;
     output string log_file;
-    string s0, s1, s2, s3, s4, s5, s6, s7;
+    string s0, s1, s2, s3, s4, s5, s6, s7, s8, s9;
     if (wbpcg_prev_ack) begin
       logic [INST_ID_WIDTH-1:0] id;
       logic [XLEN-1:0] pc;
@@ -316,31 +501,53 @@ module offnariscv_core_wrap
                ifid_prev_tdata.pcg_data.id, ifid_prev_tdata.inst);
     end else $sformat(s2, "");
     if (idrf_prev_ack) begin
-      $sformat(s3, "S\t%0d\t0\tRF\n", idrf_prev_tdata.if_data.pcg_data.id);
+      $sformat(s3, "S\t%0d\t0\tRF\n", inst_info(idrf_prev_tdata.tag).id);
     end else $sformat(s3, "");
     if (rfex_prev_ack) begin
-      $sformat(s4, "S\t%0d\t0\tEX\n", rfex_prev_tdata.id_data.if_data.pcg_data.id);
+      $sformat(s4, "S\t%0d\t0\tEX\n", inst_info(rfex_prev_tdata.id_data.tag).id);
     end else $sformat(s4, "");
+    if (rfex1_prev_ack) begin
+      $sformat(s4, "%sS\t%0d\t0\tEX\n", s4, inst_info(rfex1_prev_tdata.id_data.tag).id);
+    end
     if (exwb_prev_ack) begin
-      $sformat(s5, "S\t%0d\t0\tWB\n", exwb_prev_tdata.rf_data.id_data.if_data.pcg_data.id);
+      $sformat(s5, "S\t%0d\t0\tWB\n", inst_info(exwb_prev_tdata.tag).id);
     end else $sformat(s5, "");
+    if (exwb1_prev_ack) begin
+      $sformat(s5, "%sS\t%0d\t0\tWB\n", s5, inst_info(exwb1_prev_tdata.tag).id);
+    end
     if (wbrf_prev_ack) begin
-      $sformat(s6, "R\t%0d\t%0d\t0\n", wbrf_prev_tdata.ex_data.rf_data.id_data.if_data.pcg_data.id,
-               ret_cnt);
+      $sformat(s6, "R\t%0d\t%0d\t0\n", inst_info(wbrf_prev_tdata.ex_data.tag).id, ret_cnt);
       ret_cnt++;
+      if (wbrf_prev_tdata.ex_data.fused) begin  // The second half came next
+        $sformat(s6, "%sR\t%0d\t%0d\t0\n", s6,
+                 inst_info(wbrf_prev_tdata.ex_data.tag).id + 1, ret_cnt);
+        ret_cnt++;
+      end
     end else $sformat(s6, "");
+    if (wbrf1_prev_ack) begin
+      $sformat(s9, "R\t%0d\t%0d\t0\n", inst_info(wbrf1_prev_tdata.ex_data.tag).id, ret_cnt);
+      ret_cnt++;
+    end else $sformat(s9, "");
     if (prev_invalidate) begin
       pcgif_tdata_t tdata;
       assign tdata = offnariscv_core_inst.pcgif_axis_if.tdata;
       for (
-          longint i = wbrf_prev_tdata.ex_data.rf_data.id_data.if_data.pcg_data.id + 1;
+          longint i = inst_info(wbrf_prev_tdata.ex_data.tag).id + 1 +
+              wbrf_prev_tdata.ex_data.fused;
           i < tdata.id;
           ++i
       ) begin
         $sformat(s7, "%sR\t%0d\t-1\t1\n", s7, i);
       end
     end else $sformat(s7, "");
-    $sformat(log_file, "%s%s%s%s%s%s%s%s", s0, s1, s2, s3, s4, s5, s6, s7);
+    if (prev_fe_invalidate) begin  // Squashed by a decode-stage redirect
+      pcgif_tdata_t tdata;
+      assign tdata = offnariscv_core_inst.pcgif_axis_if.tdata;
+      for (longint i = redirect_id + 1; i < tdata.id; ++i) begin
+        $sformat(s8, "%sR\t%0d\t-1\t1\n", s8, i);
+      end
+    end else $sformat(s8, "");
+    $sformat(log_file, "%s%s%s%s%s%s%s%s%s%s", s0, s1, s2, s3, s4, s5, s6, s9, s7, s8);
   endtask
 
 endmodule
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: MIT
+
+#include <verilated.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <print>
+#include <vector>
+
+#include "AceInterconnect.hpp"
+#include "Assembler.hpp"
+#include "Dut.hpp"
+#include "Voffnariscv_smp.h"
+
+// Parallel array reduction on 1/2/4 of the four harts. Each active hart sums
+// its slice of a shared read-only array, then adds its partial sum to a total
+// in turn (a ticket lock built from plain loads and stores) and finally waits
+// for every other hart before loading the total. The handoffs bounce the
+// synchronization line between the L1Ds, so the result is only right if the
+// snoop responders keep it coherent.
+//
+// The atomic loops increment a counter AMO_ITERS times per hart, with either
+// amoadd.w or an lr.w/sc.w retry loop, on one shared counter (contended) or on
+// one line per hart (uncontended).
+//
+// The code patching program has hart 1 rewrite a function that hart 0 has
+// already run, so that hart 0 only sees the new code if the patch invalidated
+// its L1I. Hart 1 loads the line before it stores to it, which takes the line
+// shared only if hart 0's snoop responder reports the copy in its L1I.
+
+namespace {
+
+constexpr int NUM_CORES = 4;
+
+constexpr std::uint32_t TEXT_BASE = 0x80000000;
+constexpr std::uint32_t DATA_BASE = 0x80010000;
+constexpr std::uint32_t SYNC_BASE = 0x80020000;  // turn at +0, total at +32 (next line)
+constexpr std::uint32_t AMO_BASE = SYNC_BASE + 0x100;  // One line per hart
+constexpr int DATA_WORDS = 1024;
+constexpr int AMO_ITERS = 64;
+
+constexpr int A0 = 10, A1 = 11, A2 = 12;
+constexpr int T0 = 5, T1 = 6, T2 = 7, T3 = 28, T4 = 29, T5 = 30, T6 = 31, S0 = 8;
+constexpr int MHARTID = 0xf14;
+
+struct Result {
+  std::uint64_t cycles = 0;
+  std::uint64_t retired = 0;
+  std::uint64_t snoops = 0;
+  std::uint64_t snoop_data = 0;
+};
+
+std::vector<std::uint32_t> build_program(int active) {
+  int chunk_bytes = DATA_WORDS * 4 / active;
+
+  std::vector<std::uint32_t> text;
+  rv::li(text, A1, active);
+  auto park_branch = text.size();
+  text.push_back(0);  // bgeu a0, a1, park
+  rv::li(text, T0, chunk_bytes);
+  text.push_back(rv::slli(T1, A0, std::countr_zero(static_cast<unsigned>(chunk_bytes))));
+  rv::li(text, T2, DATA_BASE);
+  text.push_back(rv::add(T1, T1, T2));  // Start of this hart's slice
+  text.push_back(rv::add(T3, T1, T0));  // End of this hart's slice
+  text.push_back(rv::mv(S0, 0));
+  auto loop = text.size();
+  text.push_back(rv::lw(T4, T1, 0));
+  text.push_back(rv::add(S0, S0, T4));
+  text.push_back(rv::addi(T1, T1, 4));
+  text.push_back(rv::bne(T1, T3, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+
+  rv::li(text, T5, SYNC_BASE);
+  auto wait = text.size();
+  text.push_back(rv::lw(T6, T5, 0));
+  text.push_back(rv::bne(T6, A0, 4 * (static_cast<int>(wait) - static_cast<int>(text.size()))));
+  text.push_back(rv::lw(T6, T5, 32));
+  text.push_back(rv::add(T6, T6, S0));
+  text.push_back(rv::sw(T6, T5, 32));
+  text.push_back(rv::addi(T6, A0, 1));
+  text.push_back(rv::sw(T6, T5, 0));
+
+  auto barrier = text.size();
+  text.push_back(rv::lw(T6, T5, 0));
+  text.push_back(
+      rv::bne(T6, A1, 4 * (static_cast<int>(barrier) - static_cast<int>(text.size()))));
+  text.push_back(rv::lw(A2, T5, 32));
+
+  auto park = text.size();
+  text.push_back(rv::j(0));
+  text[park_branch] =
+      rv::bgeu(A0, A1, 4 * (static_cast<int>(park) - static_cast<int>(park_branch)));
+  return text;
+}
+
+std::vector<std::uint32_t> build_code_patch_program() {
+  constexpr int RA = 1;
+  constexpr int BLOCK_WORDS = 8;
+
+  std::vector<std::uint32_t> text;
+  text.resize(2);  // li t3, func
+  rv::li(text, A1, 2);
+  auto park_branch = text.size();
+  text.push_back(0);  // bgeu a0, a1, park
+  rv::li(text, T5, SYNC_BASE);
+  text.push_back(rv::slli(T4, A0, 5));
+  text.push_back(rv::add(T4, T4, T5));
+  text.push_back(rv::addi(T4, T4, 64));  // This hart's result, past the two flags
+  text.push_back(rv::addi(T1, 0, 1));
+  auto writer_branch = text.size();
+  text.push_back(0);  // bne a0, zero, writer
+
+  // Hart 0 runs the old code, then the new one once hart 1 has patched it
+  text.push_back(rv::jalr(RA, T3, 0));
+  text.push_back(rv::sw(T1, T5, 0));
+  auto wait_patched = text.size();
+  text.push_back(rv::lw(T2, T5, 32));
+  text.push_back(
+      rv::beq(T2, 0, 4 * (static_cast<int>(wait_patched) - static_cast<int>(text.size()))));
+  text.push_back(rv::fence_i());
+  text.push_back(rv::jalr(RA, T3, 0));
+  auto reader_jump = text.size();
+  text.push_back(0);  // j tail
+
+  auto writer = text.size();
+  auto wait_ran = text.size();
+  text.push_back(rv::lw(T2, T5, 0));
+  text.push_back(rv::beq(T2, 0, 4 * (static_cast<int>(wait_ran) - static_cast<int>(text.size()))));
+  text.push_back(rv::lw(T2, T3, 0));
+  rv::li(text, T0, rv::addi(T6, 0, 2));
+  text.push_back(rv::sw(T0, T3, 0));
+  text.push_back(rv::sw(T1, T5, 32));
+  text.push_back(rv::fence_i());
+  text.push_back(rv::jalr(RA, T3, 0));
+  auto writer_jump = text.size();
+  text.push_back(0);  // j tail
+
+  // The function has a block to itself
+  while (text.size() % BLOCK_WORDS != 0) text.push_back(rv::nop());
+  auto func = text.size();
+  text.push_back(rv::addi(T6, 0, 1));  // addi t6, zero, 2 once patched
+  text.push_back(rv::jalr(0, RA, 0));
+  while (text.size() % BLOCK_WORDS != 0) text.push_back(rv::nop());
+
+  auto tail = text.size();
+  text.push_back(rv::sw(T6, T4, 0));
+  text.push_back(rv::lw(A2, T4, 0));
+  auto park = text.size();
+  text.push_back(rv::j(0));
+
+  std::vector<std::uint32_t> head;
+  rv::li(head, T3, TEXT_BASE + 4 * static_cast<std::uint32_t>(func));
+  std::copy(head.begin(), head.end(), text.begin());
+  text[park_branch] =
+      rv::bgeu(A0, A1, 4 * (static_cast<int>(park) - static_cast<int>(park_branch)));
+  text[writer_branch] =
+      rv::bne(A0, 0, 4 * (static_cast<int>(writer) - static_cast<int>(writer_branch)));
+  text[reader_jump] = rv::j(4 * (static_cast<int>(tail) - static_cast<int>(reader_jump)));
+  text[writer_jump] = rv::j(4 * (static_cast<int>(tail) - static_cast<int>(writer_jump)));
+  return text;
+}
+
+std::vector<std::uint32_t> build_amo_program(int active, bool contended, bool lrsc) {
+  std::vector<std::uint32_t> text;
+  rv::li(text, A1, active);
+  auto park_branch = text.size();
+  text.push_back(0);  // bgeu a0, a1, park
+  rv::li(text, T0, AMO_ITERS);
+  rv::li(text, T5, AMO_BASE);
+  if (!contended) {
+    text.push_back(rv::slli(T2, A0, 5));
+    text.push_back(rv::add(T5, T5, T2));
+  }
+  text.push_back(rv::addi(T1, 0, 1));
+  auto loop = text.size();
+  if (lrsc) {
+    text.push_back(rv::lr_w(T4, T5));
+    text.push_back(rv::addi(T4, T4, 1));
+    text.push_back(rv::sc_w(T6, T5, T4));
+    text.push_back(rv::bne(T6, 0, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+  } else {
+    text.push_back(rv::amoadd_w(0, T5, T1));
+  }
+  text.push_back(rv::addi(T0, T0, -1));
+  text.push_back(rv::bne(T0, 0, 4 * (static_cast<int>(loop) - static_cast<int>(text.size()))));
+
+  rv::li(text, T3, SYNC_BASE);
+  text.push_back(rv::amoadd_w(0, T3, T1));
+  auto barrier = text.size();
+  text.push_back(rv::lw(T6, T3, 0));
+  text.push_back(
+      rv::bne(T6, A1, 4 * (static_cast<int>(barrier) - static_cast<int>(text.size()))));
+  text.push_back(rv::lw(A2, T5, 0));
+
+  auto park = text.size();
+  text.push_back(rv::j(0));
+  text[park_branch] =
+      rv::bgeu(A0, A1, 4 * (static_cast<int>(park) - static_cast<int>(park_branch)));
+  return text;
+}
+
+// Runs `text` on the first `active` harts, until each of them has loaded
+// `expected` into a2 with the second-to-last instruction
+Result run(const std::vector<std::uint32_t>& text, int active, std::uint32_t expected) {
+  Dut<Voffnariscv_smp> dut;
+  AceInterconnect<NUM_CORES> interconnect;
+
+  // Boot code shared by every hart: a0 = mhartid, then jump to TEXT_BASE
+  interconnect.memory.write32(0, rv::csrrs(A0, MHARTID, 0));
+  interconnect.memory.write32(4, rv::lui(T0, TEXT_BASE));
+  interconnect.memory.write32(8, rv::jalr(0, T0, 0));
+
+  interconnect.memory.write(TEXT_BASE, reinterpret_cast<const std::uint8_t*>(text.data()),
+                            text.size() * 4);
+  for (int i = 0; i < DATA_WORDS; ++i) {
+    interconnect.memory.write32(DATA_BASE + 4 * i, i + 1);
+  }
+  interconnect.memory.write32(SYNC_BASE, 0);
+  interconnect.memory.write32(SYNC_BASE + 32, 0);
+  for (int i = 0; i < NUM_CORES; ++i) {
+    interconnect.memory.write32(AMO_BASE + 32 * i, 0);
+  }
+
+  interconnect.init(dut);
+  dut.reset();
+
+  Result result;
+  std::uint32_t final_load_pc = TEXT_BASE + 4 * (static_cast<std::uint32_t>(text.size()) - 2);
+  std::array<bool, NUM_CORES> done{};
+  int remaining = active;
+  while (remaining > 0 && result.cycles < 200000) {
+    interconnect.respond(dut);
+    for (int c = 0; c < active; ++c) {
+      if (!dut->smp_commit_valid[c]) continue;
+      ++result.retired;
+      if (dut->smp_commit_pc[c] == final_load_pc && dut->smp_commit_rd[c] == A2 && !done[c]) {
+        CHECK(dut->smp_commit_wdata[c] == expected);
+        done[c] = true;
+        --remaining;
+      }
+    }
+    dut.step();
+    interconnect.retire(dut);
+    ++result.cycles;
+  }
+  REQUIRE(remaining == 0);
+
+  result.snoops = interconnect.snoops;
+  result.snoop_data = interconnect.snoop_data;
+  return result;
+}
+
+}  // namespace
+
+TEST_CASE("offnariscv_smp/reduction scaling") {
+  std::uint32_t expected = DATA_WORDS * (DATA_WORDS + 1) / 2;
+
+  std::print("{:>5} {:>8} {:>8} {:>6} {:>12} {:>8} {:>7} {:>10}\n", "cores", "cycles", "retired",
+             "IPC", "words/kcycle", "speedup", "snoops", "snoop data");
+  std::uint64_t base_cycles = 0;
+  for (int active : {1, 2, 4}) {
+    auto result = run(build_program(active), active, expected);
+    if (active == 1) base_cycles = result.cycles;
+    std::print("{:>5} {:>8} {:>8} {:>6.3f} {:>12.1f} {:>8.2f} {:>7} {:>10}\n", active,
+               result.cycles, result.retired,
+               static_cast<double>(result.retired) / result.cycles,
+               1000.0 * DATA_WORDS / result.cycles,
+               static_cast<double>(base_cycles) / result.cycles, result.snoops,
+               result.snoop_data);
+  }
+}
+
+TEST_CASE("offnariscv_smp/atomic throughput") {
+  std::print("{:>6} {:>11} {:>5} {:>8} {:>10} {:>10}\n", "kind", "counter", "cores", "cycles",
+             "cycles/op", "ops/kcycle");
+  for (bool lrsc : {false, true}) {
+    for (bool contended : {false, true}) {
+      for (int active : {1, 2, 4}) {
+        std::uint32_t expected = contended ? active * AMO_ITERS : AMO_ITERS;
+        auto result = run(build_amo_program(active, contended, lrsc), active, expected);
+        int ops = active * AMO_ITERS;
+        std::print("{:>6} {:>11} {:>5} {:>8} {:>10.1f} {:>10.1f}\n", lrsc ? "lr/sc" : "amoadd",
+                   contended ? "contended" : "private", active, result.cycles,
+                   static_cast<double>(result.cycles) / ops,
+                   1000.0 * ops / result.cycles);
+      }
+    }
+  }
+}
+
+TEST_CASE("offnariscv_smp/cross-hart code patching") {
+  // Both harts end up running the patched function
+  auto result = run(build_code_patch_program(), 2, 2);
+  std::print("{} cycles, {} snoops, {} with data\n", result.cycles, result.snoops,
+             result.snoop_data);
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+
+// NUM_CORES copies of offnariscv_core_wrap, one per hart, with the ACE
+// channels the interconnect model needs brought out as per-core arrays. The
+// harts share one CLINT, so that they can send each other software interrupts.
+module offnariscv_smp_wrap
+  import offnariscv_pkg::*;
+#(
+    parameter NUM_CORES = 4,
+    localparam ACE_XDATA_WIDTH = 64,
+    localparam ACE_AXADDR_WIDTH = 32
+) (
+    input clk,
+    input rst,
+
+    output logic [ACE_AXADDR_WIDTH-1:0] smp_ace_awaddr[NUM_CORES],
+    output logic smp_ace_awvalid[NUM_CORES],
+    input logic smp_ace_awready[NUM_CORES],
+    output logic [ACE_AWSNOOP_WIDTH-1:0] smp_ace_awsnoop[NUM_CORES],
+    output logic [ACE_XDATA_WIDTH-1:0] smp_ace_wdata[NUM_CORES],
+    output logic [ACE_XDATA_WIDTH/8-1:0] smp_ace_wstrb[NUM_CORES],
+    output logic smp_ace_wlast[NUM_CORES],
+    output logic smp_ace_wvalid[NUM_CORES],
+    input logic smp_ace_wready[NUM_CORES],
+    input logic [ACE_BRESP_WIDTH-1:0] smp_ace_bresp[NUM_CORES],
+    input logic smp_ace_bvalid[NUM_CORES],
+    output logic smp_ace_bready[NUM_CORES],
+    output logic [ACE_AXADDR_WIDTH-1:0] smp_ace_araddr[NUM_CORES],
+    output logic [ACE_AXLEN_WIDTH-1:0] smp_ace_arlen[NUM_CORES],
+    output logic smp_ace_arvalid[NUM_CORES],
+    output logic smp_ace_arlock[NUM_CORES],
+    input logic smp_ace_arready[NUM_CORES],
+    output logic [ACE_ARSNOOP_WIDTH-1:0] smp_ace_arsnoop[NUM_CORES],
+    output logic [ACE_DOMAIN_WIDTH-1:0] smp_ace_ardomain[NUM_CORES],
+    input logic [ACE_XDATA_WIDTH-1:0] smp_ace_rdata[NUM_CORES],
+    input logic [ACE_RRESP_WIDTH-1:0] smp_ace_rresp[NUM_CORES],
+    input logic smp_ace_rlast[NUM_CORES],
+    input logic smp_ace_rvalid[NUM_CORES],
+    output logic smp_ace_rready[NUM_CORES],
+    input logic smp_ace_acvalid[NUM_CORES],
+    output logic smp_ace_acready[NUM_CORES],
+    input logic [ACE_AXADDR_WIDTH-1:0] smp_ace_acaddr[NUM_CORES],
+    input logic [ACE_ACSNOOP_WIDTH-1:0] smp_ace_acsnoop[NUM_CORES],
+    output logic smp_ace_crvalid[NUM_CORES],
+    input logic smp_ace_crready[NUM_CORES],
+    output logic [ACE_CRRESP_WIDTH-1:0] smp_ace_crresp[NUM_CORES],
+    output logic smp_ace_cdvalid[NUM_CORES],
+    input logic smp_ace_cdready[NUM_CORES],
+    output logic [ACE_XDATA_WIDTH-1:0] smp_ace_cddata[NUM_CORES],
+    output logic smp_ace_cdlast[NUM_CORES],
+
+    output logic smp_commit_valid[NUM_CORES],
+    output logic [XLEN-1:0] smp_commit_pc[NUM_CORES],
+    output logic [4:0] smp_commit_rd[NUM_CORES],
+    output logic [XLEN-1:0] smp_commit_wdata[NUM_CORES]
+);
+
+  clint_if clint_ifs[NUM_CORES] ();
+
+  clint #(
+      .NUM_HARTS(NUM_CORES)
+  ) clint_inst (
+      .clk(clk),
+      .rst(rst),
+      .clint_rsp_if(clint_ifs),
+      .skip('0)
+  );
+
+  for (genvar i = 0; i < NUM_CORES; ++i) begin : gen_core
+    offnariscv_core_wrap #(
+        .MHARTID(i),
+        .EXTERNAL_CLINT(1)
+    ) offnariscv_core_wrap_inst (
+        .clk(clk),
+        .rst(rst),
+        .core_ace_awid(),
+        .core_ace_awaddr(smp_ace_awaddr[i]),
+        .core_ace_awlen(),
+        .core_ace_awsize(),
+        .core_ace_awburst(),
+        .core_ace_awlock(),
+        .core_ace_awcache(),
+        .core_ace_awprot(),
+        .core_ace_awqos(),
+        .core_ace_awregion(),
+        .core_ace_awuser(),
+        .core_ace_awvalid(smp_ace_awvalid[i]),
+        .core_ace_awready(smp_ace_awready[i]),
+        .core_ace_awsnoop(smp_ace_awsnoop[i]),
+        .core_ace_awdomain(),
+        .core_ace_awbar(),
+        .core_ace_wdata(smp_ace_wdata[i]),
+        .core_ace_wstrb(smp_ace_wstrb[i]),
+        .core_ace_wlast(smp_ace_wlast[i]),
+        .core_ace_wuser(),
+        .core_ace_wvalid(smp_ace_wvalid[i]),
+        .core_ace_wready(smp_ace_wready[i]),
+        .core_ace_bid('0),
+        .core_ace_bresp(smp_ace_bresp[i]),
+        .core_ace_buser('0),
+        .core_ace_bvalid(smp_ace_bvalid[i]),
+        .core_ace_bready(smp_ace_bready[i]),
+        .core_ace_arid(),
+        .core_ace_araddr(smp_ace_araddr[i]),
+        .core_ace_arlen(smp_ace_arlen[i]),
+        .core_ace_arsize(),
+        .core_ace_arburst(),
+        .core_ace_arlock(smp_ace_arlock[i]),
+        .core_ace_arcache(),
+        .core_ace_arprot(),
+        .core_ace_arqos(),
+        .core_ace_arregion(),
+        .core_ace_aruser(),
+        .core_ace_arvalid(smp_ace_arvalid[i]),
+        .core_ace_arready(smp_ace_arready[i]),
+        .core_ace_arsnoop(smp_ace_arsnoop[i]),
+        .core_ace_ardomain(smp_ace_ardomain[i]),
+        .core_ace_arbar(),
+        .core_ace_rid('0),
+        .core_ace_rdata(smp_ace_rdata[i]),
+        .core_ace_rresp(smp_ace_rresp[i]),
+        .core_ace_rlast(smp_ace_rlast[i]),
+        .core_ace_ruser('0),
+        .core_ace_rvalid(smp_ace_rvalid[i]),
+        .core_ace_rready(smp_ace_rready[i]),
+        .core_ace_acvalid(smp_ace_acvalid[i]),
+        .core_ace_acready(smp_ace_acready[i]),
+        .core_ace_acaddr(smp_ace_acaddr[i]),
+        .core_ace_acsnoop(smp_ace_acsnoop[i]),
+        .core_ace_acprot('0),
+        .core_ace_crvalid(smp_ace_crvalid[i]),
+        .core_ace_crready(smp_ace_crready[i]),
+        .core_ace_crresp(smp_ace_crresp[i]),
+        .core_ace_cdvalid(smp_ace_cdvalid[i]),
+        .core_ace_cdready(smp_ace_cdready[i]),
+        .core_ace_cddata(smp_ace_cddata[i]),
+        .core_ace_cdlast(smp_ace_cdlast[i]),
+        .core_ace_rack(),
+        .core_ace_wack(),
+        .core_lsu_addr(),
+        .core_lsu_wdata(),
+        .core_lsu_store(),
+        .core_commit_valid(smp_commit_valid[i]),
+        .core_commit_pc(smp_commit_pc[i]),
+        .core_commit_rd(smp_commit_rd[i]),
+        .core_commit_wdata(smp_commit_wdata[i]),
+        .core_commit_fused(),
+        .core_commit_fused_pc(),
+        .core_commit_fused_rd(),
+        .core_commit_fused_wdata(),
+        .core_commit1_valid(),
+        .core_commit1_pc(),
+        .core_commit1_rd(),
+        .core_commit1_wdata(),
+        .core_clint_valid(clint_ifs[i].valid),
+        .core_clint_write(clint_ifs[i].write),
+        .core_clint_addr(clint_ifs[i].addr),
+        .core_clint_wdata(clint_ifs[i].wdata),
+        .core_clint_wstrb(clint_ifs[i].wstrb),
+        .core_clint_rdata(clint_ifs[i].rdata),
+        .core_clint_mtip(clint_ifs[i].mtip),
+        .core_clint_msip(clint_ifs[i].msip),
+        .clint_skip('0),
+        .clint_mtime(),
+        .clint_mtimecmp(),
+        .core_sleep(),
+        .core_retired(),
+        .core_fused(),
+        .core_fetched(),
+        .core_l1i_refills(),
+        .core_loop_cycles(),
+        .core_loop_replayed(),
+        .core_load_misses(),
+        .core_prefetch_fills(),
+        .core_prefetch_hits(),
+        .core_prefetch_drops(),
+        .core_itlb_hits(),
+        .core_itlb_misses(),
+        .core_dtlb_hits(),
+        .core_dtlb_misses()
+    );
+  end
+
+endmodule
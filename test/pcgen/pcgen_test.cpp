@@ -15,14 +15,103 @@ static void init_dut(Dut<Vpcgen>& dut) {
   dut->current_pc_tvalid = 0;
   dut->bru_tdata = 0;
   dut->bru_tvalid = 0;
+  dut->dec_tdata = 0;
+  dut->dec_tvalid = 0;
+  dut->predecode_vld = 0;
+  dut->predecode_rvc = 0;
+  dut->predecode_taken = 0;
+  dut->predecode_target = 0;
 
   dut.reset();
 }
 
-TEST_CASE("pcgen_implement_me") {
+// pcgif_tdata_t is {pc, untaken_pc, id}, so the PC is the most significant word
+static std::uint32_t next_pc(Dut<Vpcgen>& dut) { return dut->next_pc_tdata[3]; }
+
+TEST_CASE("pcgen_redirect_priority") {
+  Dut<Vpcgen> dut;
+  init_dut(dut);
+
+  std::print("----- Sequential\n");
+  dut->next_pc_tready = 1;
+  dut->eval();
+  REQUIRE(next_pc(dut) == 0);
+  dut.step();
+  REQUIRE(next_pc(dut) == 4);
+
+  std::print("----- Decoder redirect\n");
+  dut->dec_tdata = 0x100;
+  dut->dec_tvalid = 1;
+  dut->eval();
+  REQUIRE(dut->dec_tready);
+  dut.step();
+  dut->dec_tvalid = 0;
+  dut->eval();
+  REQUIRE(next_pc(dut) == 0x100);
+
+  std::print("----- Back-end redirect wins over the decoder\n");
+  dut->dec_tdata = 0x200;
+  dut->dec_tvalid = 1;
+  dut->bru_tdata = 0x300;
+  dut->bru_tvalid = 1;
+  dut->eval();
+  REQUIRE(!dut->dec_tready);
+  dut.step();
+  dut->dec_tvalid = 0;
+  dut->bru_tvalid = 0;
+  dut->eval();
+  REQUIRE(next_pc(dut) == 0x300);
+  dut.step();
+  REQUIRE(next_pc(dut) == 0x304);
+}
+
+TEST_CASE("pcgen_compressed") {
   Dut<Vpcgen> dut;
   init_dut(dut);
+  dut->next_pc_tready = 1;
+
+  std::print("----- Unknown length is predicted as 4 bytes\n");
+  dut->eval();
+  REQUIRE(dut->predecode_pc == 0);
+  REQUIRE(dut->next_pc_tdata[2] == 4);  // untaken_pc
+  dut.step();
+  REQUIRE(next_pc(dut) == 4);
+
+  std::print("----- Predecoded compressed instruction\n");
+  dut->predecode_vld = 1;
+  dut->predecode_rvc = 1;
+  dut->eval();
+  REQUIRE(dut->next_pc_tdata[2] == 6);
+  dut.step();
+  REQUIRE(next_pc(dut) == 6);
+  dut->predecode_rvc = 0;
+  dut.step();
+  REQUIRE(next_pc(dut) == 10);
+}
+
+TEST_CASE("pcgen_predicted_taken") {
+  Dut<Vpcgen> dut;
+  init_dut(dut);
+  dut->next_pc_tready = 1;
+
+  std::print("----- The end of a replayed loop turns around to its head\n");
+  dut->bru_tdata = 0x40;
+  dut->bru_tvalid = 1;
+  dut.step();
+  dut->bru_tvalid = 0;
+  dut->predecode_vld = 1;
+  dut->predecode_taken = 1;
+  dut->predecode_target = 0x20;
+  dut->eval();
+  REQUIRE(next_pc(dut) == 0x40);
+  REQUIRE(dut->next_pc_tdata[2] == 0x20);  // untaken_pc carries the prediction
+  dut.step();
+  REQUIRE(next_pc(dut) == 0x20);
 
-  std::print("----- Implement me\n");
-  REQUIRE(true);
+  std::print("----- Ignored unless predecoded\n");
+  dut->predecode_vld = 0;
+  dut->eval();
+  REQUIRE(dut->next_pc_tdata[2] == 0x24);
+  dut.step();
+  REQUIRE(next_pc(dut) == 0x24);
 }
@@ -16,12 +16,23 @@ module pcgen_wrap
 
     input logic [XLEN-1:0] bru_tdata,
     input logic bru_tvalid,
-    output logic bru_tready
+    output logic bru_tready,
+
+    input logic [XLEN-1:0] dec_tdata,
+    input logic dec_tvalid,
+    output logic dec_tready,
+
+    output logic [XLEN-1:0] predecode_pc,
+    input logic predecode_vld,
+    input logic predecode_rvc,
+    input logic predecode_taken,
+    input logic [XLEN-1:0] predecode_target
 );
 
   axis_if #(.TDATA_WIDTH($bits(pcgif_tdata_t))) pcgif_axis_if ();
   axis_if #(.TDATA_WIDTH(XLEN)) current_pc_axis_if ();
   axis_if #(.TDATA_WIDTH(XLEN)) wbpcg_axis_if ();
+  axis_if #(.TDATA_WIDTH(XLEN)) idpcg_axis_if ();
 
   assign next_pc_tdata = pcgif_axis_if.tdata;
   assign next_pc_tvalid = pcgif_axis_if.tvalid;
@@ -35,6 +46,10 @@ module pcgen_wrap
   assign wbpcg_axis_if.tvalid = bru_tvalid;
   assign bru_tready = wbpcg_axis_if.tready;
 
+  assign idpcg_axis_if.tdata = dec_tdata;
+  assign idpcg_axis_if.tvalid = dec_tvalid;
+  assign dec_tready = idpcg_axis_if.tready;
+
   pcgen pcgen_inst (.*);
 
 endmodule